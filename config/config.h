@@ -35,6 +35,19 @@
 // Sensor de pH analógico
 #define ENABLE_SENSOR_PH
 
+// Adquisición (ver sensors_read_all y power_rail.h): las esperas de estabilización y de
+// conversión se solapan y, si son largas, se pasan en light sleep
+#define SENSOR_WAIT_LIGHT_SLEEP true      // true: dormir la CPU durante las esperas de sensores
+#define SENSOR_LIGHT_SLEEP_MIN_MS 20      // Espera mínima (ms) para entrar en light sleep
+#define SENSOR_SNAPSHOT_MAX_AGE_MS 60000  // Antigüedad máxima de la última lectura antes de repetirla
+
+// Frecuencia de la CPU por fase (ver cpu_governor.h)
+#define CPU_GOVERNOR true                 // false: 240 MHz todo el tiempo despierto
+#define CPU_BASE_MHZ 80                   // Por defecto (APB a 80 MHz: SPI, I2C y UART intactos)
+#define CPU_BOOST_MHZ 240                 // Ráfagas de cálculo: pantalla, trama y cifrado
+#define CPU_WAIT_MHZ 40                   // Esperas activas sin tráfico I2C (80 para no tocar el APB)
+#define CPU_WAIT_MIN_MS 10                // Espera mínima (ms) para bajar a CPU_WAIT_MHZ
+
 // =============================================================================
 // INCLUSIÓN AUTOMÁTICA DE SENSORES
 // =============================================================================
@@ -76,6 +89,29 @@
 #define TX_POWER_DBM 17              // Potencia de transmisión (máx 17 para evitar interferencias)
 #define BACKOFF_INITIAL_SECONDS 300  // Backoff inicial exponencial
 
+// Persistencia de sesión OTAA entre ciclos de sueño profundo (ver session.h)
+#define SESSION_PERSIST_NVS false    // true: copia de respaldo en NVS (sobrevive a cortes de alimentación)
+#define SESSION_MAX_UPLINKS 4032     // Forzar nuevo join tras N uplinks (~14 días a 300 s)
+#define SESSION_CONFIRM_EVERY 12     // Enviar un uplink confirmado cada N envíos (0 = nunca)
+#define SESSION_MAX_MISSED_ACKS 3    // Forzar nuevo join tras N confirmados seguidos sin ACK
+
+// Control de DR y potencia según el margen del enlace (ver link_controller.h)
+#define LINK_CONTROLLER_ADR false        // true: DR y potencia los decide el ADR de la red
+#define LINK_CONTROLLER_CHECK_EVERY 6    // Pedir LinkCheckReq cada N uplinks (0 = solo sin medidas o con pérdidas)
+#define LINK_CONTROLLER_MARGIN_DB 0      // Margen extra sobre el suelo de demodulación (0 = solo el modelo)
+#define LINK_CONTROLLER_MISSED_STEP 2    // Comprobaciones perdidas por peldaño de la escalera
+#define LINK_CONTROLLER_CYCLE_UC 30000   // Carga fija de un ciclo con envío (µC = mA·ms)
+#define LINK_CONTROLLER_GW_TX_DBM 14     // Potencia del gateway en RX1 (SNR del uplink por reciprocidad)
+
+// Error de reloj de las ventanas RX según la deriva del reloj lento RTC (ver clock_drift.h)
+#define CLOCK_DRIFT_ESTIMATE true        // false: error fijo de CLOCK_DRIFT_MAX_PPM (el 1 % de siempre)
+#define CLOCK_DRIFT_MIN_PPM 200          // Error mínimo por deriva del reloj lento (sin el retardo de despertar)
+#define CLOCK_DRIFT_WAKE_LATENCY_US 2000 // Retardo fijo de txend al despertar del light sleep; bajarlo solo tras medir rxOffset
+#define CLOCK_DRIFT_MAX_PPM 10000        // Error máximo (1 %), usado también sin calibraciones
+#define CLOCK_DRIFT_XTAL_PPM 20          // Tolerancia del cristal principal contra el que se calibra
+#define CLOCK_DRIFT_MARGIN 2             // Factor de seguridad sobre la deriva medida
+#define CLOCK_DRIFT_CAL_CYCLES 1024      // Ciclos del reloj lento por calibración (~7 ms con el RC de 150 kHz)
+
 // =============================================================================
 // CLAVES LoRaWAN OTAA (¡MODIFICA EN lorawan_config.h!)
 // =============================================================================
@@ -89,19 +125,61 @@
 #define SEND_INTERVAL_SECONDS 300    // Intervalo entre envíos (mínimo 60s para evitar sobrecarga)
 #define WATCHDOG_TIMEOUT_MINUTES 5   // Timeout del watchdog en minutos
 
+// Planificador del intervalo según batería y carga solar (ver scheduler.h)
+#define SCHEDULER_POLICY 1                  // 0: fijo (SEND_INTERVAL_SECONDS), 1: adaptativo
+#define SCHEDULER_MIN_INTERVAL_SECONDS 120  // Intervalo mínimo
+#define SCHEDULER_MAX_INTERVAL_SECONDS 3600 // Intervalo máximo
+#define SCHEDULER_DUTY_CYCLE_PERCENT 1      // Duty cycle de la banda (EU868 g/g1: 1 %)
+#define SCHEDULER_SUNRISE_HOUR 7            // Hora asignada a la vuelta de VBUS tras la noche
+#define SCHEDULER_DAYLIGHT_HOURS 12         // Horas de luz a partir del amanecer
+#define SCHEDULER_NIGHT_MIN_HOURS 6         // Horas sin VBUS para considerar que ha sido de noche
+
+// Planificador de uplinks: presupuesto de duty cycle en ventana móvil (ver uplink_planner.h)
+#define UPLINK_PLANNER_WINDOW_SECONDS 3600  // Ventana del presupuesto (1 hora)
+#define UPLINK_PLANNER_ADAPT_DR false       // true: subir el DR si la trama no cabe (solo sin ADR)
+#define UPLINK_PLANNER_CHAIN_WAIT_MS 300    // Espera de banda máxima para encadenar un uplink tras otro
+
+// Muestreo por lotes (ver batch.h): se mide cada SEND_INTERVAL_SECONDS y se envía
+// un uplink con las muestras acumuladas cada BATCH_SAMPLES_PER_UPLINK despertares
+#define BATCH_SAMPLES_PER_UPLINK 1   // 1: una muestra por envío (trama simple, FPort 1)
+#define BATCH_BUFFER_RECORDS 32      // Capacidad del buffer circular en memoria RTC
+#define BATCH_FPORT 2                // FPort de las tramas por lotes
+
 // Energía y batería
 #define ENABLE_SOLAR_CHARGING true   // Habilitar carga solar
 #define BATTERY_LOW_THRESHOLD 20     // Umbral de batería baja (%)
-#define BATTERY_AS_PERCENTAGE        // Descomentar para enviar batería como porcentaje (1 byte)
-                                     // Comentar para enviar como voltaje (2 bytes)
+#define BATTERY_CAPACITY_MAH 3000    // Capacidad nominal de la batería (contador de culombios del AXP192)
+#define BATTERY_SOC_MAX_DRIFT 15     // Desviación máxima (%) del contador frente a la curva OCV en reposo
+#define BATTERY_AS_PERCENTAGE        // Descomentar para enviar batería como porcentaje (0-100 %, 7 bits)
+                                     // Comentar para enviar como voltaje (2.50-4.50 V, 8 bits)
+
+// Hibernación por batería baja (ver hibernate.h)
+#define HIBERNATE_SOC_PERCENT 5           // Hibernar por debajo de este estado de carga (sin VBUS)
+#define HIBERNATE_RESUME_SOC_PERCENT 15   // Salir sin VBUS a partir de este estado de carga
+#define HIBERNATE_WAKE_HOURS 12           // Despertar de comprobación si no llega la interrupción del PMU
+#define HIBERNATE_FPORT 4                 // FPort del aviso de entrada en hibernación
+
+// Configuración por downlink (ver remote_config.h): SEND_INTERVAL_SECONDS,
+// BATCH_SAMPLES_PER_UPLINK, LINK_CONTROLLER_ADR, la resolución del DS18B20 y las
+// muestras de pH de este archivo son los valores de fábrica
+#define REMOTE_CONFIG_FPORT 5             // FPort de los comandos y de su confirmación
 
 // =============================================================================
 // CONFIGURACIÓN DE DEPURACIÓN Y LOGGING
 // =============================================================================
 
 #define ENABLE_SERIAL_LOGS true      // Habilitar logs por Serial
-#define LOG_LEVEL 1                  // 0: ninguno, 1: básico, 2: detallado
+#define LOG_LEVEL 1                  // 0: ninguno, 1: básico, 2: detallado (ver logger.h)
+#define LOG_BUFFER_BYTES 4096        // Buffer circular de logs diferidos (potencia de 2)
 #define SHOW_TTN_DECODER true  // true: mostrar decoder TTN por Serial al iniciar
+#define FAST_BOOT_ON_TIMER true      // true: sin diagnóstico ni escaneos al despertar por temporizador
+
+// Perfil de tiempo y carga por fase, acumulado en memoria RTC (ver profiler.h)
+#define ENABLE_PROFILER true         // false: los marcadores PHASE_* desaparecen al compilar
+#define PROFILER_REPORT_EVERY 288    // Uplink de diagnóstico cada N ciclos (~1 día a 300 s, 0 = nunca)
+#define PROFILER_FPORT 3             // FPort del uplink de diagnóstico
+#define PROFILER_PMU_SAMPLING true   // true: medir la corriente con el PMU (solo AXP192)
+#define PROFILER_LIGHT_SLEEP_UA 800  // Consumo estimado en light sleep (µA)
 
 // =============================================================================
 // CONFIGURACIÓN DE PAYLOAD Y DATOS
@@ -138,7 +216,9 @@
 #define SYSTEM_HAS_PH 0
 #endif
 
-// Cálculo del tamaño del payload usando directivas del preprocesador
+// Tamaño del payload sin comprimir (2 bytes por campo). Es solo una cota para
+// dimensionar buffers: el formato real lo define config/payload_schema.h y el
+// tamaño de un registro lo da payload_codec_record_size()
 #if defined(ENABLE_SENSOR_BME280)
 #define PAYLOAD_SIZE_TEMPERATURE 2
 #define PAYLOAD_SIZE_HUMIDITY 2
@@ -161,12 +241,7 @@
 #define PAYLOAD_SIZE_PH 0
 #endif
 
-// Tamaño de batería según configuración
-#ifdef BATTERY_AS_PERCENTAGE
-#define PAYLOAD_SIZE_BATTERY 2  // 2 bytes para mantener formato
-#else
-#define PAYLOAD_SIZE_BATTERY 2  // 2 bytes para voltaje (* 100)
-#endif
+#define PAYLOAD_SIZE_BATTERY 2
 
 // Orden del payload: Batería, pH, Temperatura exterior, Temperatura 1m, Humedad, Presión
 #define PAYLOAD_SIZE_BYTES ( \
@@ -178,12 +253,22 @@
     PAYLOAD_SIZE_PRESSURE \
 )
 
-// Valores de error para lecturas fallidas
-#define SENSOR_ERROR_TEMPERATURE -999.0f
-#define SENSOR_ERROR_HUMIDITY -1.0f
-#define SENSOR_ERROR_PRESSURE -1.0f
-#define SENSOR_ERROR_BATTERY -1.0f
-#define SENSOR_ERROR_PH -1.0f
+// Unidades de sensor_data_t: enteros escalados (sin float en la ruta de datos)
+#define SENSOR_SCALE_TEMPERATURE 100  // Centésimas de °C por °C
+#define SENSOR_SCALE_HUMIDITY 100     // Centésimas de % por %
+#define SENSOR_SCALE_PRESSURE 100     // Pa por hPa
+#define SENSOR_SCALE_PH 100           // Centésimas de pH por unidad de pH
+#define SENSOR_SCALE_BATTERY 1000     // mV por V
+
+// Bits de validez de sensor_data_t (sustituyen a los valores de error)
+#define SENSOR_FIELD_TEMPERATURE    (1 << 0)
+#define SENSOR_FIELD_HUMIDITY       (1 << 1)
+#define SENSOR_FIELD_PRESSURE       (1 << 2)
+#define SENSOR_FIELD_TEMPERATURE_1M (1 << 3)
+#define SENSOR_FIELD_PH             (1 << 4)
+#define SENSOR_FIELD_BATTERY        (1 << 5)
+#define SENSOR_FIELDS_SENSORS       (SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY | SENSOR_FIELD_PRESSURE | \
+                                     SENSOR_FIELD_TEMPERATURE_1M | SENSOR_FIELD_PH)
 
 // =============================================================================
 // ESTRUCTURAS DE DATOS PARA SENSORES (MODIFICABLES POR EL USUARIO)
@@ -195,16 +280,21 @@
 
 /**
  * @brief Estructura que contiene todas las lecturas del sensor
+ *
+ * Todos los campos son int32_t en las unidades SENSOR_SCALE_* (el codec del
+ * payload los lee por offsetof()). Un campo solo tiene lectura si su bit
+ * SENSOR_FIELD_* está activo en valid_mask.
+ *
  * @note MODIFICA esta estructura al añadir nuevos tipos de datos de sensores
  */
 typedef struct {
-    float temperature;        /**< Temperatura exterior en °C (BME280) */
-    float humidity;           /**< Humedad relativa en % (BME280) */
-    float pressure;           /**< Presión atmosférica en hPa (BME280) */
-    float temperature_1m;     /**< Temperatura a 1m de profundidad en °C (DS18B20) */
-    float ph;                 /**< Valor de pH */
-    float battery;            /**< Voltaje de batería en V */
-    bool valid;               /**< true si todas las lecturas son válidas */
+    int32_t temperature;      /**< Temperatura exterior en centésimas de °C (BME280) */
+    int32_t humidity;         /**< Humedad relativa en centésimas de % (BME280) */
+    int32_t pressure;         /**< Presión atmosférica en Pa (BME280) */
+    int32_t temperature_1m;   /**< Temperatura a 1m de profundidad en centésimas de °C (DS18B20) */
+    int32_t ph;               /**< pH en centésimas */
+    int32_t battery;          /**< Voltaje de batería en mV */
+    uint8_t valid_mask;       /**< Campos con lectura válida (SENSOR_FIELD_*) */
 } sensor_data_t;
 
 /**
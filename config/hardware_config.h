@@ -220,7 +220,7 @@
 
 // Pin para sensor de pH (ADC)
 #ifndef PH_ANALOG_PIN
-#define PH_ANALOG_PIN 25
+#define PH_ANALOG_PIN 36
 #endif
 
 // Pin para sensor de temperatura de electrónica (ADC)
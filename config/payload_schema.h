@@ -0,0 +1,55 @@
+#ifndef PAYLOAD_SCHEMA_H
+#define PAYLOAD_SCHEMA_H
+
+// =============================================================================
+// ESQUEMA DEL PAYLOAD (ÚNICA FUENTE PARA CODIFICADOR Y DECODER TTN)
+// =============================================================================
+// Cada campo se cuantiza como round((valor - mínimo) * escala) + 1 y se
+// empaqueta con los bits justos para su rango; el código 0 indica que no hay
+// lectura válida (valor fuera de rango o sensor en error). El decoder
+// JavaScript que imprime ttn_decoder_generator.cpp se genera a partir de esta
+// misma tabla, así que añadir, quitar o cambiar un campo aquí basta para
+// mantener ambos lados de acuerdo.
+//
+// Bits delta: en las tramas por lotes cada registro se codifica respecto al
+// anterior; si la diferencia cabe en este número de bits (con signo) se envía
+// la diferencia, si no el valor completo.
+//
+// Solo se incluye desde payload_codec.cpp.
+
+#include <stddef.h>
+
+// PAYLOAD_FIELD(nombre en el decoder, campo de sensor_data_t, bit de validez,
+//               unidades del campo por unidad física (SENSOR_SCALE_*), escala, mínimo, máximo, bits delta)
+// Las unidades del campo deben ser múltiplo de la escala del payload: el
+// codificador solo resta raw_min y divide por raw_step (1 si coinciden).
+#define PAYLOAD_FIELD(name, member, bit, unit, scale, min, max, delta) \
+    { name, offsetof(sensor_data_t, member), bit, scale, min, max, delta, \
+      (int32_t)((min) * (unit) + ((min) < 0 ? -0.5f : 0.5f)), \
+      (int32_t)((float)(unit) / (scale) + 0.5f), \
+      (uint16_t)(((max) - (min)) * (scale) + 0.5f) + 1 }
+
+static const payload_field_t PAYLOAD_SCHEMA[] = {
+#ifdef BATTERY_AS_PERCENTAGE
+    // payload_codec_quantize() convierte los mV a % antes de cuantizar
+    PAYLOAD_FIELD("battery_percent",      battery,        SENSOR_FIELD_BATTERY,        1,   1.0f,   0.0f,   100.0f,  3),
+#else
+    PAYLOAD_FIELD("battery_voltage",      battery,        SENSOR_FIELD_BATTERY,        SENSOR_SCALE_BATTERY,     100.0f, 2.5f, 4.5f, 4),
+#endif
+#ifdef ENABLE_SENSOR_PH
+    PAYLOAD_FIELD("ph",                   ph,             SENSOR_FIELD_PH,             SENSOR_SCALE_PH,          100.0f, PH_MIN, PH_MAX, 6),
+#endif
+#ifdef ENABLE_SENSOR_BME280
+    PAYLOAD_FIELD("temperature_ext",      temperature,    SENSOR_FIELD_TEMPERATURE,    SENSOR_SCALE_TEMPERATURE, 100.0f, TEMPERATURE_MIN, TEMPERATURE_MAX, 9),
+#endif
+#ifdef ENABLE_SENSOR_DS18B20
+    // Rango del agua, no el del sensor (-55..125 °C): ahorra 2 bits
+    PAYLOAD_FIELD("temperature_water_1m", temperature_1m, SENSOR_FIELD_TEMPERATURE_1M, SENSOR_SCALE_TEMPERATURE, 100.0f, -10.0f, 50.0f, 7),
+#endif
+#ifdef ENABLE_SENSOR_BME280
+    PAYLOAD_FIELD("humidity",             humidity,       SENSOR_FIELD_HUMIDITY,       SENSOR_SCALE_HUMIDITY,    100.0f, HUMIDITY_MIN, HUMIDITY_MAX, 9),
+    PAYLOAD_FIELD("pressure",             pressure,       SENSOR_FIELD_PRESSURE,       SENSOR_SCALE_PRESSURE,    10.0f,  PRESSURE_MIN, PRESSURE_MAX, 6),
+#endif
+};
+
+#endif // PAYLOAD_SCHEMA_H
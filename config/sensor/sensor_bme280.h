@@ -15,14 +15,18 @@
 #define BME280_I2C_ADDR_SECONDARY 0x77
 #define BME280_POWER_PIN 12
 #define BME280_POWER_ON_DELAY_MS 100
+#define BME280_SWITCHED_POWER false  // true: alimentado por BME280_POWER_PIN (gestor de rails)
 
 // Configuración del sensor
 #define BME280_SEA_LEVEL_PRESSURE 1013.25f
-#define BME280_MODE 3
-#define BME280_STANDBY 5
-#define BME280_FILTER 4
 #define BME280_SPI3W_EN 0
 
+// Sobremuestreo de la medida forzada: 1, 2, 4, 8 o 16 muestras
+// Recomendación Bosch para monitorización meteorológica: x1 / x1 / x1
+#define BME280_OVERSAMPLING_TEMPERATURE 1
+#define BME280_OVERSAMPLING_PRESSURE 1
+#define BME280_OVERSAMPLING_HUMIDITY 1
+
 // Rangos válidos
 #define TEMPERATURE_MIN -40.0f
 #define TEMPERATURE_MAX 85.0f
@@ -33,6 +37,5 @@
 
 // Configuración de lecturas
 #define BME280_READ_ATTEMPTS 3
-#define BME280_READ_DELAY_MS 100
 
 #endif // SENSOR_CONFIG_BME280_H
\ No newline at end of file
@@ -15,12 +15,15 @@
 #define DS18B20_POWER_ON_DELAY_MS 30000  // 30 segundos para estabilización de sensores
 
 // Configuración del sensor
-#define DS18B20_RESOLUTION 12  // 9-12 bits de resolución
-#define DS18B20_CONVERSION_DELAY_MS 750  // Tiempo de conversión para 12 bits
+// Precisión requerida en °C: se usa la resolución mínima que la cumple
+// 0.5 -> 9 bits (94 ms), 0.25 -> 10 bits (188 ms), 0.125 -> 11 bits (375 ms), 0.0625 -> 12 bits (750 ms)
+#define DS18B20_PRECISION_C 0.0625f
+#define DS18B20_POLL_INTERVAL_MS 25  // Intervalo de sondeo del fin de conversión
+#define DS18B20_CACHE_NVS true       // true: copia de la ROM en NVS (sobrevive a cortes de alimentación)
 
 // Rangos válidos
-#define DS18B20_TEMPERATURE_MIN -55.0f
-#define DS18B20_TEMPERATURE_MAX 125.0f
+#define DS18B20_TEMPERATURE_MIN -55  // °C
+#define DS18B20_TEMPERATURE_MAX 125  // °C
 
 // Configuración de lecturas
 #define DS18B20_READ_ATTEMPTS 3
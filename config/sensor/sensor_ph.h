@@ -8,15 +8,18 @@
 #define SENSOR_PH_HAS_PH true
 
 // Configuración hardware
-#define PH_ANALOG_PIN 25  // Pin ADC para sensor de pH DFRobot (GPIO25)
+#define PH_ANALOG_PIN 36  // Pin ADC para sensor de pH DFRobot (GPIO36/SENSOR_VP, ADC1)
+                          // ADC1: la ráfaga usa el modo continuo/DMA. GPIO25 no sirve
+                          // en el T3 V1.6: es BOARD_LED y setupBoards() lo pone como salida
 #ifndef PH_POWER_PIN
 #define PH_POWER_PIN 13   // Pin para controlar alimentación de sensores
 #endif
 #define PH_POWER_ON_DELAY_MS 30000  // 30 segundos para estabilización
 
-// Configuración del sensor DFRobot
-#define PH_REFERENCE_VOLTAGE 3.3f             // Voltaje de referencia ADC (3.3V para ESP32)
-#define PH_ADC_RESOLUTION 4096.0f             // Resolución ADC (12 bits = 4096 valores)
+// Configuración del ADC (ver ph_adc.h); tensión calibrada con eFuse
+#define PH_ADC_SAMPLES 256                    // Muestras por lectura (una ráfaga de pocos ms)
+#define PH_ADC_SAMPLE_FREQ_HZ 40000           // Frecuencia en modo continuo/DMA (solo ADC1, 20k-2M)
+#define PH_ADC_TRIM_PERCENT 10                // % descartado en cada extremo para la media recortada
 
 // Temperatura para compensación (se puede actualizar con sensor de temperatura)
 #define PH_DEFAULT_TEMPERATURE 25.0f          // Temperatura por defecto en °C
@@ -25,8 +28,4 @@
 #define PH_MIN 0.0f
 #define PH_MAX 14.0f
 
-// Configuración de lecturas
-#define PH_READ_SAMPLES 10  // Número de muestras para promediar
-#define PH_READ_DELAY_MS 20  // Delay entre muestras (mínimo 20ms recomendado)
-
 #endif // SENSOR_CONFIG_PH_H
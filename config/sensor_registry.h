@@ -0,0 +1,54 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+// =============================================================================
+// REGISTRO DE DRIVERS DE SENSORES
+// =============================================================================
+// Una entrada por sensor habilitado (ver sensor_driver_t en
+// sensor_interface.h). sensors_init_all(), sensors_read_all() y el resto del
+// agregador, así como la lista de sensores del decoder TTN, recorren esta
+// tabla: añadir un sensor es añadir su descriptor aquí y sus campos en
+// config/payload_schema.h.
+//
+// El orden importa cuando dos sensores están listos a la vez: el planificador
+// sigue el orden de la tabla, así que el pH (compensado con la temperatura
+// exterior) va detrás del BME280.
+//
+// Solo se incluye desde sensor.cpp.
+
+//   { nombre, descripción, capacidades, rail, estabilización (ms),
+//     init, is_available, retry_init, start, wait, read, set_available_for_testing }
+static const sensor_driver_t SENSOR_DRIVERS[] = {
+#ifdef ENABLE_SENSOR_BME280
+    { "BME280", "Temperatura exterior, Humedad, Presión",
+      SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY | SENSOR_FIELD_PRESSURE,
+#if BME280_SWITCHED_POWER
+      BME280_POWER_PIN, BME280_POWER_ON_DELAY_MS,
+#else
+      SENSOR_POWER_ALWAYS_ON, 0,
+#endif
+      sensor_bme280_init, sensor_bme280_is_available, sensor_bme280_retry_init,
+      sensor_bme280_start_measurement, NULL, sensor_bme280_read_measurement,
+      sensor_bme280_set_available_for_testing },
+#endif
+#ifdef ENABLE_SENSOR_DS18B20
+    { "DS18B20", "Temperatura agua 1m",
+      SENSOR_FIELD_TEMPERATURE_1M,
+      DS18B20_POWER_PIN, DS18B20_POWER_ON_DELAY_MS,
+      sensor_ds18b20_init, sensor_ds18b20_is_available, sensor_ds18b20_retry_init,
+      sensor_ds18b20_start_conversion, sensor_ds18b20_wait_conversion, sensor_ds18b20_read_conversion,
+      sensor_ds18b20_set_available_for_testing },
+#endif
+#ifdef ENABLE_SENSOR_PH
+    { "pH", "pH del agua, DFRobot",
+      SENSOR_FIELD_PH,
+      PH_POWER_PIN, PH_POWER_ON_DELAY_MS,
+      sensor_ph_init, sensor_ph_is_available, sensor_ph_retry_init,
+      NULL, NULL, sensor_ph_read_measurement,
+      sensor_ph_set_available_for_testing },
+#endif
+};
+
+#define SENSOR_DRIVER_COUNT (sizeof(SENSOR_DRIVERS) / sizeof(SENSOR_DRIVERS[0]))
+
+#endif // SENSOR_REGISTRY_H
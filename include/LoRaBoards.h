@@ -108,9 +108,11 @@ extern bool pmuInterrupt;
 void loopPMU(void (*pressed_cb)(void));
 bool beginPower();
 void disablePeripherals();
+bool armPmuPowerWakeup();
 #else
 #define beginPower()
 #define disablePeripherals()
+#define armPmuPowerWakeup() (false)
 #endif
 
 #ifdef DISPLAY_MODEL
@@ -143,18 +145,82 @@ void setupBLE();
 
 extern uint32_t deviceOnline;
 
+/**
+ * @brief Tipo de arranque según la causa del despertar (ver printWakeupReason()).
+ */
+typedef enum {
+    BOOT_MODE_COLD,     /**< Encendido o reset: diagnóstico completo */
+    BOOT_MODE_TIMER,    /**< Despertar por temporizador: ruta rápida */
+    BOOT_MODE_WAKEUP,   /**< Otro despertar (ext0/ext1, ULP, touch): diagnóstico completo */
+} boot_mode_t;
+
+/**
+ * @brief Clasifica el arranque actual con esp_sleep_get_wakeup_cause().
+ *
+ * @return Tipo de arranque.
+ */
+boot_mode_t getBootMode();
+
+/**
+ * @brief Indica si setupBoards() ha tomado la ruta rápida.
+ *        Solo en despertares por temporizador con FAST_BOOT_ON_TIMER y un
+ *        inventario de hardware válido en memoria RTC: sin información del
+ *        chip, escaneos I2C, prueba de la SD ni esperas de arranque.
+ *
+ * @return true si es un arranque rápido.
+ */
+bool isFastBoot();
+
+/**
+ * @brief Consulta el mapa del bus I2C principal del último arranque completo.
+ *
+ * @param addr Dirección I2C de 7 bits.
+ * @return true si el dispositivo respondió en el último escaneo.
+ */
+bool i2cDeviceCached(uint8_t addr);
+
+/**
+ * @brief Cierra un tramo del desglose del tiempo de arranque.
+ *
+ * @param step Nombre del tramo (cadena constante).
+ */
+void bootTimeMark(const char *step);
+
+/**
+ * @brief Imprime el desglose del tiempo de arranque.
+ *        En arranque completo guarda el total en memoria RTC para comparar
+ *        con los arranques rápidos siguientes.
+ */
+void printBootTimes();
+
 /**
  * @brief Lee el voltaje de batería de la forma más fiable disponible.
  *        Si hay PMU, usa el chip AXP192/AXP2101. Si no, usa el ADC y divisor resistivo.
  *        El voltaje máximo esperado es 4.2V (batería 18650 Li-Ion).
  *
+ * @return Voltaje de batería en mV (0 si no hay lectura válida).
+ */
+uint16_t readBatteryMillivolts();
+
+/**
+ * @brief Lee el voltaje de batería en voltios (ver readBatteryMillivolts()).
+ *
  * @return Voltaje de batería en voltios (float).
  */
 float readBatteryVoltage();
 
 /**
  * @brief Obtiene el porcentaje de batería estimado a partir del voltaje.
- *        3.3V = 0%, 4.1V = 100% (rango personalizado Li-Ion).
+ *        Curva OCV por tramos de una celda Li-Ion (3.0V = 0%, 4.15V = 100%).
+ *        Solo es fiable con la batería en reposo (ver battery_soc.h).
+ *
+ * @param millivolts Voltaje de batería en mV.
+ * @return Porcentaje estimado (0-100).
+ */
+uint8_t batteryPercentFromMillivolts(uint16_t millivolts);
+
+/**
+ * @brief Obtiene el porcentaje de batería estimado a partir del voltaje.
  *
  * @param voltage Voltaje de batería en voltios.
  * @return Porcentaje estimado (0-100).
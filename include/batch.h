@@ -0,0 +1,97 @@
+/**
+ * @file      batch.h
+ * @brief     Muestreo por lotes: buffer circular de registros en memoria RTC
+ *
+ * Desacopla la medición del envío: el nodo despierta cada intervalo
+ * (SEND_INTERVAL_SECONDS o el que decida scheduler.h), añade un registro al buffer (que sobrevive al
+ * sueño profundo) y solo cada BATCH_SAMPLES_PER_UPLINK despertares (o los
+ * fijados por downlink, ver remote_config.h) envía
+ * un uplink con varios registros, repartiendo la cabecera LoRaWAN, el MIC
+ * y las ventanas RX entre todas las muestras.
+ *
+ * Formato de la trama por lotes (FPort BATCH_FPORT):
+ * - Byte 0:    número de registros N en la trama
+ * - Byte 1:    registros más recientes que quedan en el buffer (no enviados)
+ * - Byte 2-3:  intervalo entre muestras en segundos (little-endian)
+ * - Byte 4...: N registros, del más antiguo al más reciente, empaquetados a
+ *              nivel de bit: el primero completo y el resto como deltas
+ *              respecto al anterior (ver payload_codec.h)
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "payload_codec.h"
+
+// Tamaño de la cabecera de la trama por lotes
+#define BATCH_HEADER_SIZE 4
+
+/**
+ * @brief Añade un registro al buffer circular
+ *
+ * Si el buffer está lleno se descarta el registro más antiguo.
+ *
+ * @param record Registro cuantizado
+ * @return true si se añadió el registro
+ */
+bool batch_add_record(const payload_record_t* record);
+
+/**
+ * @brief Número de registros pendientes de enviar
+ */
+uint8_t batch_count(void);
+
+/**
+ * @brief Indica si el lote está completo y toca enviar
+ */
+bool batch_uplink_due(void);
+
+/**
+ * @brief Muestras por uplink vigentes (BATCH_SAMPLES_PER_UPLINK o remote_config.h)
+ */
+uint8_t batch_samples_per_uplink(void);
+
+/**
+ * @brief Indica si este ciclo envía una trama por lotes
+ *
+ * Con una muestra por uplink se envía la trama simple (FPort 1), salvo que
+ * queden registros en el buffer de cuando había lotes.
+ */
+bool batch_enabled(void);
+
+/**
+ * @brief Construye una trama por lotes con los registros más antiguos
+ *
+ * @param buffer   Buffer de salida
+ * @param max_size Tamaño máximo de la trama (según el DR actual)
+ * @param records  Número de registros incluidos en la trama
+ * @return Número de bytes escritos (0 si no hay registros o no caben)
+ */
+uint8_t batch_build_frame(uint8_t* buffer, uint8_t max_size, uint8_t* records);
+
+/**
+ * @brief Elimina del buffer los registros ya enviados
+ *
+ * @param records Número de registros enviados (los más antiguos)
+ */
+void batch_commit(uint8_t records);
+
+/**
+ * @brief Tamaño máximo de payload de aplicación para un DR (EU868)
+ *
+ * Descuenta los FOpts que LMIC añadirá al próximo uplink
+ * (uplink_planner_fopts_size()): llamar después de link_controller_apply(),
+ * que puede pedir un LinkCheckReq.
+ *
+ * @param datarate DR de LMIC (DR_SF12 ... DR_FSK)
+ * @return Bytes de payload disponibles
+ */
+uint8_t batch_max_frame_size(uint8_t datarate);
+
+#endif // BATCH_H
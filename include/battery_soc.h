@@ -0,0 +1,87 @@
+/**
+ * @file      battery_soc.h
+ * @brief     Telemetría del PMU y estimación del estado de carga de la batería
+ *
+ * Toda la telemetría del PMU (tensión de batería y VBUS, corriente, estado
+ * de carga y temperatura del chip) se obtiene con una lectura en ráfaga por
+ * bloque de registros, en lugar de una transacción I2C por cada getter de
+ * XPowersLib.
+ *
+ * El estado de carga (SoC) se estima según lo que ofrezca la placa:
+ * - AXP2101: medidor de combustible interno (registro 0xA4)
+ * - AXP192: contador de culombios, anclado a la curva OCV en reposo y a
+ *   100 % al terminar la carga; se re-ancla si se desvía más de
+ *   BATTERY_SOC_MAX_DRIFT puntos de la curva
+ * - Solo ADC: curva OCV por tramos (batteryPercentFromMillivolts()) sobre
+ *   la tensión en reposo medida al despertar, antes de encender la radio y
+ *   los sensores
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef BATTERY_SOC_H
+#define BATTERY_SOC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Temperatura del PMU no disponible
+#define BATTERY_TEMP_UNKNOWN INT16_MIN
+
+/**
+ * @brief Origen de la estimación del estado de carga
+ */
+typedef enum {
+    BATTERY_SOC_NONE,     /**< Sin lectura de batería */
+    BATTERY_SOC_GAUGE,    /**< Medidor de combustible del AXP2101 */
+    BATTERY_SOC_COULOMB,  /**< Contador de culombios del AXP192 */
+    BATTERY_SOC_OCV       /**< Curva OCV sobre la tensión en reposo */
+} battery_soc_source_t;
+
+/**
+ * @brief Última telemetría del PMU y estado de carga estimado
+ */
+typedef struct {
+    uint16_t battery_mv;     /**< Tensión de batería (0 = sin lectura) */
+    uint16_t vbus_mv;        /**< Tensión de VBUS (0 = ausente o no medida) */
+    int16_t  current_ma;     /**< Corriente de batería, >0 cargando (0 si el PMU no la mide) */
+    int16_t  die_temp_c10;   /**< Temperatura del PMU en décimas de °C */
+    int32_t  coulomb_uah;    /**< Carga neta del contador de culombios (µAh, 0 sin contador) */
+    uint8_t  soc_percent;    /**< Estado de carga (0-100 %) */
+    uint8_t  soc_source;     /**< battery_soc_source_t */
+    bool     battery_present;
+    bool     vbus;
+    bool     charging;
+} battery_status_t;
+
+/**
+ * @brief Primera lectura del ciclo, con la batería aún en reposo
+ *
+ * Llamar justo después de setupBoards(), antes de encender la radio y los
+ * sensores. En el AXP192 activa el contador de culombios si hace falta.
+ */
+void battery_soc_begin(void);
+
+/**
+ * @brief Vuelve a leer la telemetría y actualiza el estado de carga
+ *
+ * Con la curva OCV el estado de carga se mantiene el del reposo: la
+ * tensión bajo carga lo subestimaría.
+ *
+ * @return true si hay lectura de batería
+ */
+bool battery_soc_update(void);
+
+/**
+ * @brief Último estado leído
+ */
+const battery_status_t* battery_status(void);
+
+/**
+ * @brief Nombre corto del origen de la estimación
+ */
+const char* battery_soc_source_name(uint8_t source);
+
+#endif // BATTERY_SOC_H
@@ -0,0 +1,73 @@
+/**
+ * @file      clock_drift.h
+ * @brief     Error de reloj de las ventanas RX según la deriva medida del
+ *            reloj lento RTC
+ *
+ * LMIC abre RX1 y RX2 a 1 s y 2 s del fin del uplink con hal_ticks(). Entre
+ * medias el ESP32 duerme en light sleep (LMIC_ESP32_LIGHT_SLEEP) y el tiempo
+ * se cuenta con el reloj lento RTC (RC de 150 kHz o cristal de 32 kHz)
+ * multiplicado por su calibración contra el cristal principal. El error de
+ * hal_ticks() es por tanto el de esa calibración, no el 1 % genérico.
+ *
+ * Antes de cada uplink se calibra el reloj lento contra el cristal
+ * (CLOCK_DRIFT_CAL_CYCLES ciclos) y la calibración nueva pasa a ser la que
+ * usa el light sleep. La variación entre la calibración de un uplink y la
+ * del siguiente (guardada en memoria RTC) mide cuánto puede moverse el
+ * reloj lento entre calibraciones; su envolvente, más la tolerancia del
+ * cristal (CLOCK_DRIFT_XTAL_PPM), por CLOCK_DRIFT_MARGIN, es el error que
+ * recibe LMIC_setClockError(), limitado a [CLOCK_DRIFT_MIN_PPM,
+ * CLOCK_DRIFT_MAX_PPM]. Sin dos calibraciones todavía se usa el máximo (1 %).
+ *
+ * La deriva no cubre un error fijo: el fin del uplink (txend) se marca al
+ * despertar del light sleep con la DIO de TX_DONE, tarde por lo que tarda en
+ * salir del sueño. Ese retardo (CLOCK_DRIFT_WAKE_LATENCY_US) se suma como
+ * ppm sobre el retardo de RX1 (LMIC.rxDelay), la ventana más corta, hasta el
+ * máximo. CLOCK_DRIFT_MIN_PPM y CLOCK_DRIFT_WAKE_LATENCY_US solo deben
+ * bajarse tras comprobar en el hardware la llegada de los downlinks en el
+ * log de rxOffset.
+ *
+ * Un uplink confirmado sin ningún downlink duplica el error aplicado en los
+ * siguientes uplinks (hasta el máximo) por si la ventana se quedó corta; el
+ * primer downlink lo devuelve a la estimación.
+ *
+ * Al completar cada transacción se muestra el tiempo con las ventanas RX
+ * abiertas (LMIC.rxOnTime, medido por la radio) y, si hubo downlink, su
+ * llegada respecto a la prevista (LMIC.rxOffset): "RX: N ms de ventana, ...".
+ * Ambos incluyen el retardo en despertar del light sleep con la DIO, así
+ * que son cotas superiores.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef CLOCK_DRIFT_H
+#define CLOCK_DRIFT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Aplica a LMIC el error de reloj de la última estimación
+ *
+ * Llamar en setupLMIC() tras LMIC_reset(), antes del join o de restaurar la
+ * sesión.
+ */
+void clock_drift_begin(void);
+
+/**
+ * @brief Calibra el reloj lento y ajusta el error de reloj del próximo uplink
+ *
+ * Llamar justo antes de LMIC_setTxData2(). Pone a cero LMIC.rxOnTime.
+ */
+void clock_drift_apply(void);
+
+/**
+ * @brief Registra el resultado de las ventanas RX del uplink de datos
+ *
+ * @param confirmed  true si el uplink se envió como confirmado
+ * @param txrx_flags Valor de LMIC.txrxFlags al completar la transmisión
+ */
+void clock_drift_on_tx_complete(bool confirmed, uint8_t txrx_flags);
+
+#endif // CLOCK_DRIFT_H
@@ -0,0 +1,89 @@
+/**
+ * @file      cpu_governor.h
+ * @brief     Frecuencia de la CPU según la fase del ciclo
+ *
+ * El ESP32 arranca a 240 MHz, pero casi todo el tiempo despierto se va en
+ * esperas (estabilización de sensores, sondeo de conversiones, bus I2C,
+ * SPI de la radio) que no dependen de la CPU. Tras setupBoards() el
+ * gobernador fija tres niveles:
+ * - Base (CPU_BASE_MHZ, 80 MHz): todo lo demás. A 80 MHz o más el APB
+ *   sigue a 80 MHz, así que el SPI de la radio (SPISettings a 10 MHz en
+ *   hal.cpp), el I2C y el baudrate de la UART no cambian
+ * - Ráfaga (CPU_BOOST_MHZ, 240 MHz): cpu_governor_boost()/
+ *   cpu_governor_unboost() alrededor del cálculo concentrado: composición
+ *   de la pantalla y construcción y cifrado de la trama. Se anidan
+ * - Espera (CPU_WAIT_MHZ, 40 MHz): cpu_governor_delay() en las esperas
+ *   activas de al menos CPU_WAIT_MIN_MS sin ráfaga abierta. Por debajo de
+ *   80 MHz el APB baja con la CPU: Arduino reajusta el divisor de la UART
+ *   (el vaciado de logger.h se detiene durante el cambio) y el SPI
+ *   recalcula el suyo en cada SPI.beginTransaction(). El I2C no se
+ *   reajusta, por eso durante la espera no debe haber tráfico en el bus
+ *
+ * Las esperas largas de sensores y de las ventanas RX ya se hacen en light
+ * sleep (power_rail_wait_until() y hal_sleepUntil()); el gobernador cubre
+ * el resto del tiempo despierto. cpu_governor_report() imprime el tiempo
+ * del ciclo a cada frecuencia antes del sueño profundo.
+ *
+ * Con CPU_GOVERNOR false la CPU se queda a 240 MHz y las funciones solo
+ * esperan o no hacen nada, para comparar el consumo con y sin gobernador.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef CPU_GOVERNOR_H
+#define CPU_GOVERNOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Niveles de frecuencia del gobernador
+ */
+typedef enum {
+    CPU_LEVEL_WAIT,   /**< CPU_WAIT_MHZ */
+    CPU_LEVEL_BASE,   /**< CPU_BASE_MHZ */
+    CPU_LEVEL_BOOST,  /**< CPU_BOOST_MHZ (y el arranque antes de cpu_governor_begin()) */
+    CPU_LEVEL_COUNT
+} cpu_level_t;
+
+/**
+ * @brief Baja la CPU a la frecuencia base
+ *
+ * Llamar después de setupBoards(); el tiempo anterior cuenta como ráfaga.
+ */
+void cpu_governor_begin(void);
+
+/**
+ * @brief Abre una ráfaga de cálculo a CPU_BOOST_MHZ (anidable)
+ */
+void cpu_governor_boost(void);
+
+/**
+ * @brief Cierra una ráfaga; con la última se vuelve a la frecuencia base
+ */
+void cpu_governor_unboost(void);
+
+/**
+ * @brief delay() a CPU_WAIT_MHZ si es largo y no hay ráfaga abierta
+ *
+ * No usar con tráfico I2C en curso (ver la descripción del módulo).
+ *
+ * @param ms Milisegundos de espera
+ */
+void cpu_governor_delay(uint32_t ms);
+
+/**
+ * @brief Frecuencia actual de la CPU en MHz
+ */
+uint32_t cpu_governor_mhz(void);
+
+/**
+ * @brief Imprime el tiempo del ciclo a cada frecuencia
+ *
+ * Llamar justo antes del sueño profundo.
+ */
+void cpu_governor_report(void);
+
+#endif // CPU_GOVERNOR_H
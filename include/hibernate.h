@@ -0,0 +1,95 @@
+/**
+ * @file      hibernate.h
+ * @brief     Hibernación por batería baja con despertar al volver la carga solar
+ *
+ * Con el estado de carga por debajo de HIBERNATE_SOC_PERCENT y sin VBUS, el
+ * nodo deja de despertar cada intervalo para medir y transmitir (lo que
+ * acabaría en brownout y podría corromper el estado). En su lugar:
+ * - Envía un único aviso por HIBERNATE_FPORT (ver hibernate_build_notice())
+ *   en lugar del uplink de datos del ciclo; la muestra queda en el lote
+ * - Apaga la radio, los rails de los sensores, las salidas del PMU y sus
+ *   bloques de medida (disablePeripherals())
+ * - Duerme con despertar por la interrupción del PMU en PMU_IRQ (ext0),
+ *   armada solo para entrada de VBUS e inicio de carga
+ *   (armPmuPowerWakeup()), y un temporizador de respaldo de
+ *   HIBERNATE_WAKE_HOURS
+ *
+ * En cada despertar, hibernate_on_wake() decide si se sale: con VBUS o
+ * cargando, o con al menos HIBERNATE_RESUME_SOC_PERCENT. Si no, se vuelve
+ * a dormir sin inicializar la radio ni LMIC.
+ *
+ * Tras un reset por brownout con la batería baja se hiberna directamente,
+ * sin aviso: no hay energía para un join.
+ *
+ * Con contador de culombios (AXP192) se mide el consumo medio durante la
+ * hibernación y se envía en el siguiente aviso.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef HIBERNATE_H
+#define HIBERNATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Versión del formato del aviso de hibernación
+#define HIBERNATE_NOTICE_VERSION 1
+
+/// Tamaño del aviso de hibernación
+#define HIBERNATE_NOTICE_SIZE 7
+
+/// Consumo medio en hibernación aún no medido
+#define HIBERNATE_CURRENT_UNKNOWN 0xFFFF
+
+/**
+ * @brief Indica si la batería está por debajo del umbral de hibernación
+ *
+ * Sin VBUS ni carga y con lectura de batería válida.
+ */
+bool hibernate_should_enter(void);
+
+/**
+ * @brief Decide al despertar si hay que seguir (o empezar a) hibernar
+ *
+ * Llamar después de battery_soc_begin(). Si el nodo hibernaba y la batería
+ * se ha recuperado, sale de la hibernación e informa del consumo medido.
+ *
+ * @return true si hay que volver a dormir con startHibernation()
+ */
+bool hibernate_on_wake(void);
+
+/**
+ * @brief Indica si el nodo está hibernando
+ */
+bool hibernate_active(void);
+
+/**
+ * @brief Construye el aviso de entrada en hibernación
+ *
+ * Formato (little-endian):
+ * - Byte 0:   versión (HIBERNATE_NOTICE_VERSION)
+ * - Byte 1:   estado de carga (%)
+ * - Bytes 2-3: tensión de batería (mV)
+ * - Byte 4:   horas del temporizador de respaldo
+ * - Bytes 5-6: consumo medio de la última hibernación (µA,
+ *              HIBERNATE_CURRENT_UNKNOWN si no se pudo medir)
+ *
+ * @param buffer Destino (al menos HIBERNATE_NOTICE_SIZE bytes)
+ * @return Bytes escritos
+ */
+uint8_t hibernate_build_notice(uint8_t* buffer);
+
+/**
+ * @brief Marca el inicio (o la continuación) de la hibernación
+ *
+ * Guarda el instante y la carga del contador de culombios para medir el
+ * consumo. El despertar por el PMU lo programa startDeepSleep().
+ *
+ * @return Segundos del temporizador de respaldo
+ */
+uint32_t hibernate_prepare_sleep(void);
+
+#endif // HIBERNATE_H
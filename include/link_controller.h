@@ -0,0 +1,71 @@
+/**
+ * @file      link_controller.h
+ * @brief     Control de DR y potencia de TX según el margen del enlace
+ *
+ * El nodo mide el enlace con lo que ya le llega de la red:
+ * - LinkCheckAns: margen de demodulación del uplink en el gateway. Se pide
+ *   con LMIC_requestLinkCheck() cada LINK_CONTROLLER_CHECK_EVERY uplinks y
+ *   en todos mientras haya pérdidas
+ * - SNR de los downlinks recibidos en RX1 (ACKs incluidos): SNR del uplink
+ *   estimado por reciprocidad, con LINK_CONTROLLER_GW_TX_DBM como potencia
+ *   del gateway
+ *
+ * Cada medida se normaliza a la SNR que tendría el uplink a la potencia
+ * máxima y se guarda en un histórico en memoria RTC. Con la media y la
+ * dispersión del histórico se estima la probabilidad de entrega de cada
+ * combinación de DR (SF12 ... SF7) y potencia (14, 11, 8, 5, 2 dBm) y se
+ * elige la de menor carga por trama entregada: carga fija del ciclo
+ * (LINK_CONTROLLER_CYCLE_UC) más tiempo en el aire por corriente de TX,
+ * dividido por la probabilidad de entrega.
+ *
+ * Una comprobación sin respuesta (LinkCheckReq o uplink confirmado sin
+ * ningún downlink) entra en el histórico como medida censurada en el suelo
+ * de demodulación del DR usado, y activa una escalera: la primera sube a
+ * la potencia máxima y cada LINK_CONTROLLER_MISSED_STEP seguidas más bajan
+ * un DR, hasta SF12. La primera respuesta devuelve la elección al modelo;
+ * si la escalera llegó a bajar el DR, el histórico se vacía (el enlace ha
+ * cambiado).
+ *
+ * Con LINK_CONTROLLER_ADR el DR y la potencia los decide el ADR de la red
+ * (LinkADRReq) y el nodo solo mantiene el histórico, el ADRACKReq de LMIC
+ * y la escalera ante pérdidas. La política (modelo, ADR o un DR fijo a la
+ * potencia máxima) se puede cambiar por downlink (ver remote_config.h); el
+ * cambio a o desde ADR rige desde el siguiente arranque de LMIC.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef LINK_CONTROLLER_H
+#define LINK_CONTROLLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Configura el ADR y el link check de LMIC
+ *
+ * Llamar con la sesión ya establecida: tras session_restore() o EV_JOINED.
+ */
+void link_controller_begin(void);
+
+/**
+ * @brief Fija el DR y la potencia del próximo uplink
+ *
+ * Pide además un LinkCheckReq si toca. Llamar antes de dimensionar la
+ * trama y de consultar el presupuesto de duty cycle (uplink_planner.h).
+ *
+ * @param payload_size Bytes de payload previstos (para el tiempo en el aire)
+ */
+void link_controller_apply(uint8_t payload_size);
+
+/**
+ * @brief Recoge el resultado de la transacción del uplink de datos
+ *
+ * @param confirmed  true si el uplink se envió como confirmado
+ * @param txrx_flags Valor de LMIC.txrxFlags al completar la transmisión
+ */
+void link_controller_on_tx_complete(bool confirmed, uint8_t txrx_flags);
+
+#endif // LINK_CONTROLLER_H
@@ -0,0 +1,148 @@
+/**
+ * @file      logger.h
+ * @brief     Logs por Serial diferidos a un buffer circular, filtrados por nivel
+ *
+ * Serial.printf() a 115200 baudios bloquea ~87 us por carácter en cuanto se
+ * llena la FIFO de la UART: una línea de depuración cuesta milisegundos,
+ * demasiado dentro de onEvent() o entre la conversión de un sensor y su
+ * lectura. Los mensajes de este módulo se copian a un buffer circular en
+ * RAM y salen por Serial desde otra tarea:
+ * - Niveles en tiempo de compilación: con ENABLE_SERIAL_LOGS false o un
+ *   LOG_LEVEL inferior, las macros desaparecen (ni código ni argumentos)
+ * - LOG_INFO()/LOG_DEBUG() formatean con vsnprintf() al llamar (decenas
+ *   de us) y solo copian el texto
+ * - LOG_INFO_FAST()/LOG_DEBUG_FAST() no formatean: guardan el puntero al
+ *   formato y hasta LOGGER_DEFERRED_MAX_ARGS enteros de 32 bits, y el texto
+ *   se compone al vaciar. El formato debe ser un literal y solo admite
+ *   conversiones enteras de 32 bits (%d, %u, %lu, %X...), nunca %s ni %f
+ * - LOG_DEBUG_HEX() guarda los bytes de un buffer y los imprime en
+ *   hexadecimal al vaciar
+ *
+ * El buffer es de un solo productor sin bloqueos: solo se puede registrar
+ * desde la tarea de Arduino (setup(), loop() y los callbacks de LMIC que
+ * ejecuta), nunca desde una ISR. Si se llena, los mensajes nuevos se
+ * descartan y se cuenta cuántos.
+ *
+ * El buffer lo vacía una tarea de baja prioridad en el otro núcleo, y
+ * logger_flush() antes del sueño profundo. Alrededor de un light sleep,
+ * logger_suspend()/logger_resume() detienen el vaciado para no cortar una
+ * escritura en la UART; lo pendiente sale al despertar.
+ *
+ * Los volcados interactivos (comando PROFILE, decoder TTN) siguen usando
+ * Serial directamente tras logger_flush().
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <type_traits>
+#include "../config/config.h"  // ENABLE_SERIAL_LOGS, LOG_LEVEL
+
+/// Niveles de LOG_LEVEL
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_BASIC 1
+#define LOG_LEVEL_DETAILED 2
+
+/// Logs compilados
+#define LOGGER_ENABLED (ENABLE_SERIAL_LOGS && LOG_LEVEL > LOG_LEVEL_NONE)
+
+/// Argumentos enteros de un mensaje diferido
+#define LOGGER_DEFERRED_MAX_ARGS 4
+
+/// Bytes como máximo de un volcado LOG_DEBUG_HEX()
+#define LOGGER_HEX_MAX_BYTES 64
+
+// Marcadores: desaparecen al compilar por debajo de su nivel
+#if ENABLE_SERIAL_LOGS && LOG_LEVEL >= LOG_LEVEL_BASIC
+#define LOG_INFO(...) logger_printf(__VA_ARGS__)
+#define LOG_INFO_FAST(fmt, ...) logger_deferred(fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#define LOG_INFO_FAST(fmt, ...) ((void)0)
+#endif
+
+#if ENABLE_SERIAL_LOGS && LOG_LEVEL >= LOG_LEVEL_DETAILED
+#define LOG_DEBUG(...) logger_printf(__VA_ARGS__)
+#define LOG_DEBUG_FAST(fmt, ...) logger_deferred(fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_HEX(label, data, len) logger_hex(label, data, len)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#define LOG_DEBUG_FAST(fmt, ...) ((void)0)
+#define LOG_DEBUG_HEX(label, data, len) ((void)0)
+#endif
+
+/**
+ * @brief Arranca la tarea que vacía el buffer por Serial
+ *
+ * Llamar después de Serial.begin(). Lo registrado antes se conserva.
+ */
+void logger_begin(void);
+
+/**
+ * @brief Vacía el buffer y espera a que la UART termine de transmitir
+ *
+ * Llamar antes del sueño profundo o de escribir directamente en Serial.
+ */
+void logger_flush(void);
+
+/**
+ * @brief Detiene el vaciado y espera a que la UART termine de transmitir
+ *
+ * Llamar antes de esp_light_sleep_start(): la UART se para durante el
+ * light sleep. Espera como mucho a la entrada que la tarea esté escribiendo
+ * y a que se vacíe la FIFO de la UART, no a todo el buffer.
+ */
+void logger_suspend(void);
+
+/**
+ * @brief Reanuda el vaciado tras logger_suspend()
+ */
+void logger_resume(void);
+
+/**
+ * @brief Formatea un mensaje y lo copia al buffer (ver LOG_INFO())
+ */
+void logger_printf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Copia un mensaje diferido al buffer (ver logger_deferred())
+ */
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count);
+
+/**
+ * @brief Copia un volcado de bytes al buffer (ver LOG_DEBUG_HEX())
+ *
+ * @param label Literal que precede a los bytes
+ */
+void logger_hex(const char* label, const void* data, uint16_t len);
+
+/**
+ * @brief Convierte un argumento diferido a 32 bits
+ */
+template <typename T>
+static inline uint32_t logger_arg(T value) {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                  "LOG_*_FAST solo admite argumentos enteros");
+    static_assert(sizeof(T) <= sizeof(uint32_t), "LOG_*_FAST solo admite enteros de hasta 32 bits");
+    return (uint32_t)value;
+}
+
+/**
+ * @brief Mensaje diferido: el formato se aplica al vaciar el buffer
+ *
+ * @param fmt Literal de formato (se guarda el puntero, no el texto)
+ */
+template <typename... Args>
+static inline void logger_deferred(const char* fmt, Args... args) {
+    static_assert(sizeof...(Args) <= LOGGER_DEFERRED_MAX_ARGS, "LOG_*_FAST admite hasta 4 argumentos");
+    const uint32_t values[] = { logger_arg(args)..., 0 };
+    logger_push_deferred(fmt, values, sizeof...(Args));
+}
+
+#endif // LOGGER_H
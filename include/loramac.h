@@ -35,4 +35,24 @@ void setupLMIC(void);
  */
 void loopLMIC(void);
 
+/**
+ * @brief     Despertar en hibernación por batería baja (ver hibernate.h)
+ *
+ * Debe llamarse en setup() después de battery_soc_begin() y antes de
+ * runSampleOnlyCycle(). Mientras la batería no se recupere vuelve a
+ * hibernar sin inicializar la radio ni LMIC.
+ *
+ * @return    false si hay que continuar con el arranque normal
+ */
+bool runHibernationCheck(void);
 
+/**
+ * @brief     Despertar de solo medición (muestreo por lotes)
+ *
+ * Debe llamarse en setup() antes de setupLMIC(). Si el lote aún no está
+ * completo, guarda la muestra en memoria RTC y vuelve a sueño profundo
+ * sin inicializar la radio ni LMIC.
+ *
+ * @return    false si hay que continuar con el ciclo completo de envío
+ */
+bool runSampleOnlyCycle(void);
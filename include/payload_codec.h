@@ -0,0 +1,116 @@
+/**
+ * @file      payload_codec.h
+ * @brief     Codec compacto del payload basado en un esquema de campos
+ *
+ * Un único esquema (config/payload_schema.h) describe cada campo del
+ * payload: nombre, escala, rango y bits de delta. A partir de él:
+ * - El codificador cuantiza las lecturas y empaqueta cada campo con los bits
+ *   justos para su rango (MSB primero), con el código 0 reservado para
+ *   "sin lectura"
+ * - En las tramas por lotes, cada registro se codifica como delta respecto
+ *   al anterior (un bit por campo indica delta o valor completo)
+ * - ttn_decoder_generator.cpp genera el decoder JavaScript de TTN
+ *
+ * Las deltas solo se aplican dentro de una misma trama: los payload
+ * formatters de TTN no guardan estado entre uplinks, y una trama perdida
+ * rompería la cadena.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef PAYLOAD_CODEC_H
+#define PAYLOAD_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Número máximo de campos del esquema
+#define PAYLOAD_MAX_FIELDS 8
+
+/**
+ * @brief Descripción de un campo del payload
+ */
+typedef struct {
+    const char* name;     /**< Nombre del campo en el decoder TTN */
+    uint16_t offset;      /**< offsetof() del int32_t en sensor_data_t */
+    uint8_t valid_bit;    /**< Bit SENSOR_FIELD_* que indica lectura válida */
+    float scale;          /**< Factor de escala (p. ej. 100 = centésimas) */
+    float min;            /**< Valor mínimo representable */
+    float max;            /**< Valor máximo representable */
+    uint8_t delta_bits;   /**< Bits (con signo) de la delta en tramas por lotes */
+    int32_t raw_min;      /**< min en unidades de sensor_data_t */
+    int32_t raw_step;     /**< Unidades de sensor_data_t por código */
+    uint16_t max_code;    /**< Código del valor máximo (el 0 es "sin lectura") */
+} payload_field_t;
+
+/**
+ * @brief Registro cuantizado: un código por campo del esquema (0 = sin lectura)
+ */
+typedef struct {
+    uint16_t code[PAYLOAD_MAX_FIELDS];
+} payload_record_t;
+
+/**
+ * @brief Escritor de bits sobre un buffer (MSB primero)
+ */
+typedef struct {
+    uint8_t* buffer;      /**< Buffer de salida */
+    uint16_t max_bits;    /**< Capacidad del buffer en bits */
+    uint16_t bits;        /**< Bits escritos */
+} payload_bitwriter_t;
+
+/**
+ * @brief Número de campos del esquema activo
+ */
+uint8_t payload_codec_field_count(void);
+
+/**
+ * @brief Descripción del campo i del esquema
+ */
+const payload_field_t* payload_codec_field(uint8_t index);
+
+/**
+ * @brief Bits de un campo codificado como valor completo
+ */
+uint8_t payload_codec_field_bits(const payload_field_t* field);
+
+/**
+ * @brief Tamaño en bytes de un registro completo (sin delta)
+ */
+uint8_t payload_codec_record_size(void);
+
+/**
+ * @brief Cuantiza las lecturas de los sensores según el esquema
+ *
+ * Solo aritmética entera: código = (valor - raw_min) / raw_step + 1.
+ *
+ * @param data   Lecturas (campos sin bit de validez o fuera de rango = sin lectura)
+ * @param record Registro cuantizado de salida
+ */
+void payload_codec_quantize(const sensor_data_t* data, payload_record_t* record);
+
+/**
+ * @brief Inicializa un escritor de bits
+ */
+void payload_codec_writer_init(payload_bitwriter_t* writer, uint8_t* buffer, uint8_t max_size);
+
+/**
+ * @brief Añade un registro al flujo de bits
+ *
+ * @param writer Escritor de bits
+ * @param record Registro a codificar
+ * @param prev   Registro anterior de la trama para codificar deltas, o
+ *               NULL para codificar todos los campos completos
+ * @return false si el registro no cabe (el escritor no se modifica)
+ */
+bool payload_codec_write_record(payload_bitwriter_t* writer, const payload_record_t* record,
+                                const payload_record_t* prev);
+
+/**
+ * @brief Bytes ocupados por el flujo de bits (redondeando hacia arriba)
+ */
+uint8_t payload_codec_writer_bytes(const payload_bitwriter_t* writer);
+
+#endif // PAYLOAD_CODEC_H
@@ -0,0 +1,63 @@
+/**
+ * @file      ph_adc.h
+ * @brief     Adquisición calibrada del ADC para el sensor de pH
+ *
+ * Toma una ráfaga de PH_ADC_SAMPLES muestras (o las fijadas con
+ * ph_adc_set_samples()) en pocos milisegundos en lugar de unas pocas
+ * lecturas separadas por delay():
+ * - Pin en ADC1 (GPIO36 por defecto): modo continuo (DMA) a
+ *   PH_ADC_SAMPLE_FREQ_HZ; la tarea queda bloqueada en la cola del DMA
+ *   mientras se llena el buffer.
+ * - Pin en ADC2 (p. ej. GPIO4): ráfaga de lecturas one-shot, ya que el modo
+ *   DMA del ESP32 solo admite ADC1. ADC2 no se puede leer con Wi-Fi activo.
+ *
+ * Las muestras se convierten a mV con la calibración de eFuse del chip
+ * (esp_adc_cal: Two Point o Vref) y se filtran con mediana y media
+ * recortada; se devuelven también estadísticas de ruido.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef PH_ADC_H
+#define PH_ADC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Resultado de una ráfaga de muestras del ADC
+ */
+typedef struct {
+    float voltage_mv;     /**< Media recortada calibrada (mV) */
+    float median_mv;      /**< Mediana calibrada (mV) */
+    float noise_mv;       /**< Desviación típica de las muestras conservadas (mV) */
+    float span_mv;        /**< Rango pico a pico de todas las muestras (mV) */
+    uint16_t samples;     /**< Muestras válidas obtenidas */
+    uint32_t duration_us; /**< Duración de la ráfaga */
+} ph_adc_result_t;
+
+/**
+ * @brief Comprueba el pin, configura el canal y carga la calibración de eFuse
+ *
+ * @return false si PH_ANALOG_PIN no es un pin ADC utilizable
+ */
+bool ph_adc_init(void);
+
+/**
+ * @brief Fija el número de muestras de las siguientes ráfagas
+ *
+ * @param samples Muestras por ráfaga (1 ... PH_ADC_SAMPLES; 0 = PH_ADC_SAMPLES)
+ */
+void ph_adc_set_samples(uint16_t samples);
+
+/**
+ * @brief Toma una ráfaga de muestras y calcula tensión y ruido
+ *
+ * @param result Resultado de la adquisición
+ * @return true si se obtuvieron muestras válidas
+ */
+bool ph_adc_acquire(ph_adc_result_t* result);
+
+#endif // PH_ADC_H
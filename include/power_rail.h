@@ -0,0 +1,88 @@
+/**
+ * @file      power_rail.h
+ * @brief     Gestor de rails de alimentación conmutados de los sensores
+ *
+ * Varios sensores comparten el mismo pin de alimentación (el DS18B20 y el
+ * sensor de pH cuelgan ambos de GPIO13). En lugar de que cada driver
+ * encienda y apague el pin por su cuenta, cada uno solicita el rail que
+ * necesita junto con su tiempo de estabilización:
+ * - El rail se enciende con el primer usuario y se apaga cuando lo libera
+ *   el último (conteo de referencias).
+ * - Se registra el instante de encendido, de modo que un segundo usuario
+ *   no vuelve a pagar la estabilización ya transcurrida.
+ * - Cada solicitud devuelve el instante "listo a" (millis) de ese usuario;
+ *   la espera se hace con power_rail_wait_until(), que duerme la CPU en
+ *   light sleep si la espera es larga. millis() se basa en esp_timer y
+ *   sigue contando durante el light sleep.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef POWER_RAIL_H
+#define POWER_RAIL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Número máximo de rails distintos gestionados
+#define POWER_RAIL_MAX 4
+
+/**
+ * @brief Solicita un rail de alimentación y lo enciende si estaba apagado
+ *
+ * @param pin GPIO que conmuta el rail
+ * @param warmup_ms Tiempo de estabilización que necesita este usuario
+ * @return Instante (millis) a partir del cual el rail está estable para él
+ */
+uint32_t power_rail_acquire(uint8_t pin, uint32_t warmup_ms);
+
+/**
+ * @brief Libera un rail; se apaga cuando lo libera su último usuario
+ *
+ * @param pin GPIO que conmuta el rail
+ */
+void power_rail_release(uint8_t pin);
+
+/**
+ * @brief Apaga todos los rails registrados y los retiene a nivel bajo
+ *
+ * Sin retención los pines quedan flotando en sueño profundo. La retención
+ * sigue al despertar hasta que power_rail_acquire() vuelve a encender el
+ * rail.
+ */
+void power_rail_shutdown(void);
+
+/**
+ * @brief Indica si un rail está encendido
+ */
+bool power_rail_is_on(uint8_t pin);
+
+/**
+ * @brief Instante (millis) en que el rail estará estable para un tiempo dado
+ *
+ * @return 0 si el rail está apagado
+ */
+uint32_t power_rail_ready_at(uint8_t pin, uint32_t warmup_ms);
+
+/**
+ * @brief Espera hasta un instante (millis), en light sleep si es largo
+ *
+ * Los pines de alimentación mantienen su nivel durante el light sleep, así
+ * que los sensores siguen estabilizándose o convirtiendo mientras la CPU
+ * duerme (ver SENSOR_WAIT_LIGHT_SLEEP).
+ *
+ * @param deadline_ms Instante objetivo en millis()
+ */
+void power_rail_wait_until(uint32_t deadline_ms);
+
+/**
+ * @brief Tiempo acumulado en light sleep por power_rail_wait_until()
+ *
+ * @param reset true para poner el contador a cero tras leerlo
+ * @return Milisegundos en light sleep
+ */
+uint32_t power_rail_slept_ms(bool reset);
+
+#endif // POWER_RAIL_H
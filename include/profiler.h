@@ -0,0 +1,163 @@
+/**
+ * @file      profiler.h
+ * @brief     Perfil de tiempo y carga por fase del ciclo, acumulado en memoria RTC
+ *
+ * Cada fase del ciclo (arranque, LMIC, sensores, join, TX, ventanas RX,
+ * pantalla) se delimita con PHASE_BEGIN()/PHASE_END(), que leen
+ * esp_timer_get_time(). Al entrar en sueño profundo, profiler_cycle_end()
+ * vuelca las duraciones del ciclo a un histograma en memoria RTC que se
+ * acumula entre ciclos:
+ * - Por fase: ciclos en los que se ejecutó, tiempo total y máximo, carga
+ *   estimada y un histograma de duraciones en tramos x4 (16 ms ... 64 s)
+ * - La carga se estima con la corriente nominal de cada fase o, en placas
+ *   con PMU AXP192, con la corriente de descarga de batería medida al
+ *   principio y al final de la fase. El tiempo en light sleep dentro de una
+ *   fase se cuenta a PROFILER_LIGHT_SLEEP_UA.
+ *
+ * Cada PROFILER_REPORT_EVERY ciclos se envía un resumen por el FPort
+ * PROFILER_FPORT (ver profiler_build_report()) y se reinicia la ventana.
+ * Escribiendo PROFILE por Serial se imprime el histograma completo.
+ *
+ * Las fases pueden anidarse (p. ej. la inicialización de sensores dentro de
+ * la configuración de LMIC); PROFILER_PHASE_AWAKE es el total del ciclo.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Fases medidas del ciclo
+ */
+typedef enum {
+    PROFILER_PHASE_BOOT,          /**< setupBoards() */
+    PROFILER_PHASE_LMIC_SETUP,    /**< setupLMIC() */
+    PROFILER_PHASE_SENSOR_INIT,   /**< sensors_init_all() */
+    PROFILER_PHASE_SENSORS,       /**< sensors_read_all(): estabilización y conversión */
+    PROFILER_PHASE_JOIN,          /**< Join OTAA hasta EV_JOINED / EV_JOIN_FAILED */
+    PROFILER_PHASE_TX,            /**< Tiempo en el aire del uplink */
+    PROFILER_PHASE_RX,            /**< Resto de la transacción: ventanas RX y esperas */
+    PROFILER_PHASE_DISPLAY,       /**< Pantalla OLED */
+    PROFILER_PHASE_AWAKE,         /**< Ciclo completo, del arranque al sueño profundo */
+    PROFILER_PHASE_COUNT
+} profiler_phase_t;
+
+/// Tramos del histograma de duraciones (x4 desde 16 ms)
+#define PROFILER_BUCKETS 8
+
+/// Versión del formato del uplink de diagnóstico
+#define PROFILER_REPORT_VERSION 1
+
+// Marcadores: desaparecen al compilar con ENABLE_PROFILER false
+#if ENABLE_PROFILER
+#define PHASE_BEGIN(phase) profiler_begin(phase)
+#define PHASE_END(phase) profiler_end(phase)
+#define PHASE_RECORD(phase, us) profiler_record(phase, us)
+#define PHASE_SLEEP(phase, us) profiler_add_sleep(phase, us)
+#else
+#define PHASE_BEGIN(phase) ((void)0)
+#define PHASE_END(phase) ((void)0)
+#define PHASE_RECORD(phase, us) ((void)0)
+#define PHASE_SLEEP(phase, us) ((void)0)
+#endif
+
+/**
+ * @brief Marca el inicio de una fase
+ */
+void profiler_begin(profiler_phase_t phase);
+
+/**
+ * @brief Marca el fin de una fase y acumula su duración en el ciclo
+ */
+void profiler_end(profiler_phase_t phase);
+
+/**
+ * @brief Acumula una duración medida por otros medios (p. ej. tiempo en el aire)
+ *
+ * @param phase Fase
+ * @param duration_us Duración en microsegundos (despierto)
+ */
+void profiler_record(profiler_phase_t phase, uint32_t duration_us);
+
+/**
+ * @brief Indica qué parte de una fase se pasó en light sleep
+ *
+ * @param phase Fase
+ * @param slept_us Tiempo en light sleep dentro de la fase
+ */
+void profiler_add_sleep(profiler_phase_t phase, uint32_t slept_us);
+
+/**
+ * @brief Cierra el ciclo: vuelca las fases al histograma RTC
+ *
+ * Llamar justo antes de entrar en sueño profundo.
+ */
+void profiler_cycle_end(void);
+
+/**
+ * @brief Nombre corto de una fase
+ */
+const char* profiler_phase_name(uint8_t phase);
+
+/**
+ * @brief Indica si toca enviar el uplink de diagnóstico en este ciclo
+ */
+bool profiler_report_due(void);
+
+/**
+ * @brief Aplaza el resumen al siguiente despertar con envío
+ *
+ * Tras el uplink de datos la banda queda ocupada 100 veces su tiempo en el
+ * aire (1 % de duty cycle): si la espera es larga el resumen no se encadena
+ * y sale solo en el siguiente ciclo.
+ */
+void profiler_report_defer(void);
+
+/**
+ * @brief Indica si el resumen aplazado debe salir como único uplink del ciclo
+ */
+bool profiler_report_deferred(void);
+
+/**
+ * @brief Construye el resumen para el uplink de diagnóstico
+ *
+ * Formato (FPort PROFILER_FPORT, little-endian):
+ * - Byte 0:   versión (PROFILER_REPORT_VERSION)
+ * - Byte 1:   número de fases N incluidas
+ * - Byte 2-3: ciclos de la ventana
+ * - N x 7 bytes: fase, duración media (ms), duración máxima (ms),
+ *   carga media por ciclo (µAh); valores saturados a 65535
+ * Solo se incluyen las fases que se ejecutaron; si no caben todas en
+ * max_size se omiten las últimas.
+ *
+ * @param buffer   Buffer de salida
+ * @param max_size Tamaño máximo (según el DR actual)
+ * @return Bytes escritos (0 si no cabe ni la cabecera)
+ */
+uint8_t profiler_build_report(uint8_t* buffer, uint8_t max_size);
+
+/**
+ * @brief Notifica que el resumen se ha enviado y reinicia la ventana
+ */
+void profiler_report_sent(void);
+
+/**
+ * @brief Imprime por Serial el histograma acumulado
+ */
+void profiler_dump(void);
+
+/**
+ * @brief Atiende el comando PROFILE recibido por Serial
+ *
+ * Solo consume la entrada si empieza por 'P', para no interferir con los
+ * comandos de calibración de pH (ENTERPH / CALPH / EXITPH).
+ */
+void profiler_process_serial(void);
+
+#endif // PROFILER_H
@@ -0,0 +1,166 @@
+/**
+ * @file      remote_config.h
+ * @brief     Ajustes de operación cambiados por downlink, guardados en NVS
+ *
+ * Los parámetros que antes exigían reprogramar el nodo se cambian con un
+ * downlink por REMOTE_CONFIG_FPORT. Los ajustes vigentes viven en memoria
+ * RTC y se copian a NVS en cada cambio, así que sobreviven a un corte de
+ * alimentación; sin nada guardado se usan los de config.h.
+ *
+ * Formato del downlink (little-endian):
+ * - Byte 0: versión del protocolo (REMOTE_CONFIG_VERSION)
+ * - Byte 1: número de secuencia, devuelto en la confirmación
+ * - Byte 2...: parámetros TLV (etiqueta, longitud, valor):
+ *   | Etiqueta | Long. | Valor                                              |
+ *   |----------|-------|----------------------------------------------------|
+ *   | 0x01     | 2     | Intervalo nominal en s (límites del planificador)  |
+ *   | 0x02     | 1     | Muestras por uplink (1 ... BATCH_BUFFER_RECORDS)   |
+ *   | 0x03     | 1     | Sensores activos: bit i = driver i del registro    |
+ *   | 0x04     | 1     | Resolución del DS18B20: 9-12 bits, 0 = config.h    |
+ *   | 0x05     | 2     | Muestras por lectura de pH, 0 = PH_ADC_SAMPLES     |
+ *   | 0x06     | 1-2   | Política de DR (remote_config_dr_policy_t) y DR    |
+ *   |          |       | fijo (DR_SF12 ... DR_SF7) con la política fija     |
+ *   | 0x7F     | 0     | Volver a config.h (antes de los TLV siguientes)    |
+ *
+ * El downlink se aplica entero o nada: una versión distinta, un TLV
+ * truncado, una etiqueta desconocida o un valor fuera de rango lo
+ * rechazan. Un downlink sin TLV solo pide la configuración vigente.
+ *
+ * Los ajustes rigen desde el siguiente ciclo (el intervalo, ya en el sueño
+ * que sigue). La confirmación sale por REMOTE_CONFIG_FPORT como único uplink
+ * del ciclo siguiente, en lugar del de datos (la muestra queda en el lote):
+ * - Byte 0: versión
+ * - Byte 1: secuencia del último downlink
+ * - Byte 2: resultado (remote_config_status_t)
+ * - Byte 3: etiqueta del TLV rechazado (0 si no hubo)
+ * - Byte 4...: configuración vigente completa, en los mismos TLV
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef REMOTE_CONFIG_H
+#define REMOTE_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Versión del protocolo de configuración
+#define REMOTE_CONFIG_VERSION 1
+
+/// Tamaño de la confirmación
+#define REMOTE_CONFIG_ACK_SIZE 25
+
+/**
+ * @brief Etiquetas de los parámetros TLV
+ */
+typedef enum {
+    REMOTE_CONFIG_TAG_INTERVAL     = 0x01,
+    REMOTE_CONFIG_TAG_BATCH        = 0x02,
+    REMOTE_CONFIG_TAG_SENSORS      = 0x03,
+    REMOTE_CONFIG_TAG_DS18B20_BITS = 0x04,
+    REMOTE_CONFIG_TAG_PH_SAMPLES   = 0x05,
+    REMOTE_CONFIG_TAG_DR_POLICY    = 0x06,
+    REMOTE_CONFIG_TAG_DEFAULTS     = 0x7F
+} remote_config_tag_t;
+
+/**
+ * @brief Resultado de un downlink de configuración
+ */
+typedef enum {
+    REMOTE_CONFIG_OK          = 0,
+    REMOTE_CONFIG_BAD_VERSION = 1,  /**< Versión del protocolo distinta */
+    REMOTE_CONFIG_MALFORMED   = 2,  /**< Trama corta, TLV truncado o longitud errónea */
+    REMOTE_CONFIG_UNKNOWN_TAG = 3,  /**< Etiqueta no soportada por este firmware */
+    REMOTE_CONFIG_BAD_VALUE   = 4   /**< Valor fuera de rango o sensor no compilado */
+} remote_config_status_t;
+
+/**
+ * @brief Política de DR y potencia (ver link_controller.h)
+ */
+typedef enum {
+    REMOTE_CONFIG_DR_MODEL = 0,  /**< Control de enlace del nodo */
+    REMOTE_CONFIG_DR_ADR   = 1,  /**< ADR de la red */
+    REMOTE_CONFIG_DR_FIXED = 2   /**< DR fijo a la potencia máxima */
+} remote_config_dr_policy_t;
+
+/**
+ * @brief Ajustes de operación
+ */
+typedef struct {
+    uint16_t send_interval_s;  /**< Intervalo nominal (SEND_INTERVAL_SECONDS) */
+    uint8_t  batch_samples;    /**< Muestras por uplink (BATCH_SAMPLES_PER_UPLINK) */
+    uint8_t  sensor_mask;      /**< Drivers activos del registro de sensores */
+    uint8_t  ds18b20_bits;     /**< Resolución del DS18B20 (0 = DS18B20_PRECISION_C) */
+    uint16_t ph_samples;       /**< Muestras por lectura de pH (0 = PH_ADC_SAMPLES) */
+    uint8_t  dr_policy;        /**< remote_config_dr_policy_t */
+    uint8_t  fixed_dr;         /**< DR con REMOTE_CONFIG_DR_FIXED */
+} remote_config_t;
+
+/**
+ * @brief Ajustes de config.h
+ */
+void remote_config_defaults(remote_config_t* config);
+
+/**
+ * @brief Aplica los TLV de un downlink sobre una configuración
+ *
+ * Sin efectos fuera de config: se puede probar en el host con tramas
+ * preparadas.
+ *
+ * @param data   Payload del downlink (versión, secuencia y TLV)
+ * @param len    Bytes del payload
+ * @param config Configuración de partida; solo se modifica si el
+ *               resultado es REMOTE_CONFIG_OK
+ * @param tag    Etiqueta del TLV rechazado (0 si no hubo), puede ser NULL
+ * @return Resultado
+ */
+remote_config_status_t remote_config_parse(const uint8_t* data, uint8_t len,
+                                           remote_config_t* config, uint8_t* tag);
+
+/**
+ * @brief Ajustes vigentes
+ *
+ * Al encender se leen de NVS (o de config.h si no hay nada válido).
+ */
+const remote_config_t* remote_config_get(void);
+
+/**
+ * @brief Pasa a los drivers los ajustes que guardan ellos (DS18B20, pH)
+ *
+ * Lo llama sensors_init_all().
+ */
+void remote_config_apply(void);
+
+/**
+ * @brief Procesa un downlink si es de configuración
+ *
+ * @param port FPort del downlink
+ * @param data Payload
+ * @param len  Bytes del payload
+ * @return true si era de configuración (aplicado o rechazado)
+ */
+bool remote_config_on_downlink(uint8_t port, const uint8_t* data, uint8_t len);
+
+/**
+ * @brief Indica si hay que enviar una confirmación en este ciclo
+ *
+ * Solo a partir del ciclo siguiente al del downlink.
+ */
+bool remote_config_ack_pending(void);
+
+/**
+ * @brief Construye la confirmación del último downlink
+ *
+ * @param buffer Buffer de al menos REMOTE_CONFIG_ACK_SIZE bytes
+ * @return Bytes escritos
+ */
+uint8_t remote_config_build_ack(uint8_t* buffer);
+
+/**
+ * @brief Marca la confirmación como enviada
+ */
+void remote_config_ack_sent(void);
+
+#endif // REMOTE_CONFIG_H
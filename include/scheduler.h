@@ -0,0 +1,107 @@
+/**
+ * @file      scheduler.h
+ * @brief     Planificador adaptativo del intervalo de medida según batería y sol
+ *
+ * Antes de cada sueño profundo decide cuánto dormir a partir del estado de
+ * la energía:
+ * - Tensión y estado de carga de la batería, y su tendencia (mV/h)
+ * - Presencia de VBUS (placa solar produciendo) y estado de carga del PMU
+ * - Hora del día estimada: el nodo no tiene reloj de red, así que se toma
+ *   como amanecer (SCHEDULER_SUNRISE_HOUR) la primera entrada de VBUS tras
+ *   al menos SCHEDULER_NIGHT_MIN_HOURS sin ella, y se cuenta desde ahí con
+ *   el tiempo despierto y dormido acumulado en memoria RTC
+ *
+ * La decisión la toma una política intercambiable (SCHEDULER_POLICY, ver
+ * scheduler_policy()). Las políticas son funciones puras de
+ * scheduler_state_t, de modo que pueden reproducirse sobre trazas grabadas
+ * de batería y carga solar. El resultado se limita a
+ * [SCHEDULER_MIN_INTERVAL_SECONDS, SCHEDULER_MAX_INTERVAL_SECONDS] y nunca
+ * baja del tiempo de silencio que exige el duty cycle tras el último uplink.
+ *
+ * Mientras queden registros en el lote (batch_count() > 0) el intervalo no
+ * cambia: la trama por lotes da a todos sus registros el intervalo vigente
+ * (ver batch.h), y eso incluye los que quedan tras un envío parcial, un
+ * aplazamiento o un uplink de servicio. La política, el nuevo intervalo
+ * nominal de remote_config.h y el silencio del duty cycle se aplican en el
+ * primer sueño con el lote vacío; mientras tanto el duty cycle lo garantiza
+ * uplink_planner.h, que aplaza los envíos sin presupuesto.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Hora del día aún no estimada
+#define SCHEDULER_HOUR_UNKNOWN 0xFF
+
+/**
+ * @brief Estado de la energía en el que se basa la decisión
+ */
+typedef struct {
+    uint16_t battery_mv;         /**< Tensión de batería (0 = sin lectura) */
+    uint8_t  soc_percent;        /**< Estado de carga estimado (0-100 %) */
+    int16_t  trend_mv_per_hour;  /**< Tendencia de la tensión (>0 cargando) */
+    bool     vbus;               /**< Entrada solar/USB presente */
+    bool     charging;           /**< El PMU está cargando la batería */
+    uint8_t  hour;               /**< Hora estimada (0-23 o SCHEDULER_HOUR_UNKNOWN) */
+    uint32_t base_interval_s;    /**< Intervalo nominal (SEND_INTERVAL_SECONDS o remote_config.h) */
+} scheduler_state_t;
+
+/**
+ * @brief Política de planificación
+ */
+typedef struct {
+    const char* name;
+    uint32_t (*next_interval)(const scheduler_state_t* state);  /**< Intervalo propuesto (s), sin limitar */
+} scheduler_policy_t;
+
+/**
+ * @brief Número de políticas disponibles
+ */
+uint8_t scheduler_policy_count(void);
+
+/**
+ * @brief Política por índice (0 = fija, 1 = adaptativa)
+ *
+ * @return Puntero a la política, o NULL si el índice no existe
+ */
+const scheduler_policy_t* scheduler_policy(uint8_t index);
+
+/**
+ * @brief Lee el estado de la energía y decide el siguiente intervalo
+ *
+ * Llamar una vez por ciclo con envío, antes de session_save(). Con registros
+ * pendientes en el lote devuelve el intervalo vigente sin replanificar.
+ *
+ * @param airtime_us Tiempo en el aire de los uplinks de este ciclo
+ * @return Segundos de sueño profundo hasta el siguiente despertar
+ */
+uint32_t scheduler_plan(uint32_t airtime_us);
+
+/**
+ * @brief Intervalo vigente (el último planificado, o SEND_INTERVAL_SECONDS)
+ */
+uint32_t scheduler_interval(void);
+
+/**
+ * @brief Segundos desde el encendido, incluido el sueño profundo
+ *
+ * Reloj del planificador (ver scheduler_on_sleep()); lo comparte el
+ * presupuesto de duty cycle de uplink_planner.h.
+ */
+uint32_t scheduler_clock_s(void);
+
+/**
+ * @brief Avanza el reloj del planificador antes del sueño profundo
+ *
+ * @param sleep_seconds Duración del sueño que empieza
+ */
+void scheduler_on_sleep(uint32_t sleep_seconds);
+
+#endif // SCHEDULER_H
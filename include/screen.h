@@ -10,6 +10,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include "../config/config.h"  // sensor_data_t
 
 // Tipos de mensajes de pantalla
 enum ScreenMessageType {
@@ -78,12 +79,10 @@ void showSuccess(const String& text, uint32_t duration = 2000);
 /**
  * @brief Muestra datos del sensor en la pantalla
  *
- * @param temp Temperatura en °C
- * @param hum Humedad en %
- * @param battery Voltaje de batería en V
+ * @param data Lecturas (enteros escalados, ver sensor_data_t)
  * @param duration Duración en milisegundos (por defecto 5000ms)
  */
-void showSensorData(float temp, float hum, float battery, uint32_t duration = 5000);
+void showSensorData(const sensor_data_t* data, uint32_t duration = 5000);
 
 /**
  * @brief Limpia la pantalla
@@ -18,83 +18,55 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Las estructuras de datos están definidas en config.h
 // #include "../config/config.h"  // Ya incluido en los archivos que usan esta interfaz
 
 // ============================================================================
-// FUNCIONES DE LA INTERFAZ DEL SENSOR
+// REGISTRO DE DRIVERS
 // ============================================================================
 
-/**
- * @brief Inicializa el sensor DHT22
- */
-bool sensor_dht22_init(void);
-
-/**
- * @brief Verifica si el sensor DHT22 está disponible
- */
-bool sensor_dht22_is_available(void);
-
-/**
- * @brief Intenta reinicializar el sensor DHT22
- */
-bool sensor_dht22_retry_init(void);
-
-/**
- * @brief Lee todos los datos del sensor DHT22
- */
-bool sensor_dht22_read_all(sensor_data_t* data);
+/// Pin de alimentación de un sensor sin rail conmutado
+#define SENSOR_POWER_ALWAYS_ON 0xFF
 
 /**
- * @brief Obtiene el payload del sensor DHT22
- */
-uint8_t sensor_dht22_get_payload(payload_config_t* config);
-
-/**
- * @brief Obtiene el nombre del sensor DHT22
- */
-const char* sensor_dht22_get_name(void);
-
-/**
- * @brief Fuerza el estado del sensor DHT22 para testing
- */
-void sensor_dht22_set_available_for_testing(bool available);
-
-/**
- * @brief Inicializa el sensor DHT11
- */
-bool sensor_dht11_init(void);
-
-/**
- * @brief Verifica si el sensor DHT11 está disponible
- */
-bool sensor_dht11_is_available(void);
-
-/**
- * @brief Intenta reinicializar el sensor DHT11
- */
-bool sensor_dht11_retry_init(void);
-
-/**
- * @brief Lee todos los datos del sensor DHT11
+ * @brief Descriptor de un driver de sensor (ver config/sensor_registry.h)
+ *
+ * El agregador, el planificador de adquisición y el generador del decoder
+ * recorren la tabla de descriptores en lugar de repetir un bloque #ifdef
+ * por sensor. Ciclo de una lectura:
+ *   power_rail_acquire(power_pin, warmup_ms) -> start() -> wait() -> read()
+ *   -> power_rail_release(power_pin)
  */
-bool sensor_dht11_read_all(sensor_data_t* data);
+typedef struct {
+    const char* name;              /**< Nombre corto para logs */
+    const char* description;       /**< Magnitudes medidas (decoder TTN) */
+    uint8_t capabilities;          /**< Campos que escribe en sensor_data_t (SENSOR_FIELD_*) */
+    uint8_t power_pin;             /**< Rail de alimentación o SENSOR_POWER_ALWAYS_ON */
+    uint32_t warmup_ms;            /**< Estabilización tras encender el rail */
+    bool (*init)(void);            /**< Inicialización */
+    bool (*is_available)(void);    /**< Estado del sensor */
+    bool (*retry_init)(void);      /**< Reintento de inicialización */
+    uint32_t (*start)(void);       /**< Lanza la conversión y devuelve su duración en ms (NULL: sin conversión) */
+    void (*wait)(uint32_t deadline_ms); /**< Espera la conversión (NULL: power_rail_wait_until) */
+    bool (*read)(sensor_data_t* data);  /**< Escribe sus campos en data (sensor ya listo) */
+    void (*set_available_for_testing)(bool available); /**< Fuerza el estado para testing */
+} sensor_driver_t;
 
 /**
- * @brief Obtiene el payload del sensor DHT11
+ * @brief Número de drivers registrados
  */
-uint8_t sensor_dht11_get_payload(payload_config_t* config);
+uint8_t sensors_driver_count(void);
 
 /**
- * @brief Obtiene el nombre del sensor DHT11
+ * @brief Descriptor del driver i-ésimo del registro (NULL si no existe)
  */
-const char* sensor_dht11_get_name(void);
+const sensor_driver_t* sensors_driver(uint8_t index);
 
-/**
- * @brief Fuerza el estado del sensor DHT11 para testing
- */
-void sensor_dht11_set_available_for_testing(bool available);
+// ============================================================================
+// FUNCIONES DE LA INTERFAZ DEL SENSOR
+// ============================================================================
 
 /**
  * @brief Inicializa el sensor DS18B20
@@ -112,14 +84,25 @@ bool sensor_ds18b20_is_available(void);
 bool sensor_ds18b20_retry_init(void);
 
 /**
- * @brief Lee todos los datos del sensor DS18B20
+ * @brief Lanza la conversión del DS18B20 sin bloquear (sensor alimentado)
+ * @return Milisegundos hasta que la conversión esté lista
+ */
+uint32_t sensor_ds18b20_start_conversion(void);
+
+/**
+ * @brief Espera el fin de la conversión del DS18B20 (bit de estado o plazo)
  */
-bool sensor_ds18b20_read_all(sensor_data_t* data);
+void sensor_ds18b20_wait_conversion(uint32_t deadline_ms);
 
 /**
- * @brief Obtiene el payload del sensor DS18B20
+ * @brief Recoge la temperatura de la conversión lanzada previamente
  */
-uint8_t sensor_ds18b20_get_payload(payload_config_t* config);
+bool sensor_ds18b20_read_conversion(sensor_data_t* data);
+
+/**
+ * @brief Fija la precisión requerida del DS18B20 en °C (elige 9-12 bits)
+ */
+void sensor_ds18b20_set_precision(float precision);
 
 /**
  * @brief Obtiene el nombre del sensor DS18B20
@@ -147,14 +130,10 @@ bool sensor_ph_is_available(void);
 bool sensor_ph_retry_init(void);
 
 /**
- * @brief Lee todos los datos del sensor de pH
- */
-bool sensor_ph_read_all(sensor_data_t* data);
-
-/**
- * @brief Obtiene el payload del sensor de pH
+ * @brief Muestrea el pH (sensor ya alimentado y estabilizado), compensando
+ *        con la temperatura exterior de data si ya se ha leído
  */
-uint8_t sensor_ph_get_payload(payload_config_t* config);
+bool sensor_ph_read_measurement(sensor_data_t* data);
 
 /**
  * @brief Obtiene el nombre del sensor de pH
@@ -195,14 +174,15 @@ bool sensor_bme280_is_available(void);
 bool sensor_bme280_retry_init(void);
 
 /**
- * @brief Lee todos los datos del sensor BME280
+ * @brief Lanza una medida forzada del BME280 (sensor alimentado)
+ * @return Milisegundos hasta que la medida esté lista
  */
-bool sensor_bme280_read_all(sensor_data_t* data);
+uint32_t sensor_bme280_start_measurement(void);
 
 /**
- * @brief Obtiene el payload del sensor BME280
+ * @brief Recoge la medida forzada del BME280 (temperatura, humedad y presión)
  */
-uint8_t sensor_bme280_get_payload(payload_config_t* config);
+bool sensor_bme280_read_measurement(sensor_data_t* data);
 
 /**
  * @brief Obtiene el nombre del sensor BME280
@@ -215,99 +195,67 @@ const char* sensor_bme280_get_name(void);
 void sensor_bme280_set_available_for_testing(bool available);
 
 /**
- * @brief Inicializa el sensor HC-SR04
- */
-bool sensor_hcsr04_init(void);
-
-/**
- * @brief Verifica si el sensor HC-SR04 está disponible
- */
-bool sensor_hcsr04_is_available(void);
-
-/**
- * @brief Intenta reinicializar el sensor HC-SR04
- */
-bool sensor_hcsr04_retry_init(void);
-
-/**
- * @brief Lee todos los datos del sensor HC-SR04
- */
-bool sensor_hcsr04_read_all(sensor_data_t* data);
-
-/**
- * @brief Obtiene el payload del sensor HC-SR04
- */
-uint8_t sensor_hcsr04_get_payload(payload_config_t* config);
-
-/**
- * @brief Obtiene el nombre del sensor HC-SR04
- */
-const char* sensor_hcsr04_get_name(void);
-
-/**
- * @brief Fuerza el estado del sensor HC-SR04 para testing
- */
-void sensor_hcsr04_set_available_for_testing(bool available);
-
-/**
- * @brief Inicializa el sensor NONE
- */
-bool sensor_none_init(void);
-
-/**
- * @brief Verifica si el sensor NONE está disponible
+ * @brief Inicializa todos los sensores habilitados
  */
-bool sensor_none_is_available(void);
+bool sensors_init_all(void);
 
 /**
- * @brief Intenta reinicializar el sensor NONE
+ * @brief Verifica si al menos un sensor está disponible
  */
-bool sensor_none_retry_init(void);
+bool sensors_is_any_available(void);
 
 /**
- * @brief Lee todos los datos del sensor NONE
+ * @brief Intenta reinicializar todos los sensores
  */
-bool sensor_none_read_all(sensor_data_t* data);
+bool sensors_retry_init_all(void);
 
 /**
- * @brief Obtiene el payload del sensor NONE
+ * @brief Lee datos de todos los sensores habilitados y los combina
  */
-uint8_t sensor_none_get_payload(payload_config_t* config);
+bool sensors_read_all(sensor_data_t* data);
 
 /**
- * @brief Obtiene el nombre del sensor NONE
+ * @brief Adquiere todos los sensores y guarda el resultado como snapshot del ciclo
  */
-const char* sensor_none_get_name(void);
+bool sensors_acquire(void);
 
 /**
- * @brief Fuerza el estado del sensor NONE para testing
+ * @brief Copia el snapshot del ciclo (adquiere si no hay o tiene más de
+ *        SENSOR_SNAPSHOT_MAX_AGE_MS)
  */
-void sensor_none_set_available_for_testing(bool available);
+bool sensors_snapshot(sensor_data_t* data);
 
 /**
- * @brief Inicializa todos los sensores habilitados
+ * @brief Antigüedad del snapshot en milisegundos (UINT32_MAX si no hay)
  */
-bool sensors_init_all(void);
+uint32_t sensors_snapshot_age_ms(void);
 
 /**
- * @brief Verifica si al menos un sensor está disponible
+ * @brief Descarta el snapshot para forzar una nueva adquisición
  */
-bool sensors_is_any_available(void);
+void sensors_invalidate_snapshot(void);
 
 /**
- * @brief Intenta reinicializar todos los sensores
+ * @brief Construye el payload con el snapshot de los sensores
  */
-bool sensors_retry_init_all(void);
+uint8_t sensors_get_payload(payload_config_t* config);
 
 /**
- * @brief Lee datos de todos los sensores habilitados y los combina
+ * @brief Codifica una lectura ya realizada en el formato del payload
  */
-bool sensors_read_all(sensor_data_t* data);
+uint8_t sensors_encode_payload(const sensor_data_t* data, payload_config_t* config);
 
 /**
- * @brief Construye el payload con datos de todos los sensores
- */
-uint8_t sensors_get_payload(payload_config_t* config);
+ * @brief Formatea un entero escalado como decimal sin usar float
+ *
+ * @param buffer   Destino
+ * @param size     Tamaño del destino
+ * @param value    Valor en unidades de 1/scale (p. ej. centésimas de °C)
+ * @param scale    Unidades por unidad física (potencia de 10)
+ * @param decimals Decimales a mostrar (redondeando)
+ * @return buffer
+ */
+char* sensor_format_fixed(char* buffer, size_t size, int32_t value, int32_t scale, uint8_t decimals);
 
 /**
  * @brief Obtiene el nombre de los sensores activos
@@ -0,0 +1,91 @@
+/**
+ * @file      session.h
+ * @brief     Persistencia de la sesión LoRaWAN OTAA entre ciclos de sueño profundo
+ *
+ * Guarda en memoria RTC (y opcionalmente en NVS) el estado mínimo de la sesión
+ * LMIC para que, al despertar por temporizador, el nodo restaure la sesión con
+ * LMIC_setSession() en lugar de repetir el join OTAA en cada ciclo.
+ *
+ * Funcionalidades:
+ * - Snapshot de devaddr, claves de sesión, contadores de trama, canales,
+ *   datarate/potencia, parámetros RX2/RX1 y disponibilidad de bandas
+ * - Validación por número mágico, versión y CRC16
+ * - Rejoin forzado tras SESSION_MAX_UPLINKS envíos o tras
+ *   SESSION_MAX_MISSED_ACKS confirmaciones perdidas consecutivas
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Restaura la sesión LoRaWAN guardada antes del sueño profundo
+ *
+ * Debe llamarse después de LMIC_reset() y de configurar los canales.
+ * Si hay un snapshot válido, aplica LMIC_setSession() y recupera contadores,
+ * canales, datarate y disponibilidad de bandas.
+ *
+ * @return true si la sesión se restauró y no hace falta hacer join
+ */
+bool session_restore(void);
+
+/**
+ * @brief Guarda la sesión LoRaWAN actual antes de entrar en sueño profundo
+ *
+ * @param sleep_seconds Duración prevista del sueño, usada para descontar
+ *                      el tiempo de espera de duty cycle de cada banda
+ */
+void session_save(uint32_t sleep_seconds);
+
+/**
+ * @brief Suma un periodo de sueño más a la sesión guardada
+ *
+ * Para despertares en los que no se inicializa LMIC (p. ej. solo medir):
+ * el sueño se acumula y se descuenta de las esperas de duty cycle al
+ * restaurar la sesión.
+ *
+ * @param sleep_seconds Duración del siguiente sueño profundo
+ */
+void session_add_sleep(uint32_t sleep_seconds);
+
+/**
+ * @brief Invalida la sesión guardada para forzar un nuevo join OTAA
+ */
+void session_invalidate(void);
+
+/**
+ * @brief Notifica que se ha completado un join OTAA
+ *
+ * Reinicia los contadores de envíos y de ACKs perdidos.
+ */
+void session_on_joined(void);
+
+/**
+ * @brief Notifica el fin de una transacción TX/RX
+ *
+ * Actualiza los contadores de envíos y de ACKs perdidos. Si se supera
+ * alguno de los límites configurados, invalida la sesión para que el
+ * siguiente ciclo haga un join completo.
+ *
+ * @param confirmed true si el uplink se envió como confirmado
+ * @param txrx_flags Valor de LMIC.txrxFlags al completar la transmisión
+ */
+void session_on_tx_complete(bool confirmed, uint8_t txrx_flags);
+
+/**
+ * @brief Indica si el próximo uplink debe enviarse como confirmado
+ *
+ * Se usa un uplink confirmado cada SESSION_CONFIRM_EVERY envíos para
+ * comprobar que la sesión sigue siendo válida en el servidor de red.
+ *
+ * @return true si el próximo uplink debe pedir ACK
+ */
+bool session_should_confirm(void);
+
+#endif // SESSION_H
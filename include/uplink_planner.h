@@ -0,0 +1,131 @@
+/**
+ * @file      uplink_planner.h
+ * @brief     Planificador de uplinks: tiempo en el aire y duty cycle (EU868)
+ *
+ * Expone a la aplicación lo que LMIC calcula internamente:
+ * - Tiempo en el aire previsto de un payload a cada DR (calcAirTime() con
+ *   la cabecera LoRaWAN de 13 bytes y los FOpts que LMIC tiene pendientes)
+ * - Primer instante legal de transmisión por banda y por canal, a partir de
+ *   LMIC.bands[].avail (1 % en la banda g, 0,1 % en g2) y del duty cycle
+ *   global. session.h conserva esa disponibilidad durante el sueño profundo
+ * - Presupuesto de duty cycle en ventana móvil: el tiempo en el aire de la
+ *   última UPLINK_PLANNER_WINDOW_SECONDS no puede superar
+ *   SCHEDULER_DUTY_CYCLE_PERCENT de la ventana. Se guarda en memoria RTC,
+ *   por cubos, con el reloj del planificador de intervalos (scheduler.h)
+ *
+ * Con el presupuesto la aplicación decide antes de llamar a
+ * LMIC_setTxData2(): cuántos registros del lote caben
+ * (uplink_planner_fit_payload()), si hace falta un DR más rápido
+ * (uplink_planner_fit_datarate(), solo con UPLINK_PLANNER_ADAPT_DR) o si el
+ * uplink se aplaza al siguiente ciclo.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef UPLINK_PLANNER_H
+#define UPLINK_PLANNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Espera devuelta para un canal deshabilitado o sin canales para el DR
+#define UPLINK_PLANNER_NEVER 0xFFFFFFFFUL
+
+/// Cabecera MAC + FHDR + FPort + MIC sobre el payload de aplicación
+#define UPLINK_PLANNER_OVERHEAD 13
+
+/**
+ * @brief Bytes de FOpts que LMIC añadirá al próximo uplink
+ *
+ * Respuestas pendientes a comandos MAC de la red y LinkCheckReq, con las
+ * mismas condiciones que buildDataFrame() de LMIC. Van en la cabecera y
+ * restan del tamaño máximo de payload del DR (hasta 15 bytes).
+ */
+uint8_t uplink_planner_fopts_size(void);
+
+/**
+ * @brief Tiempo en el aire de un uplink
+ *
+ * Incluye los FOpts pendientes (uplink_planner_fopts_size()): llamar antes
+ * de LMIC_setTxData2(), que los consume al construir la trama.
+ *
+ * @param datarate     DR de LMIC (DR_SF12 ... DR_FSK)
+ * @param payload_size Bytes de payload de aplicación
+ * @return Microsegundos en el aire
+ */
+uint32_t uplink_planner_airtime_us(uint8_t datarate, uint8_t payload_size);
+
+/**
+ * @brief Espera hasta que una banda admite otra transmisión
+ *
+ * Incluye el duty cycle global que pueda imponer la red (DutyCycleReq).
+ *
+ * @param band BAND_MILLI, BAND_CENTI, BAND_DECI o BAND_AUX
+ * @return Milisegundos (0 = ya se puede transmitir)
+ */
+uint32_t uplink_planner_band_wait_ms(uint8_t band);
+
+/**
+ * @brief Espera hasta que un canal admite otra transmisión
+ *
+ * @param channel Índice de canal de LMIC
+ * @return Milisegundos, o UPLINK_PLANNER_NEVER si el canal está deshabilitado
+ */
+uint32_t uplink_planner_channel_wait_ms(uint8_t channel);
+
+/**
+ * @brief Primer instante legal para transmitir a un DR
+ *
+ * @param datarate DR de LMIC
+ * @return Milisegundos hasta el primer canal libre que admite el DR, o
+ *         UPLINK_PLANNER_NEVER si ningún canal habilitado lo admite
+ */
+uint32_t uplink_planner_next_tx_ms(uint8_t datarate);
+
+/**
+ * @brief Tiempo en el aire disponible en la ventana móvil
+ *
+ * @return Microsegundos que aún caben en el presupuesto
+ */
+uint32_t uplink_planner_budget_left_us(void);
+
+/**
+ * @brief Payload más grande que cabe en el presupuesto a un DR
+ *
+ * @param datarate DR de LMIC
+ * @param max_size Límite del DR o del buffer
+ * @return Bytes de payload (0 si no cabe ni una trama vacía)
+ */
+uint8_t uplink_planner_fit_payload(uint8_t datarate, uint8_t max_size);
+
+/**
+ * @brief DR con el que el uplink cabe en el presupuesto
+ *
+ * Devuelve el DR actual si cabe. Si no, con UPLINK_PLANNER_ADAPT_DR busca
+ * el más lento de los más rápidos (hasta DR_SF7) que quepa.
+ *
+ * @param datarate     DR actual
+ * @param payload_size Bytes de payload de aplicación
+ * @return DR a usar, o DR_NONE si hay que aplazar el uplink
+ */
+uint8_t uplink_planner_fit_datarate(uint8_t datarate, uint8_t payload_size);
+
+/**
+ * @brief Anota un uplink en el presupuesto
+ *
+ * Llamar junto a cada LMIC_setTxData2().
+ *
+ * @param airtime_us Tiempo en el aire del uplink
+ */
+void uplink_planner_record(uint32_t airtime_us);
+
+/**
+ * @brief Imprime el tiempo en el aire por DR, la espera por banda y el presupuesto
+ *
+ * @param payload_size Bytes de payload de aplicación
+ */
+void uplink_planner_log(uint8_t payload_size);
+
+#endif // UPLINK_PLANNER_H
@@ -0,0 +1,43 @@
+/*
+ * AES backend using the hardware AES accelerator of the ESP32, through
+ * the esp_aes driver that ESP-IDF also uses as mbedTLS AES backend.
+ *
+ * Like the Ideetron implementation, this only provides single block
+ * encryption:
+ *
+ *      extern "C" void lmic_aes_encrypt(u1_t *data, u1_t *key);
+ *
+ * CMAC and AES-CTR on top of it are done by aes/other.c. The expanded key
+ * stays loaded in the context between calls, so it is only set again when
+ * LMIC switches between the network and application session keys (or
+ * the AppKey during join).
+ */
+
+#include "../../lmic/oslmic.h"
+
+#if defined(USE_ESP32_HW_AES)
+
+#include <string.h>
+#include "aes/esp_aes.h"
+
+extern "C" void lmic_aes_encrypt(u1_t *data, u1_t *key);
+
+static esp_aes_context aes_ctx;
+static u1_t aes_ctx_key[16];
+static bool aes_ctx_keyed = false;
+
+void lmic_aes_encrypt(u1_t *data, u1_t *key)
+{
+    if (!aes_ctx_keyed || memcmp(aes_ctx_key, key, 16) != 0) {
+        if (!aes_ctx_keyed)
+            esp_aes_init(&aes_ctx);
+        memcpy(aes_ctx_key, key, 16);
+        esp_aes_setkey(&aes_ctx, aes_ctx_key, 128);
+        aes_ctx_keyed = true;
+    }
+
+    // Single block ECB, the driver supports in-place operation
+    esp_aes_crypt_ecb(&aes_ctx, ESP_AES_ENCRYPT, data, data);
+}
+
+#endif // defined(USE_ESP32_HW_AES)
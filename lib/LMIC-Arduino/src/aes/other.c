@@ -59,7 +59,9 @@ static void os_aes_cmac(xref2u1_t buf, u2_t len, u1_t prepend_aux) {
     else
         memset (AESaux, 0, 16);
 
-    while (len > 0) {
+    // do/while so that an empty message still gets its padded final
+    // block (RFC4493 example 1); LoRaWAN itself never MICs 0 bytes.
+    do {
         u1_t need_padding = 0;
         for (u1_t i = 0; i < 16; ++i, ++buf, --len) {
             if (len == 0) {
@@ -101,7 +103,7 @@ static void os_aes_cmac(xref2u1_t buf, u2_t len, u1_t prepend_aux) {
         }
 
         lmic_aes_encrypt(AESaux, AESkey);
-    }
+    } while (len > 0);
 }
 
 // Run AES-CTR using the key in AESKEY and using AESAUX as the
@@ -14,9 +14,72 @@
 #include "hal.h"
 #include <stdio.h>
 
+#if defined(ARDUINO_ARCH_ESP32) && defined(LMIC_ESP32_LIGHT_SLEEP)
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#define LMIC_HAL_DIO_IRQ
+#endif
+
 // -----------------------------------------------------------------------------
 // I/O
 
+#if defined(LMIC_HAL_DIO_IRQ)
+// Set by the DIO interrupt handler, consumed by hal_io_check() in task
+// context. It only says that some DIO line changed: the actual edge
+// detection still compares pin levels against dio_states, so one radio
+// event is never reported twice and radio_irq_handler() (which does SPI
+// transfers) never runs inside an ISR. Starts true to sample the initial
+// pin levels once.
+static volatile bool dio_irq_pending = true;
+// micros() of the first DIO edge not consumed yet, valid if dio_irq_stamped.
+// radio_irq_handler_v2() gets this time instead of the time hal_io_check()
+// runs, so TXDONE/RXDONE (and the RX windows scheduled from txend) are not
+// shifted by the task latency or by the light sleep exit.
+static volatile u4_t dio_irq_us;
+static volatile bool dio_irq_stamped = false;
+static portMUX_TYPE dio_irq_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR hal_dio_isr ()
+{
+    u4_t now = micros();
+    portENTER_CRITICAL_ISR(&dio_irq_mux);
+    dio_irq_pending = true;
+    if (!dio_irq_stamped) {
+        dio_irq_us = now;
+        dio_irq_stamped = true;
+    }
+    portEXIT_CRITICAL_ISR(&dio_irq_mux);
+}
+
+// Consumes the pending flag. *edge_us is the micros() of the first edge,
+// or the current time if no edge was timestamped (initial sampling, or a
+// light sleep that ended on the timer).
+static bool hal_dio_take_pending (u4_t *edge_us)
+{
+    u4_t now = micros();
+    portENTER_CRITICAL(&dio_irq_mux);
+    bool pending = dio_irq_pending;
+    *edge_us = dio_irq_stamped ? dio_irq_us : now;
+    dio_irq_pending = false;
+    dio_irq_stamped = false;
+    portEXIT_CRITICAL(&dio_irq_mux);
+    return pending;
+}
+
+// Marks the DIO lines for sampling, with the edge at edge_us if stamped.
+static void hal_dio_set_pending (bool stamped, u4_t edge_us)
+{
+    portENTER_CRITICAL(&dio_irq_mux);
+    dio_irq_pending = true;
+    if (stamped && !dio_irq_stamped) {
+        dio_irq_us = edge_us;
+        dio_irq_stamped = true;
+    }
+    portEXIT_CRITICAL(&dio_irq_mux);
+}
+#endif
+
 static void hal_io_init ()
 {
     // NSS and DIO0 are required, DIO1 is required for LoRa, DIO2 for FSK
@@ -35,6 +98,13 @@ static void hal_io_init ()
         pinMode(lmic_pins.dio[1], INPUT);
     if (lmic_pins.dio[2] != LMIC_UNUSED_PIN)
         pinMode(lmic_pins.dio[2], INPUT);
+
+#if defined(LMIC_HAL_DIO_IRQ)
+    for (uint8_t i = 0; i < NUM_DIO; ++i) {
+        if (lmic_pins.dio[i] != LMIC_UNUSED_PIN)
+            attachInterrupt(digitalPinToInterrupt(lmic_pins.dio[i]), hal_dio_isr, CHANGE);
+    }
+#endif
 }
 
 // val == 1  => tx 1
@@ -63,6 +133,16 @@ static bool dio_states[NUM_DIO] = {0};
 static void hal_io_check()
 {
     uint8_t i;
+#if defined(LMIC_HAL_DIO_IRQ)
+    // No DIO edge since the last check, nothing to sample
+    u4_t edge_us;
+    if (!hal_dio_take_pending(&edge_us))
+        return;
+    // Edge time in ticks: now, minus the time elapsed since the edge
+    ostime_t tref = hal_ticks() - (ostime_t)(((u4_t)micros() - edge_us) >> US_PER_OSTICK_EXPONENT);
+#else
+    ostime_t tref = hal_ticks();
+#endif
     for (i = 0; i < NUM_DIO; ++i) {
         if (lmic_pins.dio[i] == LMIC_UNUSED_PIN)
             continue;
@@ -70,7 +150,7 @@ static void hal_io_check()
         if (dio_states[i] != digitalRead(lmic_pins.dio[i])) {
             dio_states[i] = !dio_states[i];
             if (dio_states[i])
-                radio_irq_handler(i);
+                radio_irq_handler_v2(i, tref);
         }
     }
 }
@@ -109,6 +189,30 @@ u1_t hal_spi (u1_t out)
     return res;
 }
 
+// perform burst SPI transaction with radio (address byte, then the buffer)
+void hal_spi_burst (u1_t addr, u1_t* buf, u1_t len, u1_t dir)
+{
+    hal_pin_nss(0);
+    SPI.transfer(addr);
+#if defined(ARDUINO_ARCH_ESP32)
+    // Whole buffer through the SPI FIFO instead of one transfer per byte
+    if (dir == HAL_SPI_WRITE) {
+        SPI.writeBytes(buf, len);
+    } else {
+        memset(buf, 0x00, len);
+        SPI.transferBytes(buf, buf, len);
+    }
+#else
+    for (u1_t i = 0; i < len; i++) {
+        if (dir == HAL_SPI_WRITE)
+            SPI.transfer(buf[i]);
+        else
+            buf[i] = SPI.transfer(0x00);
+    }
+#endif
+    hal_pin_nss(1);
+}
+
 // -----------------------------------------------------------------------------
 // TIME
 
@@ -207,7 +311,8 @@ void hal_enableIRQs ()
         // and/or not available on all pins on AVR), just poll the pin
         // values. Since os_runloop disables and re-enables interrupts,
         // putting this here makes sure we check at least once every
-        // loop.
+        // loop. On ESP32 (LMIC_HAL_DIO_IRQ) the DIO interrupt only
+        // flags the change and the pins are sampled here as well.
         //
         // As an additional bonus, this prevents the can of worms that
         // we would otherwise get for running SPI transfers inside ISRs
@@ -217,7 +322,114 @@ void hal_enableIRQs ()
 
 void hal_sleep ()
 {
-    // Not implemented
+    // Not implemented, see hal_sleepUntil()
+}
+
+void __attribute__((weak)) hal_beforeLightSleep ()
+{
+    Serial.flush();
+}
+
+void __attribute__((weak)) hal_afterLightSleep ()
+{
+}
+
+static u4_t sleep_count = 0;
+static u4_t sleep_total_us = 0;
+
+#if defined(LMIC_HAL_DIO_IRQ)
+// Microseconds to sleep from now: LMIC_SLEEP_MAX_MS, or up to
+// LMIC_SLEEP_GUARD_US before the deadline if that comes first.
+static int64_t sleep_duration_us (u1_t hasDeadline, u4_t deadline)
+{
+    int64_t us = (int64_t)LMIC_SLEEP_MAX_MS * 1000;
+    if (hasDeadline) {
+        int64_t until = (int64_t)delta_time(deadline) * US_PER_OSTICK - LMIC_SLEEP_GUARD_US;
+        if (until < us)
+            us = until;
+    }
+    return us;
+}
+
+void hal_sleepUntil (u1_t hasDeadline, u4_t deadline)
+{
+    if (sleep_duration_us(hasDeadline, deadline) < LMIC_SLEEP_MIN_US)
+        return;
+
+    // A DIO edge that hal_io_check() has not consumed yet, or a DIO line
+    // that is still high, means the radio needs attention: don't sleep.
+    if (dio_irq_pending)
+        return;
+    for (uint8_t i = 0; i < NUM_DIO; ++i) {
+        if (lmic_pins.dio[i] != LMIC_UNUSED_PIN && digitalRead(lmic_pins.dio[i]))
+            return;
+    }
+
+    // The UART is stopped during light sleep, drain pending output first.
+    // This can block for a while (Serial.flush(), or whatever the
+    // application does), and the sleep timer counts from
+    // esp_light_sleep_start(), so the duration is only computed now.
+    hal_beforeLightSleep();
+    int64_t us = sleep_duration_us(hasDeadline, deadline);
+    if (us < LMIC_SLEEP_MIN_US || dio_irq_pending) {
+        hal_afterLightSleep();
+        return;
+    }
+
+    // GPIO wakeup from light sleep is level triggered and shares the
+    // interrupt type register with the edge interrupt, so mask the edge
+    // interrupt while sleeping (otherwise the high level would storm the
+    // ISR right after waking up) and restore it afterwards.
+    for (uint8_t i = 0; i < NUM_DIO; ++i) {
+        if (lmic_pins.dio[i] == LMIC_UNUSED_PIN)
+            continue;
+        gpio_intr_disable((gpio_num_t)lmic_pins.dio[i]);
+        gpio_wakeup_enable((gpio_num_t)lmic_pins.dio[i], GPIO_INTR_HIGH_LEVEL);
+    }
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)us);
+
+    int64_t start = esp_timer_get_time();
+    esp_light_sleep_start();
+    // First thing after waking: on a GPIO wake this is the DIO edge, late
+    // only by the light sleep exit (the edge ISR is masked while sleeping)
+    u4_t wake_us = micros();
+    bool dio_wake = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+    sleep_total_us += (u4_t)(esp_timer_get_time() - start);
+    hal_afterLightSleep();
+    sleep_count++;
+
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    for (uint8_t i = 0; i < NUM_DIO; ++i) {
+        if (lmic_pins.dio[i] == LMIC_UNUSED_PIN)
+            continue;
+        gpio_wakeup_disable((gpio_num_t)lmic_pins.dio[i]);
+        gpio_set_intr_type((gpio_num_t)lmic_pins.dio[i], GPIO_INTR_ANYEDGE);
+        gpio_intr_enable((gpio_num_t)lmic_pins.dio[i]);
+    }
+
+    // Edges during light sleep were not latched, sample the pins on the
+    // next hal_io_check()
+    hal_dio_set_pending(dio_wake, wake_us);
+}
+#else
+void hal_sleepUntil (u1_t hasDeadline, u4_t deadline)
+{
+    // Not implemented, keep polling
+}
+#endif
+
+void hal_getSleepStats (u4_t *count, u4_t *total_us)
+{
+    *count = sleep_count;
+    *total_us = sleep_total_us;
+}
+
+void hal_resetSleepStats ()
+{
+    sleep_count = 0;
+    sleep_total_us = 0;
 }
 
 // -----------------------------------------------------------------------------
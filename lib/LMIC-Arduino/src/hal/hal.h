@@ -26,4 +26,19 @@ const u1_t LMIC_UNUSED_PIN = 0xff;
 // Declared here, to be defined an initialized by the application
 extern const lmic_pinmap lmic_pins;
 
+// Time spent in low-power mode by hal_sleepUntil() since the last reset:
+// number of sleeps and total duration in microseconds (always 0 when the
+// HAL does not sleep, i.e. without LMIC_ESP32_LIGHT_SLEEP).
+void hal_getSleepStats (u4_t *count, u4_t *total_us);
+void hal_resetSleepStats ();
+
+// Called by hal_sleepUntil() right before and after the light sleep. The
+// default (weak) versions flush Serial, since the UART stops while
+// sleeping; an application with buffered output can override both.
+// hal_beforeLightSleep() may block: the sleep time is computed after it
+// returns, and if the next deadline is too close by then, hal_sleepUntil()
+// calls hal_afterLightSleep() and returns without sleeping.
+void hal_beforeLightSleep ();
+void hal_afterLightSleep ();
+
 #endif // _hal_hal_h_
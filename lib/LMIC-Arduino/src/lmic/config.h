@@ -20,6 +20,20 @@
 #define US_PER_OSTICK (1 << US_PER_OSTICK_EXPONENT)
 #define OSTICKS_PER_SEC (1000000 / US_PER_OSTICK)
 
+// On ESP32, attach GPIO interrupts to the DIO pins (the radio IRQ itself is
+// still handled in task context) and let os_runloop_once() put the CPU in
+// light sleep until the next scheduled job or a DIO edge. Comment this out
+// to fall back to plain DIO polling with the CPU always running.
+#define LMIC_ESP32_LIGHT_SLEEP
+// Don't bother entering light sleep for less than this many microseconds.
+#define LMIC_SLEEP_MIN_US 3000
+// Wake up this many microseconds before the next job deadline, to cover
+// the light sleep exit latency.
+#define LMIC_SLEEP_GUARD_US 1500
+// Never sleep longer than this (ms), so the application loop keeps running
+// (watchdog, display) while LMIC is only waiting for a radio IRQ.
+#define LMIC_SLEEP_MAX_MS 1000
+
 // Set this to 1 to enable some basic debug output (using printf) about
 // RF settings used during transmission and reception. Set to 2 to
 // enable more verbose output. Make sure that printf is actually
@@ -66,7 +80,8 @@
 //#define DISABLE_INVERT_IQ_ON_RX
 
 // This allows choosing between multiple included AES implementations.
-// Make sure exactly one of these is uncommented.
+// Make sure at most one of these is uncommented here or passed in
+// build_flags (-DUSE_...); without any, the Ideetron one is used.
 //
 // This selects the original AES implementation included LMIC. This
 // implementation is optimized for speed on 32-bit processors using
@@ -78,6 +93,22 @@
 // own LoRaWAN library. It also uses lookup tables, but smaller
 // byte-oriented ones, making it use a lot less flash space (but it is
 // also about twice as slow as the original).
+// #define USE_IDEETRON_AES
+//
+// This selects the hardware AES accelerator of the ESP32, through the
+// esp_aes driver of ESP-IDF (the same one mbedTLS uses). Only raw block
+// encryption is offloaded, CMAC and CTR are still done in aes/other.c.
+// On other architectures this falls back to the Ideetron implementation.
+// Not the default until test/test_aes has passed on the board (see
+// docs/5_desarrollo.md).
+// #define USE_ESP32_HW_AES
+
+#if defined(USE_ESP32_HW_AES) && !defined(ARDUINO_ARCH_ESP32)
+#undef USE_ESP32_HW_AES
+#endif
+
+#if !defined(USE_ORIGINAL_AES) && !defined(USE_ESP32_HW_AES)
 #define USE_IDEETRON_AES
+#endif
 
 #endif // _lmic_config_h_
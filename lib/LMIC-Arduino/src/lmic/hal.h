@@ -43,6 +43,16 @@ void hal_pin_rst (u1_t val);
  */
 u1_t hal_spi (u1_t outval);
 
+/*
+ * perform a burst SPI transaction with radio (one NSS cycle).
+ *   - write address byte 'addr' (including the radio's R/W bit)
+ *   - dir == HAL_SPI_WRITE: write 'len' bytes from 'buf'
+ *   - dir == HAL_SPI_READ: read 'len' bytes into 'buf'
+ */
+#define HAL_SPI_READ  0
+#define HAL_SPI_WRITE 1
+void hal_spi_burst (u1_t addr, u1_t* buf, u1_t len, u1_t dir);
+
 /*
  * disable all CPU interrupts.
  *   - might be invoked nested
@@ -60,6 +70,14 @@ void hal_enableIRQs (void);
  */
 void hal_sleep (void);
 
+/*
+ * put system and CPU in low-power mode until the given timestamp (in ticks)
+ * or until a radio IRQ, whichever comes first.
+ *   - hasDeadline == 0 means no timed job is pending
+ *   - called with interrupts enabled, only when no job is runnable
+ */
+void hal_sleepUntil (u1_t hasDeadline, u4_t deadline);
+
 /*
  * return 32-bit system time in ticks.
  */
@@ -632,7 +632,8 @@ static void updateTx (ostime_t txbeg) {
     // Update channel/global duty cycle stats
     xref2band_t band = &LMIC.bands[freq & 0x3];
     LMIC.freq  = freq & ~(u4_t)3;
-    LMIC.txpow = band->txpow;
+    // DR/txpow setting (app or ADR) capped by the band limit
+    LMIC.txpow = LMIC.adrTxPow < band->txpow ? LMIC.adrTxPow : band->txpow;
     band->avail = txbeg + airtime * band->txcap;
     if( LMIC.globalDutyRate != 0 )
         LMIC.globalDutyAvail = txbeg + (airtime<<LMIC.globalDutyRate);
@@ -1142,8 +1143,8 @@ static bit_t decodeFrame (void) {
     while( oidx < olen ) {
         switch( opts[oidx] ) {
         case MCMD_LCHK_ANS: {
-            //int gwmargin = opts[oidx+1];
-            //int ngws = opts[oidx+2];
+            LMIC.gwMargin = opts[oidx+1];
+            LMIC.gwCnt    = opts[oidx+2];
             oidx += 3;
             continue;
         }
@@ -1655,6 +1656,11 @@ static void buildDataFrame (void) {
         end += 2;
         LMIC.ladrAns = 0;
     }
+    if( LMIC.lchkReq ) {  // ask NWK for link margin
+        LMIC.frame[end] = MCMD_LCHK_REQ;
+        end += 1;
+        LMIC.lchkReq = 0;
+    }
 #if !defined(DISABLE_BEACONS)
     if( LMIC.bcninfoTries > 0 ) {
         LMIC.frame[end] = MCMD_BCNI_REQ;
@@ -1888,6 +1894,13 @@ static void processPingRx (xref2osjob_t osjob) {
 static bit_t processDnData (void) {
     ASSERT((LMIC.opmode & OP_TXRXPEND)!=0);
 
+    if( LMIC.dataLen != 0 ) {
+        // Where the preamble started relative to where schedRx12() expected
+        // it (txend + delay); positive means late
+        ostime_t delay = sec2osticks(LMIC.rxDelay + ((LMIC.txrxFlags & TXRX_DNW2) ? (int)DELAY_EXTDNW2 : 0));
+        LMIC.rxOffset = LMIC.rxtime - calcAirTime(LMIC.rps, LMIC.dataLen) - (LMIC.txend + delay);
+    }
+
     if( LMIC.dataLen == 0 ) {
       norx:
         if( LMIC.txCnt != 0 ) {
@@ -2374,6 +2387,13 @@ void LMIC_setLinkCheckMode (bit_t enabled) {
     LMIC.adrAckReq = enabled ? LINK_CHECK_INIT : LINK_CHECK_OFF;
 }
 
+// Piggyback a LinkCheckReq on the next UP frame. The answer (if any)
+// shows up in LMIC.gwMargin/gwCnt when the transaction completes.
+void LMIC_requestLinkCheck (void) {
+    LMIC.lchkReq = 1;
+    LMIC.gwCnt   = 0;
+}
+
 // Sets the max clock error to compensate for (defaults to 0, which
 // allows for +/- 640 at SF7BW250). MAX_CLOCK_ERROR represents +/-100%,
 // so e.g. for a +/-1% error you would pass MAX_CLOCK_ERROR * 1 / 100.
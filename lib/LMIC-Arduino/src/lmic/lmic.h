@@ -193,6 +193,8 @@ struct lmic_t {
 
     u2_t        clockError; // Inaccuracy in the clock. CLOCK_ERROR_MAX
                             // represents +/-100% error
+    ostime_t    rxOnTime;   // time spent in RX windows (accumulated, reset by app)
+    ostime_t    rxOffset;   // last downlink: preamble start - expected (ticks)
 
     u1_t        pendTxPort;
     u1_t        pendTxConf;   // confirmed data
@@ -213,6 +215,9 @@ struct lmic_t {
     u1_t        rxDelay;      // Rx delay after TX
     
     u1_t        margin;
+    u1_t        lchkReq;      // link check request pending
+    u1_t        gwMargin;     // last LinkCheckAns: demod margin [dB]
+    u1_t        gwCnt;        // last LinkCheckAns: gateways (0=no answer)
     bit_t       ladrAns;      // link adr adapt answer pending
     bit_t       devsAns;      // device status answer pending
     u1_t        adrEnabled;
@@ -304,6 +309,7 @@ void  LMIC_tryRejoin     (void);
 
 void LMIC_setSession (u4_t netid, devaddr_t devaddr, xref2u1_t nwkKey, xref2u1_t artKey);
 void LMIC_setLinkCheckMode (bit_t enabled);
+void LMIC_requestLinkCheck (void);
 void LMIC_setClockError(u2_t error);
 
 // Declare onEvent() function, to make sure any definition will have the
@@ -37,7 +37,9 @@ enum { DR_PAGE_US915 = 0x10 };
 
 // Global maximum frame length
 enum { STD_PREAMBLE_LEN  =  8 };
-enum { MAX_LEN_FRAME     = 64 };
+// Raised from 64 so that batched uplinks can use the full EU868 DR3 payload
+// (115 bytes). Keep end+5+dlen in buildDataFrame() below 256.
+enum { MAX_LEN_FRAME     = 128 };
 enum { LEN_DEVNONCE      =  2 };
 enum { LEN_ARTNONCE      =  3 };
 enum { LEN_NETID         =  3 };
@@ -113,6 +113,7 @@ void os_runloop_once()
     bool has_deadline = false;
 #endif
     osjob_t *j = NULL;
+    bit_t idle = 0;
     hal_disableIRQs();
     // check for runnable jobs
     if (OS.runnablejobs) {
@@ -126,6 +127,7 @@ void os_runloop_once()
 #endif
     } else { // nothing pending
         hal_sleep(); // wake by irq (timer already restarted)
+        idle = 1;
     }
     hal_enableIRQs();
     if (j) { // run job callback
@@ -133,5 +135,13 @@ void os_runloop_once()
         lmic_printf("%lu: Running job %p, cb %p, deadline %lu\n", os_getTime(), j, j->func, has_deadline ? j->deadline : 0);
 #endif
         j->func(j);
+    } else if (idle && !OS.runnablejobs) {
+        // Nothing to do right now (hal_enableIRQs() may just have queued a
+        // radio job, hence the re-check): let the HAL sleep until the
+        // first timed job is due or a radio IRQ arrives.
+        if (OS.scheduledjobs)
+            hal_sleepUntil(1, OS.scheduledjobs->deadline);
+        else
+            hal_sleepUntil(0, 0);
     }
 }
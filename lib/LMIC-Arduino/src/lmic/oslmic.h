@@ -105,6 +105,9 @@ void os_runloop_once (void);
 
 typedef s4_t  ostime_t;
 
+// radio_irq_handler() with the time of the DIO edge taken by the hal
+void radio_irq_handler_v2 (u1_t dio, ostime_t now);
+
 #if !HAS_ostick_conv
 #define us2osticks(us)   ((ostime_t)( ((int64_t)(us) * OSTICKS_PER_SEC) / 1000000))
 #define ms2osticks(ms)   ((ostime_t)( ((int64_t)(ms) * OSTICKS_PER_SEC)    / 1000))
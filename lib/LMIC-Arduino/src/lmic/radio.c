@@ -260,41 +260,100 @@ static u1_t randbuf[16];
 #endif
 
 
+// REGISTER SHADOW
+// Last value written to each register. Configuration registers are staged
+// with stageReg() (skipped if unchanged) or queueReg() (always written) and
+// flushRegs() writes the dirty ones as bursts of consecutive addresses, so
+// the settings repeated on every TX/RX cost no SPI transactions. Registers
+// 0x0D-0x3F have different meanings in LoRa and FSK mode, so the shadow is
+// dropped whenever the modem changes (and on reset). Only registers the
+// radio never modifies by itself may be staged with stageReg().
+#define SHADOW_REGS 0x80
+static u1_t shadow[SHADOW_REGS];
+static u1_t shadowValid[SHADOW_REGS/8];
+static u1_t shadowDirty[SHADOW_REGS/8];
+
+#define SHADOW_TEST(set, addr)  ((set)[(addr)>>3] & (1 << ((addr)&7)))
+#define SHADOW_SET(set, addr)   ((set)[(addr)>>3] |= (1 << ((addr)&7)))
+#define SHADOW_CLEAR(set, addr) ((set)[(addr)>>3] &= ~(1 << ((addr)&7)))
+
+static void shadowInvalidate () {
+    os_clearMem(shadowValid, sizeof(shadowValid));
+    os_clearMem(shadowDirty, sizeof(shadowDirty));
+}
+
 static void writeReg (u1_t addr, u1_t data ) {
-    hal_pin_nss(0);
-    hal_spi(addr | 0x80);
-    hal_spi(data);
-    hal_pin_nss(1);
+    // leaving or entering LoRa mode switches the register page
+    if (addr == RegOpMode && (!SHADOW_TEST(shadowValid, RegOpMode) ||
+                              ((shadow[RegOpMode] ^ data) & OPMODE_LORA) != 0)) {
+        shadowInvalidate();
+    }
+    hal_spi_burst(addr | 0x80, &data, 1, HAL_SPI_WRITE);
+    shadow[addr] = data;
+    SHADOW_SET(shadowValid, addr);
+    SHADOW_CLEAR(shadowDirty, addr);
 }
 
 static u1_t readReg (u1_t addr) {
-    hal_pin_nss(0);
-    hal_spi(addr & 0x7F);
-    u1_t val = hal_spi(0x00);
-    hal_pin_nss(1);
+    u1_t val;
+    hal_spi_burst(addr & 0x7F, &val, 1, HAL_SPI_READ);
     return val;
 }
 
 static void writeBuf (u1_t addr, xref2u1_t buf, u1_t len) {
-    hal_pin_nss(0);
-    hal_spi(addr | 0x80);
-    for (u1_t i=0; i<len; i++) {
-        hal_spi(buf[i]);
-    }
-    hal_pin_nss(1);
+    hal_spi_burst(addr | 0x80, buf, len, HAL_SPI_WRITE);
 }
 
 static void readBuf (u1_t addr, xref2u1_t buf, u1_t len) {
-    hal_pin_nss(0);
-    hal_spi(addr & 0x7F);
-    for (u1_t i=0; i<len; i++) {
-        buf[i] = hal_spi(0x00);
+    hal_spi_burst(addr & 0x7F, buf, len, HAL_SPI_READ);
+}
+
+// stage a configuration register, written by flushRegs() only if it changed
+static void stageReg (u1_t addr, u1_t data) {
+    if (SHADOW_TEST(shadowValid, addr) && shadow[addr] == data) {
+        return;
+    }
+    shadow[addr] = data;
+    SHADOW_SET(shadowValid, addr);
+    SHADOW_SET(shadowDirty, addr);
+}
+
+// stage a register that must be written by flushRegs() even if unchanged
+static void queueReg (u1_t addr, u1_t data) {
+    shadow[addr] = data;
+    SHADOW_SET(shadowValid, addr);
+    SHADOW_SET(shadowDirty, addr);
+}
+
+// configuration register as last written (read from the radio if unknown)
+static u1_t shadowReg (u1_t addr) {
+    if (!SHADOW_TEST(shadowValid, addr)) {
+        shadow[addr] = readReg(addr);
+        SHADOW_SET(shadowValid, addr);
+    }
+    return shadow[addr];
+}
+
+// write staged registers, one burst per run of consecutive addresses
+static void flushRegs () {
+    u1_t addr = 0;
+    while (addr < SHADOW_REGS) {
+        if (!SHADOW_TEST(shadowDirty, addr)) {
+            addr++;
+            continue;
+        }
+        u1_t first = addr;
+        while (addr < SHADOW_REGS && SHADOW_TEST(shadowDirty, addr)) {
+            SHADOW_CLEAR(shadowDirty, addr);
+            addr++;
+        }
+        writeBuf(first, &shadow[first], addr - first);
     }
-    hal_pin_nss(1);
 }
 
 static void opmode (u1_t mode) {
-    writeReg(RegOpMode, (readReg(RegOpMode) & ~OPMODE_MASK) | mode);
+    // only the mode bits are changed by the radio itself
+    writeReg(RegOpMode, (shadowReg(RegOpMode) & ~OPMODE_MASK) | mode);
 }
 
 static void opmodeLora() {
@@ -338,22 +397,22 @@ static void configLoraModem () {
 
         if (getIh(LMIC.rps)) {
             mc1 |= SX1276_MC1_IMPLICIT_HEADER_MODE_ON;
-            writeReg(LORARegPayloadLength, getIh(LMIC.rps)); // required length
+            queueReg(LORARegPayloadLength, getIh(LMIC.rps)); // required length
         }
         // set ModemConfig1
-        writeReg(LORARegModemConfig1, mc1);
+        stageReg(LORARegModemConfig1, mc1);
 
         mc2 = (SX1272_MC2_SF7 + ((sf-1)<<4));
         if (getNocrc(LMIC.rps) == 0) {
             mc2 |= SX1276_MC2_RX_PAYLOAD_CRCON;
         }
-        writeReg(LORARegModemConfig2, mc2);
+        stageReg(LORARegModemConfig2, mc2);
 
         mc3 = SX1276_MC3_AGCAUTO;
         if ((sf == SF11 || sf == SF12) && getBw(LMIC.rps) == BW125) {
             mc3 |= SX1276_MC3_LOW_DATA_RATE_OPTIMIZE;
         }
-        writeReg(LORARegModemConfig3, mc3);
+        stageReg(LORARegModemConfig3, mc3);
 #elif CFG_sx1272_radio
         u1_t mc1 = (getBw(LMIC.rps)<<6);
 
@@ -374,13 +433,13 @@ static void configLoraModem () {
 
         if (getIh(LMIC.rps)) {
             mc1 |= SX1272_MC1_IMPLICIT_HEADER_MODE_ON;
-            writeReg(LORARegPayloadLength, getIh(LMIC.rps)); // required length
+            queueReg(LORARegPayloadLength, getIh(LMIC.rps)); // required length
         }
         // set ModemConfig1
-        writeReg(LORARegModemConfig1, mc1);
+        stageReg(LORARegModemConfig1, mc1);
 
         // set ModemConfig2 (sf, AgcAutoOn=1 SymbTimeoutHi=00)
-        writeReg(LORARegModemConfig2, (SX1272_MC2_SF7 + ((sf-1)<<4)) | 0x04);
+        stageReg(LORARegModemConfig2, (SX1272_MC2_SF7 + ((sf-1)<<4)) | 0x04);
 #else
 #error Missing CFG_sx1272_radio/CFG_sx1276_radio
 #endif /* CFG_sx1272_radio */
@@ -389,9 +448,9 @@ static void configLoraModem () {
 static void configChannel () {
     // set frequency: FQ = (FRF * 32 Mhz) / (2 ^ 19)
     uint64_t frf = ((uint64_t)LMIC.freq << 19) / 32000000;
-    writeReg(RegFrfMsb, (u1_t)(frf>>16));
-    writeReg(RegFrfMid, (u1_t)(frf>> 8));
-    writeReg(RegFrfLsb, (u1_t)(frf>> 0));
+    stageReg(RegFrfMsb, (u1_t)(frf>>16));
+    stageReg(RegFrfMid, (u1_t)(frf>> 8));
+    stageReg(RegFrfLsb, (u1_t)(frf>> 0));
 }
 
 
@@ -406,8 +465,8 @@ static void configPower () {
         pw = 2;
     }
     // check board type for BOOST pin
-    writeReg(RegPaConfig, (u1_t)(0x80|(pw&0xf)));
-    writeReg(RegPaDac, readReg(RegPaDac)|0x4);
+    stageReg(RegPaConfig, (u1_t)(0x80|(pw&0xf)));
+    stageReg(RegPaDac, shadowReg(RegPaDac)|0x4);
 
 #elif CFG_sx1272_radio
     // set PA config (2-17 dBm using PA_BOOST)
@@ -417,7 +476,7 @@ static void configPower () {
     } else if(pw < 2) {
         pw = 2;
     }
-    writeReg(RegPaConfig, (u1_t)(0x80|(pw-2)));
+    stageReg(RegPaConfig, (u1_t)(0x80|(pw-2)));
 #else
 #error Missing CFG_sx1272_radio/CFG_sx1276_radio
 #endif /* CFG_sx1272_radio */
@@ -448,6 +507,7 @@ static void txfsk () {
     configChannel();
     // configure output power
     configPower();
+    flushRegs();
 
     // set the IRQ mapping DIO0=PacketSent DIO1=NOP DIO2=NOP
     writeReg(RegDioMapping1, MAP_DIO0_FSK_READY|MAP_DIO1_FSK_NOP|MAP_DIO2_FSK_TXNOP);
@@ -479,22 +539,25 @@ static void txlora () {
     // configure frequency
     configChannel();
     // configure output power
-    writeReg(RegPaRamp, (readReg(RegPaRamp) & 0xF0) | 0x08); // set PA ramp-up time 50 uSec
+    stageReg(RegPaRamp, (shadowReg(RegPaRamp) & 0xF0) | 0x08); // set PA ramp-up time 50 uSec
     configPower();
     // set sync word
-    writeReg(LORARegSyncWord, LORA_MAC_PREAMBLE);
+    stageReg(LORARegSyncWord, LORA_MAC_PREAMBLE);
 
     // set the IRQ mapping DIO0=TxDone DIO1=NOP DIO2=NOP
-    writeReg(RegDioMapping1, MAP_DIO0_LORA_TXDONE|MAP_DIO1_LORA_NOP|MAP_DIO2_LORA_NOP);
+    stageReg(RegDioMapping1, MAP_DIO0_LORA_TXDONE|MAP_DIO1_LORA_NOP|MAP_DIO2_LORA_NOP);
     // clear all radio IRQ flags
-    writeReg(LORARegIrqFlags, 0xFF);
+    queueReg(LORARegIrqFlags, 0xFF);
     // mask all IRQs but TxDone
-    writeReg(LORARegIrqFlagsMask, ~IRQ_LORA_TXDONE_MASK);
+    stageReg(LORARegIrqFlagsMask, ~IRQ_LORA_TXDONE_MASK);
 
     // initialize the payload size and address pointers
-    writeReg(LORARegFifoTxBaseAddr, 0x00);
-    writeReg(LORARegFifoAddrPtr, 0x00);
-    writeReg(LORARegPayloadLength, LMIC.dataLen);
+    stageReg(LORARegFifoTxBaseAddr, 0x00);
+    queueReg(LORARegFifoAddrPtr, 0x00);
+    queueReg(LORARegPayloadLength, LMIC.dataLen);
+
+    // write the changed settings (FIFO pointers must be set before loading it)
+    flushRegs();
 
     // download buffer to the radio FIFO
     writeBuf(RegFifo, LMIC.frame, LMIC.dataLen);
@@ -547,8 +610,8 @@ static void rxlora (u1_t rxmode) {
     opmode(OPMODE_STANDBY);
     // don't use MAC settings at startup
     if(rxmode == RXMODE_RSSI) { // use fixed settings for rssi scan
-        writeReg(LORARegModemConfig1, RXLORA_RXMODE_RSSI_REG_MODEM_CONFIG1);
-        writeReg(LORARegModemConfig2, RXLORA_RXMODE_RSSI_REG_MODEM_CONFIG2);
+        stageReg(LORARegModemConfig1, RXLORA_RXMODE_RSSI_REG_MODEM_CONFIG1);
+        stageReg(LORARegModemConfig2, RXLORA_RXMODE_RSSI_REG_MODEM_CONFIG2);
     } else { // single or continuous rx mode
         // configure LoRa modem (cfg1, cfg2)
         configLoraModem();
@@ -558,22 +621,25 @@ static void rxlora (u1_t rxmode) {
     // set LNA gain
     writeReg(RegLna, LNA_RX_GAIN);
     // set max payload size
-    writeReg(LORARegPayloadMaxLength, 64);
+    stageReg(LORARegPayloadMaxLength, 64);
 #if !defined(DISABLE_INVERT_IQ_ON_RX)
     // use inverted I/Q signal (prevent mote-to-mote communication)
-    writeReg(LORARegInvertIQ, readReg(LORARegInvertIQ)|(1<<6));
+    stageReg(LORARegInvertIQ, shadowReg(LORARegInvertIQ)|(1<<6));
 #endif
     // set symbol timeout (for single rx)
-    writeReg(LORARegSymbTimeoutLsb, LMIC.rxsyms);
+    stageReg(LORARegSymbTimeoutLsb, LMIC.rxsyms);
     // set sync word
-    writeReg(LORARegSyncWord, LORA_MAC_PREAMBLE);
+    stageReg(LORARegSyncWord, LORA_MAC_PREAMBLE);
 
     // configure DIO mapping DIO0=RxDone DIO1=RxTout DIO2=NOP
-    writeReg(RegDioMapping1, MAP_DIO0_LORA_RXDONE|MAP_DIO1_LORA_RXTOUT|MAP_DIO2_LORA_NOP);
+    stageReg(RegDioMapping1, MAP_DIO0_LORA_RXDONE|MAP_DIO1_LORA_RXTOUT|MAP_DIO2_LORA_NOP);
     // clear all radio IRQ flags
-    writeReg(LORARegIrqFlags, 0xFF);
+    queueReg(LORARegIrqFlags, 0xFF);
     // enable required radio IRQs
-    writeReg(LORARegIrqFlagsMask, ~TABLE_GET_U1(rxlorairqmask, rxmode));
+    stageReg(LORARegIrqFlagsMask, ~TABLE_GET_U1(rxlorairqmask, rxmode));
+
+    // write the changed settings
+    flushRegs();
 
     // enable antenna switch for RX
     hal_pin_rxtx(0);
@@ -616,6 +682,7 @@ static void rxfsk (u1_t rxmode) {
     opmode(OPMODE_STANDBY);
     // configure frequency
     configChannel();
+    flushRegs();
     // set LNA gain
     //writeReg(RegLna, 0x20|0x03); // max gain, boost enable
     writeReg(RegLna, LNA_RX_GAIN);
@@ -680,6 +747,8 @@ void radio_init () {
     hal_waitUntil(os_getTime()+ms2osticks(1)); // wait >100us
     hal_pin_rst(2); // configure RST pin floating!
     hal_waitUntil(os_getTime()+ms2osticks(5)); // wait 5ms
+    // registers are back to their reset values
+    shadowInvalidate();
 
     opmode(OPMODE_SLEEP);
 
@@ -762,12 +831,25 @@ static CONST_TABLE(u2_t, LORA_RXDONE_FIXUP)[] = {
 // called by hal ext IRQ handler
 // (radio goes to stanby mode after tx/rx operations)
 void radio_irq_handler (u1_t dio) {
-    ostime_t now = os_getTime();
-    if( (readReg(RegOpMode) & OPMODE_LORA) != 0) { // LORA modem
-        u1_t flags = readReg(LORARegIrqFlags);
+    radio_irq_handler_v2(dio, os_getTime());
+}
+
+// same, with the time of the DIO edge as seen by the hal (now is the
+// reference for txend and rxtime, and so for the RX windows)
+void radio_irq_handler_v2 (u1_t dio, ostime_t now) {
+    if( (shadowReg(RegOpMode) & OPMODE_LORA) != 0) { // LORA modem
+        // one burst: FifoRxCurrentAddr, IrqFlagsMask, IrqFlags, RxNbBytes
+        u1_t irq[4];
+        readBuf(LORARegFifoRxCurrentAddr, irq, sizeof(irq));
+        u1_t flags = irq[LORARegIrqFlags - LORARegFifoRxCurrentAddr];
 #if LMIC_DEBUG_LEVEL > 1
         lmic_printf("%lu: irq: dio: 0x%x flags: 0x%x\n", now, dio, flags);
 #endif
+        if( (flags & (IRQ_LORA_RXDONE_MASK|IRQ_LORA_RXTOUT_MASK)) != 0 &&
+            (shadowReg(RegOpMode) & OPMODE_MASK) == OPMODE_RX_SINGLE ) {
+            // rxlora() opened the window at LMIC.rxtime
+            LMIC.rxOnTime += now - LMIC.rxtime;
+        }
         if( flags & IRQ_LORA_TXDONE_MASK ) {
             // save exact tx time
             LMIC.txend = now - us2osticks(43); // TXDONE FIXUP
@@ -778,23 +860,26 @@ void radio_irq_handler (u1_t dio) {
             }
             LMIC.rxtime = now;
             // read the PDU and inform the MAC that we received something
-            LMIC.dataLen = (readReg(LORARegModemConfig1) & SX1272_MC1_IMPLICIT_HEADER_MODE_ON) ?
-                readReg(LORARegPayloadLength) : readReg(LORARegRxNbBytes);
+            LMIC.dataLen = (shadowReg(LORARegModemConfig1) & SX1272_MC1_IMPLICIT_HEADER_MODE_ON) ?
+                readReg(LORARegPayloadLength) : irq[LORARegRxNbBytes - LORARegFifoRxCurrentAddr];
             // set FIFO read address pointer
-            writeReg(LORARegFifoAddrPtr, readReg(LORARegFifoRxCurrentAddr));
+            writeReg(LORARegFifoAddrPtr, irq[0]);
             // now read the FIFO
             readBuf(RegFifo, LMIC.frame, LMIC.dataLen);
-            // read rx quality parameters
-            LMIC.snr  = readReg(LORARegPktSnrValue); // SNR [dB] * 4
-            LMIC.rssi = readReg(LORARegPktRssiValue) - 125 + 64; // RSSI [dBm] (-196...+63)
+            // read rx quality parameters (PktSnrValue, PktRssiValue)
+            u1_t pkt[2];
+            readBuf(LORARegPktSnrValue, pkt, sizeof(pkt));
+            LMIC.snr  = pkt[0]; // SNR [dB] * 4
+            LMIC.rssi = pkt[1] - 125 + 64; // RSSI [dBm] (-196...+63)
         } else if( flags & IRQ_LORA_RXTOUT_MASK ) {
             // indicate timeout
             LMIC.dataLen = 0;
         }
         // mask all radio IRQs
-        writeReg(LORARegIrqFlagsMask, 0xFF);
+        stageReg(LORARegIrqFlagsMask, 0xFF);
         // clear radio IRQ flags
-        writeReg(LORARegIrqFlags, 0xFF);
+        queueReg(LORARegIrqFlags, 0xFF);
+        flushRegs();
     } else { // FSK modem
         u1_t flags1 = readReg(FSKRegIrqFlags1);
         u1_t flags2 = readReg(FSKRegIrqFlags2);
@@ -16,6 +16,8 @@
  */
 
 #include "LoRaBoards.h"
+#include "../config/config.h"
+#include "logger.h"
 
 #include "soc/rtc.h"
 #ifdef ENABLE_BLE
@@ -60,6 +62,32 @@ String gps_model = "None";
 
 uint32_t deviceOnline = 0x00;
 
+// Inventario de hardware del último arranque completo, para la ruta rápida
+#define BOOT_INVENTORY_MAGIC 0x494E5631UL  // "INV1"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t deviceOnline;   /**< Periféricos detectados (sin la SD, que no se monta) */
+    uint32_t i2cMap[4];      /**< Direcciones que respondieron en Wire */
+    uint8_t  pmuModel;       /**< XPowersChipModel_t detectado (XPOWERS_UNDEFINED si no hay) */
+    uint16_t coldBootMs;     /**< Duración del último arranque completo */
+} boot_inventory_t;
+
+static RTC_DATA_ATTR boot_inventory_t bootInventory;
+static bool fastBoot = false;
+
+// Desglose del tiempo de arranque (ver bootTimeMark())
+#define BOOT_STEPS_MAX 12
+
+typedef struct {
+    const char *name;
+    uint16_t    ms;
+} boot_step_t;
+
+static boot_step_t bootSteps[BOOT_STEPS_MAX];
+static uint8_t bootStepCount = 0;
+static uint32_t bootStepStart = 0;
+
 static void enable_slow_clock();
 
 #ifdef HAS_PMU
@@ -75,35 +103,53 @@ static void setPmuFlag()
     pmuInterrupt = true;
 }
 
+/**
+ * @brief Intenta inicializar un modelo concreto de PMU.
+ *
+ * @param model XPOWERS_AXP2101 o XPOWERS_AXP192.
+ * @return Instancia inicializada, o NULL si el chip no responde.
+ */
+static XPowersLibInterface *probePmu(uint8_t model)
+{
+    const char *name = model == XPOWERS_AXP2101 ? "AXP2101" : "AXP192";
+    XPowersLibInterface *pmu;
+    if (model == XPOWERS_AXP2101) {
+        pmu = new XPowersAXP2101(PMU_WIRE_PORT);
+    } else {
+        pmu = new XPowersAXP192(PMU_WIRE_PORT);
+    }
+    if (!pmu->init()) {
+        Serial.printf("Warning: Failed to find %s power management\n", name);
+        delete pmu;
+        return NULL;
+    }
+    Serial.printf("%s PMU init succeeded, using %s PMU\n", name, name);
+    return pmu;
+}
+
 /**
  * @brief Inicializa el módulo de gestión de energía (PMU).
- *        Intenta inicializar AXP2101 primero, luego AXP192 si falla.
+ *        Intenta inicializar AXP2101 primero, luego AXP192 si falla; en el
+ *        arranque rápido solo se prueba el modelo del inventario.
  *        Configura voltajes, interrupciones y LEDs según el modelo detectado.
  *
  * @return true si la inicialización es exitosa, false en caso contrario.
  */
 bool beginPower()
 {
-    if (!PMU) {
-        PMU = new XPowersAXP2101(PMU_WIRE_PORT);
-        if (!PMU->init()) {
-            Serial.println("Warning: Failed to find AXP2101 power management");
-            delete PMU;
-            PMU = NULL;
-        } else {
-            Serial.println("AXP2101 PMU init succeeded, using AXP2101 PMU");
+    if (!PMU && fastBoot) {
+        if (bootInventory.pmuModel == XPOWERS_UNDEFINED) {
+            return false;
         }
+        PMU = probePmu(bootInventory.pmuModel);
     }
 
     if (!PMU) {
-        PMU = new XPowersAXP192(PMU_WIRE_PORT);
-        if (!PMU->init()) {
-            Serial.println("Warning: Failed to find AXP192 power management");
-            delete PMU;
-            PMU = NULL;
-        } else {
-            Serial.println("AXP192 PMU init succeeded, using AXP192 PMU");
-        }
+        PMU = probePmu(XPOWERS_AXP2101);
+    }
+
+    if (!PMU) {
+        PMU = probePmu(XPOWERS_AXP192);
     }
 
     if (!PMU) {
@@ -303,6 +349,12 @@ bool beginPower()
     PMU->enableVbusVoltageMeasure();
     PMU->enableBattVoltageMeasure();
 
+    // Los canales y el tiempo de apagado ya se mostraron en el arranque completo
+    if (fastBoot) {
+        PMU->setPowerKeyPressOffTime(XPOWERS_POWEROFF_4S);
+        return true;
+    }
+
     Serial.printf("=========================================\n");
     if (PMU->isChannelAvailable(XPOWERS_DCDC1)) {
         Serial.printf("DC1  : %s   Voltage: %04u mV \n",  PMU->isPowerChannelEnable(XPOWERS_DCDC1)  ? "+" : "-",  PMU->getPowerChannelVoltage(XPOWERS_DCDC1));
@@ -438,6 +490,39 @@ void disablePeripherals()
 #endif
 }
 
+/**
+ * @brief Programa el despertar del sueño profundo por la interrupción del PMU.
+ *        Deja activas solo la entrada de VBUS y el inicio de carga, limpia las
+ *        interrupciones pendientes (con alguna activa la línea queda a nivel
+ *        bajo y el ESP32 despertaría al instante) y habilita ext0 en PMU_IRQ.
+ *        Llamar después de disablePeripherals(), que desactiva todas.
+ *        beginPower() restaura la configuración normal al despertar.
+ *
+ * @return true si PMU_IRQ es un pin RTC y puede despertar al ESP32.
+ */
+bool armPmuPowerWakeup()
+{
+    if (!PMU) return false;
+
+    if (PMU->getChipModel() == XPOWERS_AXP2101) {
+        PMU->disableIRQ(XPOWERS_AXP2101_ALL_IRQ);
+        PMU->clearIrqStatus();
+        PMU->enableIRQ(XPOWERS_AXP2101_VBUS_INSERT_IRQ | XPOWERS_AXP2101_BAT_CHG_START_IRQ);
+    } else if (PMU->getChipModel() == XPOWERS_AXP192) {
+        PMU->disableIRQ(XPOWERS_AXP192_ALL_IRQ);
+        PMU->clearIrqStatus();
+        PMU->enableIRQ(XPOWERS_AXP192_VBUS_INSERT_IRQ | XPOWERS_AXP192_BAT_CHG_START_IRQ);
+    }
+
+    // En el ESP32-S3 PMU_IRQ no es un pin RTC: solo queda el temporizador
+    if (!esp_sleep_is_valid_wakeup_gpio((gpio_num_t)PMU_IRQ)) {
+        LOG_INFO_FAST("PMU_IRQ (GPIO%d) no puede despertar del sueño profundo\n", PMU_IRQ);
+        return false;
+    }
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)PMU_IRQ, 0);
+    return true;
+}
+
 /**
  * @brief Maneja el bucle de eventos del PMU.
  *        Verifica interrupciones y procesa eventos como inserción/remoción de batería,
@@ -457,37 +542,34 @@ void loopPMU(void (*pressed_cb)(void))
     pmuInterrupt = false;
     // Get PMU Interrupt Status Register
     uint32_t status = PMU->getIrqStatus();
-    Serial.print("STATUS => HEX:");
-    Serial.print(status, HEX);
-    Serial.print(" BIN:");
-    Serial.println(status, BIN);
+    LOG_INFO_FAST("STATUS => HEX:%lX\n", status);
 
     if (PMU->isVbusInsertIrq()) {
-        Serial.println("isVbusInsert");
+        LOG_INFO_FAST("isVbusInsert\n");
     }
     if (PMU->isVbusRemoveIrq()) {
-        Serial.println("isVbusRemove");
+        LOG_INFO_FAST("isVbusRemove\n");
     }
     if (PMU->isBatInsertIrq()) {
-        Serial.println("isBatInsert");
+        LOG_INFO_FAST("isBatInsert\n");
     }
     if (PMU->isBatRemoveIrq()) {
-        Serial.println("isBatRemove");
+        LOG_INFO_FAST("isBatRemove\n");
     }
     if (PMU->isPekeyShortPressIrq()) {
-        Serial.println("isPekeyShortPress");
+        LOG_INFO_FAST("isPekeyShortPress\n");
         if (pressed_cb) {
             pressed_cb();
         }
     }
     if (PMU->isPekeyLongPressIrq()) {
-        Serial.println("isPekeyLongPress");
+        LOG_INFO_FAST("isPekeyLongPress\n");
     }
     if (PMU->isBatChargeDoneIrq()) {
-        Serial.println("isBatChargeDone");
+        LOG_INFO_FAST("isBatChargeDone\n");
     }
     if (PMU->isBatChargeStartIrq()) {
-        Serial.println("isBatChargeStart");
+        LOG_INFO_FAST("isBatChargeStart\n");
     }
     // Clear PMU Interrupt Status Register
     PMU->clearIrqStatus();
@@ -704,6 +786,81 @@ void printWakeupReason()
 #endif
 }
 
+/**
+ * @brief Clasifica el arranque actual según la causa del despertar.
+ */
+boot_mode_t getBootMode()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_UNDEFINED:
+        return BOOT_MODE_COLD;
+    case ESP_SLEEP_WAKEUP_TIMER:
+        return BOOT_MODE_TIMER;
+    default:
+        return BOOT_MODE_WAKEUP;
+    }
+#else
+    return BOOT_MODE_COLD;
+#endif
+}
+
+/**
+ * @brief Indica si setupBoards() ha tomado la ruta rápida.
+ */
+bool isFastBoot()
+{
+    return fastBoot;
+}
+
+/**
+ * @brief Consulta el mapa del bus I2C principal del último arranque completo.
+ */
+bool i2cDeviceCached(uint8_t addr)
+{
+    if (bootInventory.magic != BOOT_INVENTORY_MAGIC || addr > 127) {
+        return false;
+    }
+    return bootInventory.i2cMap[addr >> 5] & (1UL << (addr & 31));
+}
+
+/**
+ * @brief Cierra un tramo del desglose del tiempo de arranque.
+ *        El primer tramo empieza al arrancar la aplicación (millis() = 0).
+ */
+void bootTimeMark(const char *step)
+{
+    uint32_t now = millis();
+    if (bootStepCount < BOOT_STEPS_MAX) {
+        bootSteps[bootStepCount].name = step;
+        bootSteps[bootStepCount].ms = now - bootStepStart;
+        bootStepCount++;
+    }
+    bootStepStart = now;
+}
+
+/**
+ * @brief Imprime el desglose del tiempo de arranque.
+ */
+void printBootTimes()
+{
+    uint32_t total = millis();
+    LOG_INFO("Arranque %s: %lu ms (", fastBoot ? "rápido" : "completo", (unsigned long)total);
+    for (uint8_t i = 0; i < bootStepCount; i++) {
+        LOG_INFO("%s%s %u", i ? ", " : "", bootSteps[i].name, bootSteps[i].ms);
+    }
+    LOG_INFO_FAST(")\n");
+
+    if (fastBoot) {
+        if (bootInventory.coldBootMs > total) {
+            LOG_INFO_FAST("Arranque completo de referencia: %u ms (%lu ms menos)\n",
+                          bootInventory.coldBootMs, bootInventory.coldBootMs - total);
+        }
+    } else if (bootInventory.magic == BOOT_INVENTORY_MAGIC) {
+        bootInventory.coldBootMs = total > UINT16_MAX ? UINT16_MAX : total;
+    }
+}
+
 /**
  * @brief Obtiene y muestra información del chip ESP32.
  *        Incluye tamaño de flash, modelo, frecuencia, PSRAM, etc.
@@ -791,12 +948,25 @@ void getChipInfo()
 void setupBoards(bool disable_u8g2 )
 {
     Serial.begin(115200);
+    // El resto de módulos registra por el buffer de logger.h; el diagnóstico
+    // de la placa sigue escribiendo directamente (aún no hay nada encolado)
+    logger_begin();
 
     // while (!Serial);
 
     Serial.println("setupBoards");
 
-    getChipInfo();
+    // Despertar por temporizador: el hardware no ha cambiado desde el último
+    // arranque completo, se restaura su inventario en lugar de diagnosticarlo
+    fastBoot = FAST_BOOT_ON_TIMER && getBootMode() == BOOT_MODE_TIMER &&
+               bootInventory.magic == BOOT_INVENTORY_MAGIC;
+    if (fastBoot) {
+        deviceOnline = bootInventory.deviceOnline;
+        Serial.println("Arranque rápido: inventario de hardware restaurado de memoria RTC");
+    } else {
+        getChipInfo();
+    }
+    bootTimeMark("serie");
 
 #if defined(ARDUINO_ARCH_ESP32)
     SPI.begin(RADIO_SCLK_PIN, RADIO_MISO_PIN, RADIO_MOSI_PIN);
@@ -824,8 +994,10 @@ void setupBoards(bool disable_u8g2 )
 
 #ifdef I2C1_SDA
     Wire1.begin(I2C1_SDA, I2C1_SCL);
-    Serial.println("Scan Wire1...");
-    scanDevices(&Wire1);
+    if (!fastBoot) {
+        Serial.println("Scan Wire1...");
+        scanDevices(&Wire1);
+    }
 #endif
 
 #ifdef HAS_GPS
@@ -909,22 +1081,36 @@ void setupBoards(bool disable_u8g2 )
     pinMode(RADIO_DIO2_PIN, INPUT);
 #endif
 
+    bootTimeMark("pines");
+
     beginPower();
+    bootTimeMark("pmu");
 
     // Perform an I2C scan after power-on operation
 #ifdef I2C_SDA
     Wire.begin(I2C_SDA, I2C_SCL);
-    Serial.println("Scan Wire...");
-    scanDevices(&Wire);
+    if (!fastBoot) {
+        Serial.println("Scan Wire...");
+        memset(bootInventory.i2cMap, 0, sizeof(bootInventory.i2cMap));
+        scanDevices(&Wire);
+    }
+    bootTimeMark("i2c");
 #endif
 
-    beginSDCard();
+    // La SD no se usa en el ciclo de medida: solo se monta y prueba al encender
+    if (!fastBoot) {
+        beginSDCard();
+        bootTimeMark("sd");
+    }
 
 #ifdef HAS_DISPLAY
-    beginDisplay();
+    if (!fastBoot || (deviceOnline & DISPLAY_ONLINE)) {
+        beginDisplay();
+    }
     if (u8g2) {
         u8g2->setPowerSave(1);  // Apagar display inmediatamente para ahorro de energía
     }
+    bootTimeMark("pantalla");
 #endif
 
     // scanWiFi();
@@ -969,12 +1155,14 @@ void setupBoards(bool disable_u8g2 )
 #endif
     Serial.println("init done . ");
 
-    // Indicador visual de inicio con LED (breve parpadeo para ahorro de energía)
+    // Indicador visual de inicio con LED (breve parpadeo, solo al encender)
 #ifdef BOARD_LED
-    digitalWrite(BOARD_LED, LED_ON);
-    delay(100);
-    digitalWrite(BOARD_LED, !LED_ON);  // Apagar LED después del parpadeo
-    Serial.println("DEBUG: BOARD_LED turned OFF after setup");
+    if (!fastBoot) {
+        digitalWrite(BOARD_LED, LED_ON);
+        delay(100);
+        digitalWrite(BOARD_LED, !LED_ON);  // Apagar LED después del parpadeo
+        Serial.println("DEBUG: BOARD_LED turned OFF after setup");
+    }
 #endif
 
     // Asegurar que el LED de carga del PMU esté apagado
@@ -982,6 +1170,15 @@ void setupBoards(bool disable_u8g2 )
         PMU->setChargingLedMode(XPOWERS_CHG_LED_OFF);
         Serial.println("DEBUG: PMU charging LED turned OFF");
     }
+
+    // Guardar el inventario para los despertares por temporizador
+    if (!fastBoot) {
+        bootInventory.magic = BOOT_INVENTORY_MAGIC;
+        bootInventory.deviceOnline = deviceOnline & ~SDCARD_ONLINE;
+        bootInventory.pmuModel = PMU ? PMU->getChipModel() : XPOWERS_UNDEFINED;
+        bootInventory.coldBootMs = 0;
+    }
+    bootTimeMark("placa");
 }
 
 
@@ -1099,6 +1296,9 @@ void scanDevices(TwoWire *w)
         err = w->endTransmission();
         if (err == 0) {
             nDevices++;
+            if (w == &Wire) {
+                bootInventory.i2cMap[addr >> 5] |= 1UL << (addr & 31);
+            }
             switch (addr) {
             case 0x34:
                 Serial.println("\tFind AXP192/AXP2101 PMU!");
@@ -1524,70 +1724,100 @@ void scanWiFi()
  *        Si hay PMU, usa el chip AXP192/AXP2101. Si no, usa el ADC y divisor resistivo.
  *        El voltaje máximo esperado es 4.2V (batería 18650 Li-Ion).
  *
- * @return Voltaje de batería en voltios (float).
+ * Aritmética entera: el ADC se lee ya calibrado en mV (eFuse del chip).
+ *
+ * @return Voltaje de batería en mV (0 si no hay lectura válida).
  */
-float readBatteryVoltage() {
+uint16_t readBatteryMillivolts() {
 
 #ifdef HAS_PMU
     if (PMU) {
-        float v = PMU->getBattVoltage() / 1000.0f;
-        Serial.printf("DEBUG: PMU battery voltage raw: %d mV, converted: %.3f V\n", PMU->getBattVoltage(), v);
+        uint16_t mv = PMU->getBattVoltage();
         // Protección: solo valores razonables
-        if (v > 2.5f && v < 4.5f) {
-            Serial.printf("DEBUG: Using PMU voltage: %.3f V\n", v);
-            return v;
+        if (mv > 2500 && mv < 4500) {
+            LOG_DEBUG_FAST("DEBUG: Using PMU voltage: %u mV\n", mv);
+            return mv;
         } else {
-            Serial.printf("DEBUG: PMU voltage %.3f V out of range, trying ADC\n", v);
+            LOG_DEBUG_FAST("DEBUG: PMU voltage %u mV out of range, trying ADC\n", mv);
         }
     } else {
-        Serial.println("DEBUG: PMU not available");
+        LOG_DEBUG_FAST("DEBUG: PMU not available\n");
     }
 #endif
 
 #ifdef ADC_PIN
     // Leer ADC y calcular voltaje usando divisor resistivo
-    uint16_t raw = analogRead(ADC_PIN);
-    float vref = 3.3f; // Voltaje de referencia ESP32
-    float adcMax = 4095.0f;
-    float v_adc = (raw / adcMax) * vref;
-    float r1 = BAT_ADC_PULLUP_RES;
-    float r2 = BAT_ADC_PULLDOWN_RES;
-    float v_bat = v_adc * ((r1 + r2) / r2);
-    // Compensación opcional
-    v_bat += BAT_VOL_COMPENSATION;
-
-    Serial.printf("DEBUG: ADC raw: %d, v_adc: %.3f V, r1: %.0f, r2: %.0f, v_bat: %.3f V\n",
-                  raw, v_adc, r1, r2, v_bat);
+    const uint32_t r1 = (uint32_t)BAT_ADC_PULLUP_RES;
+    const uint32_t r2 = (uint32_t)BAT_ADC_PULLDOWN_RES;
+    uint32_t mv_adc = analogReadMilliVolts(ADC_PIN);
+    int32_t mv_bat = (int32_t)(mv_adc * (r1 + r2) / r2) + (int32_t)(BAT_VOL_COMPENSATION * 1000);
+
+    LOG_DEBUG_FAST("DEBUG: ADC %lu mV, r1: %lu, r2: %lu, v_bat: %ld mV\n", mv_adc, r1, r2, mv_bat);
 
     // Protección: solo valores razonables
-    if (v_bat > 2.5f && v_bat < 4.5f) {
-        Serial.printf("DEBUG: Using ADC voltage: %.3f V\n", v_bat);
-        return v_bat;
+    if (mv_bat > 2500 && mv_bat < 4500) {
+        return (uint16_t)mv_bat;
     } else {
-        Serial.printf("DEBUG: ADC voltage %.3f V out of range\n", v_bat);
+        LOG_DEBUG_FAST("DEBUG: ADC voltage %ld mV out of range\n", mv_bat);
     }
 #endif
 
-    Serial.println("DEBUG: All voltage readings failed, returning 0.0V");
-    // Si todo falla, devuelve 0.0V
-    return 0.0f;
+    LOG_DEBUG_FAST("DEBUG: All voltage readings failed, returning 0 mV\n");
+    // Si todo falla, devuelve 0
+    return 0;
+}
+
+/**
+ * @brief Lee el voltaje de batería en voltios (ver readBatteryMillivolts()).
+ *
+ * @return Voltaje de batería en voltios (float).
+ */
+float readBatteryVoltage() {
+    return readBatteryMillivolts() / 1000.0f;
+}
+
+/**
+ * @brief Curva de tensión en circuito abierto (OCV) de una celda Li-Ion.
+ *        Puntos (mV, %) en orden creciente; entre ellos se interpola.
+ */
+static const struct {
+    uint16_t mv;
+    uint8_t percent;
+} BATTERY_OCV_CURVE[] = {
+    { 3000,   0 }, { 3300,   2 }, { 3500,   5 }, { 3600,  10 }, { 3700,  20 },
+    { 3750,  30 }, { 3790,  40 }, { 3830,  50 }, { 3870,  60 }, { 3920,  70 },
+    { 3980,  80 }, { 4060,  90 }, { 4150, 100 },
+};
+
+/**
+ * @brief Obtiene el porcentaje de batería estimado a partir del voltaje.
+ *        Curva OCV por tramos de una celda Li-Ion (3.0V = 0%, 4.15V = 100%).
+ *        Solo es fiable con la batería en reposo (ver battery_soc.h).
+ *
+ * @param millivolts Voltaje de batería en mV.
+ * @return Porcentaje estimado (0-100).
+ */
+uint8_t batteryPercentFromMillivolts(uint16_t millivolts) {
+    const uint8_t n = sizeof(BATTERY_OCV_CURVE) / sizeof(BATTERY_OCV_CURVE[0]);
+
+    if (millivolts <= BATTERY_OCV_CURVE[0].mv) return 0;
+    if (millivolts >= BATTERY_OCV_CURVE[n - 1].mv) return 100;
+
+    uint8_t i = 1;
+    while (millivolts > BATTERY_OCV_CURVE[i].mv) i++;
+    uint16_t mv0 = BATTERY_OCV_CURVE[i - 1].mv, mv1 = BATTERY_OCV_CURVE[i].mv;
+    uint8_t p0 = BATTERY_OCV_CURVE[i - 1].percent, p1 = BATTERY_OCV_CURVE[i].percent;
+    return (uint8_t)(p0 + (uint32_t)(millivolts - mv0) * (p1 - p0) / (mv1 - mv0));
 }
 
 /**
  * @brief Obtiene el porcentaje de batería estimado a partir del voltaje.
- *        3.3V = 0%, 4.1V = 100% (rango personalizado Li-Ion).
  *
  * @param voltage Voltaje de batería en voltios.
  * @return Porcentaje estimado (0-100).
  */
 uint8_t batteryPercentFromVoltage(float voltage) {
-    const float MIN_VOLTAGE = 3.0f;
-    const float MAX_VOLTAGE = 4.1f;
-    
-    if (voltage < MIN_VOLTAGE) return 0;
-    if (voltage > MAX_VOLTAGE) return 100;
-    
-    float percentage = ((voltage - MIN_VOLTAGE) / (MAX_VOLTAGE - MIN_VOLTAGE)) * 100.0f;
-    return (uint8_t)percentage;
+    if (voltage <= 0.0f) return 0;
+    return batteryPercentFromMillivolts((uint16_t)(voltage * 1000.0f + 0.5f));
 }
 
@@ -0,0 +1,161 @@
+/**
+ * @file      batch.cpp
+ * @brief     Muestreo por lotes: buffer circular de registros en memoria RTC
+ *
+ * Los registros se guardan cuantizados (un código por campo del esquema) y
+ * se empaquetan al construir la trama, codificando cada uno como delta
+ * respecto al anterior.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include "batch.h"
+#include "scheduler.h"      // Intervalo vigente entre muestras
+#include "logger.h"         // Logs diferidos por Serial
+#include "remote_config.h"  // Muestras por uplink fijadas por downlink
+#include "uplink_planner.h" // FOpts pendientes de LMIC
+
+/**
+ * @brief Buffer circular de registros guardado en memoria RTC
+ */
+typedef struct {
+    uint8_t head;                                          /**< Índice del registro más antiguo */
+    uint8_t count;                                         /**< Registros almacenados */
+    payload_record_t records[BATCH_BUFFER_RECORDS];
+} batch_ring_t;
+
+// Buffer en memoria RTC (sobrevive al sueño profundo, se borra al encender)
+static RTC_DATA_ATTR batch_ring_t rtc_batch;
+
+/**
+ * @brief Descarta el contenido si los índices no son coherentes
+ */
+static void batch_check(void) {
+    if (rtc_batch.head >= BATCH_BUFFER_RECORDS || rtc_batch.count > BATCH_BUFFER_RECORDS) {
+        rtc_batch.head = 0;
+        rtc_batch.count = 0;
+    }
+}
+
+/**
+ * @brief Añade un registro al buffer circular
+ */
+bool batch_add_record(const payload_record_t* record) {
+    if (!record) return false;
+    batch_check();
+
+    if (rtc_batch.count == BATCH_BUFFER_RECORDS) {
+        // Buffer lleno: se pierde la muestra más antigua
+        LOG_INFO_FAST("Lote: buffer lleno, se descarta la muestra más antigua\n");
+        rtc_batch.head = (rtc_batch.head + 1) % BATCH_BUFFER_RECORDS;
+        rtc_batch.count--;
+    }
+
+    uint8_t idx = (rtc_batch.head + rtc_batch.count) % BATCH_BUFFER_RECORDS;
+    rtc_batch.records[idx] = *record;
+    rtc_batch.count++;
+    return true;
+}
+
+/**
+ * @brief Número de registros pendientes de enviar
+ */
+uint8_t batch_count(void) {
+    batch_check();
+    return rtc_batch.count;
+}
+
+/**
+ * @brief Indica si el lote está completo y toca enviar
+ */
+bool batch_uplink_due(void) {
+    return batch_count() >= batch_samples_per_uplink();
+}
+
+/**
+ * @brief Muestras por uplink vigentes
+ */
+uint8_t batch_samples_per_uplink(void) {
+    return remote_config_get()->batch_samples;
+}
+
+/**
+ * @brief Indica si este ciclo envía una trama por lotes
+ */
+bool batch_enabled(void) {
+    // Con registros pendientes se vacía el buffer aunque se haya vuelto a 1
+    return batch_samples_per_uplink() > 1 || batch_count() > 0;
+}
+
+/**
+ * @brief Construye una trama por lotes con los registros más antiguos
+ */
+uint8_t batch_build_frame(uint8_t* buffer, uint8_t max_size, uint8_t* records) {
+    if (records) *records = 0;
+    if (!buffer || max_size <= BATCH_HEADER_SIZE) return 0;
+    batch_check();
+    if (rtc_batch.count == 0) return 0;
+
+    // Registros: el primero completo, el resto como delta del anterior
+    payload_bitwriter_t writer;
+    payload_codec_writer_init(&writer, buffer + BATCH_HEADER_SIZE, max_size - BATCH_HEADER_SIZE);
+    const payload_record_t* prev = NULL;
+    uint8_t n = 0;
+    while (n < rtc_batch.count) {
+        const payload_record_t* record = &rtc_batch.records[(rtc_batch.head + n) % BATCH_BUFFER_RECORDS];
+        if (!payload_codec_write_record(&writer, record, prev)) break;
+        prev = record;
+        n++;
+    }
+    if (n == 0) return 0;
+
+    uint16_t interval = scheduler_interval();
+    buffer[0] = n;
+    buffer[1] = rtc_batch.count - n;
+    buffer[2] = interval & 0xFF;
+    buffer[3] = interval >> 8;
+    uint8_t size = BATCH_HEADER_SIZE + payload_codec_writer_bytes(&writer);
+
+    LOG_INFO_FAST("Lote: %u de %u registros en %u bytes\n", n, rtc_batch.count, size);
+
+    if (records) *records = n;
+    return size;
+}
+
+/**
+ * @brief Elimina del buffer los registros ya enviados
+ */
+void batch_commit(uint8_t records) {
+    batch_check();
+    if (records > rtc_batch.count) records = rtc_batch.count;
+
+    rtc_batch.head = (rtc_batch.head + records) % BATCH_BUFFER_RECORDS;
+    rtc_batch.count -= records;
+}
+
+/**
+ * @brief Tamaño máximo de payload de aplicación para un DR (EU868)
+ */
+uint8_t batch_max_frame_size(uint8_t datarate) {
+    // LoRaWAN Regional Parameters, EU863-870, tamaño N sin FOpts
+    static const uint8_t max_payload[] = {
+        51,   // DR0 SF12
+        51,   // DR1 SF11
+        51,   // DR2 SF10
+        115,  // DR3 SF9
+        222,  // DR4 SF8
+        222,  // DR5 SF7
+        222,  // DR6 SF7/250 kHz
+        222   // DR7 FSK
+    };
+    uint8_t size = datarate < sizeof(max_payload) ? max_payload[datarate] : max_payload[0];
+
+    // Los FOpts (LinkCheckReq, respuestas MAC) van dentro del mismo límite M
+    size -= uplink_planner_fopts_size();
+
+    // Limitado además por el buffer de trama de LMIC
+    return size < MAX_LEN_PAYLOAD ? size : MAX_LEN_PAYLOAD;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file      battery_soc.cpp
+ * @brief     Telemetría del PMU y estimación del estado de carga de la batería
+ *
+ * Ver battery_soc.h. El ancla del contador de culombios se guarda en memoria
+ * RTC; se reinicia al encender, tomando la curva OCV como punto de partida.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include "battery_soc.h"
+#include "LoRaBoards.h"         // PMU, readBatteryMillivolts y curva OCV
+#include "logger.h"             // Logs diferidos por Serial
+
+// Identificación del estado en memoria RTC
+#define BATTERY_SOC_MAGIC 0x42534F31UL  // "BSO1"
+
+// Tensión mínima para dar la carga por terminada (100 %)
+#define BATTERY_FULL_MV 4100
+
+/**
+ * @brief Ancla del contador de culombios guardada en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    int32_t  anchor_coulomb;  /**< Cuenta neta (carga - descarga) en el ancla */
+    uint16_t anchor_soc_cp;   /**< Estado de carga en el ancla (centésimas de %) */
+    uint16_t rate_hz;         /**< Frecuencia del ADC del AXP192 */
+    bool     anchored;
+} battery_soc_rtc_t;
+
+static RTC_DATA_ATTR battery_soc_rtc_t rtc_battery;
+static battery_status_t status;
+
+/**
+ * @brief Inicializa el estado si la memoria RTC no es válida (encendido)
+ */
+static void battery_soc_check(void) {
+    if (rtc_battery.magic != BATTERY_SOC_MAGIC) {
+        memset(&rtc_battery, 0, sizeof(rtc_battery));
+        rtc_battery.magic = BATTERY_SOC_MAGIC;
+    }
+}
+
+/**
+ * @brief Nombre corto del origen de la estimación
+ */
+const char* battery_soc_source_name(uint8_t source) {
+    switch (source) {
+    case BATTERY_SOC_GAUGE:   return "medidor";
+    case BATTERY_SOC_COULOMB: return "culombios";
+    case BATTERY_SOC_OCV:     return "OCV";
+    default:                  return "ninguno";
+    }
+}
+
+#ifdef HAS_PMU
+
+// =============================================================================
+// AXP192
+// =============================================================================
+
+/**
+ * @brief Lee la telemetría del AXP192 en tres ráfagas (estado, ADC, culombios)
+ *
+ * @param net_coulomb Cuenta neta del contador de culombios
+ * @return true si la lectura I2C fue correcta
+ */
+static bool read_axp192(int32_t* net_coulomb) {
+    XPowersAXP192* axp = static_cast<XPowersAXP192*>(PMU);
+    uint8_t st[2], adc[0x7D - 0x5A + 1], cc[8];
+
+    if (axp->readRegister(0x00, st, sizeof(st)) != 0) return false;
+    if (axp->readRegister(0x5A, adc, sizeof(adc)) != 0) return false;
+    if (axp->readRegister(0xB0, cc, sizeof(cc)) != 0) return false;
+
+#define ADC12(reg) (((uint16_t)adc[(reg) - 0x5A] << 4) | (adc[(reg) + 1 - 0x5A] & 0x0F))
+#define ADC13(reg) (((uint16_t)adc[(reg) - 0x5A] << 5) | (adc[(reg) + 1 - 0x5A] & 0x1F))
+    status.vbus            = st[0] & 0x20;
+    status.charging        = st[1] & 0x40;
+    status.battery_present = st[1] & 0x20;
+    status.vbus_mv         = status.vbus ? (uint16_t)(ADC12(0x5A) * 17 / 10) : 0;
+    status.die_temp_c10    = (int16_t)ADC12(0x5E) - 1447;
+    status.battery_mv      = status.battery_present ? (uint16_t)(ADC12(0x78) * 11 / 10) : 0;
+    status.current_ma      = (int16_t)(((int32_t)ADC13(0x7A) - ADC13(0x7C)) / 2);
+#undef ADC12
+#undef ADC13
+
+    uint32_t charge    = ((uint32_t)cc[0] << 24) | ((uint32_t)cc[1] << 16) | ((uint32_t)cc[2] << 8) | cc[3];
+    uint32_t discharge = ((uint32_t)cc[4] << 24) | ((uint32_t)cc[5] << 16) | ((uint32_t)cc[6] << 8) | cc[7];
+    *net_coulomb = (int32_t)(charge - discharge);
+    status.coulomb_uah = (int32_t)((int64_t)*net_coulomb * 32768 * 1000 / (3600L * rtc_battery.rate_hz));
+    return true;
+}
+
+/**
+ * @brief Estado de carga por el contador de culombios del AXP192
+ *
+ * Cada cuenta son 65536 * 0,5 mA / (3600 * frecuencia del ADC) mAh.
+ *
+ * @param at_rest La tensión es de reposo: se usa para comprobar la deriva
+ */
+static void estimate_coulomb(int32_t net, bool at_rest) {
+    uint8_t ocv = batteryPercentFromMillivolts(status.battery_mv);
+
+    if (status.vbus && !status.charging && status.battery_mv >= BATTERY_FULL_MV) {
+        // Carga terminada: ancla exacta
+        rtc_battery.anchor_soc_cp = 10000;
+        rtc_battery.anchor_coulomb = net;
+        rtc_battery.anchored = true;
+    } else if (!rtc_battery.anchored) {
+        rtc_battery.anchor_soc_cp = ocv * 100;
+        rtc_battery.anchor_coulomb = net;
+        rtc_battery.anchored = true;
+        LOG_INFO_FAST("Batería: contador de culombios anclado a %u %% (OCV)\n", ocv);
+    }
+
+    int64_t delta_cp = (int64_t)(net - rtc_battery.anchor_coulomb) * 32768 * 10000 /
+                       ((int64_t)3600 * rtc_battery.rate_hz * BATTERY_CAPACITY_MAH);
+    int32_t soc_cp = rtc_battery.anchor_soc_cp + (int32_t)delta_cp;
+    if (soc_cp < 0) soc_cp = 0;
+    if (soc_cp > 10000) soc_cp = 10000;
+    status.soc_percent = (uint8_t)(soc_cp / 100);
+
+    // Con la batería en reposo y sin carga, la curva OCV acota la deriva
+    if (at_rest && !status.vbus &&
+        abs((int)status.soc_percent - (int)ocv) > BATTERY_SOC_MAX_DRIFT) {
+        LOG_INFO_FAST("Batería: deriva del contador (%u %% frente a %u %% OCV), re-anclando\n",
+                      status.soc_percent, ocv);
+        rtc_battery.anchor_soc_cp = ocv * 100;
+        rtc_battery.anchor_coulomb = net;
+        status.soc_percent = ocv;
+    }
+}
+
+// =============================================================================
+// AXP2101
+// =============================================================================
+
+/**
+ * @brief Lee la telemetría del AXP2101 en tres ráfagas (estado, ADC, medidor)
+ *
+ * @return true si la lectura I2C fue correcta
+ */
+static bool read_axp2101(void) {
+    XPowersAXP2101* axp = static_cast<XPowersAXP2101*>(PMU);
+    uint8_t st[2], adc[0x3D - 0x34 + 1], gauge;
+
+    if (axp->readRegister(0x00, st, sizeof(st)) != 0) return false;
+    if (axp->readRegister(0x34, adc, sizeof(adc)) != 0) return false;
+    if (axp->readRegister(0xA4, &gauge, 1) != 0) return false;
+
+    uint16_t vbat = ((uint16_t)(adc[0] & 0x3F) << 8) | adc[1];
+    uint16_t vbus = ((uint16_t)(adc[4] & 0x3F) << 8) | adc[5];
+    uint16_t temp = ((uint16_t)(adc[8] & 0x3F) << 8) | adc[9];
+
+    status.battery_present = st[0] & 0x08;
+    status.vbus            = (st[0] & 0x20) && !(st[1] & 0x08);
+    status.charging        = (st[1] >> 5) == 0x01;
+    status.vbus_mv         = status.vbus ? vbus : 0;
+    status.die_temp_c10    = (int16_t)(220 + (7274 - (int32_t)temp) / 2);
+    status.battery_mv      = status.battery_present ? vbat : 0;
+    status.current_ma      = 0;  // El AXP2101 no mide la corriente de batería
+    status.soc_percent     = gauge > 100 ? 100 : gauge;
+    return true;
+}
+
+#endif // HAS_PMU
+
+// =============================================================================
+// API
+// =============================================================================
+
+/**
+ * @brief Lee la telemetría y estima el estado de carga
+ */
+static bool read_status(bool at_rest) {
+    battery_soc_check();
+
+#ifdef HAS_PMU
+    if (PMU) {
+        uint8_t model = PMU->getChipModel();
+        if (model == XPOWERS_AXP192 && rtc_battery.rate_hz) {
+            int32_t net;
+            if (read_axp192(&net)) {
+                if (status.battery_mv) {
+                    estimate_coulomb(net, at_rest);
+                    status.soc_source = BATTERY_SOC_COULOMB;
+                } else {
+                    status.soc_source = BATTERY_SOC_NONE;
+                }
+                return status.battery_mv > 0;
+            }
+        } else if (model == XPOWERS_AXP2101) {
+            if (read_axp2101()) {
+                status.soc_source = status.battery_mv ? BATTERY_SOC_GAUGE : BATTERY_SOC_NONE;
+                return status.battery_mv > 0;
+            }
+        }
+    }
+#endif
+
+    // Solo ADC (o PMU sin lectura): la curva OCV solo vale en reposo
+    status.battery_mv = readBatteryMillivolts();
+    status.battery_present = status.battery_mv > 0;
+    if (!status.battery_present) {
+        status.soc_source = BATTERY_SOC_NONE;
+    } else if (at_rest || status.soc_source != BATTERY_SOC_OCV) {
+        status.soc_percent = batteryPercentFromMillivolts(status.battery_mv);
+        status.soc_source = BATTERY_SOC_OCV;
+    }
+    return status.battery_present;
+}
+
+/**
+ * @brief Primera lectura del ciclo, con la batería aún en reposo
+ */
+void battery_soc_begin(void) {
+    memset(&status, 0, sizeof(status));
+    status.die_temp_c10 = BATTERY_TEMP_UNKNOWN;
+    battery_soc_check();
+
+#ifdef HAS_PMU
+    if (PMU) {
+        // startDeepSleep() las apaga; el estado de carga las necesita
+        PMU->enableBattDetection();
+        PMU->enableTemperatureMeasure();
+
+        if (PMU->getChipModel() == XPOWERS_AXP192) {
+            XPowersAXP192* axp = static_cast<XPowersAXP192*>(PMU);
+            uint8_t ctrl = 0, speed = 0;
+            axp->readRegister(0xB8, &ctrl, 1);
+            if (!(ctrl & 0x80)) {
+                axp->writeRegister(0xB8, (uint8_t)0x80);  // Activar el contador
+                rtc_battery.anchored = false;
+            }
+            axp->readRegister(0x84, &speed, 1);
+            rtc_battery.rate_hz = 25 << ((speed & 0xC0) >> 6);
+        } else if (PMU->getChipModel() == XPOWERS_AXP2101) {
+            static_cast<XPowersAXP2101*>(PMU)->enableGauge();
+        }
+    }
+#endif
+
+    read_status(true);
+    LOG_INFO("Batería: %u mV, %u %% (%s), %d mA, VBUS %u mV%s\n",
+             status.battery_mv, status.soc_percent, battery_soc_source_name(status.soc_source),
+             status.current_ma, status.vbus_mv, status.charging ? " (cargando)" : "");
+}
+
+/**
+ * @brief Vuelve a leer la telemetría y actualiza el estado de carga
+ */
+bool battery_soc_update(void) {
+    return read_status(false);
+}
+
+/**
+ * @brief Último estado leído
+ */
+const battery_status_t* battery_status(void) {
+    return &status;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file      clock_drift.cpp
+ * @brief     Error de reloj de las ventanas RX según la deriva medida del
+ *            reloj lento RTC
+ *
+ * Las calibraciones son el periodo del reloj lento en µs con
+ * RTC_CLK_CAL_FRACT bits de fracción, el mismo formato que
+ * esp_clk_slowclk_cal_get(). Ver clock_drift.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <lmic.h>
+#include "clock_drift.h"
+#include "LoRaBoards.h"         // Arduino y memoria RTC
+#include "logger.h"             // Logs diferidos por Serial
+#include "soc/rtc.h"            // rtc_clk_cal()
+#include "esp_private/esp_clk.h" // Calibración usada por el light sleep
+
+// Identificación del estado en memoria RTC
+#define DRIFT_MAGIC 0x434C4B31UL  // "CLK1"
+
+// Duplicaciones del error tras confirmados sin downlink
+#define DRIFT_BACKOFF_MAX 4
+
+/**
+ * @brief Estimación de la deriva guardada en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t cal;       /**< Última calibración del reloj lento */
+    uint32_t env_ppm;   /**< Envolvente de la variación entre calibraciones */
+    uint32_t ppm;       /**< Error aplicado a LMIC */
+    uint8_t  samples;   /**< Calibraciones desde el encendido (satura en 255) */
+    uint8_t  backoff;   /**< Duplicaciones activas del error */
+} drift_rtc_t;
+
+static RTC_DATA_ATTR drift_rtc_t rtc_drift;
+
+/**
+ * @brief Inicializa la estimación al encender
+ */
+static void drift_init(void) {
+    if (rtc_drift.magic == DRIFT_MAGIC) return;
+    memset(&rtc_drift, 0, sizeof(rtc_drift));
+    rtc_drift.magic = DRIFT_MAGIC;
+    rtc_drift.ppm = CLOCK_DRIFT_MAX_PPM;
+}
+
+/**
+ * @brief Diferencia relativa entre dos calibraciones en ppm
+ */
+static uint32_t cal_diff_ppm(uint32_t cal, uint32_t ref) {
+    uint32_t diff = cal > ref ? cal - ref : ref - cal;
+    return (uint32_t)((uint64_t)diff * 1000000ULL / ref);
+}
+
+/**
+ * @brief Retardo de despertar como ppm sobre el retardo de RX1
+ *
+ * LMIC solo ensancha las ventanas en proporción al retardo, así que el
+ * retardo fijo se reparte sobre el de RX1, el más corto; RX2 sale algo más
+ * ancha de lo necesario.
+ */
+static uint32_t wake_latency_ppm(void) {
+    uint32_t delay_s = LMIC.rxDelay > 0 ? LMIC.rxDelay : 1;
+    return CLOCK_DRIFT_WAKE_LATENCY_US / delay_s;
+}
+
+/**
+ * @brief Error a aplicar según la envolvente, el backoff y el retardo de
+ *        despertar
+ */
+static uint32_t drift_ppm(void) {
+#if CLOCK_DRIFT_ESTIMATE
+    if (rtc_drift.samples < 2) return CLOCK_DRIFT_MAX_PPM;
+    uint32_t ppm = CLOCK_DRIFT_MARGIN * (rtc_drift.env_ppm + CLOCK_DRIFT_XTAL_PPM);
+    ppm <<= rtc_drift.backoff;
+    if (ppm < CLOCK_DRIFT_MIN_PPM) ppm = CLOCK_DRIFT_MIN_PPM;
+    ppm += wake_latency_ppm();
+    if (ppm > CLOCK_DRIFT_MAX_PPM) ppm = CLOCK_DRIFT_MAX_PPM;
+    return ppm;
+#else
+    return CLOCK_DRIFT_MAX_PPM;
+#endif
+}
+
+/**
+ * @brief Pasa el error en ppm a las unidades de LMIC (MAX_CLOCK_ERROR = 100 %)
+ */
+static void set_clock_error(uint32_t ppm) {
+    rtc_drift.ppm = ppm;
+    uint32_t error = (uint32_t)((uint64_t)ppm * MAX_CLOCK_ERROR / 1000000ULL);
+    LMIC_setClockError(error > 0 ? error : 1);
+}
+
+/**
+ * @brief Aplica a LMIC el error de reloj de la última estimación
+ */
+void clock_drift_begin(void) {
+    drift_init();
+    set_clock_error(drift_ppm());
+}
+
+/**
+ * @brief Calibra el reloj lento y ajusta el error de reloj del próximo uplink
+ */
+void clock_drift_apply(void) {
+    drift_init();
+    LMIC.rxOnTime = 0;
+
+#if CLOCK_DRIFT_ESTIMATE
+    uint32_t cal = rtc_clk_cal(RTC_CAL_RTC_MUX, CLOCK_DRIFT_CAL_CYCLES);
+    if (cal == 0) {
+        LOG_INFO("Reloj: calibración del reloj lento fallida\n");
+        set_clock_error(CLOCK_DRIFT_MAX_PPM);
+        return;
+    }
+
+    // El light sleep de las ventanas RX cuenta con la calibración recién medida
+    uint32_t stale_ppm = cal_diff_ppm(cal, esp_clk_slowclk_cal_get());
+    esp_clk_slowclk_cal_set(cal);
+
+    if (rtc_drift.samples > 0) {
+        uint32_t step_ppm = cal_diff_ppm(cal, rtc_drift.cal);
+        if (step_ppm > CLOCK_DRIFT_MAX_PPM) {
+            // Cambio de fuente (p. ej. arrancó el cristal de 32 kHz): empezar de nuevo
+            rtc_drift.samples = 0;
+            rtc_drift.env_ppm = 0;
+        } else {
+            rtc_drift.env_ppm -= rtc_drift.env_ppm / 8;
+            if (step_ppm > rtc_drift.env_ppm) rtc_drift.env_ppm = step_ppm;
+        }
+        LOG_DEBUG("Reloj: variación %lu ppm desde la calibración anterior, %lu ppm sobre la del sistema\n",
+                  (unsigned long)step_ppm, (unsigned long)stale_ppm);
+    }
+    rtc_drift.cal = cal;
+    if (rtc_drift.samples < 255) rtc_drift.samples++;
+#endif
+
+    set_clock_error(drift_ppm());
+    LOG_INFO("Reloj: error de las ventanas RX %lu ppm (envolvente %lu ppm, x%u, despertar %lu ppm)\n",
+             (unsigned long)rtc_drift.ppm, (unsigned long)rtc_drift.env_ppm, 1u << rtc_drift.backoff,
+             (unsigned long)wake_latency_ppm());
+}
+
+/**
+ * @brief Registra el resultado de las ventanas RX del uplink de datos
+ */
+void clock_drift_on_tx_complete(bool confirmed, uint8_t txrx_flags) {
+    drift_init();
+    bool heard = (txrx_flags & (TXRX_DNW1 | TXRX_DNW2)) != 0;
+
+    if (heard) {
+        LOG_INFO_FAST("RX: %lu ms de ventana, error %lu ppm, downlink en RX%u a %ld us de lo previsto\n",
+                      (unsigned long)osticks2ms(LMIC.rxOnTime), (unsigned long)rtc_drift.ppm,
+                      (txrx_flags & TXRX_DNW1) ? 1 : 2, (long)osticks2us(LMIC.rxOffset));
+        rtc_drift.backoff = 0;
+        return;
+    }
+
+    LOG_INFO_FAST("RX: %lu ms de ventana, error %lu ppm, sin downlink\n",
+                  (unsigned long)osticks2ms(LMIC.rxOnTime), (unsigned long)rtc_drift.ppm);
+    // Un confirmado sin respuesta puede ser una ventana demasiado estrecha
+    if (confirmed && rtc_drift.backoff < DRIFT_BACKOFF_MAX) {
+        rtc_drift.backoff++;
+    }
+}
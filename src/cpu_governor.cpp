@@ -0,0 +1,121 @@
+/**
+ * @file      cpu_governor.cpp
+ * @brief     Frecuencia de la CPU según la fase del ciclo
+ *
+ * Los cambios se hacen con setCpuFrequencyMhz(), que avisa a los drivers de
+ * Arduino (UART, SPI, LEDC) cuando cambia el APB. El tiempo a cada nivel se
+ * mide con esp_timer, que no depende de la frecuencia de la CPU. Ver
+ * cpu_governor.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "cpu_governor.h"
+#include "logger.h"             // Vaciado de logs detenido al cambiar el APB
+
+#if CPU_GOVERNOR
+
+static const uint32_t LEVEL_MHZ[CPU_LEVEL_COUNT] = { CPU_WAIT_MHZ, CPU_BASE_MHZ, CPU_BOOST_MHZ };
+
+static cpu_level_t level = CPU_LEVEL_BOOST;
+static uint8_t boosts = 0;
+static bool started = false;
+static int64_t level_since_us = 0;
+static uint32_t level_ms[CPU_LEVEL_COUNT];
+
+/**
+ * @brief Cambia de nivel y acumula el tiempo pasado en el anterior
+ */
+static void set_level(cpu_level_t next) {
+    if (next == level) return;
+
+    // Por debajo de 80 MHz cambia el APB y con él el divisor de la UART
+    bool apb_change = LEVEL_MHZ[next] < 80 || LEVEL_MHZ[level] < 80;
+    if (apb_change) logger_suspend();
+    bool ok = setCpuFrequencyMhz(LEVEL_MHZ[next]);
+    if (apb_change) logger_resume();
+    if (!ok) return;  // Frecuencia no válida para este cristal: se sigue igual
+
+    int64_t now = esp_timer_get_time();
+    level_ms[level] += (uint32_t)((now - level_since_us) / 1000);
+    level_since_us = now;
+    level = next;
+}
+
+/**
+ * @brief Baja la CPU a la frecuencia base
+ */
+void cpu_governor_begin(void) {
+    started = true;
+    set_level(CPU_LEVEL_BASE);
+}
+
+/**
+ * @brief Abre una ráfaga de cálculo a CPU_BOOST_MHZ
+ */
+void cpu_governor_boost(void) {
+    if (boosts++ == 0 && started) set_level(CPU_LEVEL_BOOST);
+}
+
+/**
+ * @brief Cierra una ráfaga; con la última se vuelve a la frecuencia base
+ */
+void cpu_governor_unboost(void) {
+    if (boosts == 0) return;
+    if (--boosts == 0 && started) set_level(CPU_LEVEL_BASE);
+}
+
+/**
+ * @brief delay() a CPU_WAIT_MHZ si es largo y no hay ráfaga abierta
+ */
+void cpu_governor_delay(uint32_t ms) {
+    if (!started || boosts > 0 || ms < CPU_WAIT_MIN_MS) {
+        delay(ms);
+        return;
+    }
+    // El cambio de nivel (con la UART vaciándose) forma parte de la espera
+    uint32_t deadline = millis() + ms;
+    set_level(CPU_LEVEL_WAIT);
+    int32_t remaining = (int32_t)(deadline - millis());
+    if (remaining > 0) delay(remaining);
+    set_level(CPU_LEVEL_BASE);
+}
+
+/**
+ * @brief Frecuencia actual de la CPU en MHz
+ */
+uint32_t cpu_governor_mhz(void) {
+    return getCpuFrequencyMhz();
+}
+
+/**
+ * @brief Imprime el tiempo del ciclo a cada frecuencia
+ */
+void cpu_governor_report(void) {
+    uint32_t current_ms = (uint32_t)((esp_timer_get_time() - level_since_us) / 1000);
+    uint32_t ms[CPU_LEVEL_COUNT];
+    for (uint8_t i = 0; i < CPU_LEVEL_COUNT; i++) {
+        ms[i] = level_ms[i] + (i == level ? current_ms : 0);
+    }
+    LOG_INFO("CPU: %lu ms a %lu MHz, %lu ms a %lu MHz, %lu ms a %lu MHz\n",
+             (unsigned long)ms[CPU_LEVEL_BOOST], (unsigned long)CPU_BOOST_MHZ,
+             (unsigned long)ms[CPU_LEVEL_BASE], (unsigned long)CPU_BASE_MHZ,
+             (unsigned long)ms[CPU_LEVEL_WAIT], (unsigned long)CPU_WAIT_MHZ);
+}
+
+#else
+
+// Sin gobernador: la CPU se queda a la frecuencia de arranque
+void cpu_governor_begin(void) {}
+void cpu_governor_boost(void) {}
+void cpu_governor_unboost(void) {}
+void cpu_governor_delay(uint32_t ms) { delay(ms); }
+uint32_t cpu_governor_mhz(void) { return getCpuFrequencyMhz(); }
+void cpu_governor_report(void) {}
+
+#endif // CPU_GOVERNOR
@@ -0,0 +1,154 @@
+/**
+ * @file      hibernate.cpp
+ * @brief     Hibernación por batería baja con despertar al volver la carga solar
+ *
+ * Ver hibernate.h. El estado se guarda en memoria RTC; el tiempo en
+ * hibernación se mide con el reloj del sistema, que el ESP32 mantiene con
+ * el temporizador RTC durante el sueño profundo.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include "hibernate.h"
+#include "LoRaBoards.h"         // Arduino y memoria RTC
+#include "battery_soc.h"        // Estado de carga y contador de culombios
+#include "logger.h"             // Logs diferidos por Serial
+#include <esp_system.h>         // esp_reset_reason()
+#include <time.h>
+
+// Identificación del estado en memoria RTC
+#define HIBERNATE_MAGIC 0x48494231UL  // "HIB1"
+
+/**
+ * @brief Estado de la hibernación guardado en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t entered_s;      /**< Reloj del sistema al entrar */
+    int32_t  entry_uah;      /**< Contador de culombios al entrar */
+    uint16_t last_ua;        /**< Consumo medio de la última hibernación */
+    uint16_t wakeups;        /**< Despertares sin salir de la hibernación */
+    bool     active;
+    bool     measurable;     /**< Había contador de culombios al entrar */
+} hibernate_rtc_t;
+
+static RTC_DATA_ATTR hibernate_rtc_t rtc_hibernate;
+
+/**
+ * @brief Inicializa el estado si la memoria RTC no es válida (encendido)
+ */
+static void hibernate_check(void) {
+    if (rtc_hibernate.magic != HIBERNATE_MAGIC) {
+        memset(&rtc_hibernate, 0, sizeof(rtc_hibernate));
+        rtc_hibernate.magic = HIBERNATE_MAGIC;
+        rtc_hibernate.last_ua = HIBERNATE_CURRENT_UNKNOWN;
+    }
+}
+
+/**
+ * @brief Indica si la batería está por debajo del umbral de hibernación
+ */
+bool hibernate_should_enter(void) {
+    const battery_status_t* battery = battery_status();
+    return battery->soc_source != BATTERY_SOC_NONE && !battery->vbus && !battery->charging &&
+           battery->soc_percent < HIBERNATE_SOC_PERCENT;
+}
+
+/**
+ * @brief Indica si el nodo está hibernando
+ */
+bool hibernate_active(void) {
+    hibernate_check();
+    return rtc_hibernate.active;
+}
+
+/**
+ * @brief Sale de la hibernación y calcula el consumo medio durante ella
+ */
+static void hibernate_exit(const char* reason) {
+    const battery_status_t* battery = battery_status();
+    uint32_t elapsed_s = (uint32_t)time(NULL) - rtc_hibernate.entered_s;
+
+    if (rtc_hibernate.measurable && battery->soc_source == BATTERY_SOC_COULOMB && elapsed_s > 0) {
+        int32_t used_uah = rtc_hibernate.entry_uah - battery->coulomb_uah;
+        int32_t avg_ua = used_uah > 0 ? (int32_t)((int64_t)used_uah * 3600 / elapsed_s) : 0;
+        rtc_hibernate.last_ua = avg_ua < HIBERNATE_CURRENT_UNKNOWN ? (uint16_t)avg_ua : HIBERNATE_CURRENT_UNKNOWN - 1;
+        LOG_INFO_FAST("Hibernación: %lu h, %u despertares, consumo medio %ld uA\n",
+                      (unsigned long)(elapsed_s / 3600), rtc_hibernate.wakeups, (long)avg_ua);
+    } else {
+        LOG_INFO_FAST("Hibernación: %lu h, %u despertares\n",
+                      (unsigned long)(elapsed_s / 3600), rtc_hibernate.wakeups);
+    }
+    LOG_INFO("Saliendo de hibernación (%s)\n", reason);
+    rtc_hibernate.active = false;
+}
+
+/**
+ * @brief Decide al despertar si hay que seguir (o empezar a) hibernar
+ */
+bool hibernate_on_wake(void) {
+    hibernate_check();
+    const battery_status_t* battery = battery_status();
+
+    if (!rtc_hibernate.active) {
+        // Reset por brownout con la batería baja: no hay energía para un join
+        if (esp_reset_reason() == ESP_RST_BROWNOUT && hibernate_should_enter()) {
+            LOG_INFO_FAST("Brownout con batería al %u %%: hibernando sin aviso\n", battery->soc_percent);
+            return true;
+        }
+        return false;
+    }
+
+    if (battery->vbus || battery->charging) {
+        hibernate_exit(esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0 ? "interrupción del PMU" : "VBUS");
+        return false;
+    }
+    if (battery->soc_source != BATTERY_SOC_NONE && battery->soc_percent >= HIBERNATE_RESUME_SOC_PERCENT) {
+        hibernate_exit("batería recuperada");
+        return false;
+    }
+
+    rtc_hibernate.wakeups++;
+    LOG_INFO_FAST("Hibernando: batería al %u %% (%u mV), sin VBUS\n",
+                  battery->soc_percent, battery->battery_mv);
+    return true;
+}
+
+/**
+ * @brief Construye el aviso de entrada en hibernación
+ */
+uint8_t hibernate_build_notice(uint8_t* buffer) {
+    hibernate_check();
+    const battery_status_t* battery = battery_status();
+
+    buffer[0] = HIBERNATE_NOTICE_VERSION;
+    buffer[1] = battery->soc_percent;
+    buffer[2] = battery->battery_mv & 0xFF;
+    buffer[3] = battery->battery_mv >> 8;
+    buffer[4] = HIBERNATE_WAKE_HOURS;
+    buffer[5] = rtc_hibernate.last_ua & 0xFF;
+    buffer[6] = rtc_hibernate.last_ua >> 8;
+    return HIBERNATE_NOTICE_SIZE;
+}
+
+/**
+ * @brief Marca el inicio (o la continuación) de la hibernación
+ */
+uint32_t hibernate_prepare_sleep(void) {
+    hibernate_check();
+
+    if (!rtc_hibernate.active) {
+        const battery_status_t* battery = battery_status();
+        rtc_hibernate.active = true;
+        rtc_hibernate.wakeups = 0;
+        rtc_hibernate.entered_s = (uint32_t)time(NULL);
+        rtc_hibernate.entry_uah = battery->coulomb_uah;
+        rtc_hibernate.measurable = battery->soc_source == BATTERY_SOC_COULOMB;
+        LOG_INFO_FAST("Entrando en hibernación: batería al %u %% (%u mV)\n",
+                      battery->soc_percent, battery->battery_mv);
+    }
+    return HIBERNATE_WAKE_HOURS * 3600UL;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file      link_controller.cpp
+ * @brief     Control de DR y potencia de TX según el margen del enlace
+ *
+ * Las SNR se manejan en cuartos de dB, como LMIC.snr (SNR_SCALEUP). La
+ * potencia es la nominal de LMIC (LMIC.adrTxPow, limitada por la banda en
+ * updateTx()). Ver link_controller.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <lmic.h>
+#include <math.h>
+#include "link_controller.h"
+#include "LoRaBoards.h"         // Arduino y memoria RTC
+#include "uplink_planner.h"     // Tiempo en el aire por DR
+#include "logger.h"             // Logs diferidos por Serial
+#include "remote_config.h"      // Política de DR fijada por downlink
+
+// Identificación del estado en memoria RTC
+#define LINK_MAGIC 0x4C4E4B31UL  // "LNK1"
+
+#define LINK_HISTORY 8
+
+// Dispersión mínima del histórico (3 dB): desvanecimiento no observado
+#define LINK_MIN_SIGMA_Q 12
+
+// Suelo de demodulación del SX1276 por DR (DR_SF12 ... DR_SF7), en cuartos de dB
+static const int16_t DEMOD_FLOOR_Q[DR_SF7 + 1] = { -80, -70, -60, -50, -40, -30 };
+
+// Potencias candidatas (dBm nominales) y corriente de TX aproximada por
+// PA_BOOST en mA (hoja de datos del SX1276: 87 mA a +17 dBm; medir en la placa)
+static const int8_t  TXPOW_DBM[] = { 14, 11,  8,  5,  2 };
+static const uint8_t TXPOW_MA[]  = { 80, 62, 50, 42, 36 };
+#define TXPOW_COUNT (sizeof(TXPOW_DBM) / sizeof(TXPOW_DBM[0]))
+
+/**
+ * @brief Histórico del enlace guardado en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    int16_t  snr_q[LINK_HISTORY];  /**< SNR del uplink a potencia máxima */
+    uint8_t  head;                 /**< Próxima posición del histórico */
+    uint8_t  count;                /**< Medidas válidas */
+    uint8_t  base_dr;              /**< DR sin medidas (el de setupLMIC() o el join) */
+    uint8_t  missed;               /**< Comprobaciones seguidas sin respuesta */
+    uint8_t  since_check;          /**< Uplinks desde el último LinkCheckReq */
+    uint32_t checks;               /**< Comprobaciones desde el encendido */
+    uint32_t answered;             /**< Comprobaciones con respuesta */
+} link_rtc_t;
+
+static RTC_DATA_ATTR link_rtc_t rtc_link;
+
+// Comprobación pedida en el uplink en curso
+static bool checkInFlight = false;
+
+/**
+ * @brief Inicializa el histórico al encender
+ */
+static void link_init(void) {
+    if (rtc_link.magic == LINK_MAGIC) return;
+    memset(&rtc_link, 0, sizeof(rtc_link));
+    rtc_link.magic = LINK_MAGIC;
+    rtc_link.base_dr = LMIC.datarate <= DR_SF7 ? LMIC.datarate : DR_SF7;
+}
+
+/**
+ * @brief Potencia máxima: TX_POWER_DBM limitada por la banda g (EU868)
+ */
+static int8_t max_txpow(void) {
+    int8_t cap = LMIC.bands[BAND_CENTI].txpow;
+    return TX_POWER_DBM < cap ? TX_POWER_DBM : cap;
+}
+
+/**
+ * @brief Potencia de salida real del SX1276 por PA_BOOST (ver configPower())
+ */
+static int8_t radio_dbm(int8_t txpow) {
+    if (txpow >= 17) return 17;
+    if (txpow < 2) txpow = 2;
+    return txpow + 2;
+}
+
+/**
+ * @brief Añade una medida normalizada al histórico
+ */
+static void add_sample(int16_t snr_q) {
+    rtc_link.snr_q[rtc_link.head] = snr_q;
+    rtc_link.head = (rtc_link.head + 1) % LINK_HISTORY;
+    if (rtc_link.count < LINK_HISTORY) rtc_link.count++;
+}
+
+/**
+ * @brief Media y dispersión del histórico en cuartos de dB
+ */
+static void history_stats(float* mean_q, float* sigma_q) {
+    float sum = 0, sum2 = 0;
+    for (uint8_t i = 0; i < rtc_link.count; i++) {
+        sum += rtc_link.snr_q[i];
+        sum2 += (float)rtc_link.snr_q[i] * rtc_link.snr_q[i];
+    }
+    *mean_q = sum / rtc_link.count;
+    float var = sum2 / rtc_link.count - *mean_q * *mean_q;
+    *sigma_q = var > 0 ? sqrtf(var) : 0;
+    if (*sigma_q < LINK_MIN_SIGMA_Q) *sigma_q = LINK_MIN_SIGMA_Q;
+}
+
+/**
+ * @brief DR y potencia de menor carga por trama entregada según el histórico
+ */
+static void choose(uint8_t payload_size, uint8_t* dr, int8_t* txpow) {
+    int8_t cap = max_txpow();
+    *dr = rtc_link.base_dr;
+    *txpow = cap;
+    if (rtc_link.count == 0) return;
+
+    float mean_q, sigma_q;
+    history_stats(&mean_q, &sigma_q);
+
+    float best = INFINITY;
+    for (uint8_t d = DR_SF12; d <= DR_SF7; d++) {
+        uint32_t airtime_ms = uplink_planner_airtime_us(d, payload_size) / 1000;
+        for (uint8_t i = 0; i < TXPOW_COUNT; i++) {
+            int8_t pow = TXPOW_DBM[i] < cap ? TXPOW_DBM[i] : cap;
+            float margin_q = mean_q - (cap - pow) * SNR_SCALEUP - DEMOD_FLOOR_Q[d]
+                             - LINK_CONTROLLER_MARGIN_DB * SNR_SCALEUP;
+            // SNR de cada trama ~ normal(media, dispersión del histórico)
+            float delivery = 0.5f * erfcf(-margin_q / (sigma_q * (float)M_SQRT2));
+            float cost = (LINK_CONTROLLER_CYCLE_UC + (float)airtime_ms * TXPOW_MA[i]) / delivery;
+            if (cost < best) {
+                best = cost;
+                *dr = d;
+                *txpow = pow;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Aplica la escalera: un peldaño con la primera comprobación perdida
+ *        y otro cada LINK_CONTROLLER_MISSED_STEP más
+ */
+static void ladder(uint8_t* dr, int8_t* txpow) {
+    uint8_t steps = (rtc_link.missed + LINK_CONTROLLER_MISSED_STEP - 1) / LINK_CONTROLLER_MISSED_STEP;
+    int8_t cap = max_txpow();
+    while (steps-- > 0) {
+        if (*txpow < cap) {
+            *txpow = cap;
+        } else if (*dr > DR_SF12) {
+            (*dr)--;
+        }
+    }
+}
+
+/**
+ * @brief Configura el ADR y el link check de LMIC
+ */
+void link_controller_begin(void) {
+    link_init();
+    if (remote_config_get()->dr_policy == REMOTE_CONFIG_DR_ADR) {
+        // ADRACKReq: LMIC baja el DR por su cuenta si la red deja de responder
+        LMIC_setAdrMode(1);
+        LMIC_setLinkCheckMode(1);
+    } else {
+        LMIC_setAdrMode(0);
+        LMIC_setLinkCheckMode(0);
+    }
+}
+
+/**
+ * @brief Fija el DR y la potencia del próximo uplink
+ */
+void link_controller_apply(uint8_t payload_size) {
+    link_init();
+
+    // Sin medidas o con pérdidas se comprueba en cada uplink
+    checkInFlight = rtc_link.count == 0 || rtc_link.missed > 0 ||
+                    (LINK_CONTROLLER_CHECK_EVERY > 0 &&
+                     rtc_link.since_check + 1 >= LINK_CONTROLLER_CHECK_EVERY);
+    if (checkInFlight) {
+        LMIC_requestLinkCheck();
+        rtc_link.since_check = 0;
+    } else {
+        rtc_link.since_check++;
+    }
+
+    const remote_config_t* config = remote_config_get();
+    if (config->dr_policy == REMOTE_CONFIG_DR_ADR) return;
+
+    uint8_t dr = config->fixed_dr;
+    int8_t txpow = max_txpow();
+    if (config->dr_policy == REMOTE_CONFIG_DR_MODEL) {
+        choose(payload_size, &dr, &txpow);
+        ladder(&dr, &txpow);
+    }
+    if (dr != LMIC.datarate || txpow != LMIC.adrTxPow) {
+        LOG_INFO_FAST("Enlace: DR%u/%d dBm -> DR%u/%d dBm\n", LMIC.datarate, LMIC.adrTxPow, dr, txpow);
+        LMIC_setDrTxpow(dr, txpow);
+    }
+}
+
+/**
+ * @brief Recoge el resultado de la transacción del uplink de datos
+ */
+void link_controller_on_tx_complete(bool confirmed, uint8_t txrx_flags) {
+    link_init();
+    bool heard = (txrx_flags & (TXRX_DNW1 | TXRX_DNW2)) != 0;
+    bool probe = checkInFlight || confirmed;
+    checkInFlight = false;
+
+    if (probe) rtc_link.checks++;
+
+    if (!heard) {
+        if (!probe) return;
+        rtc_link.missed++;
+        LOG_INFO_FAST("Enlace: comprobación sin respuesta (%u seguidas)\n", rtc_link.missed);
+        // Medida censurada: la SNR no llegó al suelo del DR usado. Sin ella el
+        // histórico solo vería las tramas que pasan y sobrestimaría el margen
+        if (LMIC.datarate <= DR_SF7) {
+            add_sample(DEMOD_FLOOR_Q[LMIC.datarate] + (max_txpow() - (int8_t)LMIC.txpow) * SNR_SCALEUP);
+        }
+        // El ADR de la red no puede corregir lo que no oye: mismos peldaños
+        if (remote_config_get()->dr_policy == REMOTE_CONFIG_DR_ADR &&
+            (rtc_link.missed - 1) % LINK_CONTROLLER_MISSED_STEP == 0) {
+            int8_t cap = max_txpow();
+            if (LMIC.adrTxPow < cap) {
+                LMIC_setDrTxpow(LMIC.datarate, cap);
+            } else if (LMIC.datarate > DR_SF12) {
+                LMIC_setDrTxpow(LMIC.datarate - 1, KEEP_TXPOW);
+            }
+        }
+        return;
+    }
+
+    // Si la escalera llegó a bajar el DR el enlace ha cambiado: el histórico
+    // anterior ya no vale
+    if (rtc_link.missed > LINK_CONTROLLER_MISSED_STEP) {
+        rtc_link.count = 0;
+        rtc_link.head = 0;
+    }
+    rtc_link.missed = 0;
+    if (probe) rtc_link.answered++;
+
+    // Un LinkADRReq en el mismo downlink puede haber cambiado ya el DR
+    if (LMIC.ladrAns || LMIC.datarate > DR_SF7) return;
+
+    int8_t cap = max_txpow();
+    int16_t to_max_q = (cap - (int8_t)LMIC.txpow) * SNR_SCALEUP;
+    if (LMIC.gwCnt > 0) {
+        // Margen sobre el suelo de demodulación del DR del uplink
+        add_sample(LMIC.gwMargin * SNR_SCALEUP + DEMOD_FLOOR_Q[LMIC.datarate] + to_max_q);
+        LOG_INFO_FAST("Enlace: LinkCheckAns margen %u dB, %u gateways\n", LMIC.gwMargin, LMIC.gwCnt);
+        LMIC.gwCnt = 0;
+    } else if (txrx_flags & TXRX_DNW1) {
+        // RX1 sale a LINK_CONTROLLER_GW_TX_DBM: reciprocidad del enlace
+        int16_t up_q = LMIC.snr + (radio_dbm(LMIC.txpow) - LINK_CONTROLLER_GW_TX_DBM) * SNR_SCALEUP;
+        add_sample(up_q + to_max_q);
+        LOG_INFO_FAST("Enlace: downlink RSSI %d dBm, SNR %d/4 dB\n", LMIC.rssi - RSSI_OFF, LMIC.snr);
+    }
+
+    LOG_DEBUG_FAST("Enlace: %u medidas, %lu/%lu comprobaciones respondidas\n", rtc_link.count,
+              (unsigned long)rtc_link.answered, (unsigned long)rtc_link.checks);
+}
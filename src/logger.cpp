@@ -0,0 +1,282 @@
+/**
+ * @file      logger.cpp
+ * @brief     Logs por Serial diferidos a un buffer circular, filtrados por nivel
+ *
+ * Buffer circular de bytes con índices libres (se desbordan y se enmascaran
+ * con LOG_BUFFER_BYTES - 1). Solo el productor escribe head y solo el
+ * consumidor escribe tail, así que basta con orden acquire/release; el
+ * mutex solo serializa a los consumidores (tarea, logger_flush() y
+ * logger_suspend()), y la tarea lo toma entrada a entrada. Ver logger.h.
+ *
+ * Cada entrada empieza con una cabecera de 4 bytes (tamaño total, tipo y
+ * número de argumentos) seguida de:
+ * - Texto: los caracteres, sin terminador
+ * - Diferido: el puntero al formato y los argumentos
+ * - Volcado: el puntero a la etiqueta y los bytes
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "logger.h"
+
+#if LOGGER_ENABLED
+
+static_assert((LOG_BUFFER_BYTES & (LOG_BUFFER_BYTES - 1)) == 0, "LOG_BUFFER_BYTES debe ser potencia de 2");
+
+// Línea más larga que se formatea (se trunca)
+#define LOGGER_LINE_MAX 192
+
+// Periodo de vaciado de la tarea
+#define LOGGER_DRAIN_PERIOD_MS 20
+
+/**
+ * @brief Tipo de entrada del buffer
+ */
+typedef enum {
+    LOGGER_ENTRY_TEXT,
+    LOGGER_ENTRY_DEFERRED,
+    LOGGER_ENTRY_HEX
+} logger_entry_kind_t;
+
+/**
+ * @brief Cabecera de cada entrada del buffer
+ */
+typedef struct {
+    uint16_t size;   /**< Bytes de la entrada, cabecera incluida */
+    uint8_t  kind;   /**< logger_entry_kind_t */
+    uint8_t  count;  /**< Argumentos del mensaje diferido */
+} logger_header_t;
+
+static uint8_t ring[LOG_BUFFER_BYTES];
+static std::atomic<uint32_t> head(0);     // Escrito solo por el productor
+static std::atomic<uint32_t> tail(0);     // Escrito solo por el consumidor
+static std::atomic<uint32_t> dropped(0);  // Entradas descartadas por buffer lleno
+
+static SemaphoreHandle_t drain_lock = NULL;
+static std::atomic<bool> suspend_requested(false);  // logger_suspend() en curso
+static TaskHandle_t drain_task = NULL;
+
+/**
+ * @brief Copia bytes al buffer a partir de un índice libre
+ */
+static void ring_write(uint32_t index, const void* data, uint32_t len) {
+    uint32_t offset = index & (LOG_BUFFER_BYTES - 1);
+    uint32_t first = LOG_BUFFER_BYTES - offset;
+    if (first > len) first = len;
+    memcpy(&ring[offset], data, first);
+    memcpy(ring, (const uint8_t*)data + first, len - first);
+}
+
+/**
+ * @brief Copia bytes del buffer a partir de un índice libre
+ */
+static void ring_read(uint32_t index, void* data, uint32_t len) {
+    uint32_t offset = index & (LOG_BUFFER_BYTES - 1);
+    uint32_t first = LOG_BUFFER_BYTES - offset;
+    if (first > len) first = len;
+    memcpy(data, &ring[offset], first);
+    memcpy((uint8_t*)data + first, ring, len - first);
+}
+
+/**
+ * @brief Añade una entrada de dos partes; la descarta si no cabe
+ */
+static void ring_push(uint8_t kind, uint8_t count, const void* a, uint16_t a_len,
+                      const void* b, uint16_t b_len) {
+    logger_header_t header = { (uint16_t)(sizeof(header) + a_len + b_len), kind, count };
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t used = h - tail.load(std::memory_order_acquire);
+
+    if (LOG_BUFFER_BYTES - used < header.size) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring_write(h, &header, sizeof(header));
+    ring_write(h + sizeof(header), a, a_len);
+    ring_write(h + sizeof(header) + a_len, b, b_len);
+    head.store(h + header.size, std::memory_order_release);
+}
+
+/**
+ * @brief Formatea una entrada del buffer como texto
+ *
+ * @return Caracteres escritos en line
+ */
+static size_t format_entry(const logger_header_t* header, uint32_t index, char* line) {
+    uint16_t payload = header->size - sizeof(*header);
+    int n = 0;
+
+    switch (header->kind) {
+        case LOGGER_ENTRY_TEXT:
+            n = payload < LOGGER_LINE_MAX ? payload : LOGGER_LINE_MAX;
+            ring_read(index, line, n);
+            break;
+
+        case LOGGER_ENTRY_DEFERRED: {
+            const char* fmt;
+            uint32_t args[LOGGER_DEFERRED_MAX_ARGS] = { 0 };
+            ring_read(index, &fmt, sizeof(fmt));
+            ring_read(index + sizeof(fmt), args, header->count * sizeof(uint32_t));
+            n = snprintf(line, LOGGER_LINE_MAX, fmt, args[0], args[1], args[2], args[3]);
+            break;
+        }
+
+        case LOGGER_ENTRY_HEX: {
+            const char* label;
+            uint8_t bytes[LOGGER_HEX_MAX_BYTES];
+            uint16_t len = payload - sizeof(label);
+            ring_read(index, &label, sizeof(label));
+            ring_read(index + sizeof(label), bytes, len);
+            n = snprintf(line, LOGGER_LINE_MAX, "%s [", label);
+            for (uint16_t i = 0; i < len && n < LOGGER_LINE_MAX - 5; i++) {
+                n += snprintf(line + n, LOGGER_LINE_MAX - n, i ? " %02X" : "%02X", bytes[i]);
+            }
+            n += snprintf(line + n, LOGGER_LINE_MAX - n, "]\n");
+            break;
+        }
+    }
+    return n < 0 ? 0 : (n < LOGGER_LINE_MAX ? n : LOGGER_LINE_MAX - 1);
+}
+
+/**
+ * @brief Escribe por Serial la entrada más antigua (con drain_lock tomado o
+ *        sin tarea)
+ *
+ * @return false si el buffer estaba vacío
+ */
+static bool drain_entry(void) {
+    static char line[LOGGER_LINE_MAX];
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+
+    logger_header_t header;
+    ring_read(t, &header, sizeof(header));
+    size_t n = format_entry(&header, t + sizeof(header), line);
+    // Liberar el hueco antes de la escritura lenta en la UART
+    tail.store(t + header.size, std::memory_order_release);
+    Serial.write((const uint8_t*)line, n);
+    return true;
+}
+
+/**
+ * @brief Avisa de los mensajes descartados, tras vaciar el buffer
+ */
+static void drain_report_dropped(void) {
+    // Los descartados son posteriores a lo que había en el buffer
+    uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost) {
+        Serial.printf("[log] %lu mensajes descartados (buffer lleno)\n", (unsigned long)lost);
+    }
+}
+
+/**
+ * @brief Tarea de baja prioridad que vacía el buffer periódicamente
+ *
+ * Toma drain_lock para cada entrada y no para todo el buffer (4 KB son
+ * cientos de ms a 115200 baudios), y se detiene entre entradas si
+ * logger_suspend() lo pide: un light sleep solo espera a la línea en curso.
+ */
+static void drain_task_main(void*) {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(LOGGER_DRAIN_PERIOD_MS));
+        bool more = true;
+        while (more && !suspend_requested.load(std::memory_order_acquire)) {
+            xSemaphoreTake(drain_lock, portMAX_DELAY);
+            more = drain_entry();
+            if (!more) drain_report_dropped();
+            xSemaphoreGive(drain_lock);
+        }
+    }
+}
+
+/**
+ * @brief Arranca la tarea que vacía el buffer por Serial
+ */
+void logger_begin(void) {
+    if (drain_task) return;
+
+    drain_lock = xSemaphoreCreateMutex();
+    // En el núcleo que no ejecuta loop(): el vaciado no le roba CPU
+    BaseType_t core = portNUM_PROCESSORS > 1 ? !xPortGetCoreID() : 0;
+    xTaskCreatePinnedToCore(drain_task_main, "logger", 3072, NULL, tskIDLE_PRIORITY + 1, &drain_task, core);
+}
+
+/**
+ * @brief Vacía el buffer y espera a que la UART termine de transmitir
+ */
+void logger_flush(void) {
+    if (drain_lock) xSemaphoreTake(drain_lock, portMAX_DELAY);
+    while (drain_entry()) {}
+    drain_report_dropped();
+    Serial.flush();
+    if (drain_lock) xSemaphoreGive(drain_lock);
+}
+
+/**
+ * @brief Detiene el vaciado y espera a que la UART termine de transmitir
+ */
+void logger_suspend(void) {
+    // La tarea para tras la entrada que esté escribiendo
+    suspend_requested.store(true, std::memory_order_release);
+    if (drain_lock) xSemaphoreTake(drain_lock, portMAX_DELAY);
+    Serial.flush();
+}
+
+/**
+ * @brief Reanuda el vaciado tras logger_suspend()
+ */
+void logger_resume(void) {
+    if (drain_lock) xSemaphoreGive(drain_lock);
+    suspend_requested.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Formatea un mensaje y lo copia al buffer
+ */
+void logger_printf(const char* fmt, ...) {
+    char line[LOGGER_LINE_MAX];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n <= 0) return;
+    if (n >= (int)sizeof(line)) n = sizeof(line) - 1;
+    ring_push(LOGGER_ENTRY_TEXT, 0, line, n, NULL, 0);
+}
+
+/**
+ * @brief Copia un mensaje diferido al buffer
+ */
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {
+    ring_push(LOGGER_ENTRY_DEFERRED, count, &fmt, sizeof(fmt), args, count * sizeof(uint32_t));
+}
+
+/**
+ * @brief Copia un volcado de bytes al buffer
+ */
+void logger_hex(const char* label, const void* data, uint16_t len) {
+    if (len > LOGGER_HEX_MAX_BYTES) len = LOGGER_HEX_MAX_BYTES;
+    ring_push(LOGGER_ENTRY_HEX, 0, &label, sizeof(label), data, len);
+}
+
+#else
+
+// Sin logs: solo queda esperar a la UART por las escrituras directas
+void logger_begin(void) {}
+void logger_flush(void) { Serial.flush(); }
+void logger_suspend(void) { Serial.flush(); }
+void logger_resume(void) {}
+void logger_printf(const char* fmt, ...) {}
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {}
+void logger_hex(const char* label, const void* data, uint16_t len) {}
+
+#endif // LOGGER_ENABLED
@@ -29,6 +29,10 @@
 #include "LoRaBoards.h"   // Configuración de hardware y pines
 #include "screen.h"       // Gestión de pantalla
 #include "ttn_decoder_generator.h"  // Generador de decoders TTN
+#include "profiler.h"     // Perfil de fases del ciclo
+#include "battery_soc.h"  // Estado de carga de la batería
+#include "logger.h"       // Logs diferidos por Serial
+#include "cpu_governor.h" // Frecuencia de la CPU por fase
 #ifdef ENABLE_SENSOR_PH
 #include "sensor_interface.h" // Para `sensor_ph_process_serial()`
 #endif
@@ -43,22 +47,51 @@
  */
 void setup()
 {
+    PHASE_BEGIN(PROFILER_PHASE_BOOT);
     setupBoards(false);  // Configura pines y periféricos, mantiene display activo para gestión
+    PHASE_END(PROFILER_PHASE_BOOT);
+
+    // Frecuencia base desde aquí; las ráfagas de cálculo suben a CPU_BOOST_MHZ
+    cpu_governor_begin();
+
+    // Batería en reposo, antes de encender la radio y los sensores
+    battery_soc_begin();
+
+    // Hibernación por batería baja: vuelve a dormir hasta que llegue VBUS
+    runHibernationCheck();
+
+    // Despertar de solo medición: guarda la muestra y vuelve a dormir sin radio ni LMIC
+    runSampleOnlyCycle();
+
     // Retraso necesario para estabilización de alimentación al encender
-    delay(1500);
-    Serial.println("Proyecto de Sensor LoRaWAN de Bajo Consumo Iniciando...");
+    // (tras el sueño profundo la alimentación ya es estable)
+    if (!isFastBoot()) {
+        cpu_governor_delay(1500);
+        bootTimeMark("estabilizacion");
+    }
+    LOG_INFO_FAST("Proyecto de Sensor LoRaWAN de Bajo Consumo Iniciando...\n");
+    PHASE_BEGIN(PROFILER_PHASE_LMIC_SETUP);
     setupLMIC();    // Inicializa LMIC y sensor DHT22
+    PHASE_END(PROFILER_PHASE_LMIC_SETUP);
+    bootTimeMark("lmic");
 
-    // Generar e imprimir decoder TTN si está habilitado
+    // Generar e imprimir decoder TTN si está habilitado (solo al encender)
     generate_and_print_ttn_decoder();
+    bootTimeMark("decoder");
 
     // Inicializar watchdog timer (WATCHDOG_TIMEOUT_MINUTES minutos)
     esp_task_wdt_init(WATCHDOG_TIMEOUT_MINUTES * 60, true); // Timeout en segundos, panic on timeout
     esp_task_wdt_add(NULL);       // Agregar tarea actual al WDT
 
     // Inicializar sistema de pantalla
+    PHASE_BEGIN(PROFILER_PHASE_DISPLAY);
     initDisplay();
     showInfo("Sistema Iniciado", 3000);
+    PHASE_END(PROFILER_PHASE_DISPLAY);
+    bootTimeMark("display");
+
+    // Desglose del arranque (comparado con el último arranque completo)
+    printBootTimes();
 }
 
 /**
@@ -71,7 +104,12 @@ void setup()
 void loop()
 {
     loopLMIC();     // Procesa eventos LoRaWAN y gestiona el ciclo de bajo consumo
+    PHASE_BEGIN(PROFILER_PHASE_DISPLAY);
     updateDisplay(); // Gestiona la pantalla y mensajes
+    PHASE_END(PROFILER_PHASE_DISPLAY);
+
+    // Volcado del perfil de fases por Serial (comando PROFILE)
+    profiler_process_serial();
 
 #ifdef ENABLE_SENSOR_PH
     // Permitir calibración por Serial (ENTERPH / CALPH / EXITPH)
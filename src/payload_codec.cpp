@@ -0,0 +1,167 @@
+/**
+ * @file      payload_codec.cpp
+ * @brief     Codec compacto del payload basado en un esquema de campos
+ *
+ * Implementa la cuantización y el empaquetado a nivel de bit descritos en
+ * payload_codec.h. El esquema está en config/payload_schema.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include "payload_codec.h"
+#include "payload_schema.h"     // Esquema de campos
+#include "LoRaBoards.h"         // Para batteryPercentFromMillivolts
+#include "battery_soc.h"        // Estado de carga estimado
+
+#define PAYLOAD_FIELD_COUNT (sizeof(PAYLOAD_SCHEMA) / sizeof(PAYLOAD_SCHEMA[0]))
+
+static_assert(PAYLOAD_FIELD_COUNT <= PAYLOAD_MAX_FIELDS, "Demasiados campos en PAYLOAD_SCHEMA");
+
+/**
+ * @brief Número de campos del esquema activo
+ */
+uint8_t payload_codec_field_count(void) {
+    return PAYLOAD_FIELD_COUNT;
+}
+
+/**
+ * @brief Descripción del campo i del esquema
+ */
+const payload_field_t* payload_codec_field(uint8_t index) {
+    return index < PAYLOAD_FIELD_COUNT ? &PAYLOAD_SCHEMA[index] : NULL;
+}
+
+/**
+ * @brief Bits de un campo codificado como valor completo
+ */
+uint8_t payload_codec_field_bits(const payload_field_t* field) {
+    uint16_t max_code = field->max_code;
+    uint8_t bits = 0;
+    while (max_code) {
+        bits++;
+        max_code >>= 1;
+    }
+    return bits;
+}
+
+/**
+ * @brief Tamaño en bytes de un registro completo (sin delta)
+ */
+uint8_t payload_codec_record_size(void) {
+    uint16_t bits = 0;
+    for (uint8_t i = 0; i < PAYLOAD_FIELD_COUNT; i++) {
+        bits += payload_codec_field_bits(&PAYLOAD_SCHEMA[i]);
+    }
+    return (bits + 7) / 8;
+}
+
+/**
+ * @brief Cuantiza las lecturas de los sensores según el esquema
+ */
+void payload_codec_quantize(const sensor_data_t* data, payload_record_t* record) {
+    memset(record, 0, sizeof(*record));
+    if (!data) return;
+
+    sensor_data_t values = *data;
+#ifdef BATTERY_AS_PERCENTAGE
+    // Estado de carga del estimador; sin él, curva OCV sobre la tensión
+    const battery_status_t* battery = battery_status();
+    values.battery = battery->soc_source != BATTERY_SOC_NONE
+                     ? battery->soc_percent
+                     : batteryPercentFromMillivolts((uint16_t)values.battery);
+#endif
+
+    for (uint8_t i = 0; i < PAYLOAD_FIELD_COUNT; i++) {
+        const payload_field_t* field = &PAYLOAD_SCHEMA[i];
+        if (!(values.valid_mask & field->valid_bit)) continue;
+
+        int32_t value = *(const int32_t*)((const uint8_t*)&values + field->offset);
+        int32_t offset = value - field->raw_min;
+
+        // Fuera de rango: sin lectura. Se compara el valor y no el código
+        // redondeado, que admitiría hasta medio paso por encima del máximo
+        if (offset < 0 || offset > (int32_t)(field->max_code - 1) * field->raw_step) continue;
+        uint32_t code = ((uint32_t)offset + field->raw_step / 2) / field->raw_step + 1;
+
+        record->code[i] = (uint16_t)code;
+    }
+}
+
+/**
+ * @brief Inicializa un escritor de bits
+ */
+void payload_codec_writer_init(payload_bitwriter_t* writer, uint8_t* buffer, uint8_t max_size) {
+    writer->buffer = buffer;
+    writer->max_bits = (uint16_t)max_size * 8;
+    writer->bits = 0;
+    memset(buffer, 0, max_size);
+}
+
+/**
+ * @brief Escribe los n bits menos significativos de value (MSB primero)
+ */
+static void write_bits(payload_bitwriter_t* writer, uint32_t value, uint8_t n) {
+    while (n--) {
+        if ((value >> n) & 1) {
+            writer->buffer[writer->bits >> 3] |= 0x80 >> (writer->bits & 7);
+        }
+        writer->bits++;
+    }
+}
+
+/**
+ * @brief Indica si la delta entre dos códigos cabe en los bits del campo
+ */
+static bool delta_fits(const payload_field_t* field, uint16_t code, uint16_t prev, int32_t* delta) {
+    if (code == 0 || prev == 0 || field->delta_bits == 0) return false;
+
+    *delta = (int32_t)code - (int32_t)prev;
+    int32_t limit = 1L << (field->delta_bits - 1);
+    return *delta >= -limit && *delta < limit;
+}
+
+/**
+ * @brief Añade un registro al flujo de bits
+ */
+bool payload_codec_write_record(payload_bitwriter_t* writer, const payload_record_t* record,
+                                const payload_record_t* prev) {
+    // Calcular primero el tamaño para no dejar un registro a medias
+    uint16_t needed = 0;
+    for (uint8_t i = 0; i < PAYLOAD_FIELD_COUNT; i++) {
+        const payload_field_t* field = &PAYLOAD_SCHEMA[i];
+        int32_t delta;
+        if (!prev) {
+            needed += payload_codec_field_bits(field);
+        } else if (delta_fits(field, record->code[i], prev->code[i], &delta)) {
+            needed += 1 + field->delta_bits;
+        } else {
+            needed += 1 + payload_codec_field_bits(field);
+        }
+    }
+    if (writer->bits + needed > writer->max_bits) return false;
+
+    for (uint8_t i = 0; i < PAYLOAD_FIELD_COUNT; i++) {
+        const payload_field_t* field = &PAYLOAD_SCHEMA[i];
+        int32_t delta;
+        if (!prev) {
+            write_bits(writer, record->code[i], payload_codec_field_bits(field));
+        } else if (delta_fits(field, record->code[i], prev->code[i], &delta)) {
+            write_bits(writer, 0, 1);
+            write_bits(writer, (uint32_t)delta, field->delta_bits);
+        } else {
+            write_bits(writer, 1, 1);
+            write_bits(writer, record->code[i], payload_codec_field_bits(field));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Bytes ocupados por el flujo de bits (redondeando hacia arriba)
+ */
+uint8_t payload_codec_writer_bytes(const payload_bitwriter_t* writer) {
+    return (writer->bits + 7) / 8;
+}
@@ -17,7 +17,7 @@
  *
  * Gestión de errores del sensor:
  * - Si el sensor falla al inicializar, el dispositivo continúa funcionando
- * - Envía datos de error (-999 para temperatura, -1 para humedad)
+ * - Envía la trama igualmente, con los campos sin lectura a código 0
  * - Intenta reinicializar el sensor en cada ciclo
  * - Muestra "Sensor ERROR!" en pantalla cuando hay problemas
  *
@@ -38,6 +38,19 @@
 #include <esp_task_wdt.h>   // Watchdog timer
 #include "../config/config.h"         // Configuración unificada del proyecto
 #include "sensor_interface.h" // Interfaz de sensores
+#include "session.h"            // Persistencia de sesión LoRaWAN
+#include "batch.h"              // Muestreo por lotes en memoria RTC
+#include "profiler.h"           // Perfil de fases del ciclo
+#include "scheduler.h"          // Intervalo adaptativo según batería y sol
+#include "battery_soc.h"        // Estado de carga de la batería
+#include "hibernate.h"          // Hibernación por batería baja
+#include "power_rail.h"         // Rails de alimentación de los sensores
+#include "logger.h"             // Logs diferidos por Serial
+#include "cpu_governor.h"       // Frecuencia de la CPU por fase
+#include "uplink_planner.h"     // Tiempo en el aire y presupuesto de duty cycle
+#include "link_controller.h"    // DR y potencia según el margen del enlace
+#include "clock_drift.h"        // Error de reloj de las ventanas RX
+#include "remote_config.h"      // Ajustes de operación por downlink
 
 // Declaración forward
 void turnOffDisplay();
@@ -47,6 +60,8 @@ void turnOffDisplay();
 
 // Prototipos de funciones privadas
 void enterDeepSleep();
+static void startDeepSleep(uint32_t sleepSeconds, bool hibernating = false);
+static void startHibernation(bool lmicReady);
 
 // ==================== CONFIGURACIÓN LoRaWAN ====================
 // Las claves de activación OTAA ahora están incluidas desde config.h
@@ -78,7 +93,6 @@ static osjob_t sendjob;
 static int spreadFactor = DR_SF7;
 static int joinStatus = EV_JOINING;
 static const unsigned TX_INTERVAL = 30;  // No usado en bajo consumo, pero mantener para compatibilidad
-#define SLEEP_TIME_SECONDS SEND_INTERVAL_SECONDS  // Periodo entre transmisiones
 #define uS_TO_S_FACTOR 1000000ULL
 static String lora_msg = "";
 
@@ -86,6 +100,46 @@ static String lora_msg = "";
 static int joinFailCount = 0;  // Contador de joins fallidos consecutivos
 static bool inJoinBackoff = false;  // Si estamos en período de backoff
 
+// Si el último uplink se envió como confirmado (para contar ACKs perdidos)
+static bool lastUplinkConfirmed = false;
+
+// Inicio de la transacción TX/RX en curso (para el perfil de light sleep)
+static unsigned long txStartMs = 0;
+
+// Tiempo en el aire estimado del uplink en curso (µs), para el perfil de fases
+static uint32_t txAirtimeUs = 0;
+
+// Tiempo en el aire de todos los uplinks del ciclo (µs), para el duty cycle
+static uint32_t cycleAirtimeUs = 0;
+
+// Si el uplink en curso es el resumen del perfil de fases (FPort PROFILER_FPORT)
+static bool profilerReportInFlight = false;
+
+// Si el uplink en curso es el aviso de hibernación (FPort HIBERNATE_FPORT)
+static bool hibernateNoticeInFlight = false;
+
+// Si el uplink en curso es la confirmación de configuración (FPort REMOTE_CONFIG_FPORT)
+static bool remoteAckInFlight = false;
+
+// Registros del lote incluidos en el uplink en curso
+static uint8_t batchRecordsInFlight = 0;
+
+/**
+ * @brief Lee los sensores y añade la muestra al lote en memoria RTC
+ *
+ * @param data Lecturas realizadas (para mostrar en pantalla/log)
+ * @return true si al menos un sensor dio una lectura válida
+ */
+static bool sampleToBatch(sensor_data_t* data) {
+    bool ok = sensors_acquire();
+    sensors_snapshot(data);
+
+    payload_record_t record;
+    payload_codec_quantize(data, &record);
+    batch_add_record(&record);
+    return ok;
+}
+
 /**
  * @brief Determina el tiempo de backoff basado en el número de fallos consecutivos
  *
@@ -113,7 +167,7 @@ static int getJoinBackoffTime(int failCount) {
  * @param seconds Tiempo en segundos para dormir
  */
 static void enterLightSleep(int seconds) {
-    Serial.printf("Entrando en sueño ligero por %d segundos (backoff join)...\n", seconds);
+    LOG_INFO_FAST("Entrando en sueño ligero por %d segundos (backoff join)...\n", seconds);
 
     // Apagar pantalla para ahorrar energía durante el sueño
     turnOffDisplay();
@@ -122,10 +176,65 @@ static void enterLightSleep(int seconds) {
     esp_sleep_enable_timer_wakeup((uint64_t)seconds * uS_TO_S_FACTOR);
 
     // Entrar en sueño ligero (mantiene estado de RAM)
+    logger_suspend();
     esp_light_sleep_start();
+    logger_resume();
 
     // Al despertar, volver a encender la pantalla si es necesario
-    Serial.println("Despertando de sueño ligero");
+    LOG_INFO_FAST("Despertando de sueño ligero\n");
+}
+
+/**
+ * @brief Aplaza el uplink por falta de presupuesto de duty cycle
+ *
+ * Duerme el intervalo planificado sin transmitir. Con muestreo por lotes
+ * los registros siguen en memoria RTC para el siguiente uplink.
+ */
+static void deferUplink() {
+    LOG_INFO_FAST("Presupuesto de duty cycle agotado (%lu ms libres): uplink aplazado\n",
+                  (unsigned long)(uplink_planner_budget_left_us() / 1000));
+    enterDeepSleep();
+}
+
+/**
+ * @brief Arranca un uplink de servicio (no confirmado, por su propio FPort)
+ */
+static void startServiceUplink(u1_t port, xref2u1_t data, u1_t size) {
+    lastUplinkConfirmed = false;
+    hal_resetSleepStats();
+    txStartMs = millis();
+    // Airtime antes de construir la trama: LMIC consume los FOpts pendientes
+    txAirtimeUs = uplink_planner_airtime_us(LMIC.datarate, size);
+    cycleAirtimeUs += txAirtimeUs;
+    uplink_planner_record(txAirtimeUs);
+    LMIC_setTxData2(port, data, size, 0);
+}
+
+/**
+ * @brief Envía un uplink de servicio como único uplink del ciclo
+ *
+ * Sustituye al uplink de datos: la muestra de este despertar queda en el
+ * lote en memoria RTC y sale con el siguiente. Encadenado tras el de datos
+ * esperaría en light sleep a que se libere la banda (100 veces el tiempo
+ * en el aire con el 1 % de duty cycle).
+ *
+ * @return false si no cabe en el presupuesto de duty cycle (no se transmite)
+ */
+static bool sendServiceUplink(u1_t port, xref2u1_t data, u1_t size) {
+    sensor_data_t sensorData;
+    sampleToBatch(&sensorData);
+
+    uint8_t datarate = uplink_planner_fit_datarate(LMIC.datarate, size);
+    if (datarate == DR_NONE) return false;
+    if (datarate != LMIC.datarate) {
+        LOG_INFO_FAST("Presupuesto de duty cycle: DR%u -> DR%u\n", LMIC.datarate, datarate);
+        LMIC_setDrTxpow(datarate, KEEP_TXPOW);
+    }
+    uplink_planner_log(size);
+
+    clock_drift_apply();
+    startServiceUplink(port, data, size);
+    return true;
 }
 
 /**
@@ -134,7 +243,7 @@ static void enterLightSleep(int seconds) {
 static void resetJoinFailCount() {
     joinFailCount = 0;
     inJoinBackoff = false;
-    Serial.println("Contador de joins fallidos reseteado");
+    LOG_INFO_FAST("Contador de joins fallidos reseteado\n");
 }
 
 // Funciones callback de LMIC
@@ -153,6 +262,18 @@ void os_getDevKey (u1_t *buf)
     memcpy_P(buf, APPKEY, 16);
 }
 
+// Light sleep del bucle de LMIC: el vaciado de logs se detiene mientras
+// la UART está parada y sigue al despertar (ver logger.h)
+void hal_beforeLightSleep ()
+{
+    logger_suspend();
+}
+
+void hal_afterLightSleep ()
+{
+    logger_resume();
+}
+
 
 // ==================== FUNCIONES DE CALLBACK Y UTILIDAD ====================
 
@@ -180,13 +301,13 @@ void do_send(osjob_t *j)
     
     // Verificar si estamos en período de backoff de join
     if (inJoinBackoff) {
-        Serial.println(F("En período de backoff de join, esperando..."));
+        LOG_INFO_FAST("En período de backoff de join, esperando...\n");
         return;
     }
 
     // Verificar estado de join
     if (joinStatus == EV_JOINING) {
-        Serial.println(F("Aún no unido a la red"));
+        LOG_INFO_FAST("Aún no unido a la red\n");
         // Reprogramar envío para más tarde
         os_setTimedCallback(&sendjob, os_getTime() + sec2osticks(TX_INTERVAL), do_send);
         return;
@@ -194,59 +315,151 @@ void do_send(osjob_t *j)
 
     // Verificar si hay una transmisión/recepción pendiente
     if (LMIC.opmode & OP_TXRXPEND) {
-        Serial.println(F("Transmisión pendiente, esperando..."));
+        LOG_INFO_FAST("Transmisión pendiente, esperando...\n");
         return;
     }
 
-    Serial.println(F("Preparando datos del sensor para envío..."));
+    // Batería agotada y sin sol: el aviso de hibernación es el único uplink
+    // del ciclo y la muestra queda en el lote hasta que el nodo se recupere
+    battery_soc_update();
+    if (hibernate_should_enter()) {
+        uint8_t notice[HIBERNATE_NOTICE_SIZE];
+        uint8_t noticeSize = hibernate_build_notice(notice);
+        LOG_INFO_FAST("Batería al %u %%: enviando aviso de hibernación (FPort %d)\n",
+                      battery_status()->soc_percent, HIBERNATE_FPORT);
+        hibernateNoticeInFlight = sendServiceUplink(HIBERNATE_FPORT, notice, noticeSize);
+        if (!hibernateNoticeInFlight) {
+            // Reintentar cada intervalo agotaría la batería: hibernar sin aviso
+            LOG_INFO_FAST("Presupuesto de duty cycle agotado: hibernando sin aviso\n");
+            startHibernation(true);
+        }
+        return;
+    }
+
+    // Confirmación del downlink de configuración del ciclo anterior: único
+    // uplink de este ciclo, la muestra sale con el siguiente
+    if (remote_config_ack_pending()) {
+        uint8_t ack[REMOTE_CONFIG_ACK_SIZE];
+        uint8_t ackSize = remote_config_build_ack(ack);
+        LOG_INFO_FAST("Enviando confirmación de configuración (%u bytes, FPort %d)\n",
+                      ackSize, REMOTE_CONFIG_FPORT);
+        remoteAckInFlight = sendServiceUplink(REMOTE_CONFIG_FPORT, ack, ackSize);
+        if (!remoteAckInFlight) deferUplink();
+        return;
+    }
+
+    // Resumen del perfil aplazado en el ciclo anterior: sale solo en este
+    if (profiler_report_deferred()) {
+        uint8_t report[MAX_LEN_PAYLOAD];
+        uint8_t reportSize = profiler_build_report(report, batch_max_frame_size(LMIC.datarate));
+        if (reportSize > 0) {
+            LOG_INFO_FAST("Enviando resumen del perfil aplazado (%u bytes, FPort %d)\n", reportSize, PROFILER_FPORT);
+            profilerReportInFlight = sendServiceUplink(PROFILER_FPORT, report, reportSize);
+            if (!profilerReportInFlight) deferUplink();
+            return;
+        }
+    }
+
+    LOG_INFO_FAST("Preparando datos del sensor para envío...\n");
 
     // ==================== OBTENER PAYLOAD COMPLETO ====================
-    uint8_t payload[8];  // Buffer para el payload
-    payload_config_t payload_config = {
-        .buffer = payload,
-        .max_size = sizeof(payload),
-        .written = 0
-    };
-    uint8_t payloadSize = sensors_get_payload(&payload_config);
+    uint8_t payload[MAX_LEN_PAYLOAD];  // Buffer para el payload
+    uint8_t payloadSize;
+    uint8_t port = 1;
+    sensor_data_t sensorData;
+    bool sensorOk;
+
+    if (batch_enabled()) {
+        // Añadir la muestra de este despertar y enviar las acumuladas que
+        // quepan en el DR actual y en el presupuesto de duty cycle (el resto
+        // sale en el siguiente uplink)
+        sensorOk = sampleToBatch(&sensorData);
+        // El DR fija el tamaño de la trama: se elige con el tamaño previsto del lote
+        uint16_t expectedSize = (uint16_t)payload_codec_record_size() * batch_count();
+        link_controller_apply(expectedSize < MAX_LEN_PAYLOAD ? expectedSize : MAX_LEN_PAYLOAD);
+        cpu_governor_boost();
+        uint8_t maxSize = uplink_planner_fit_payload(LMIC.datarate, batch_max_frame_size(LMIC.datarate));
+        payloadSize = batch_build_frame(payload, maxSize, &batchRecordsInFlight);
+        cpu_governor_unboost();
+        port = BATCH_FPORT;
+        if (payloadSize == 0) {
+            deferUplink();
+            return;
+        }
+    } else {
+        payload_config_t payload_config = {
+            .buffer = payload,
+            .max_size = sizeof(payload),
+            .written = 0
+        };
+        sensorOk = sensors_acquire();
+        // La adquisición espera al bus y a los sensores: la ráfaga empieza después
+        cpu_governor_boost();
+        payloadSize = sensors_get_payload(&payload_config);
+        cpu_governor_unboost();
+        link_controller_apply(payloadSize);
+
+        // ==================== OBTENER DATOS PARA DISPLAY ====================
+        // Mismo snapshot que el payload: no se vuelve a leer el hardware
+        sensors_snapshot(&sensorData);
+    }
 
     if (payloadSize == 0) {
-        Serial.println("Error al obtener payload del sensor");
+        LOG_INFO_FAST("Error al obtener payload del sensor\n");
         showError("Error payload", 3000);
         // Programar siguiente intento en 10 segundos
         os_setTimedCallback(&sendjob, os_getTime() + sec2osticks(10), do_send);
         return;
     }
 
-    // ==================== OBTENER DATOS PARA DISPLAY ====================
-    sensor_data_t sensorData;
-    bool sensorOk = sensors_read_all(&sensorData);
-    float temperatura = sensorData.temperature;
-    float humedad = sensorData.humidity;
-    float presion = sensorData.pressure;
-    float bateria = sensorData.battery;
+    // ==================== PRESUPUESTO DE DUTY CYCLE ====================
+    // Tiempo en el aire de la última hora (ver uplink_planner.h)
+    uint8_t datarate = uplink_planner_fit_datarate(LMIC.datarate, payloadSize);
+    if (datarate == DR_NONE) {
+        deferUplink();
+        return;
+    }
+    if (datarate != LMIC.datarate) {
+        LOG_INFO_FAST("Presupuesto de duty cycle: DR%u -> DR%u\n", LMIC.datarate, datarate);
+        LMIC_setDrTxpow(datarate, KEEP_TXPOW);
+    }
+    uplink_planner_log(payloadSize);
+
+    char temperatura[12], humedad[12], bateria[12];
+    sensor_format_fixed(temperatura, sizeof(temperatura), sensorData.temperature, SENSOR_SCALE_TEMPERATURE, 2);
+    sensor_format_fixed(humedad, sizeof(humedad), sensorData.humidity, SENSOR_SCALE_HUMIDITY, 2);
+    sensor_format_fixed(bateria, sizeof(bateria), sensorData.battery, SENSOR_SCALE_BATTERY, 2);
 
     // ==================== INTERFAZ DE USUARIO ====================
     // Mostrar datos en pantalla OLED durante el envío (sin límite de tiempo)
     if (sensorOk) {
-        showSensorData(temperatura, humedad, bateria, 0);  // 0 = mostrar hasta que llegue otro mensaje
+        showSensorData(&sensorData, 0);  // 0 = mostrar hasta que llegue otro mensaje
     } else {
         // Mostrar solo batería cuando no hay sensor
         showWarning("Solo bateria", 0);  // 0 = mostrar hasta que llegue otro mensaje
     }
 
     // ==================== ENVÍO LoRaWAN ====================
-    LMIC_setTxData2(1, payload, payloadSize, 0);
+    // Periódicamente se pide ACK para comprobar que la sesión restaurada sigue viva
+    lastUplinkConfirmed = session_should_confirm();
+    // Ventanas RX ajustadas a la deriva medida del reloj lento
+    clock_drift_apply();
+    hal_resetSleepStats();
+    txStartMs = millis();
+    // Airtime antes de construir la trama: LMIC consume los FOpts pendientes
+    txAirtimeUs = uplink_planner_airtime_us(LMIC.datarate, payloadSize);
+    cycleAirtimeUs += txAirtimeUs;
+    uplink_planner_record(txAirtimeUs);
+    // Construcción de la trama y cifrado AES de FRMPayload y MIC
+    cpu_governor_boost();
+    LMIC_setTxData2(port, payload, payloadSize, lastUplinkConfirmed);
+    cpu_governor_unboost();
 
     if (sensorOk) {
-        #ifdef USE_SENSOR_DHT22
-        Serial.printf("Enviando: Temp=%.2f C, Hum=%.2f %%, Batt=%.2f V\n",
-                     temperatura, humedad, bateria);
-        #else
-        Serial.printf("Enviando: Temp=%.2f C, Hum=%.2f %%, Batt=%.2f V\n",
-                     temperatura, humedad, bateria);
-        #endif
+        LOG_INFO("Enviando: Temp=%s C, Hum=%s %%, Batt=%s V\n",
+                 temperatura, humedad, bateria);
     } else {
-        Serial.printf("Enviando datos limitados: Temp=ERROR, Hum=ERROR, Batt=%.2f V\n", bateria);
+        LOG_INFO("Enviando datos limitados: Temp=ERROR, Hum=ERROR, Batt=%s V\n", bateria);
     }
 
     // Nota: No se programa el siguiente envío aquí - se hará después del TX completo en onEvent
@@ -269,39 +482,115 @@ void onEvent (ev_t ev)
     // Resetear watchdog para evitar reinicio durante operaciones LoRaWAN
     esp_task_wdt_reset();
     
-    Serial.print(os_getTime());
-    Serial.print(": ");
+    // onEvent() corre entre TX y las ventanas RX: solo logs diferidos
+    LOG_INFO_FAST("%ld: ", os_getTime());
 
     switch (ev) {
         case EV_TXCOMPLETE:
-            Serial.println(F("Transmisión completada (incluyendo RX windows)"));
+            LOG_INFO_FAST("Transmisión completada (incluyendo RX windows)\n");
 
             // Verificar si se recibió ACK
             if (LMIC.txrxFlags & TXRX_ACK) {
-                Serial.println(F("ACK recibido de gateway"));
+                LOG_INFO_FAST("ACK recibido de gateway\n");
                 lora_msg = "ACK recibido.";
             }
 
-            // Mostrar métricas de enlace
-            lora_msg = "rssi:" + String(LMIC.rssi) + " snr: " + String(LMIC.snr);
+            // Perfil de la transacción: tiempo despierto vs. en light sleep
+            // esperando ventanas RX o interrupciones DIO de la radio
+            {
+                u4_t sleeps, sleptUs;
+                hal_getSleepStats(&sleeps, &sleptUs);
+                uint32_t totalUs = (millis() - txStartMs) * 1000UL;
+                LOG_INFO_FAST("TX/RX: %lu ms totales, %lu ms en light sleep (%lu tramos)\n",
+                              totalUs / 1000, sleptUs / 1000, sleeps);
+                PHASE_RECORD(PROFILER_PHASE_TX, txAirtimeUs);
+                PHASE_RECORD(PROFILER_PHASE_RX, totalUs > txAirtimeUs ? totalUs - txAirtimeUs : 0);
+                PHASE_SLEEP(PROFILER_PHASE_RX, sleptUs);
+            }
 
-            // Verificar datos downlink
+            // Downlink en cualquiera de los uplinks del ciclo: comandos de
+            // configuración por REMOTE_CONFIG_FPORT (ver remote_config.h)
             if (LMIC.dataLen) {
-                Serial.print(F("Datos recibidos: "));
-                Serial.print(LMIC.dataLen);
-                Serial.println(F(" bytes"));
-                // Aquí se podrían procesar comandos downlink
+                uint8_t port = (LMIC.txrxFlags & TXRX_PORT) ? LMIC.frame[LMIC.dataBeg - 1] : 0;
+                LOG_INFO_FAST("Datos recibidos: %u bytes (FPort %u)\n", LMIC.dataLen, port);
+                remote_config_on_downlink(port, LMIC.frame + LMIC.dataBeg, LMIC.dataLen);
+            }
+
+            // Tras el aviso de hibernación no se vuelve a despertar cada intervalo
+            if (hibernateNoticeInFlight) {
+                hibernateNoticeInFlight = false;
+                session_on_tx_complete(lastUplinkConfirmed, LMIC.txrxFlags);
+                startHibernation(true);
+                break;
+            }
+
+            // El resumen del perfil (encadenado tras el uplink de datos o solo
+            // en el ciclo) no repite el procesado de lote, sesión ni pantalla
+            if (profilerReportInFlight) {
+                profilerReportInFlight = false;
+                profiler_report_sent();
+                session_on_tx_complete(lastUplinkConfirmed, LMIC.txrxFlags);
+                enterDeepSleep();
+                break;
+            }
+
+            // La confirmación de configuración (único uplink del ciclo) tampoco
+            // repite el procesado
+            if (remoteAckInFlight) {
+                remoteAckInFlight = false;
+                remote_config_ack_sent();
+                session_on_tx_complete(lastUplinkConfirmed, LMIC.txrxFlags);
+                enterDeepSleep();
+                break;
             }
 
+            // Los registros enviados salen del buffer RTC
+            batch_commit(batchRecordsInFlight);
+            batchRecordsInFlight = 0;
+
+            // Actualizar contadores de la sesión (puede forzar un nuevo join)
+            session_on_tx_complete(lastUplinkConfirmed, LMIC.txrxFlags);
+
+            // Margen del enlace y ACKs perdidos para el DR y la potencia del siguiente uplink
+            link_controller_on_tx_complete(lastUplinkConfirmed, LMIC.txrxFlags);
+
+            // Tiempo con las ventanas RX abiertas y ensanchado tras confirmados perdidos
+            clock_drift_on_tx_complete(lastUplinkConfirmed, LMIC.txrxFlags);
+
+            // Mostrar métricas de enlace
+            lora_msg = "rssi:" + String(LMIC.rssi) + " snr: " + String(LMIC.snr);
+
             // Feedback visual de éxito
             showSuccess("Datos enviados!", 5000);
 
+            // Resumen periódico del perfil de fases por su propio FPort: solo
+            // se encadena si la banda queda libre enseguida y cabe en el
+            // presupuesto; si no, sale solo en el siguiente despertar
+            if (profiler_report_due()) {
+                uint32_t waitMs = uplink_planner_next_tx_ms(LMIC.datarate);
+                uint8_t report[MAX_LEN_PAYLOAD];
+                uint8_t reportSize = 0;
+                if (waitMs <= UPLINK_PLANNER_CHAIN_WAIT_MS) {
+                    uint8_t maxSize = uplink_planner_fit_payload(LMIC.datarate, batch_max_frame_size(LMIC.datarate));
+                    reportSize = profiler_build_report(report, maxSize);
+                }
+                if (reportSize > 0) {
+                    LOG_INFO_FAST("Enviando resumen del perfil (%u bytes, FPort %d)\n", reportSize, PROFILER_FPORT);
+                    profilerReportInFlight = true;
+                    startServiceUplink(PROFILER_FPORT, report, reportSize);
+                    break;
+                }
+                LOG_INFO_FAST("Resumen del perfil aplazado al siguiente despertar (banda libre en %lu ms)\n",
+                              waitMs);
+                profiler_report_defer();
+            }
+
             // ==================== TRANSICIÓN A SUEÑO PROFUNDO ====================
             enterDeepSleep();
             break;
 
         case EV_JOINING:
-            Serial.println(F("Iniciando proceso de join..."));
+            LOG_INFO_FAST("Iniciando proceso de join...\n");
             lora_msg = "Uniéndose OTAA....";
             joinStatus = EV_JOINING;
 
@@ -311,10 +600,18 @@ void onEvent (ev_t ev)
 
         case EV_JOIN_FAILED:
         {
+            PHASE_END(PROFILER_PHASE_JOIN);
             joinFailCount++;
-            Serial.printf("Join fallido #%d - aplicando backoff\n", joinFailCount);
+            LOG_INFO_FAST("Join fallido #%d - aplicando backoff\n", joinFailCount);
             lora_msg = "Unión OTAA fallida";
 
+            // Sin red no hay aviso posible: reintentar el join agotaría la batería
+            battery_soc_update();
+            if (hibernate_should_enter()) {
+                LMIC_shutdown();
+                startHibernation(false);
+            }
+
             int backoffSeconds = getJoinBackoffTime(joinFailCount);
             inJoinBackoff = true;
 
@@ -323,19 +620,20 @@ void onEvent (ev_t ev)
             sprintf(backoffMsg, "Reintento en %d min", backoffSeconds / 60);
             showWarning(backoffMsg, 3000);
 
-            Serial.printf("Esperando %d segundos antes del próximo intento de join\n", backoffSeconds);
+            LOG_INFO_FAST("Esperando %d segundos antes del próximo intento de join\n", backoffSeconds);
 
             // Si es un backoff moderado, usar callback normal
             if (backoffSeconds <= 300) {
                 os_setTimedCallback(&sendjob, os_getTime() + sec2osticks(backoffSeconds), do_send);
             } else {
                 // Para backoffs largos, dormir ligero y luego reiniciar join
-                delay(1000);  // Pequeño delay para mostrar mensaje
+                cpu_governor_delay(1000);  // Pequeño delay para mostrar mensaje
                 enterLightSleep(backoffSeconds);
 
                 // Al despertar, reiniciar LMIC y volver a intentar join
-                Serial.println("Reiniciando LMIC después de backoff");
+                LOG_INFO_FAST("Reiniciando LMIC después de backoff\n");
                 LMIC_reset();
+                PHASE_BEGIN(PROFILER_PHASE_JOIN);
                 LMIC_startJoining();
                 os_setTimedCallback(&sendjob, os_getTime() + sec2osticks(5), do_send);
             }
@@ -343,12 +641,14 @@ void onEvent (ev_t ev)
         }
 
         case EV_JOINED:
-            Serial.println(F("Unión exitosa a la red LoRaWAN"));
+            LOG_INFO_FAST("Unión exitosa a la red LoRaWAN\n");
             lora_msg = "Unido!";
             joinStatus = EV_JOINED;
+            PHASE_END(PROFILER_PHASE_JOIN);
 
             // Resetear contador de fallos al conectar exitosamente
             resetJoinFailCount();
+            session_on_joined();
 
             // Mostrar mensaje de conexión exitosa durante 5 segundos
             // La pantalla se apagará automáticamente al expirar el mensaje
@@ -357,24 +657,24 @@ void onEvent (ev_t ev)
             // Programar el primer envío con delay para dar tiempo a ver el mensaje
             os_setTimedCallback(&sendjob, os_getTime() + sec2osticks(6), do_send);
 
-            // Deshabilitar link check para simplificar
-            LMIC_setLinkCheckMode(0);
+            // ADR y link check según el modo del control de enlace
+            link_controller_begin();
             break;
 
         case EV_RXCOMPLETE:
-            Serial.println(F("Recepción completada"));
+            LOG_INFO_FAST("Recepción completada\n");
             break;
 
         case EV_LINK_DEAD:
-            Serial.println(F("Enlace perdido"));
+            LOG_INFO_FAST("Enlace perdido\n");
             break;
 
         case EV_LINK_ALIVE:
-            Serial.println(F("Enlace recuperado"));
+            LOG_INFO_FAST("Enlace recuperado\n");
             break;
 
         default:
-            Serial.println(F("Evento desconocido"));
+            LOG_INFO_FAST("Evento desconocido\n");
             break;
     }
 }
@@ -382,39 +682,154 @@ void onEvent (ev_t ev)
 /**
  * @brief     Entrada en modo sueño profundo
  *
- * Configura el temporizador ESP32 para despertar después del intervalo definido
- * y apaga la pantalla para maximizar el ahorro de energía.
+ * Configura el temporizador ESP32 para despertar después del intervalo que
+ * decide el planificador (scheduler_plan()) y apaga la pantalla para maximizar el ahorro de energía.
  * NO apaga completamente el PMU para permitir el despertar por temporizador.
  *
  * @note      El dispositivo se reiniciará completamente al despertar
- * @warning   Toda la memoria RAM se pierde durante el sueño profundo
+ * @warning   Toda la memoria RAM se pierde durante el sueño profundo; la sesión
+ *            LoRaWAN se conserva en memoria RTC mediante session_save()
  */
 void enterDeepSleep() {
-    Serial.println("Entrando en sueño profundo por " + String(SLEEP_TIME_SECONDS) + " segundos...");
+    // Intervalo hasta el siguiente despertar según batería, carga solar y duty cycle
+    uint32_t sleepSeconds = scheduler_plan(cycleAirtimeUs);
+    LOG_INFO_FAST("Entrando en sueño profundo por %lu segundos...\n", sleepSeconds);
+
+    // Guardar la sesión LoRaWAN en memoria RTC para evitar el join al despertar
+    session_save(sleepSeconds);
+
+    startDeepSleep(sleepSeconds);
+}
+
+/**
+ * @brief Programa el despertar por temporizador y entra en sueño profundo
+ *
+ * Parte común de enterDeepSleep(), de los despertares de solo medición, que
+ * no inicializan LMIC y por tanto no guardan la sesión, y de la hibernación.
+ *
+ * @param hibernating Apaga además las salidas del PMU (disablePeripherals())
+ *                    y programa el despertar por su interrupción
+ */
+static void startDeepSleep(uint32_t sleepSeconds, bool hibernating) {
     // Apagar pantalla para ahorrar energía
     turnOffDisplayCompletely();
 
     // Configurar despertar por temporizador (RTC interno del ESP32)
-    esp_sleep_enable_timer_wakeup(SLEEP_TIME_SECONDS * uS_TO_S_FACTOR);
+    esp_sleep_enable_timer_wakeup(sleepSeconds * uS_TO_S_FACTOR);
+    scheduler_on_sleep(sleepSeconds);
 
     // NO apagar PMU completamente para evitar problemas de despertar
     // disablePeripherals();  // Comentado para permitir despertar
 
     // Solo apagar mediciones del PMU pero mantener alimentación
-    if (PMU) {
+    if (PMU && !hibernating) {
         PMU->setChargingLedMode(XPOWERS_CHG_LED_OFF);
         PMU->disableSystemVoltageMeasure();
         PMU->disableVbusVoltageMeasure();
-        PMU->disableBattVoltageMeasure();
+        // El contador de culombios del AXP192 integra con el ADC de batería
+        if (battery_status()->soc_source != BATTERY_SOC_COULOMB) {
+            PMU->disableBattVoltageMeasure();
+        }
         PMU->disableTemperatureMeasure();
         PMU->disableBattDetection();
         // NO apagar las salidas de alimentación del PMU
     }
 
+    // Hibernación: radio, GNSS y pantalla sin alimentación (beginPower() las
+    // restaura al despertar) y despertar por VBUS o inicio de carga
+    if (PMU && hibernating) {
+        disablePeripherals();
+        // El contador de culombios mide el consumo en hibernación
+        if (battery_status()->soc_source == BATTERY_SOC_COULOMB) {
+            PMU->enableBattVoltageMeasure();
+        }
+        if (!armPmuPowerWakeup()) {
+            LOG_INFO_FAST("Hibernación: sin despertar por el PMU, solo temporizador\n");
+        }
+    }
+
+    // Volcar las fases de este ciclo al histograma en memoria RTC
+    profiler_cycle_end();
+    cpu_governor_report();
+
+    // Sacar los logs pendientes: la RAM se pierde en el sueño profundo
+    logger_flush();
+
     // Entrar en sueño profundo (reinicio completo al despertar)
     esp_deep_sleep_start();
 }
 
+/**
+ * @brief Entra en hibernación (ver hibernate.h)
+ *
+ * @param lmicReady LMIC está inicializado: se guarda la sesión para no
+ *                  repetir el join al salir y se duerme la radio
+ */
+static void startHibernation(bool lmicReady) {
+    uint32_t sleepSeconds = hibernate_prepare_sleep();
+
+    if (lmicReady) {
+        session_save(sleepSeconds);
+        LMIC_shutdown();  // SX127x en modo sleep (placas sin PMU)
+    } else {
+        session_add_sleep(sleepSeconds);
+    }
+    power_rail_shutdown();
+
+    LOG_INFO_FAST("Hibernando %lu h (o hasta VBUS)\n", sleepSeconds / 3600);
+    startDeepSleep(sleepSeconds, true);
+}
+
+/**
+ * @brief Despertar en hibernación
+ *
+ * Si el nodo hiberna y la batería no se ha recuperado, vuelve a dormir sin
+ * inicializar la radio, los sensores ni LMIC.
+ *
+ * @return false si hay que continuar con el arranque normal (si no, no retorna)
+ */
+bool runHibernationCheck(void) {
+    if (!hibernate_on_wake()) return false;
+    startHibernation(false);
+    return false;
+}
+
+/**
+ * @brief Despertar de solo medición del muestreo por lotes
+ *
+ * Si el despertar es por temporizador y el lote aún no está completo, lee
+ * los sensores, guarda el registro en memoria RTC y vuelve a dormir sin
+ * inicializar la radio ni LMIC.
+ *
+ * @return false si este despertar debe hacer el ciclo completo con envío
+ *         (si no, no retorna)
+ */
+bool runSampleOnlyCycle(void) {
+    uint8_t samplesPerUplink = batch_samples_per_uplink();
+    if (samplesPerUplink <= 1) return false;
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) return false;
+
+    // El despertar que completa el lote hace el ciclo completo con envío
+    if (batch_count() + 1 >= samplesPerUplink) return false;
+
+    PHASE_BEGIN(PROFILER_PHASE_SENSOR_INIT);
+    sensors_init_all();
+    PHASE_END(PROFILER_PHASE_SENSOR_INIT);
+    sensor_data_t data;
+    sampleToBatch(&data);
+    LOG_INFO_FAST("Muestra %u/%u guardada, sin envío en este ciclo\n",
+                  batch_count(), samplesPerUplink);
+    bootTimeMark("muestra");
+    printBootTimes();
+
+    // LMIC no se ha inicializado: solo se acumula el sueño en la sesión.
+    // Con registros en el lote el intervalo no cambia (ver scheduler.h)
+    uint32_t sleepSeconds = scheduler_interval();
+    session_add_sleep(sleepSeconds);
+    startDeepSleep(sleepSeconds);
+    return false;
+}
+
 // ==================== FUNCIONES PÚBLICAS ====================
 
 /**
@@ -427,7 +842,7 @@ void enterDeepSleep() {
  * - Sesión LoRaWAN con claves OTAA
  * - Canales TTN para Europa (868MHz)
  * - Parámetros de enlace y tasa de datos
- * - Inicia el proceso de join
+ * - Restaura la sesión guardada en memoria RTC o inicia el proceso de join
  *
  * @note      Debe llamarse una vez en setup() de Arduino
  * @warning   Asegúrate de actualizar las claves LoRaWAN antes de usar
@@ -445,8 +860,11 @@ void setupLMIC(void)
 
     // ==================== CONFIGURACIÓN DEL SENSOR ====================
     // Inicializar sensor usando la interfaz unificada
-    if (!sensors_init_all()) {
-        Serial.println("ADVERTENCIA: Sensor no disponible, el dispositivo continuará funcionando y enviará datos de error");
+    PHASE_BEGIN(PROFILER_PHASE_SENSOR_INIT);
+    bool sensorsReady = sensors_init_all();
+    PHASE_END(PROFILER_PHASE_SENSOR_INIT);
+    if (!sensorsReady) {
+        LOG_INFO_FAST("ADVERTENCIA: Sensor no disponible, el dispositivo continuará funcionando y enviará datos de error\n");
         showWarning("Sensor no disponible", 5000);
         // No entramos en bucle infinito - el dispositivo debe continuar funcionando
     } else {
@@ -457,8 +875,8 @@ void setupLMIC(void)
     // Reiniciar estado MAC - descarta sesiones y transferencias pendientes
     LMIC_reset();
 
-    // Configurar tolerancia de error de reloj (1% máximo)
-    LMIC_setClockError(MAX_CLOCK_ERROR * 1 / 100);
+    // Tolerancia de error de reloj según la deriva medida (1 % sin medidas)
+    clock_drift_begin();
 
     // Configurar canales TTN Europa (868MHz) - habilita todos los canales disponibles
     // Esto evita sobrecargar los 3 canales base de LoRaWAN
@@ -478,11 +896,21 @@ void setupLMIC(void)
     // Configurar downlink RX2 with SF9 (estándar TTN)
     LMIC.dn2Dr = DR_SF9;
 
-    // Configurar spread factor y potencia de transmisión (aumentada para mejor alcance)
+    // Spread factor y potencia de partida; el control de enlace los ajusta
+    // en cada uplink (ver link_controller.h)
     LMIC_setDrTxpow(spreadFactor, TX_POWER_DBM);
 
-    Serial.println("Iniciando proceso de join LoRaWAN...");
+    // Restaurar la sesión guardada antes del sueño profundo (sin join OTAA)
+    if (session_restore()) {
+        joinStatus = EV_JOINED;
+        link_controller_begin();
+        os_setCallback(&sendjob, do_send);
+        return;
+    }
+
+    LOG_INFO_FAST("Iniciando proceso de join LoRaWAN...\n");
     // Iniciar el proceso de joining a la red
+    PHASE_BEGIN(PROFILER_PHASE_JOIN);
     LMIC_startJoining();
 
     // El envío se programará en EV_JOINED después de mostrar el mensaje de conexión
@@ -0,0 +1,147 @@
+/**
+ * @file      power_rail.cpp
+ * @brief     Gestor de rails de alimentación conmutados de los sensores
+ *
+ * Tabla pequeña de rails indexada por pin. Cada entrada guarda el número de
+ * usuarios y el instante de encendido; los plazos de estabilización se
+ * calculan a partir de ese instante, así que se solapan entre usuarios.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <esp_sleep.h>
+#include <driver/gpio.h>         // Retención de pines en sueño profundo
+#include "power_rail.h"
+#include "logger.h"
+#include "cpu_governor.h"
+
+/**
+ * @brief Estado de un rail de alimentación
+ */
+typedef struct {
+    uint8_t pin;          /**< GPIO que conmuta el rail */
+    uint8_t users;        /**< Usuarios activos (0 = apagado) */
+    uint32_t on_since;    /**< Instante de encendido (millis) */
+} power_rail_t;
+
+static power_rail_t rails[POWER_RAIL_MAX];
+static uint8_t rail_count = 0;
+static uint32_t slept_ms = 0;
+
+/**
+ * @brief Busca un rail por pin, registrándolo si no existía
+ */
+static power_rail_t* rail_find(uint8_t pin, bool create) {
+    for (uint8_t i = 0; i < rail_count; i++) {
+        if (rails[i].pin == pin) return &rails[i];
+    }
+    if (!create || rail_count >= POWER_RAIL_MAX) return NULL;
+
+    power_rail_t* rail = &rails[rail_count++];
+    rail->pin = pin;
+    rail->users = 0;
+    rail->on_since = 0;
+    return rail;
+}
+
+/**
+ * @brief Solicita un rail de alimentación y lo enciende si estaba apagado
+ */
+uint32_t power_rail_acquire(uint8_t pin, uint32_t warmup_ms) {
+    power_rail_t* rail = rail_find(pin, true);
+    if (!rail) {
+        LOG_INFO_FAST("Rail GPIO%d: ERROR - Tabla de rails llena\n", pin);
+        return millis() + warmup_ms;
+    }
+
+    if (rail->users == 0) {
+        gpio_hold_dis((gpio_num_t)pin);  // Retenido a nivel bajo por power_rail_shutdown()
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, HIGH);
+        rail->on_since = millis();
+        LOG_INFO_FAST("Rail GPIO%d: Alimentación activada\n", pin);
+    }
+    rail->users++;
+
+    return rail->on_since + warmup_ms;
+}
+
+/**
+ * @brief Libera un rail; se apaga cuando lo libera su último usuario
+ */
+void power_rail_release(uint8_t pin) {
+    power_rail_t* rail = rail_find(pin, false);
+    if (!rail || rail->users == 0) return;
+
+    if (--rail->users == 0) {
+        digitalWrite(pin, LOW);
+        LOG_INFO_FAST("Rail GPIO%d: Alimentación desactivada tras %lu ms\n",
+                      pin, (unsigned long)(millis() - rail->on_since));
+    }
+}
+
+/**
+ * @brief Apaga todos los rails y los retiene apagados en sueño profundo
+ */
+void power_rail_shutdown(void) {
+    for (uint8_t i = 0; i < rail_count; i++) {
+        pinMode(rails[i].pin, OUTPUT);
+        digitalWrite(rails[i].pin, LOW);
+        gpio_hold_en((gpio_num_t)rails[i].pin);
+        rails[i].users = 0;
+    }
+    if (rail_count > 0) gpio_deep_sleep_hold_en();
+}
+
+/**
+ * @brief Indica si un rail está encendido
+ */
+bool power_rail_is_on(uint8_t pin) {
+    power_rail_t* rail = rail_find(pin, false);
+    return rail && rail->users > 0;
+}
+
+/**
+ * @brief Instante (millis) en que el rail estará estable para un tiempo dado
+ */
+uint32_t power_rail_ready_at(uint8_t pin, uint32_t warmup_ms) {
+    power_rail_t* rail = rail_find(pin, false);
+    if (!rail || rail->users == 0) return 0;
+    return rail->on_since + warmup_ms;
+}
+
+/**
+ * @brief Espera hasta un instante (millis), en light sleep si es largo
+ */
+void power_rail_wait_until(uint32_t deadline_ms) {
+    for (;;) {
+        int32_t remaining = (int32_t)(deadline_ms - millis());
+        if (remaining <= 0) return;
+
+#if SENSOR_WAIT_LIGHT_SLEEP
+        if (remaining >= SENSOR_LIGHT_SLEEP_MIN_MS) {
+            uint32_t start = millis();
+            logger_suspend();
+            esp_sleep_enable_timer_wakeup((uint64_t)remaining * 1000ULL);
+            esp_light_sleep_start();
+            logger_resume();
+            esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+            slept_ms += millis() - start;
+            continue;
+        }
+#endif
+        cpu_governor_delay(remaining);
+    }
+}
+
+/**
+ * @brief Tiempo acumulado en light sleep por power_rail_wait_until()
+ */
+uint32_t power_rail_slept_ms(bool reset) {
+    uint32_t value = slept_ms;
+    if (reset) slept_ms = 0;
+    return value;
+}
@@ -0,0 +1,332 @@
+/**
+ * @file      profiler.cpp
+ * @brief     Perfil de tiempo y carga por fase del ciclo, acumulado en memoria RTC
+ *
+ * Las fases del ciclo en curso se acumulan en RAM (una fase puede abrirse y
+ * cerrarse varias veces, p. ej. la pantalla) y se vuelcan al histograma RTC
+ * en profiler_cycle_end(). Ver profiler.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <esp_timer.h>
+#include "profiler.h"
+#include "LoRaBoards.h"         // PMU
+#include "logger.h"             // logger_flush()
+
+// Identificación del histograma en memoria RTC
+#define PROFILER_MAGIC 0x50524F32UL  // "PRO2"
+
+/**
+ * @brief Nombre y corriente nominal de cada fase
+ *
+ * Estimaciones del T3 V1.6 a partir de las hojas de datos del ESP32 (CPU a
+ * 240 MHz), del SX1276 y de los sensores, sin medir en la placa; solo se
+ * usan si no hay PMU con medida de corriente.
+ */
+typedef struct {
+    const char* name;
+    uint16_t nominal_ma;
+} profiler_phase_info_t;
+
+static const profiler_phase_info_t PHASE_INFO[PROFILER_PHASE_COUNT] = {
+    { "boot",        45 },
+    { "lmic_setup",  45 },
+    { "sensor_init", 50 },
+    { "sensors",     50 },
+    { "join",        45 },
+    { "tx",          120 },  // SX1276 a 17 dBm + ESP32
+    { "rx",          55 },
+    { "display",     60 },
+    { "awake",       45 },
+};
+
+/**
+ * @brief Estadísticas acumuladas de una fase
+ */
+typedef struct {
+    uint32_t count;                     /**< Ciclos en los que se ejecutó */
+    uint32_t total_ms;                  /**< Duración total */
+    uint32_t max_ms;                    /**< Duración máxima en un ciclo */
+    uint32_t charge_mc;                 /**< Carga total estimada (mC) */
+    uint16_t bucket[PROFILER_BUCKETS];  /**< Ciclos por tramo de duración */
+} profiler_stats_t;
+
+/**
+ * @brief Histograma guardado en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t cycles;                    /**< Ciclos de la ventana actual */
+    uint32_t total_cycles;              /**< Ciclos desde el encendido */
+    bool deferred;                      /**< Resumen aplazado al siguiente despertar */
+    profiler_stats_t phase[PROFILER_PHASE_COUNT];
+} profiler_rtc_t;
+
+/**
+ * @brief Fase dentro del ciclo en curso
+ */
+typedef struct {
+    int64_t begin_us;       /**< Inicio de la apertura en curso (0 = cerrada) */
+    uint32_t begin_ma;      /**< Corriente medida al abrir (0 = sin medida) */
+    uint32_t awake_us;      /**< Tiempo acumulado en el ciclo */
+    uint32_t slept_us;      /**< Parte del tiempo en light sleep */
+    uint64_t charge_nc;     /**< Carga acumulada (nC) */
+    bool ran;               /**< Se ha ejecutado en este ciclo */
+} profiler_cycle_t;
+
+// Histograma en memoria RTC (sobrevive al sueño profundo, se borra al encender)
+static RTC_DATA_ATTR profiler_rtc_t rtc_profile;
+
+static profiler_cycle_t cycle[PROFILER_PHASE_COUNT];
+
+/**
+ * @brief Inicializa el histograma si la memoria RTC no es válida (encendido)
+ */
+static void profiler_check(void) {
+    if (rtc_profile.magic != PROFILER_MAGIC) {
+        memset(&rtc_profile, 0, sizeof(rtc_profile));
+        rtc_profile.magic = PROFILER_MAGIC;
+    }
+}
+
+/**
+ * @brief Corriente de batería medida por el PMU en mA (0 si no hay medida)
+ */
+static uint32_t measure_current_ma(void) {
+#if defined(HAS_PMU) && PROFILER_PMU_SAMPLING
+    if (PMU && PMU->getChipModel() == XPOWERS_AXP192) {
+        // Con VBUS presente la descarga es 0: se usa la corriente nominal
+        return (uint32_t)static_cast<XPowersAXP192*>(PMU)->getBattDischargeCurrent();
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Tramo del histograma para una duración (x4 desde 16 ms)
+ */
+static uint8_t bucket_for(uint32_t ms) {
+    uint8_t bucket = 0;
+    for (uint32_t limit = 16; bucket < PROFILER_BUCKETS - 1 && ms >= limit; limit *= 4) {
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Marca el inicio de una fase
+ */
+void profiler_begin(profiler_phase_t phase) {
+    if (phase >= PROFILER_PHASE_COUNT) return;
+    cycle[phase].begin_us = esp_timer_get_time();
+    cycle[phase].begin_ma = measure_current_ma();
+}
+
+/**
+ * @brief Marca el fin de una fase y acumula su duración en el ciclo
+ */
+void profiler_end(profiler_phase_t phase) {
+    if (phase >= PROFILER_PHASE_COUNT || cycle[phase].begin_us == 0) return;
+
+    profiler_cycle_t* entry = &cycle[phase];
+    uint32_t duration_us = (uint32_t)(esp_timer_get_time() - entry->begin_us);
+    entry->begin_us = 0;
+
+    // Media de las dos medidas del PMU, o la corriente nominal
+    uint32_t end_ma = measure_current_ma();
+    uint32_t ma = entry->begin_ma && end_ma ? (entry->begin_ma + end_ma) / 2 : PHASE_INFO[phase].nominal_ma;
+    entry->awake_us += duration_us;
+    entry->charge_nc += (uint64_t)duration_us * ma;
+    entry->ran = true;
+}
+
+/**
+ * @brief Acumula una duración medida por otros medios
+ */
+void profiler_record(profiler_phase_t phase, uint32_t duration_us) {
+    if (phase >= PROFILER_PHASE_COUNT) return;
+    cycle[phase].awake_us += duration_us;
+    cycle[phase].charge_nc += (uint64_t)duration_us * PHASE_INFO[phase].nominal_ma;
+    cycle[phase].ran = true;
+}
+
+/**
+ * @brief Indica qué parte de una fase se pasó en light sleep
+ *
+ * Ese tiempo ya está incluido en la duración de la fase: se descuenta la
+ * carga a corriente de fase y se suma a PROFILER_LIGHT_SLEEP_UA.
+ */
+void profiler_add_sleep(profiler_phase_t phase, uint32_t slept_us) {
+    if (phase >= PROFILER_PHASE_COUNT) return;
+    profiler_cycle_t* entry = &cycle[phase];
+
+    uint64_t awake_nc = (uint64_t)slept_us * PHASE_INFO[phase].nominal_ma;
+    entry->charge_nc -= awake_nc < entry->charge_nc ? awake_nc : entry->charge_nc;
+    entry->charge_nc += (uint64_t)slept_us * PROFILER_LIGHT_SLEEP_UA / 1000;
+    entry->slept_us += slept_us;
+
+    // El ciclo completo también descuenta el light sleep
+    if (phase != PROFILER_PHASE_AWAKE) {
+        cycle[PROFILER_PHASE_AWAKE].slept_us += slept_us;
+    }
+}
+
+/**
+ * @brief Cierra el ciclo: vuelca las fases al histograma RTC
+ */
+void profiler_cycle_end(void) {
+    profiler_check();
+
+    // Ciclo completo: desde el arranque (esp_timer empieza en 0)
+    profiler_cycle_t* awake = &cycle[PROFILER_PHASE_AWAKE];
+    uint32_t awake_us = (uint32_t)esp_timer_get_time();
+    uint32_t slept_us = awake->slept_us < awake_us ? awake->slept_us : awake_us;
+    awake->awake_us = awake_us;
+    awake->charge_nc = (uint64_t)(awake_us - slept_us) * PHASE_INFO[PROFILER_PHASE_AWAKE].nominal_ma +
+                       (uint64_t)slept_us * PROFILER_LIGHT_SLEEP_UA / 1000;
+    awake->ran = true;
+
+    for (uint8_t i = 0; i < PROFILER_PHASE_COUNT; i++) {
+        profiler_cycle_t* entry = &cycle[i];
+        if (entry->begin_us != 0) profiler_end((profiler_phase_t)i);  // Fase abierta
+        if (!entry->ran) continue;
+
+        profiler_stats_t* stats = &rtc_profile.phase[i];
+        uint32_t ms = entry->awake_us / 1000;
+        stats->count++;
+        stats->total_ms += ms;
+        if (ms > stats->max_ms) stats->max_ms = ms;
+        stats->charge_mc += (uint32_t)(entry->charge_nc / 1000000ULL);
+        uint8_t bucket = bucket_for(ms);
+        if (stats->bucket[bucket] < UINT16_MAX) stats->bucket[bucket]++;
+    }
+    rtc_profile.cycles++;
+    rtc_profile.total_cycles++;
+
+    memset(cycle, 0, sizeof(cycle));
+}
+
+/**
+ * @brief Nombre corto de una fase
+ */
+const char* profiler_phase_name(uint8_t phase) {
+    return phase < PROFILER_PHASE_COUNT ? PHASE_INFO[phase].name : "?";
+}
+
+/**
+ * @brief Indica si toca enviar el uplink de diagnóstico en este ciclo
+ *
+ * El ciclo actual aún no se ha volcado: se envía la ventana anterior.
+ */
+bool profiler_report_due(void) {
+#if ENABLE_PROFILER && PROFILER_REPORT_EVERY > 0
+    profiler_check();
+    return rtc_profile.cycles >= PROFILER_REPORT_EVERY;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Aplaza el resumen al siguiente despertar con envío
+ */
+void profiler_report_defer(void) {
+    profiler_check();
+    rtc_profile.deferred = true;
+}
+
+/**
+ * @brief Indica si el resumen debe salir como único uplink de este ciclo
+ */
+bool profiler_report_deferred(void) {
+    return profiler_report_due() && rtc_profile.deferred;
+}
+
+/**
+ * @brief Escribe un entero de 16 bits little-endian, saturado
+ */
+static uint8_t put_u16(uint8_t* buffer, uint32_t value) {
+    if (value > UINT16_MAX) value = UINT16_MAX;
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+    return 2;
+}
+
+/**
+ * @brief Construye el resumen para el uplink de diagnóstico
+ */
+uint8_t profiler_build_report(uint8_t* buffer, uint8_t max_size) {
+    const uint8_t header = 4, entry_size = 7;
+    if (!buffer || max_size < header) return 0;
+    profiler_check();
+
+    uint8_t size = header;
+    uint8_t phases = 0;
+    for (uint8_t i = 0; i < PROFILER_PHASE_COUNT && size + entry_size <= max_size; i++) {
+        const profiler_stats_t* stats = &rtc_profile.phase[i];
+        if (stats->count == 0) continue;
+
+        buffer[size++] = i;
+        size += put_u16(&buffer[size], stats->total_ms / stats->count);
+        size += put_u16(&buffer[size], stats->max_ms);
+        size += put_u16(&buffer[size], stats->charge_mc * 1000ULL / 3600 / stats->count);  // mC -> µAh
+        phases++;
+    }
+
+    buffer[0] = PROFILER_REPORT_VERSION;
+    buffer[1] = phases;
+    put_u16(&buffer[2], rtc_profile.cycles);
+    return size;
+}
+
+/**
+ * @brief Notifica que el resumen se ha enviado y reinicia la ventana
+ */
+void profiler_report_sent(void) {
+    profiler_check();
+    uint32_t total_cycles = rtc_profile.total_cycles;
+    memset(&rtc_profile, 0, sizeof(rtc_profile));
+    rtc_profile.magic = PROFILER_MAGIC;
+    rtc_profile.total_cycles = total_cycles;
+}
+
+/**
+ * @brief Imprime por Serial el histograma acumulado
+ */
+void profiler_dump(void) {
+    profiler_check();
+    logger_flush();  // Volcado directo por Serial, tras los logs pendientes
+
+    Serial.printf("=== PERFIL DE FASES: %lu ciclos en la ventana (%lu desde el encendido) ===\n",
+                  (unsigned long)rtc_profile.cycles, (unsigned long)rtc_profile.total_cycles);
+    Serial.println("fase         ciclos   media ms    max ms  uAh/ciclo  <16ms <64 <256 <1s <4s <16s <64s >64s");
+    for (uint8_t i = 0; i < PROFILER_PHASE_COUNT; i++) {
+        const profiler_stats_t* stats = &rtc_profile.phase[i];
+        if (stats->count == 0) continue;
+
+        Serial.printf("%-12s %6lu %10lu %9lu %10lu ", PHASE_INFO[i].name, (unsigned long)stats->count,
+                      (unsigned long)(stats->total_ms / stats->count), (unsigned long)stats->max_ms,
+                      (unsigned long)(stats->charge_mc * 1000ULL / 3600 / stats->count));
+        for (uint8_t b = 0; b < PROFILER_BUCKETS; b++) {
+            Serial.printf(" %u", stats->bucket[b]);
+        }
+        Serial.println();
+    }
+}
+
+/**
+ * @brief Atiende el comando PROFILE recibido por Serial
+ */
+void profiler_process_serial(void) {
+    if (Serial.available() == 0 || Serial.peek() != 'P') return;
+
+    String command = Serial.readStringUntil('\n');
+    command.trim();
+    if (command == "PROFILE") {
+        profiler_dump();
+    }
+}
@@ -0,0 +1,319 @@
+/**
+ * @file      remote_config.cpp
+ * @brief     Ajustes de operación cambiados por downlink, guardados en NVS
+ *
+ * La copia en memoria RTC evita leer NVS en cada despertar; NVS solo se lee
+ * al encender y se escribe cuando un downlink cambia algo. Ver
+ * remote_config.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <lmic.h>
+#include <stddef.h>
+#include <string.h>
+#include <Preferences.h>
+#include "remote_config.h"
+#include "sensor_interface.h"   // Registro de drivers y precisión del DS18B20
+#include "logger.h"             // Logs diferidos por Serial
+#ifdef ENABLE_SENSOR_PH
+#include "ph_adc.h"             // Muestras por ráfaga del ADC
+#endif
+
+// Identificación del estado en memoria RTC y en NVS
+#define REMOTE_CONFIG_MAGIC 0x52434631UL  // "RCF1"
+
+// Mínimo de muestras por lectura de pH (mediana y media recortada con sentido)
+#define PH_SAMPLES_MIN 16
+
+/**
+ * @brief Ajustes guardados en NVS
+ * @note El CRC debe ser siempre el último campo
+ */
+typedef struct {
+    uint32_t magic;
+    uint8_t  version;
+    remote_config_t config;
+    uint16_t crc;
+} remote_config_stored_t;
+
+/**
+ * @brief Ajustes vigentes y confirmación pendiente en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    remote_config_t config;
+    bool     ack_pending;  /**< Hay un downlink sin confirmar */
+    uint8_t  ack_seq;      /**< Secuencia del último downlink */
+    uint8_t  ack_status;   /**< remote_config_status_t */
+    uint8_t  ack_tag;      /**< Etiqueta rechazada */
+} remote_config_rtc_t;
+
+static RTC_DATA_ATTR remote_config_rtc_t rtc_remote;
+
+// Downlink recibido en este ciclo: se confirma en el siguiente
+static bool received_this_boot = false;
+
+/**
+ * @brief Ajustes de config.h
+ */
+void remote_config_defaults(remote_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->send_interval_s = SEND_INTERVAL_SECONDS;
+    config->batch_samples = BATCH_SAMPLES_PER_UPLINK;
+    config->sensor_mask = (uint8_t)((1U << sensors_driver_count()) - 1);
+    config->dr_policy = LINK_CONTROLLER_ADR ? REMOTE_CONFIG_DR_ADR : REMOTE_CONFIG_DR_MODEL;
+    config->fixed_dr = DR_SF7;
+}
+
+/**
+ * @brief Comprueba un campo; devuelve la etiqueta del primero fuera de rango
+ */
+static uint8_t invalid_tag(const remote_config_t* config) {
+    if (config->send_interval_s < SCHEDULER_MIN_INTERVAL_SECONDS ||
+        config->send_interval_s > SCHEDULER_MAX_INTERVAL_SECONDS) {
+        return REMOTE_CONFIG_TAG_INTERVAL;
+    }
+    if (config->batch_samples < 1 || config->batch_samples > BATCH_BUFFER_RECORDS) {
+        return REMOTE_CONFIG_TAG_BATCH;
+    }
+    if ((config->sensor_mask >> sensors_driver_count()) != 0) {
+        return REMOTE_CONFIG_TAG_SENSORS;
+    }
+#ifdef ENABLE_SENSOR_DS18B20
+    if (config->ds18b20_bits != 0 && (config->ds18b20_bits < 9 || config->ds18b20_bits > 12)) {
+#else
+    if (config->ds18b20_bits != 0) {
+#endif
+        return REMOTE_CONFIG_TAG_DS18B20_BITS;
+    }
+#ifdef ENABLE_SENSOR_PH
+    if (config->ph_samples != 0 && (config->ph_samples < PH_SAMPLES_MIN || config->ph_samples > PH_ADC_SAMPLES)) {
+#else
+    if (config->ph_samples != 0) {
+#endif
+        return REMOTE_CONFIG_TAG_PH_SAMPLES;
+    }
+    if (config->dr_policy > REMOTE_CONFIG_DR_FIXED || config->fixed_dr > DR_SF7) {
+        return REMOTE_CONFIG_TAG_DR_POLICY;
+    }
+    return 0;
+}
+
+/**
+ * @brief Aplica los TLV de un downlink sobre una configuración
+ */
+remote_config_status_t remote_config_parse(const uint8_t* data, uint8_t len,
+                                           remote_config_t* config, uint8_t* tag) {
+    if (tag) *tag = 0;
+    if (!data || !config || len < 2) return REMOTE_CONFIG_MALFORMED;
+    if (data[0] != REMOTE_CONFIG_VERSION) return REMOTE_CONFIG_BAD_VERSION;
+
+    remote_config_t staged = *config;
+    uint8_t pos = 2;
+    while (pos < len) {
+        if (len - pos < 2) return REMOTE_CONFIG_MALFORMED;
+        uint8_t t = data[pos];
+        uint8_t l = data[pos + 1];
+        const uint8_t* v = &data[pos + 2];
+        if (tag) *tag = t;
+        if (len - pos - 2 < l) return REMOTE_CONFIG_MALFORMED;
+        pos += 2 + l;
+
+        switch (t) {
+            case REMOTE_CONFIG_TAG_INTERVAL:
+                if (l != 2) return REMOTE_CONFIG_MALFORMED;
+                staged.send_interval_s = v[0] | (v[1] << 8);
+                break;
+            case REMOTE_CONFIG_TAG_BATCH:
+                if (l != 1) return REMOTE_CONFIG_MALFORMED;
+                staged.batch_samples = v[0];
+                break;
+            case REMOTE_CONFIG_TAG_SENSORS:
+                if (l != 1) return REMOTE_CONFIG_MALFORMED;
+                staged.sensor_mask = v[0];
+                break;
+            case REMOTE_CONFIG_TAG_DS18B20_BITS:
+                if (l != 1) return REMOTE_CONFIG_MALFORMED;
+                staged.ds18b20_bits = v[0];
+                break;
+            case REMOTE_CONFIG_TAG_PH_SAMPLES:
+                if (l != 2) return REMOTE_CONFIG_MALFORMED;
+                staged.ph_samples = v[0] | (v[1] << 8);
+                break;
+            case REMOTE_CONFIG_TAG_DR_POLICY:
+                if (l != 1 && l != 2) return REMOTE_CONFIG_MALFORMED;
+                staged.dr_policy = v[0];
+                if (l == 2) staged.fixed_dr = v[1];
+                break;
+            case REMOTE_CONFIG_TAG_DEFAULTS:
+                if (l != 0) return REMOTE_CONFIG_MALFORMED;
+                remote_config_defaults(&staged);
+                break;
+            default:
+                return REMOTE_CONFIG_UNKNOWN_TAG;
+        }
+        if (invalid_tag(&staged) != 0) return REMOTE_CONFIG_BAD_VALUE;
+    }
+
+    if (tag) *tag = 0;
+    *config = staged;
+    return REMOTE_CONFIG_OK;
+}
+
+/**
+ * @brief CRC16 de los ajustes guardados (sin incluir el propio campo CRC)
+ */
+static uint16_t stored_crc(const remote_config_stored_t* s) {
+    return os_crc16((xref2u1_t)s, offsetof(remote_config_stored_t, crc));
+}
+
+/**
+ * @brief Recupera los ajustes de NVS
+ */
+static bool load_from_nvs(remote_config_t* config) {
+    remote_config_stored_t s;
+    Preferences prefs;
+    if (!prefs.begin("remotecfg", true)) return false;
+    size_t len = prefs.getBytes("config", &s, sizeof(s));
+    prefs.end();
+    if (len != sizeof(s) || s.magic != REMOTE_CONFIG_MAGIC || s.version != REMOTE_CONFIG_VERSION) return false;
+    if (s.crc != stored_crc(&s) || invalid_tag(&s.config) != 0) return false;
+    *config = s.config;
+    return true;
+}
+
+/**
+ * @brief Copia los ajustes a NVS
+ */
+static void store_to_nvs(const remote_config_t* config) {
+    remote_config_stored_t s;
+    memset(&s, 0, sizeof(s));
+    s.magic = REMOTE_CONFIG_MAGIC;
+    s.version = REMOTE_CONFIG_VERSION;
+    s.config = *config;
+    s.crc = stored_crc(&s);
+
+    Preferences prefs;
+    if (!prefs.begin("remotecfg", false)) return;
+    prefs.putBytes("config", &s, sizeof(s));
+    prefs.end();
+}
+
+/**
+ * @brief Ajustes vigentes
+ */
+const remote_config_t* remote_config_get(void) {
+    if (rtc_remote.magic != REMOTE_CONFIG_MAGIC || invalid_tag(&rtc_remote.config) != 0) {
+        memset(&rtc_remote, 0, sizeof(rtc_remote));
+        rtc_remote.magic = REMOTE_CONFIG_MAGIC;
+        if (load_from_nvs(&rtc_remote.config)) {
+            LOG_INFO_FAST("Configuración remota recuperada de NVS\n");
+        } else {
+            remote_config_defaults(&rtc_remote.config);
+        }
+    }
+    return &rtc_remote.config;
+}
+
+/**
+ * @brief Pasa a los drivers los ajustes que guardan ellos (DS18B20, pH)
+ */
+void remote_config_apply(void) {
+    const remote_config_t* config = remote_config_get();
+#ifdef ENABLE_SENSOR_DS18B20
+    // Paso de 0.5 °C a 9 bits, la mitad con cada bit más
+    sensor_ds18b20_set_precision(config->ds18b20_bits
+                                 ? 0.5f / (1 << (config->ds18b20_bits - 9))
+                                 : DS18B20_PRECISION_C);
+#endif
+#ifdef ENABLE_SENSOR_PH
+    ph_adc_set_samples(config->ph_samples ? config->ph_samples : PH_ADC_SAMPLES);
+#endif
+    (void)config;
+}
+
+/**
+ * @brief Procesa un downlink si es de configuración
+ */
+bool remote_config_on_downlink(uint8_t port, const uint8_t* data, uint8_t len) {
+    if (port != REMOTE_CONFIG_FPORT) return false;
+
+    remote_config_t config = *remote_config_get();
+    uint8_t tag;
+    remote_config_status_t status = remote_config_parse(data, len, &config, &tag);
+
+    if (status == REMOTE_CONFIG_OK) {
+        if (memcmp(&config, &rtc_remote.config, sizeof(config)) != 0) {
+            rtc_remote.config = config;
+            store_to_nvs(&config);
+        }
+        LOG_INFO_FAST("Configuración remota #%u aplicada: %u s, %u muestras/uplink, sensores 0x%02X\n",
+                      data[1], config.send_interval_s, config.batch_samples, config.sensor_mask);
+        LOG_INFO_FAST("Configuración remota: DS18B20 %u bits, pH %u muestras, DR política %u/DR%u\n",
+                      config.ds18b20_bits, config.ph_samples, config.dr_policy, config.fixed_dr);
+    } else {
+        LOG_INFO_FAST("Configuración remota rechazada: error %u en la etiqueta 0x%02X\n", status, tag);
+    }
+
+    rtc_remote.ack_pending = true;
+    rtc_remote.ack_seq = len > 1 ? data[1] : 0;
+    rtc_remote.ack_status = status;
+    rtc_remote.ack_tag = tag;
+    received_this_boot = true;
+    return true;
+}
+
+/**
+ * @brief Indica si hay que enviar una confirmación en este ciclo
+ */
+bool remote_config_ack_pending(void) {
+    remote_config_get();
+    return rtc_remote.ack_pending && !received_this_boot;
+}
+
+/**
+ * @brief Construye la confirmación del último downlink
+ */
+uint8_t remote_config_build_ack(uint8_t* buffer) {
+    const remote_config_t* c = remote_config_get();
+    uint8_t n = 0;
+    buffer[n++] = REMOTE_CONFIG_VERSION;
+    buffer[n++] = rtc_remote.ack_seq;
+    buffer[n++] = rtc_remote.ack_status;
+    buffer[n++] = rtc_remote.ack_tag;
+
+    buffer[n++] = REMOTE_CONFIG_TAG_INTERVAL;
+    buffer[n++] = 2;
+    buffer[n++] = c->send_interval_s & 0xFF;
+    buffer[n++] = c->send_interval_s >> 8;
+    buffer[n++] = REMOTE_CONFIG_TAG_BATCH;
+    buffer[n++] = 1;
+    buffer[n++] = c->batch_samples;
+    buffer[n++] = REMOTE_CONFIG_TAG_SENSORS;
+    buffer[n++] = 1;
+    buffer[n++] = c->sensor_mask;
+    buffer[n++] = REMOTE_CONFIG_TAG_DS18B20_BITS;
+    buffer[n++] = 1;
+    buffer[n++] = c->ds18b20_bits;
+    buffer[n++] = REMOTE_CONFIG_TAG_PH_SAMPLES;
+    buffer[n++] = 2;
+    buffer[n++] = c->ph_samples & 0xFF;
+    buffer[n++] = c->ph_samples >> 8;
+    buffer[n++] = REMOTE_CONFIG_TAG_DR_POLICY;
+    buffer[n++] = 2;
+    buffer[n++] = c->dr_policy;
+    buffer[n++] = c->fixed_dr;
+    return n;
+}
+
+/**
+ * @brief Marca la confirmación como enviada
+ */
+void remote_config_ack_sent(void) {
+    // Un downlink llegado con la propia confirmación se confirma en el siguiente ciclo
+    if (!received_this_boot) rtc_remote.ack_pending = false;
+}
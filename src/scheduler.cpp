@@ -0,0 +1,234 @@
+/**
+ * @file      scheduler.cpp
+ * @brief     Planificador adaptativo del intervalo de medida según batería y sol
+ *
+ * Ver scheduler.h. El reloj, la tendencia de la batería y la detección del
+ * amanecer se guardan en memoria RTC; se reinician al encender.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include "scheduler.h"
+#include "LoRaBoards.h"         // Arduino y memoria RTC
+#include "battery_soc.h"        // Telemetría del PMU y estado de carga
+#include "logger.h"             // Logs diferidos por Serial
+#include "remote_config.h"      // Intervalo nominal fijado por downlink
+#include "batch.h"              // Registros pendientes del lote
+
+// Identificación del estado en memoria RTC
+#define SCHEDULER_MAGIC 0x53434832UL  // "SCH2"
+
+/**
+ * @brief Estado del planificador guardado en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t interval_s;        /**< Intervalo vigente */
+    uint32_t clock_s;           /**< Tiempo desde el encendido al inicio del ciclo */
+    uint32_t last_sample_s;     /**< Reloj de la última lectura de batería */
+    uint32_t vbus_off_since_s;  /**< Reloj en que desapareció VBUS */
+    uint32_t sunrise_s;         /**< Reloj del último amanecer detectado */
+    uint16_t clock_ms;          /**< Milisegundos despierto aún no sumados a clock_s */
+    uint16_t last_mv;           /**< Última tensión de batería */
+    int16_t  trend_mv_h;        /**< Tendencia filtrada (mV/h) */
+    bool     vbus;              /**< VBUS en la última lectura */
+    bool     sunrise_known;     /**< Se ha detectado al menos un amanecer */
+} scheduler_rtc_t;
+
+static RTC_DATA_ATTR scheduler_rtc_t rtc_scheduler;
+
+// =============================================================================
+// POLÍTICAS
+// =============================================================================
+
+/**
+ * @brief Indica si es de noche: por la hora estimada o, sin ella, por VBUS
+ */
+static bool is_night(const scheduler_state_t* state) {
+    if (state->hour == SCHEDULER_HOUR_UNKNOWN) return !state->vbus;
+    uint8_t since_sunrise = (state->hour + 24 - SCHEDULER_SUNRISE_HOUR) % 24;
+    return since_sunrise >= SCHEDULER_DAYLIGHT_HOURS;
+}
+
+/**
+ * @brief Política fija: siempre el intervalo nominal
+ */
+static uint32_t policy_fixed(const scheduler_state_t* state) {
+    return state->base_interval_s;
+}
+
+/**
+ * @brief Política adaptativa
+ *
+ * - Panel produciendo y batería llena: la energía sobrante se usa en medir
+ *   el doble de a menudo
+ * - Batería por debajo de BATTERY_LOW_THRESHOLD: intervalo x4
+ * - Batería a media carga y bajando: intervalo x2
+ * - De noche, sin VBUS y descargándose: otro x2 hasta el amanecer
+ */
+static uint32_t policy_adaptive(const scheduler_state_t* state) {
+    uint32_t interval = state->base_interval_s;
+    if (state->battery_mv == 0) return interval;  // Sin lectura: no se adapta
+
+    bool depleting = state->trend_mv_per_hour < 0;
+    if (state->vbus && (state->soc_percent >= 90 || (!state->charging && state->soc_percent >= 70))) {
+        interval /= 2;
+    } else if (state->soc_percent < BATTERY_LOW_THRESHOLD) {
+        interval *= 4;
+    } else if (state->soc_percent < 50 && depleting) {
+        interval *= 2;
+    }
+
+    if (is_night(state) && !state->vbus && depleting && state->soc_percent < 80) {
+        interval *= 2;
+    }
+    return interval;
+}
+
+static const scheduler_policy_t POLICIES[] = {
+    { "fija",       policy_fixed },
+    { "adaptativa", policy_adaptive },
+};
+
+/**
+ * @brief Número de políticas disponibles
+ */
+uint8_t scheduler_policy_count(void) {
+    return sizeof(POLICIES) / sizeof(POLICIES[0]);
+}
+
+/**
+ * @brief Política por índice
+ */
+const scheduler_policy_t* scheduler_policy(uint8_t index) {
+    return index < scheduler_policy_count() ? &POLICIES[index] : NULL;
+}
+
+// =============================================================================
+// ESTADO
+// =============================================================================
+
+/**
+ * @brief Inicializa el estado si la memoria RTC no es válida (encendido)
+ */
+static void scheduler_check(void) {
+    if (rtc_scheduler.magic != SCHEDULER_MAGIC) {
+        memset(&rtc_scheduler, 0, sizeof(rtc_scheduler));
+        rtc_scheduler.magic = SCHEDULER_MAGIC;
+        rtc_scheduler.interval_s = remote_config_get()->send_interval_s;
+    }
+}
+
+/**
+ * @brief Lee batería y PMU y actualiza tendencia, VBUS y amanecer
+ */
+static void read_state(scheduler_state_t* state) {
+    uint32_t now = scheduler_clock_s();
+
+    battery_soc_update();
+    const battery_status_t* battery = battery_status();
+    state->battery_mv = battery->battery_mv;
+    state->soc_percent = battery->soc_percent;
+    state->vbus = battery->vbus;
+    state->charging = battery->charging;
+    state->base_interval_s = remote_config_get()->send_interval_s;
+
+    // Tendencia en mV/h, filtrada (1/4) para no reaccionar a picos de carga
+    if (state->battery_mv && rtc_scheduler.last_mv && now > rtc_scheduler.last_sample_s) {
+        int32_t rate = ((int32_t)state->battery_mv - rtc_scheduler.last_mv) * 3600 /
+                       (int32_t)(now - rtc_scheduler.last_sample_s);
+        rtc_scheduler.trend_mv_h += (rate - rtc_scheduler.trend_mv_h) / 4;
+    }
+    rtc_scheduler.last_mv = state->battery_mv;
+    rtc_scheduler.last_sample_s = now;
+    state->trend_mv_per_hour = rtc_scheduler.trend_mv_h;
+
+    // Amanecer: vuelve VBUS tras una noche completa sin él
+    if (!state->vbus && rtc_scheduler.vbus) {
+        rtc_scheduler.vbus_off_since_s = now;
+    } else if (state->vbus && !rtc_scheduler.vbus &&
+               now - rtc_scheduler.vbus_off_since_s >= SCHEDULER_NIGHT_MIN_HOURS * 3600UL) {
+        rtc_scheduler.sunrise_s = now;
+        rtc_scheduler.sunrise_known = true;
+        LOG_INFO_FAST("Planificador: amanecer detectado, reloj solar sincronizado\n");
+    }
+    rtc_scheduler.vbus = state->vbus;
+
+    state->hour = rtc_scheduler.sunrise_known
+                  ? (SCHEDULER_SUNRISE_HOUR + (now - rtc_scheduler.sunrise_s) / 3600) % 24
+                  : SCHEDULER_HOUR_UNKNOWN;
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+/**
+ * @brief Lee el estado de la energía y decide el siguiente intervalo
+ */
+uint32_t scheduler_plan(uint32_t airtime_us) {
+    scheduler_check();
+
+    scheduler_state_t state;
+    read_state(&state);
+
+    // Los registros pendientes salen con el intervalo vigente: no se cambia
+    // hasta que el lote se vacíe (ver scheduler.h)
+    uint8_t pending = batch_count();
+    if (pending > 0) {
+        LOG_INFO("Planificador: %u registros en el lote, se mantiene %lu s\n",
+                 pending, (unsigned long)rtc_scheduler.interval_s);
+        return rtc_scheduler.interval_s;
+    }
+
+    const scheduler_policy_t* policy = scheduler_policy(SCHEDULER_POLICY);
+    if (!policy) policy = &POLICIES[0];
+    uint32_t interval = policy->next_interval(&state);
+
+    if (interval < SCHEDULER_MIN_INTERVAL_SECONDS) interval = SCHEDULER_MIN_INTERVAL_SECONDS;
+    if (interval > SCHEDULER_MAX_INTERVAL_SECONDS) interval = SCHEDULER_MAX_INTERVAL_SECONDS;
+
+    // Duty cycle: tras T en el aire, (100 / DC - 1) * T de silencio
+    uint32_t off_s = (uint32_t)(((uint64_t)airtime_us * (100 / SCHEDULER_DUTY_CYCLE_PERCENT - 1) + 999999) / 1000000);
+    if (interval < off_s) interval = off_s;
+
+    LOG_INFO("Planificador (%s): %u mV, %u %%, %d mV/h, VBUS %s%s, hora %d -> %lu s\n",
+             policy->name, state.battery_mv, state.soc_percent, state.trend_mv_per_hour,
+             state.vbus ? "sí" : "no", state.charging ? " (cargando)" : "",
+             state.hour == SCHEDULER_HOUR_UNKNOWN ? -1 : state.hour, (unsigned long)interval);
+
+    rtc_scheduler.interval_s = interval;
+    return interval;
+}
+
+/**
+ * @brief Intervalo vigente
+ */
+uint32_t scheduler_interval(void) {
+    scheduler_check();
+    return rtc_scheduler.interval_s;
+}
+
+/**
+ * @brief Segundos desde el encendido, incluido el sueño profundo
+ */
+uint32_t scheduler_clock_s(void) {
+    scheduler_check();
+    return rtc_scheduler.clock_s + (rtc_scheduler.clock_ms + millis()) / 1000;
+}
+
+/**
+ * @brief Avanza el reloj del planificador antes del sueño profundo
+ *
+ * El resto de milisegundos del ciclo despierto se guarda para el siguiente:
+ * truncar a segundos perdería hasta 1 s por ciclo.
+ */
+void scheduler_on_sleep(uint32_t sleep_seconds) {
+    scheduler_check();
+    uint32_t awake_ms = rtc_scheduler.clock_ms + millis();
+    rtc_scheduler.clock_s += awake_ms / 1000 + sleep_seconds;
+    rtc_scheduler.clock_ms = awake_ms % 1000;
+}
@@ -13,6 +13,9 @@
 #include "screen.h"
 #include "LoRaBoards.h"
 #include "../config/config.h"  // Configuración del proyecto
+#include "sensor_interface.h"  // sensor_format_fixed
+#include "logger.h"            // Logs diferidos por Serial
+#include "cpu_governor.h"      // Ráfaga durante la composición
 
 // Declaraciones forward
 void turnOffDisplay();
@@ -32,24 +35,27 @@ static bool displayActive = false;
  */
 bool initDisplay() {
     if (!ENABLE_DISPLAY) {
-        Serial.println("Display disabled in configuration");
+        LOG_INFO_FAST("Display disabled in configuration\n");
         return false;
     }
 
-    Serial.print("DEBUG: Initializing display, u8g2 = ");
-    Serial.println((u8g2 != nullptr) ? "not null" : "null");
+    LOG_DEBUG("DEBUG: Initializing display, u8g2 = %s\n", (u8g2 != nullptr) ? "not null" : "null");
 
     if (!u8g2) {
-        Serial.println("Display no disponible");
+        LOG_INFO_FAST("Display no disponible\n");
         return false;
     }
     u8g2->begin();
     u8g2->clearBuffer();
     u8g2->setFont(u8g2_font_ncenB08_tr);
-    u8g2->drawStr(0, 20, "MediaLab LoRaWAN");
-    u8g2->drawStr(0, 40, "Bajo Consumo V.1.1");
-    u8g2->sendBuffer();
-    delay(2000);
+
+    // Pantalla de bienvenida solo al encender, no en cada despertar
+    if (!isFastBoot()) {
+        u8g2->drawStr(0, 20, "MediaLab LoRaWAN");
+        u8g2->drawStr(0, 40, "Bajo Consumo V.1.1");
+        u8g2->sendBuffer();
+        cpu_governor_delay(2000);
+    }
 
     displayActive = true;
     return true;
@@ -92,6 +98,8 @@ static void renderMessage(ScreenMessageType type, const String& text) {
         return;
     }
 
+    // Composición en RAM a CPU_BOOST_MHZ; el envío por I2C no depende de la CPU
+    cpu_governor_boost();
     u8g2->clearBuffer();
     u8g2->setFont(u8g2_font_ncenB08_tr);
 
@@ -137,6 +145,7 @@ static void renderMessage(ScreenMessageType type, const String& text) {
     }
 
     // Los indicadores de actividad se muestran en turnOffDisplay(), no aquí
+    cpu_governor_unboost();
 
     u8g2->sendBuffer();
 }
@@ -153,11 +162,7 @@ void showMessage(ScreenMessageType type, const String& text, uint32_t duration)
         return;
     }
 
-    Serial.print("DEBUG: Showing message: '");
-    Serial.print(text);
-    Serial.print("' for ");
-    Serial.print(duration);
-    Serial.println("ms");
+    LOG_DEBUG("DEBUG: Showing message: '%s' for %lums\n", text.c_str(), (unsigned long)duration);
 
     currentMessage = text;
     currentType = type;
@@ -215,19 +220,21 @@ void showSuccess(const String& text, uint32_t duration) {
 /**
  * @brief Muestra datos del sensor en la pantalla
  *
- * @param temp Temperatura en °C
- * @param hum Humedad en %
- * @param battery Voltaje de batería en V
+ * @param data Lecturas (enteros escalados, ver sensor_data_t)
  * @param duration Duración en milisegundos (por defecto 5000ms)
  */
-void showSensorData(float temp, float hum, float battery, uint32_t duration) {
-    char buffer[64];
-    if (temp == -999.0f && hum == -1.0f) {
+void showSensorData(const sensor_data_t* data, uint32_t duration) {
+    const uint8_t needed = SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY;
+    if (!data || (data->valid_mask & needed) != needed) {
         // Datos de error del sensor
         showMessage(MSG_ERROR, "Sensor ERROR!", duration);
     } else {
         // Datos válidos del sensor
-        sprintf(buffer, "T:%.1fC H:%.1f%% B:%.2fV", temp, hum, battery);
+        char temp[12], hum[12], battery[12], buffer[64];
+        snprintf(buffer, sizeof(buffer), "T:%sC H:%s%% B:%sV",
+                 sensor_format_fixed(temp, sizeof(temp), data->temperature, SENSOR_SCALE_TEMPERATURE, 1),
+                 sensor_format_fixed(hum, sizeof(hum), data->humidity, SENSOR_SCALE_HUMIDITY, 1),
+                 sensor_format_fixed(battery, sizeof(battery), data->battery, SENSOR_SCALE_BATTERY, 2));
         showMessage(MSG_SENSOR_DATA, buffer, duration);
     }
 }
@@ -11,11 +11,44 @@
 
 #include "../config/config.h"  // Configuracion unificada del proyecto
 #include "sensor_interface.h"  // Interfaz generica de sensores
-#include "LoRaBoards.h"  // Para readBatteryVoltage y batteryPercentFromVoltage
+#include "payload_codec.h"     // Codec compacto del payload
+#include "battery_soc.h" // Tensión de batería (telemetría del PMU)
+#include "power_rail.h"   // Rails de alimentacion y esperas en light sleep
+#include "sensor_registry.h"  // Tabla de drivers (SENSOR_DRIVERS)
+#include "profiler.h"   // Perfil de fases del ciclo
+#include "logger.h"     // Logs diferidos por Serial
+#include "remote_config.h"  // Sensores activos y ajustes por downlink
 
 // Declaracion externa para funciones de carga solar
 extern bool isSolarChargingBattery();
 
+// ============================================================================
+// REGISTRO DE DRIVERS
+// ============================================================================
+
+/**
+ * @brief Numero de drivers registrados
+ */
+uint8_t sensors_driver_count(void) {
+    return SENSOR_DRIVER_COUNT;
+}
+
+/**
+ * @brief Descriptor del driver i-esimo del registro
+ * @return NULL si el indice esta fuera de la tabla
+ */
+const sensor_driver_t* sensors_driver(uint8_t index) {
+    if (index >= SENSOR_DRIVER_COUNT) return NULL;
+    return &SENSOR_DRIVERS[index];
+}
+
+/**
+ * @brief Indica si el driver i-esimo esta activo (ver remote_config.h)
+ */
+static bool driver_enabled(uint8_t index) {
+    return (remote_config_get()->sensor_mask >> index) & 1;
+}
+
 // ============================================================================
 // FUNCIONES PARA GESTIONAR TODOS LOS SENSORES
 // ============================================================================
@@ -26,27 +59,20 @@ extern bool isSolarChargingBattery();
  */
 bool sensors_init_all(void) {
     bool any_init = false;
-    
-#ifdef ENABLE_SENSOR_BME280
-    if (sensor_bme280_init()) {
-        Serial.println("BME280 inicializado");
-        any_init = true;
-    }
-#endif
 
-#ifdef ENABLE_SENSOR_DS18B20
-    if (sensor_ds18b20_init()) {
-        Serial.println("DS18B20 inicializado");
-        any_init = true;
-    }
-#endif
+    // Precision del DS18B20 y muestras de pH fijadas por downlink
+    remote_config_apply();
 
-#ifdef ENABLE_SENSOR_PH
-    if (sensor_ph_init()) {
-        Serial.println("Sensor de pH inicializado");
-        any_init = true;
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        if (!driver_enabled(i)) {
+            LOG_INFO("%s desactivado por configuracion remota\n", SENSOR_DRIVERS[i].name);
+            continue;
+        }
+        if (SENSOR_DRIVERS[i].init()) {
+            LOG_INFO("%s inicializado\n", SENSOR_DRIVERS[i].name);
+            any_init = true;
+        }
     }
-#endif
 
     return any_init;
 }
@@ -57,18 +83,10 @@ bool sensors_init_all(void) {
  */
 bool sensors_is_any_available(void) {
     bool any_available = false;
-    
-#ifdef ENABLE_SENSOR_BME280
-    any_available |= sensor_bme280_is_available();
-#endif
-
-#ifdef ENABLE_SENSOR_DS18B20
-    any_available |= sensor_ds18b20_is_available();
-#endif
 
-#ifdef ENABLE_SENSOR_PH
-    any_available |= sensor_ph_is_available();
-#endif
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        any_available |= driver_enabled(i) && SENSOR_DRIVERS[i].is_available();
+    }
 
     return any_available;
 }
@@ -79,196 +97,276 @@ bool sensors_is_any_available(void) {
  */
 bool sensors_retry_init_all(void) {
     bool any_retry = false;
-    
-#ifdef ENABLE_SENSOR_BME280
-    any_retry |= sensor_bme280_retry_init();
-#endif
 
-#ifdef ENABLE_SENSOR_DS18B20
-    any_retry |= sensor_ds18b20_retry_init();
-#endif
-
-#ifdef ENABLE_SENSOR_PH
-    any_retry |= sensor_ph_retry_init();
-#endif
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        if (driver_enabled(i)) any_retry |= SENSOR_DRIVERS[i].retry_init();
+    }
 
     return any_retry;
 }
 
+/**
+ * @brief Fase de un sensor dentro de sensors_read_all()
+ */
+typedef enum {
+    SENSOR_STAGE_IDLE,        /**< No disponible en este ciclo */
+    SENSOR_STAGE_WARMUP,      /**< Rail encendido, estabilizandose */
+    SENSOR_STAGE_CONVERTING,  /**< Conversion lanzada */
+    SENSOR_STAGE_DONE         /**< Leido y rail liberado */
+} sensor_stage_t;
+
+/**
+ * @brief Estado de planificacion de un sensor
+ */
+typedef struct {
+    sensor_stage_t stage;   /**< Fase actual */
+    uint32_t due_at;        /**< Fin de la fase actual (millis) */
+    uint32_t started_at;    /**< Inicio de la medida, tras estabilizar (millis) */
+    uint32_t elapsed_ms;    /**< Duracion de la medida */
+} sensor_schedule_t;
+
 /**
  * @brief Lee datos de todos los sensores habilitados
+ *
+ * En lugar de leer cada sensor de forma secuencial (cada uno con su propia
+ * espera de estabilizacion), todos los sensores solicitan su alimentacion al
+ * principio (ver power_rail.h: el rail compartido se enciende una sola vez)
+ * y las fases se solapan. Se atiende siempre el plazo mas proximo:
+ *   - Fin de estabilizacion: se lanza la conversion sin bloquear (start) o,
+ *     si el sensor no tiene, se lee directamente.
+ *   - Fin de conversion: se espera con el hook wait del driver, se lee y se
+ *     libera el rail.
+ * A igualdad de plazo se lanzan antes las conversiones y se respeta el orden
+ * de SENSOR_DRIVERS. Las esperas entre plazos se pasan en light sleep. El
+ * ciclo dura max(estabilizacion) + conversion en lugar de la suma de todas
+ * las esperas.
+ *
  * @param data Puntero a estructura donde almacenar los datos
  * @return true si se pudieron leer datos de al menos un sensor
  */
 bool sensors_read_all(sensor_data_t* data) {
     if (!data) return false;
 
-    // Inicializar con valores de error
-    data->temperature = SENSOR_ERROR_TEMPERATURE;
-    data->humidity = SENSOR_ERROR_HUMIDITY;
-    data->pressure = SENSOR_ERROR_PRESSURE;
-    data->temperature_1m = SENSOR_ERROR_TEMPERATURE;
-    data->ph = SENSOR_ERROR_PH;
-    data->battery = readBatteryVoltage();
-    data->valid = false;
+    // Sin lecturas: cada driver activa el bit de validez de sus campos
+    memset(data, 0, sizeof(*data));
+    if (battery_soc_update()) {
+        data->battery = battery_status()->battery_mv;
+        data->valid_mask |= SENSOR_FIELD_BATTERY;
+    }
 
     bool any_data = false;
+    uint32_t t_start = millis();
+    power_rail_slept_ms(true);
+    PHASE_BEGIN(PROFILER_PHASE_SENSORS);
+
+    // Solicitar la alimentacion de todos los sensores a la vez
+    sensor_schedule_t schedule[SENSOR_DRIVER_COUNT > 0 ? SENSOR_DRIVER_COUNT : 1] = {};
+    uint8_t pending = 0;
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        const sensor_driver_t* driver = &SENSOR_DRIVERS[i];
+        if (!driver_enabled(i) || !driver->is_available()) continue;
+
+        schedule[i].stage = SENSOR_STAGE_WARMUP;
+        schedule[i].due_at = driver->power_pin == SENSOR_POWER_ALWAYS_ON
+            ? millis() + driver->warmup_ms
+            : power_rail_acquire(driver->power_pin, driver->warmup_ms);
+        pending++;
+    }
 
-    // Leer del sensor BME280
-#ifdef ENABLE_SENSOR_BME280
-    {
-        sensor_data_t bme_data;
-        if (sensor_bme280_read_all(&bme_data)) {
-            if (bme_data.temperature != SENSOR_ERROR_TEMPERATURE) {
-                data->temperature = bme_data.temperature;
-                any_data = true;
-            }
-            if (bme_data.humidity != SENSOR_ERROR_HUMIDITY) {
-                data->humidity = bme_data.humidity;
-                any_data = true;
+    while (pending > 0) {
+        // Siguiente plazo (a igualdad, las conversiones por lanzar primero)
+        int8_t next = -1;
+        for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+            if (schedule[i].stage != SENSOR_STAGE_WARMUP && schedule[i].stage != SENSOR_STAGE_CONVERTING) continue;
+            if (next < 0) {
+                next = i;
+                continue;
             }
-            if (bme_data.pressure != SENSOR_ERROR_PRESSURE) {
-                data->pressure = bme_data.pressure;
-                any_data = true;
+            int32_t diff = (int32_t)(schedule[i].due_at - schedule[next].due_at);
+            if (diff < 0 || (diff == 0 && schedule[i].stage < schedule[next].stage)) {
+                next = i;
             }
         }
-    }
-#endif
-
-    // Leer del sensor DS18B20 (temperatura a 1m)
-#ifdef ENABLE_SENSOR_DS18B20
-    {
-        sensor_data_t ds18b20_data;
-        if (sensor_ds18b20_read_all(&ds18b20_data)) {
-            if (ds18b20_data.temperature_1m != SENSOR_ERROR_TEMPERATURE) {
-                data->temperature_1m = ds18b20_data.temperature_1m;
-                any_data = true;
+
+        const sensor_driver_t* driver = &SENSOR_DRIVERS[next];
+        sensor_schedule_t* entry = &schedule[next];
+
+        if (entry->stage == SENSOR_STAGE_WARMUP) {
+            power_rail_wait_until(entry->due_at);
+            entry->started_at = millis();
+            if (driver->start) {
+                entry->due_at = entry->started_at + driver->start();
+                entry->stage = SENSOR_STAGE_CONVERTING;
+                continue;
             }
+        } else if (driver->wait) {
+            driver->wait(entry->due_at);
+        } else {
+            power_rail_wait_until(entry->due_at);
         }
-    }
-#endif
-
-    // Leer del sensor de pH (con compensacion de temperatura si esta disponible)
-#ifdef ENABLE_SENSOR_PH
-    {
-        // Si tenemos temperatura del BME280, actualizar compensacion de pH
-        #ifdef ENABLE_SENSOR_BME280
-        if (data->temperature != SENSOR_ERROR_TEMPERATURE) {
-            sensor_ph_set_temperature(data->temperature);
-        }
-        #endif
-        
-        sensor_data_t ph_data;
-        if (sensor_ph_read_all(&ph_data)) {
-            if (ph_data.ph != SENSOR_ERROR_PH) {
-                data->ph = ph_data.ph;
-                any_data = true;
-            }
+
+        any_data |= driver->read(data);
+        if (driver->power_pin != SENSOR_POWER_ALWAYS_ON) {
+            power_rail_release(driver->power_pin);
         }
+        entry->elapsed_ms = millis() - entry->started_at;
+        entry->stage = SENSOR_STAGE_DONE;
+        pending--;
     }
-#endif
 
-    data->valid = any_data;
+    PHASE_SLEEP(PROFILER_PHASE_SENSORS, power_rail_slept_ms(false) * 1000);
+    PHASE_END(PROFILER_PHASE_SENSORS);
+
+    LOG_INFO_FAST("Sensores:");
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        LOG_INFO(" %s %lu ms,", SENSOR_DRIVERS[i].name, (unsigned long)schedule[i].elapsed_ms);
+    }
+    LOG_INFO_FAST(" total %lu ms (%lu ms en light sleep)\n",
+                  millis() - t_start, power_rail_slept_ms(false));
+
     return any_data;
 }
 
+// ============================================================================
+// SNAPSHOT DE LECTURAS
+// ============================================================================
+
+/**
+ * @brief Ultima adquisicion de todos los sensores
+ *
+ * Una adquisicion completa cuesta decenas de segundos (estabilizacion de los
+ * sensores del rail), asi que se hace una sola vez por ciclo y el resto de
+ * consumidores (payload, pantalla, logs) leen esta copia. Vive en RAM: tras
+ * el sueño profundo no hay snapshot y el primer consumidor adquiere.
+ */
+typedef struct {
+    sensor_data_t data;   /**< Lecturas */
+    uint32_t taken_ms;    /**< Instante de la adquisicion (millis) */
+    bool ok;              /**< Resultado de sensors_read_all() */
+    bool present;         /**< true si hay snapshot */
+} sensor_snapshot_t;
+
+static sensor_snapshot_t snapshot = {};
+
+/**
+ * @brief Lee todos los sensores y guarda el resultado como snapshot
+ *
+ * Si ningun sensor responde se intenta reinicializarlos; el snapshot queda
+ * solo con la bateria (resto de bits de validez a cero).
+ *
+ * @return true si al menos un sensor dio una lectura valida
+ */
+bool sensors_acquire(void) {
+    snapshot.ok = sensors_read_all(&snapshot.data);
+    snapshot.taken_ms = millis();
+    snapshot.present = true;
+
+    if (!snapshot.ok) {
+        // Si no hay datos validos, intentar reinicializar
+        sensors_retry_init_all();
+    }
+    return snapshot.ok;
+}
+
+/**
+ * @brief Copia el snapshot actual, adquiriendo uno nuevo si no existe o ha caducado
+ *
+ * @param data Destino de las lecturas
+ * @return true si el snapshot contiene lecturas validas
+ */
+bool sensors_snapshot(sensor_data_t* data) {
+    if (sensors_snapshot_age_ms() > SENSOR_SNAPSHOT_MAX_AGE_MS) {
+        sensors_acquire();
+    }
+    if (data) *data = snapshot.data;
+    return snapshot.ok;
+}
+
+/**
+ * @brief Antigüedad del snapshot en milisegundos (UINT32_MAX si no hay)
+ */
+uint32_t sensors_snapshot_age_ms(void) {
+    if (!snapshot.present) return UINT32_MAX;
+    return millis() - snapshot.taken_ms;
+}
+
+/**
+ * @brief Descarta el snapshot para que el siguiente consumidor adquiera de nuevo
+ */
+void sensors_invalidate_snapshot(void) {
+    snapshot.present = false;
+}
+
 /**
  * @brief Construye el payload con datos de todos los sensores
+ *
+ * Usa el snapshot del ciclo (ver sensors_snapshot()).
+ *
  * @param config Configuracion del payload
  * @return Numero de bytes escritos
  */
 uint8_t sensors_get_payload(payload_config_t* config) {
-    if (!config || config->max_size < PAYLOAD_SIZE_BYTES) return 0;
+    if (!config || config->max_size < payload_codec_record_size()) return 0;
 
     sensor_data_t data;
-    bool sensor_ok = sensors_read_all(&data);
+    sensors_snapshot(&data);
 
-    if (!sensor_ok) {
-        // Si no hay datos validos, intentar reinicializar
-        sensors_retry_init_all();
-        // Usar datos de error
-        data.temperature = SENSOR_ERROR_TEMPERATURE;
-        data.humidity = SENSOR_ERROR_HUMIDITY;
-        data.pressure = SENSOR_ERROR_PRESSURE;
-        data.temperature_1m = SENSOR_ERROR_TEMPERATURE;
-        data.ph = SENSOR_ERROR_PH;
-    }
+    return sensors_encode_payload(&data, config);
+}
 
-    uint8_t offset = 0;
-
-    // Orden del payload: Bateria, pH, Temperatura exterior, Temperatura 1m, Humedad, Presion
-    
-    // 1. Bateria (2 bytes) - PRIMERO
-#ifdef BATTERY_AS_PERCENTAGE
-    // Enviar como porcentaje (2 bytes para mantener formato)
-    uint8_t batt_percent = batteryPercentFromVoltage(data.battery);
-    Serial.printf("DEBUG: Battery voltage %.2f V = %u%%\n", data.battery, batt_percent);
-    config->buffer[offset++] = batt_percent & 0xFF;       // Low byte
-    config->buffer[offset++] = 0x00;                       // High byte (siempre 0 para porcentaje)
-#else
-    // Enviar como voltaje (2 bytes)
-    uint16_t batt_int = (uint16_t)(data.battery * 100);
-    Serial.printf("DEBUG: Battery voltage %.2f V as %u (0x%04X)\n", data.battery, batt_int, batt_int);
-    config->buffer[offset++] = batt_int & 0xFF;           // Low byte primero
-    config->buffer[offset++] = batt_int >> 8;             // High byte despues
-#endif
-
-    // 2. pH (2 bytes)
-#ifdef ENABLE_SENSOR_PH
-    if (SYSTEM_HAS_PH) {
-        uint16_t ph_int = (uint16_t)(data.ph * 100);
-        config->buffer[offset++] = ph_int & 0xFF;        // Low byte primero
-        config->buffer[offset++] = ph_int >> 8;           // High byte despues
-    }
-#endif
-
-    // 3. Temperatura exterior/BME280 (2 bytes)
-#ifdef ENABLE_SENSOR_BME280
-    if (SYSTEM_HAS_TEMPERATURE) {
-        int16_t temp_int = (int16_t)(data.temperature * 100);
-        config->buffer[offset++] = temp_int & 0xFF;      // Low byte primero
-        config->buffer[offset++] = temp_int >> 8;         // High byte despues
-    }
-#endif
-
-    // 4. Temperatura a 1m (2 bytes)
-#ifdef ENABLE_SENSOR_DS18B20
-    if (SYSTEM_HAS_TEMP_1M) {
-        int16_t temp1m_int = (int16_t)(data.temperature_1m * 100);
-        config->buffer[offset++] = temp1m_int & 0xFF;     // Low byte primero
-        config->buffer[offset++] = temp1m_int >> 8;       // High byte despues
-    }
-#endif
-
-    // 5. Humedad (2 bytes)
-#ifdef ENABLE_SENSOR_BME280
-    if (SYSTEM_HAS_HUMIDITY) {
-        int16_t hum_int = (int16_t)(data.humidity * 100);
-        config->buffer[offset++] = hum_int & 0xFF;        // Low byte primero
-        config->buffer[offset++] = hum_int >> 8;          // High byte despues
-    }
-#endif
-
-    // 6. Presion (2 bytes)
-#ifdef ENABLE_SENSOR_BME280
-    if (SYSTEM_HAS_PRESSURE) {
-        uint16_t pres_int = (uint16_t)(data.pressure * 10);
-        config->buffer[offset++] = pres_int & 0xFF;       // Low byte primero
-        config->buffer[offset++] = pres_int >> 8;         // High byte despues
+/**
+ * @brief Codifica una lectura ya realizada en el formato del payload
+ *
+ * Registro completo (sin deltas) empaquetado a nivel de bit según el
+ * esquema de config/payload_schema.h (ver payload_codec.h).
+ *
+ * @param data Lecturas de los sensores
+ * @param config Configuracion del payload
+ * @return Numero de bytes escritos
+ */
+uint8_t sensors_encode_payload(const sensor_data_t* data, payload_config_t* config) {
+    if (!data || !config || config->max_size < payload_codec_record_size()) return 0;
+
+    payload_record_t record;
+    payload_codec_quantize(data, &record);
+
+    payload_bitwriter_t writer;
+    payload_codec_writer_init(&writer, config->buffer, config->max_size);
+    if (!payload_codec_write_record(&writer, &record, NULL)) return 0;
+
+    uint8_t size = payload_codec_writer_bytes(&writer);
+    config->written = size;
+
+    LOG_DEBUG_FAST("DEBUG: Battery voltage %ld mV\n", data->battery);
+    LOG_DEBUG_HEX("Buffer enviado", config->buffer, size);
+
+    return size;
+}
+
+/**
+ * @brief Formatea un entero escalado como decimal sin usar float
+ *
+ * Ej.: value = -1234, scale = 100, decimals = 1 -> "-12.3".
+ */
+char* sensor_format_fixed(char* buffer, size_t size, int32_t value, int32_t scale, uint8_t decimals) {
+    int32_t divisor = scale;
+    for (uint8_t i = 0; i < decimals && divisor > 1; i++) {
+        divisor /= 10;
     }
-#endif
-
-    config->written = offset;
-    
-    // Imprimir buffer enviado
-    Serial.print("\nBuffer enviado [");
-    for (uint8_t i = 0; i < offset; i++) {
-        Serial.print(config->buffer[i]);
-        Serial.print(" ");
+
+    // Redondear al ultimo decimal mostrado y separar parte entera y fraccionaria
+    bool negative = value < 0;
+    uint32_t magnitude = negative ? -(uint32_t)value : (uint32_t)value;
+    uint32_t units = (magnitude + divisor / 2) / divisor;
+    uint32_t unit_scale = scale / divisor;
+
+    if (unit_scale > 1) {
+        snprintf(buffer, size, "%s%lu.%0*lu", negative && units ? "-" : "",
+                 (unsigned long)(units / unit_scale), (int)decimals, (unsigned long)(units % unit_scale));
+    } else {
+        snprintf(buffer, size, "%s%lu", negative && units ? "-" : "", (unsigned long)units);
     }
-    Serial.println("]");
-    
-    return offset;
+    return buffer;
 }
 
 /**
@@ -278,21 +376,16 @@ uint8_t sensors_get_payload(payload_config_t* config) {
 const char* sensors_get_name(void) {
     static char name_buffer[100] = "";
     name_buffer[0] = '\0';
-    
-#ifdef ENABLE_SENSOR_BME280
-    strcat(name_buffer, "BME280 ");
-#endif
-#ifdef ENABLE_SENSOR_DS18B20
-    strcat(name_buffer, "DS18B20 ");
-#endif
-#ifdef ENABLE_SENSOR_PH
-    strcat(name_buffer, "pH ");
-#endif
-    
+
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        strncat(name_buffer, SENSOR_DRIVERS[i].name, sizeof(name_buffer) - strlen(name_buffer) - 2);
+        strcat(name_buffer, " ");
+    }
+
     if (strlen(name_buffer) == 0) {
         strcpy(name_buffer, "NINGUNO");
     }
-    
+
     return name_buffer;
 }
 
@@ -301,15 +394,9 @@ const char* sensors_get_name(void) {
  * @param available true para simular disponible, false para simular fallo
  */
 void sensors_set_available_for_testing(bool available) {
-#ifdef ENABLE_SENSOR_BME280
-    sensor_bme280_set_available_for_testing(available);
-#endif
-#ifdef ENABLE_SENSOR_DS18B20
-    sensor_ds18b20_set_available_for_testing(available);
-#endif
-#ifdef ENABLE_SENSOR_PH
-    sensor_ph_set_available_for_testing(available);
-#endif
+    for (uint8_t i = 0; i < SENSOR_DRIVER_COUNT; i++) {
+        SENSOR_DRIVERS[i].set_available_for_testing(available);
+    }
 }
 
 // ============================================================================
@@ -318,7 +405,8 @@ void sensors_set_available_for_testing(bool available) {
 
 /**
  * Funciones legacy para mantener compatibilidad con el codigo existente
- * Estas funciones llaman a la nueva interfaz multisensor
+ * Estas funciones llaman a la nueva interfaz multisensor y leen el snapshot
+ * del ciclo en lugar de volver a leer el hardware
  */
 
 bool initSensor() {
@@ -335,26 +423,29 @@ bool retrySensorInit() {
 
 float readTemperature() {
     sensor_data_t data;
-    if (sensors_read_all(&data) && data.valid) {
-        return data.temperature;
+    sensors_snapshot(&data);
+    if (data.valid_mask & SENSOR_FIELD_TEMPERATURE) {
+        return (float)data.temperature / SENSOR_SCALE_TEMPERATURE;
     }
-    return SENSOR_ERROR_TEMPERATURE;
+    return NAN;
 }
 
 float readHumidity() {
     sensor_data_t data;
-    if (sensors_read_all(&data) && data.valid) {
-        return data.humidity;
+    sensors_snapshot(&data);
+    if (data.valid_mask & SENSOR_FIELD_HUMIDITY) {
+        return (float)data.humidity / SENSOR_SCALE_HUMIDITY;
     }
-    return SENSOR_ERROR_HUMIDITY;
+    return NAN;
 }
 
 float readPressure() {
     sensor_data_t data;
-    if (sensors_read_all(&data) && data.valid) {
-        return data.pressure;
+    sensors_snapshot(&data);
+    if (data.valid_mask & SENSOR_FIELD_PRESSURE) {
+        return (float)data.pressure / SENSOR_SCALE_PRESSURE;
     }
-    return SENSOR_ERROR_PRESSURE;
+    return NAN;
 }
 
 void setSensorAvailableForTesting(bool available) {
@@ -368,12 +459,12 @@ uint8_t getSensorPayload(uint8_t* payload, uint8_t maxSize) {
 
 bool getSensorDataForDisplay(float& temp, float& hum, float& pres, float& battery) {
     sensor_data_t data;
-    bool ok = sensors_read_all(&data);
+    bool ok = sensors_snapshot(&data);
 
-    temp = data.temperature;
-    hum = data.humidity;
-    pres = data.pressure;
-    battery = data.battery;
+    temp = (data.valid_mask & SENSOR_FIELD_TEMPERATURE) ? (float)data.temperature / SENSOR_SCALE_TEMPERATURE : NAN;
+    hum = (data.valid_mask & SENSOR_FIELD_HUMIDITY) ? (float)data.humidity / SENSOR_SCALE_HUMIDITY : NAN;
+    pres = (data.valid_mask & SENSOR_FIELD_PRESSURE) ? (float)data.pressure / SENSOR_SCALE_PRESSURE : NAN;
+    battery = (float)data.battery / SENSOR_SCALE_BATTERY;
 
-    return ok && data.valid;
+    return ok;
 }
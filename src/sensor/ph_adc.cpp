@@ -0,0 +1,266 @@
+/**
+ * @file      ph_adc.cpp
+ * @brief     Adquisición calibrada del ADC para el sensor de pH
+ *
+ * Ver ph_adc.h. El canal se resuelve en tiempo de compilación a partir de
+ * PH_ANALOG_PIN, de modo que un pin sin ADC o ya usado por la placa se
+ * detecta al compilar.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../../config/config.h"
+
+#ifdef ENABLE_SENSOR_PH
+#include <stdlib.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include "ph_adc.h"
+#include "logger.h"
+
+// =============================================================================
+// MAPA DE PINES (ESP32)
+// =============================================================================
+
+#if PH_ANALOG_PIN == 36
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_0
+#elif PH_ANALOG_PIN == 37
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_1
+#elif PH_ANALOG_PIN == 38
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_2
+#elif PH_ANALOG_PIN == 39
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_3
+#elif PH_ANALOG_PIN == 32
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_4
+#elif PH_ANALOG_PIN == 33
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_5
+#elif PH_ANALOG_PIN == 34
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_6
+#elif PH_ANALOG_PIN == 35
+#define PH_ADC1_CHANNEL ADC1_CHANNEL_7
+#elif PH_ANALOG_PIN == 4
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_0
+#elif PH_ANALOG_PIN == 0
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_1
+#elif PH_ANALOG_PIN == 2
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_2
+#elif PH_ANALOG_PIN == 15
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_3
+#elif PH_ANALOG_PIN == 13
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_4
+#elif PH_ANALOG_PIN == 12
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_5
+#elif PH_ANALOG_PIN == 14
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_6
+#elif PH_ANALOG_PIN == 27
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_7
+#elif PH_ANALOG_PIN == 25
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_8
+#elif PH_ANALOG_PIN == 26
+#define PH_ADC2_CHANNEL ADC2_CHANNEL_9
+#else
+#error "PH_ANALOG_PIN no es un pin ADC del ESP32"
+#endif
+
+// Pines que la placa ya usa para otra función
+#if (defined(ADC_PIN) && ADC_PIN == PH_ANALOG_PIN) || \
+    (defined(PMU_IRQ) && PMU_IRQ == PH_ANALOG_PIN) || \
+    (defined(RADIO_DIO0_PIN) && RADIO_DIO0_PIN == PH_ANALOG_PIN) || \
+    (defined(RADIO_DIO1_PIN) && RADIO_DIO1_PIN == PH_ANALOG_PIN) || \
+    (defined(RADIO_DIO2_PIN) && RADIO_DIO2_PIN == PH_ANALOG_PIN)
+#error "PH_ANALOG_PIN está en uso por la placa (ADC de batería, PMU o radio)"
+#endif
+
+#if defined(BOARD_LED) && BOARD_LED == PH_ANALOG_PIN
+#error "PH_ANALOG_PIN coincide con BOARD_LED: setupBoards() conduce el pin como salida contra el sensor"
+#endif
+
+#ifdef PH_ADC1_CHANNEL
+#define PH_ADC_UNIT ADC_UNIT_1
+#else
+#define PH_ADC_UNIT ADC_UNIT_2
+#endif
+
+#define PH_ADC_ATTEN ADC_ATTEN_DB_11      // Rango ~150-2450 mV calibrado
+#define PH_ADC_DEFAULT_VREF_MV 1100       // Vref nominal si el chip no tiene eFuse
+
+// =============================================================================
+// ESTADO
+// =============================================================================
+
+static esp_adc_cal_characteristics_t adc_chars;
+static uint16_t raw_samples[PH_ADC_SAMPLES];
+static uint16_t sample_count = PH_ADC_SAMPLES;  // Muestras por ráfaga (ver ph_adc_set_samples())
+
+#ifdef PH_ADC1_CHANNEL
+static uint8_t dma_buffer[PH_ADC_SAMPLES * sizeof(adc_digi_output_data_t)];
+
+/**
+ * @brief Ráfaga en modo continuo (DMA) sobre ADC1
+ *
+ * @return Número de muestras obtenidas
+ */
+static uint16_t acquire_burst(void) {
+    adc_digi_init_config_t init_config = {};
+    uint32_t burst_bytes = sample_count * sizeof(adc_digi_output_data_t);
+    init_config.max_store_buf_size = burst_bytes * 2;
+    init_config.conv_num_each_intr = burst_bytes;
+    init_config.adc1_chan_mask = 1UL << PH_ADC1_CHANNEL;
+    init_config.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&init_config) != ESP_OK) return 0;
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = PH_ADC_ATTEN;
+    pattern.channel = PH_ADC1_CHANNEL;
+    pattern.unit = 0;  // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = true;  // Obligatorio en el ESP32
+    config.conv_limit_num = 250;
+    config.pattern_num = 1;
+    config.adc_pattern = &pattern;
+    config.sample_freq_hz = PH_ADC_SAMPLE_FREQ_HZ;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+    uint16_t count = 0;
+    if (adc_digi_controller_configure(&config) == ESP_OK && adc_digi_start() == ESP_OK) {
+        uint32_t timeout_ms = sample_count * 1000UL / PH_ADC_SAMPLE_FREQ_HZ + 20;
+        while (count < sample_count) {
+            uint32_t length = 0;
+            if (adc_digi_read_bytes(dma_buffer, burst_bytes, &length, timeout_ms) != ESP_OK) break;
+
+            for (uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= length && count < sample_count;
+                 i += sizeof(adc_digi_output_data_t)) {
+                const adc_digi_output_data_t* sample = (const adc_digi_output_data_t*)&dma_buffer[i];
+                if (sample->type1.channel == PH_ADC1_CHANNEL) {
+                    raw_samples[count++] = sample->type1.data;
+                }
+            }
+        }
+        adc_digi_stop();
+    }
+    adc_digi_deinitialize();
+    return count;
+}
+#else
+/**
+ * @brief Ráfaga de lecturas one-shot sobre ADC2 (sin DMA en el ESP32)
+ *
+ * @return Número de muestras obtenidas (0 si Wi-Fi tiene ocupado ADC2)
+ */
+static uint16_t acquire_burst(void) {
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < sample_count; i++) {
+        int raw;
+        if (adc2_get_raw(PH_ADC2_CHANNEL, ADC_WIDTH_BIT_12, &raw) != ESP_OK) break;
+        raw_samples[count++] = (uint16_t)raw;
+    }
+    return count;
+}
+#endif
+
+/**
+ * @brief Convierte una lectura (con decimales) a mV con la calibración de eFuse
+ *
+ * esp_adc_cal solo admite enteros: se interpola entre los dos vecinos.
+ */
+static float raw_to_mv(float raw) {
+    uint32_t low = (uint32_t)raw;
+    float frac = raw - (float)low;
+    uint32_t mv_low = esp_adc_cal_raw_to_voltage(low, &adc_chars);
+    uint32_t mv_high = esp_adc_cal_raw_to_voltage(low + 1, &adc_chars);
+    return mv_low + (float)((int32_t)(mv_high - mv_low)) * frac;
+}
+
+static int compare_u16(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+/**
+ * @brief Comprueba el pin, configura el canal y carga la calibración de eFuse
+ */
+bool ph_adc_init(void) {
+#ifdef PH_ADC1_CHANNEL
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(PH_ADC1_CHANNEL, PH_ADC_ATTEN);
+    LOG_INFO("pH: GPIO%d en ADC1 canal %d (modo continuo/DMA a %lu Hz)\n",
+             PH_ANALOG_PIN, (int)PH_ADC1_CHANNEL, (unsigned long)PH_ADC_SAMPLE_FREQ_HZ);
+#else
+    if (adc2_config_channel_atten(PH_ADC2_CHANNEL, PH_ADC_ATTEN) != ESP_OK) {
+        LOG_INFO_FAST("pH: ERROR - No se pudo configurar ADC2 en GPIO%d\n", PH_ANALOG_PIN);
+        return false;
+    }
+    LOG_INFO("pH: GPIO%d en ADC2 canal %d (sin DMA; incompatible con Wi-Fi activo)\n",
+             PH_ANALOG_PIN, (int)PH_ADC2_CHANNEL);
+#endif
+
+    esp_adc_cal_value_t source = esp_adc_cal_characterize(PH_ADC_UNIT, PH_ADC_ATTEN, ADC_WIDTH_BIT_12,
+                                                          PH_ADC_DEFAULT_VREF_MV, &adc_chars);
+    LOG_INFO("pH: Calibración ADC %s\n",
+             source == ESP_ADC_CAL_VAL_EFUSE_TP ? "eFuse Two Point" :
+             source == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref" : "Vref por defecto (sin eFuse)");
+    return true;
+}
+
+/**
+ * @brief Fija el número de muestras de las siguientes ráfagas
+ */
+void ph_adc_set_samples(uint16_t samples) {
+    if (samples == 0 || samples > PH_ADC_SAMPLES) samples = PH_ADC_SAMPLES;
+    sample_count = samples;
+}
+
+/**
+ * @brief Toma una ráfaga de muestras y calcula tensión y ruido
+ */
+bool ph_adc_acquire(ph_adc_result_t* result) {
+    if (!result) return false;
+
+    uint32_t start = micros();
+    uint16_t count = acquire_burst();
+    result->duration_us = micros() - start;
+    result->samples = count;
+
+    uint16_t trim = (uint32_t)count * PH_ADC_TRIM_PERCENT / 100;
+    if (count == 0 || count <= 2 * trim) {
+        LOG_INFO_FAST("pH: ERROR - Ráfaga ADC sin muestras suficientes (%u)\n", count);
+        return false;
+    }
+
+    qsort(raw_samples, count, sizeof(raw_samples[0]), compare_u16);
+
+    // Media recortada y desviación típica de las muestras conservadas
+    uint16_t kept = count - 2 * trim;
+    uint32_t sum = 0;
+    for (uint16_t i = trim; i < count - trim; i++) {
+        sum += raw_samples[i];
+    }
+    float mean = (float)sum / kept;
+
+    float variance = 0.0f;
+    for (uint16_t i = trim; i < count - trim; i++) {
+        float diff = raw_samples[i] - mean;
+        variance += diff * diff;
+    }
+    variance /= kept;
+
+    float median = (count & 1) ? raw_samples[count / 2]
+                               : (raw_samples[count / 2 - 1] + raw_samples[count / 2]) / 2.0f;
+
+    float mv_per_lsb = raw_to_mv(mean + 1.0f) - raw_to_mv(mean);
+    result->voltage_mv = raw_to_mv(mean);
+    result->median_mv = raw_to_mv(median);
+    result->noise_mv = sqrtf(variance) * mv_per_lsb;
+    result->span_mv = raw_to_mv(raw_samples[count - 1]) - raw_to_mv(raw_samples[0]);
+    return true;
+}
+
+#endif // ENABLE_SENSOR_PH
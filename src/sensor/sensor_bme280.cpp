@@ -5,72 +5,242 @@
 #include <Adafruit_BME280.h>
 #include <Wire.h>
 #include "sensor_interface.h"
+#include "power_rail.h"
 #include "LoRaBoards.h"
+#include "logger.h"
+
+/**
+ * @brief Extensión del driver de Adafruit para la medida forzada
+ *
+ * Da acceso a miembros protegidos de Adafruit_BME280 (registro de control,
+ * calibración y bus I2C) para lanzar la medida sin espera activa y leer los
+ * registros de datos 0xF7-0xFE en una sola transacción.
+ */
+class BME280Forced : public Adafruit_BME280 {
+public:
+    /** Lanza una medida forzada; al terminar el sensor vuelve solo a modo sleep */
+    void trigger(void) {
+        write8(BME280_REGISTER_CONTROL, (_measReg.get() & ~0x03) | MODE_FORCED);
+    }
+
+    /** true mientras la medida está en curso (bit measuring del registro de estado) */
+    bool busy(void) {
+        return read8(BME280_REGISTER_STATUS) & 0x08;
+    }
+
+    /** Lectura en ráfaga de presión, temperatura y humedad (8 bytes) */
+    bool read_raw(uint8_t raw[8]) {
+        uint8_t reg = BME280_REGISTER_PRESSUREDATA;
+        return i2c_dev && i2c_dev->write_then_read(&reg, 1, raw, 8);
+    }
+
+    /** Coeficientes de calibración leídos en begin() */
+    const bme280_calib_data* calib(void) const {
+        return &_bme280_calib;
+    }
+};
 
 // Objeto global del sensor
-static Adafruit_BME280 bme;
+static BME280Forced bme;
 
 // Estado del sensor
 static bool sensor_available = false;
+static uint8_t sensor_address = BME280_I2C_ADDR_PRIMARY;
+
+/**
+ * @brief Solicita la alimentación del BME280
+ *
+ * Con BME280_SWITCHED_POWER el sensor cuelga de BME280_POWER_PIN y se
+ * gestiona como un rail más; si no, está siempre alimentado.
+ *
+ * @return Instante (millis) en que el sensor está listo
+ */
+static uint32_t sensor_bme280_power_up(void) {
+#if BME280_SWITCHED_POWER
+    return power_rail_acquire(BME280_POWER_PIN, BME280_POWER_ON_DELAY_MS);
+#else
+    return millis();
+#endif
+}
+
+/**
+ * @brief Libera la alimentación del BME280
+ */
+static void sensor_bme280_power_down(void) {
+#if BME280_SWITCHED_POWER
+    power_rail_release(BME280_POWER_PIN);
+#endif
+}
+
+/**
+ * @brief Código de sobremuestreo de Adafruit a partir del número de muestras
+ */
+static constexpr Adafruit_BME280::sensor_sampling bme280_sampling(uint8_t samples) {
+    return samples >= 16 ? Adafruit_BME280::SAMPLING_X16 :
+           samples >= 8  ? Adafruit_BME280::SAMPLING_X8 :
+           samples >= 4  ? Adafruit_BME280::SAMPLING_X4 :
+           samples >= 2  ? Adafruit_BME280::SAMPLING_X2 :
+           samples >= 1  ? Adafruit_BME280::SAMPLING_X1 :
+                           Adafruit_BME280::SAMPLING_NONE;
+}
+
+/**
+ * @brief Tiempo máximo de una medida forzada en µs (datasheet BME280, 9.1)
+ *
+ * t = 1.25 + 2.3·T + (2.3·P + 0.575) + (2.3·H + 0.575) ms, omitiendo los
+ * términos de las magnitudes que no se miden.
+ */
+static constexpr uint32_t bme280_measurement_time_us(uint8_t osrs_t, uint8_t osrs_p, uint8_t osrs_h) {
+    return 1250 +
+           (osrs_t ? 2300UL * osrs_t : 0) +
+           (osrs_p ? 2300UL * osrs_p + 575 : 0) +
+           (osrs_h ? 2300UL * osrs_h + 575 : 0);
+}
+
+static_assert(BME280_OVERSAMPLING_TEMPERATURE >= 1 && BME280_OVERSAMPLING_PRESSURE >= 1 &&
+              BME280_OVERSAMPLING_HUMIDITY >= 1,
+              "El payload incluye temperatura, presion y humedad: el sobremuestreo debe ser >= 1");
+
+static constexpr uint32_t BME280_MEASUREMENT_MS =
+    (bme280_measurement_time_us(BME280_OVERSAMPLING_TEMPERATURE,
+                                BME280_OVERSAMPLING_PRESSURE,
+                                BME280_OVERSAMPLING_HUMIDITY) + 999) / 1000;
+
+/**
+ * @brief Configura el BME280 para medidas forzadas y lo deja en modo sleep
+ *
+ * Sin filtro IIR: con una muestra cada varios minutos no aporta nada.
+ * La configuración se pierde al cortar su alimentación.
+ */
+static void sensor_bme280_configure(void) {
+    bme.setSampling(Adafruit_BME280::MODE_SLEEP,
+                    bme280_sampling(BME280_OVERSAMPLING_TEMPERATURE),
+                    bme280_sampling(BME280_OVERSAMPLING_PRESSURE),
+                    bme280_sampling(BME280_OVERSAMPLING_HUMIDITY),
+                    Adafruit_BME280::FILTER_OFF,
+                    Adafruit_BME280::STANDBY_MS_1000);
+}
+
+// ============================================================================
+// COMPENSACIÓN ENTERA (Bosch BME280, datasheet 4.2.3 y 8.2)
+// ============================================================================
+
+/**
+ * @brief Temperatura compensada en centésimas de °C
+ * @param t_fine Salida: temperatura fina usada por presión y humedad
+ */
+static int32_t bme280_compensate_temperature(int32_t adc_T, const bme280_calib_data* c, int32_t* t_fine) {
+    int32_t var1 = ((((adc_T >> 3) - ((int32_t)c->dig_T1 << 1))) * ((int32_t)c->dig_T2)) >> 11;
+    int32_t var2 = (((((adc_T >> 4) - ((int32_t)c->dig_T1)) *
+                      ((adc_T >> 4) - ((int32_t)c->dig_T1))) >> 12) *
+                    ((int32_t)c->dig_T3)) >> 14;
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8;
+}
+
+/**
+ * @brief Presión compensada en Pa con 8 bits fraccionarios (Q24.8)
+ */
+static uint32_t bme280_compensate_pressure(int32_t adc_P, const bme280_calib_data* c, int32_t t_fine) {
+    int64_t var1 = ((int64_t)t_fine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)c->dig_P6;
+    var2 = var2 + ((var1 * (int64_t)c->dig_P5) << 17);
+    var2 = var2 + (((int64_t)c->dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)c->dig_P3) >> 8) + ((var1 * (int64_t)c->dig_P2) << 12);
+    var1 = ((((int64_t)1) << 47) + var1) * ((int64_t)c->dig_P1) >> 33;
+    if (var1 == 0) return 0;  // Evitar división por cero
+
+    int64_t p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)c->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)c->dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)c->dig_P7) << 4);
+    return (uint32_t)p;
+}
+
+/**
+ * @brief Humedad relativa compensada en % con 10 bits fraccionarios (Q22.10)
+ */
+static uint32_t bme280_compensate_humidity(int32_t adc_H, const bme280_calib_data* c, int32_t t_fine) {
+    int32_t v = t_fine - ((int32_t)76800);
+    v = (((((adc_H << 14) - (((int32_t)c->dig_H4) << 20) - (((int32_t)c->dig_H5) * v)) +
+           ((int32_t)16384)) >> 15) *
+         (((((((v * ((int32_t)c->dig_H6)) >> 10) *
+              (((v * ((int32_t)c->dig_H3)) >> 11) + ((int32_t)32768))) >> 10) +
+            ((int32_t)2097152)) * ((int32_t)c->dig_H2) + 8192) >> 14));
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)c->dig_H1)) >> 4);
+    v = v < 0 ? 0 : v;
+    v = v > 419430400 ? 419430400 : v;
+    return (uint32_t)(v >> 12);
+}
 
 /**
  * @brief Inicializa el sensor BME280
  */
 bool sensor_bme280_init(void) {
-    Serial.println("BME280: Iniciando búsqueda del sensor...");
-    
-    // La librería Adafruit_BME280 ya maneja Wire internamente
-    // Solo hacemos un pequeño delay para estabilización
-    delay(100);
-    
-    // Escanear el bus I2C para ver qué dispositivos hay
-    Serial.println("BME280: Escaneando bus I2C...");
-    byte error, address;
-    int nDevices = 0;
-    for(address = 1; address < 127; address++ ) {
-        Wire.beginTransmission(address);
-        error = Wire.endTransmission();
-        if (error == 0) {
-            Serial.printf("  Dispositivo I2C encontrado en dirección 0x%02X\n", address);
-            nDevices++;
+    LOG_INFO_FAST("BME280: Iniciando búsqueda del sensor...\n");
+
+    // Con BME280_SWITCHED_POWER la espera de arranque la hace el gestor de rails
+    power_rail_wait_until(sensor_bme280_power_up());
+
+    // Escanear el bus I2C para ver qué dispositivos hay (solo al encender;
+    // al despertar por temporizador basta el inventario de setupBoards())
+    if (!isFastBoot()) {
+        LOG_INFO_FAST("BME280: Escaneando bus I2C...\n");
+        byte error, address;
+        int nDevices = 0;
+        for(address = 1; address < 127; address++ ) {
+            Wire.beginTransmission(address);
+            error = Wire.endTransmission();
+            if (error == 0) {
+                LOG_INFO_FAST("  Dispositivo I2C encontrado en dirección 0x%02X\n", address);
+                nDevices++;
+            }
         }
-    }
-    if (nDevices == 0) {
-        Serial.println("  No se encontraron dispositivos I2C en el bus!");
-    } else {
-        Serial.printf("  Total: %d dispositivo(s) encontrado(s)\n", nDevices);
+        if (nDevices == 0) {
+            LOG_INFO_FAST("  No se encontraron dispositivos I2C en el bus!\n");
+        } else {
+            LOG_INFO_FAST("  Total: %d dispositivo(s) encontrado(s)\n", nDevices);
+        }
+    } else if (i2cDeviceCached(0x77) && !i2cDeviceCached(0x76) && bme.begin(0x77, &Wire)) {
+        // Dirección conocida por el inventario: se evita el intento fallido en 0x76
+        sensor_address = 0x77;
+        sensor_bme280_configure();
+        sensor_available = true;
+        sensor_bme280_power_down();
+        return true;
     }
     
     // Intentar primero con dirección 0x76
-    Serial.print("BME280: Probando dirección 0x76... ");
+    LOG_INFO_FAST("BME280: Probando dirección 0x76... ");
     if (bme.begin(0x76, &Wire)) {
-        Serial.println("¡Encontrado!");
+        LOG_INFO_FAST("¡Encontrado!\n");
+        sensor_address = 0x76;
     }
     // Si no funciona, intentar con dirección 0x77
     else {
-        Serial.println("No encontrado");
-        Serial.print("BME280: Probando dirección 0x77... ");
+        LOG_INFO_FAST("No encontrado\n");
+        LOG_INFO_FAST("BME280: Probando dirección 0x77... ");
         if (bme.begin(0x77, &Wire)) {
-            Serial.println("¡Encontrado!");
+            LOG_INFO_FAST("¡Encontrado!\n");
+            sensor_address = 0x77;
         }
         // Si ninguna dirección funciona
         else {
-            Serial.println("No encontrado");
-            Serial.println("BME280: ERROR - No encontrado en 0x76 ni 0x77");
-            Serial.println("Verifica conexiones: VCC->3.3V, GND->GND, SDA->GPIO21, SCL->GPIO22");
+            LOG_INFO_FAST("No encontrado\n");
+            LOG_INFO_FAST("BME280: ERROR - No encontrado en 0x76 ni 0x77\n");
+            LOG_INFO_FAST("Verifica conexiones: VCC->3.3V, GND->GND, SDA->GPIO21, SCL->GPIO22\n");
             sensor_available = false;
+            sensor_bme280_power_down();
             return false;
         }
     }
     
-    bme.setSampling(Adafruit_BME280::MODE_NORMAL,
-                    Adafruit_BME280::SAMPLING_X2,   // Temperatura
-                    Adafruit_BME280::SAMPLING_X16,  // Presión
-                    Adafruit_BME280::SAMPLING_X1,   // Humedad
-                    Adafruit_BME280::FILTER_X16,
-                    Adafruit_BME280::STANDBY_MS_500);
-    Serial.println("BME280: Sensor inicializado correctamente.");
+    sensor_bme280_configure();
+    LOG_INFO("BME280: Sensor inicializado en modo forzado (medida de %lu ms).\n",
+             (unsigned long)BME280_MEASUREMENT_MS);
     sensor_available = true;
+    sensor_bme280_power_down();
     return true;
 }
 
@@ -86,77 +256,74 @@ bool sensor_bme280_is_available(void) {
  */
 bool sensor_bme280_retry_init(void) {
     if (sensor_available) return true;
-    Serial.println("Reintentando inicialización del sensor BME280...");
+    LOG_INFO_FAST("Reintentando inicialización del sensor BME280...\n");
     return sensor_bme280_init();
 }
 
 /**
- * @brief Lee todos los datos del sensor BME280
+ * @brief Lanza una medida forzada (sensor alimentado)
+ *
+ * @return Milisegundos hasta que la medida esté lista, según el sobremuestreo
  */
-bool sensor_bme280_read_all(sensor_data_t* data) {
-    if (!sensor_available || !data) return false;
+uint32_t sensor_bme280_start_measurement(void) {
+    if (!sensor_available) return 0;
 
-    data->temperature = bme.readTemperature();
-    data->humidity = bme.readHumidity();  // BME280 sí mide humedad
-    data->pressure = bme.readPressure() / 100.0F;  // Convertir a hPa
-    data->battery = readBatteryVoltage();
-    data->valid = true;
-
-    if (isnan(data->temperature) || isnan(data->pressure) || isnan(data->humidity)) {
-        Serial.println("BME280: Error en lectura");
-        data->temperature = SENSOR_ERROR_TEMPERATURE;
-        data->pressure = SENSOR_ERROR_PRESSURE;
-        data->humidity = SENSOR_ERROR_HUMIDITY;
-        data->valid = false;
-        return false;
+#if BME280_SWITCHED_POWER
+    // Tras cortar la alimentación el sensor vuelve a modo sleep sin configurar
+    if (bme.begin(sensor_address, &Wire)) {
+        sensor_bme280_configure();
     }
+#endif
 
-    Serial.printf("BME280: Lectura exitosa - Temp: %.1f°C, Hum: %.1f%%, Pres: %.1f hPa\n",
-                  data->temperature, data->humidity, data->pressure);
-    return true;
+    bme.trigger();
+    return BME280_MEASUREMENT_MS;
 }
 
 /**
- * @brief Obtiene el payload empaquetado para BME280
+ * @brief Recoge la medida forzada: ráfaga 0xF7-0xFE y compensación entera
+ *
+ * Solo escribe temperatura, humedad y presión en data, directamente en las
+ * unidades de sensor_data_t (centésimas de °C y de % y Pa).
  */
-uint8_t sensor_bme280_get_payload(payload_config_t* config) {
-    if (!config || config->max_size < PAYLOAD_SIZE_BYTES) return 0;
-
-    sensor_data_t data;
-    bool sensor_ok = sensor_bme280_read_all(&data);
+bool sensor_bme280_read_measurement(sensor_data_t* data) {
+    if (!sensor_available || !data) return false;
 
-    if (!sensor_ok) {
-        data.temperature = SENSOR_ERROR_TEMPERATURE;
-        data.humidity = SENSOR_ERROR_HUMIDITY;
-        data.pressure = SENSOR_ERROR_PRESSURE;
-        sensor_bme280_retry_init();
+    // Margen por si el oscilador interno va lento respecto al datasheet
+    for (uint8_t i = 0; i < BME280_READ_ATTEMPTS && bme.busy(); i++) {
+        delay(1);
     }
 
-    uint8_t offset = 0;
-    int16_t temp_int = (int16_t)(data.temperature * 100);
-    config->buffer[offset++] = temp_int >> 8;
-    config->buffer[offset++] = temp_int & 0xFF;
+    uint8_t raw[8];
+    bool raw_ok = bme.read_raw(raw);
 
-    // Humedad (disponible en BME280)
-    uint16_t hum_int = (uint16_t)(data.humidity * 100);
-    config->buffer[offset++] = hum_int >> 8;
-    config->buffer[offset++] = hum_int & 0xFF;
+    int32_t adc_P = ((uint32_t)raw[0] << 12) | ((uint32_t)raw[1] << 4) | (raw[2] >> 4);
+    int32_t adc_T = ((uint32_t)raw[3] << 12) | ((uint32_t)raw[4] << 4) | (raw[5] >> 4);
+    int32_t adc_H = ((uint32_t)raw[6] << 8) | raw[7];
 
-    // Presión
-    uint16_t pres_int = (uint16_t)(data.pressure * 10);
-    config->buffer[offset++] = pres_int >> 8;
-    config->buffer[offset++] = pres_int & 0xFF;
+    // 0x80000 / 0x8000 = magnitud no medida (sensor sin configurar o reiniciado)
+    if (!raw_ok || adc_T == 0x80000 || adc_P == 0x80000 || adc_H == 0x8000) {
+        LOG_INFO_FAST("BME280: Error en lectura\n");
+        data->valid_mask &= ~(SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY | SENSOR_FIELD_PRESSURE);
+        return false;
+    }
 
-    // Distancia (no disponible)
-    config->buffer[offset++] = 0xFF;
-    config->buffer[offset++] = 0xFF;
+    const bme280_calib_data* calib = bme.calib();
+    int32_t t_fine;
+    int32_t temp_centi = bme280_compensate_temperature(adc_T, calib, &t_fine);
+    uint32_t pres_q8 = bme280_compensate_pressure(adc_P, calib, t_fine);
+    uint32_t hum_q10 = bme280_compensate_humidity(adc_H, calib, t_fine);
 
-    uint16_t batt_int = (uint16_t)(data.battery * 100);
-    config->buffer[offset++] = batt_int >> 8;
-    config->buffer[offset++] = batt_int & 0xFF;
+    data->temperature = temp_centi;
+    data->pressure = (pres_q8 + 128) >> 8;                             // Pa Q24.8 -> Pa
+    data->humidity = (hum_q10 * SENSOR_SCALE_HUMIDITY + 512) >> 10;    // % Q22.10 -> centésimas
+    data->valid_mask |= SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY | SENSOR_FIELD_PRESSURE;
 
-    config->written = offset;
-    return offset;
+    char temp_str[12], hum_str[12], pres_str[12];
+    LOG_INFO("BME280: Lectura exitosa - Temp: %s°C, Hum: %s%%, Pres: %s hPa\n",
+             sensor_format_fixed(temp_str, sizeof(temp_str), data->temperature, SENSOR_SCALE_TEMPERATURE, 1),
+             sensor_format_fixed(hum_str, sizeof(hum_str), data->humidity, SENSOR_SCALE_HUMIDITY, 1),
+             sensor_format_fixed(pres_str, sizeof(pres_str), data->pressure, SENSOR_SCALE_PRESSURE, 1));
+    return true;
 }
 
 /**
@@ -171,7 +338,7 @@ const char* sensor_bme280_get_name(void) {
  */
 void sensor_bme280_set_available_for_testing(bool available) {
     sensor_available = available;
-    Serial.printf("TESTING: Sensor BME280 forzado a %s\n", available ? "disponible" : "no disponible");
+    LOG_INFO("TESTING: Sensor BME280 forzado a %s\n", available ? "disponible" : "no disponible");
 }
 
 #endif // ENABLE_SENSOR_BME280
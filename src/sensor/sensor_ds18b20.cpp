@@ -5,7 +5,17 @@
 #include <OneWire.h>
 #include <DallasTemperature.h>
 #include "sensor_interface.h"
+#include "power_rail.h"
 #include "LoRaBoards.h"
+#include "logger.h"
+
+#if DS18B20_CACHE_NVS
+#include <Preferences.h>
+#endif
+
+// Identificación de la ROM guardada en memoria RTC
+#define DS18B20_CACHE_MAGIC 0x44533138UL  // "DS18"
+#define DS18B20_FAMILY_CODE 0x28
 
 // Objetos globales del sensor
 static OneWire oneWire(DS18B20_DATA_PIN);
@@ -13,68 +23,152 @@ static DallasTemperature sensors(&oneWire);
 
 // Estado del sensor
 static bool sensor_available = false;
-static bool sensor_powered = false;
+static float precision_c = DS18B20_PRECISION_C;
 
 /**
- * @brief Enciende alimentación de sensores
+ * @brief Código ROM del sensor guardado entre ciclos de sueño profundo
+ *
+ * Con la ROM conocida se direcciona el sensor con MATCH ROM y se evita la
+ * búsqueda completa del bus OneWire (y encender el rail) en cada arranque.
  */
-static void sensor_ds18b20_power_on(void) {
-    if (sensor_powered) return;
-    
-    pinMode(DS18B20_POWER_PIN, OUTPUT);
-    digitalWrite(DS18B20_POWER_PIN, HIGH);
-    sensor_powered = true;
-    
-    Serial.println("DS18B20: Alimentación de sensores activada");
-    Serial.printf("DS18B20: Esperando %d ms para estabilización...\n", DS18B20_POWER_ON_DELAY_MS);
-    delay(DS18B20_POWER_ON_DELAY_MS);
+typedef struct {
+    uint32_t magic;        /**< DS18B20_CACHE_MAGIC si la ROM es válida */
+    DeviceAddress rom;     /**< Código ROM de 64 bits */
+} ds18b20_rom_cache_t;
+
+RTC_DATA_ATTR static ds18b20_rom_cache_t rom_cache;
+
+/**
+ * @brief Comprueba familia y CRC de un código ROM
+ */
+static bool rom_is_valid(const uint8_t* rom) {
+    return rom[0] == DS18B20_FAMILY_CODE && OneWire::crc8(rom, 7) == rom[7];
 }
 
 /**
- * @brief Apaga alimentación de sensores
+ * @brief Recupera la ROM de memoria RTC o, si no hay, de NVS
  */
-static void sensor_ds18b20_power_off(void) {
-    if (!sensor_powered) return;
-    
-    digitalWrite(DS18B20_POWER_PIN, LOW);
-    sensor_powered = false;
-    
-    Serial.println("DS18B20: Alimentación de sensores desactivada");
-    delay(1000);  // Delay para garantizar desconexión completa
+static bool rom_cache_load(void) {
+    if (rom_cache.magic == DS18B20_CACHE_MAGIC && rom_is_valid(rom_cache.rom)) return true;
+
+#if DS18B20_CACHE_NVS
+    Preferences prefs;
+    if (prefs.begin("ds18b20", true)) {
+        size_t len = prefs.getBytes("rom", rom_cache.rom, sizeof(rom_cache.rom));
+        prefs.end();
+        if (len == sizeof(rom_cache.rom) && rom_is_valid(rom_cache.rom)) {
+            rom_cache.magic = DS18B20_CACHE_MAGIC;
+            return true;
+        }
+    }
+#endif
+    rom_cache.magic = 0;
+    return false;
+}
+
+/**
+ * @brief Guarda la ROM descubierta en memoria RTC (y en NVS si está habilitado)
+ */
+static void rom_cache_store(const uint8_t* rom) {
+    memcpy(rom_cache.rom, rom, sizeof(rom_cache.rom));
+    rom_cache.magic = DS18B20_CACHE_MAGIC;
+
+#if DS18B20_CACHE_NVS
+    Preferences prefs;
+    if (prefs.begin("ds18b20", false)) {
+        prefs.putBytes("rom", rom, sizeof(rom_cache.rom));
+        prefs.end();
+    }
+#endif
+}
+
+/**
+ * @brief Descarta la ROM guardada para forzar una nueva búsqueda en el bus
+ */
+static void rom_cache_invalidate(void) {
+    rom_cache.magic = 0;
+
+#if DS18B20_CACHE_NVS
+    Preferences prefs;
+    if (prefs.begin("ds18b20", false)) {
+        prefs.remove("rom");
+        prefs.end();
+    }
+#endif
+}
+
+/**
+ * @brief Resolución mínima (9-12 bits) que cumple la precisión requerida
+ *
+ * Paso de cada resolución: 9 bits 0.5 °C, 10 bits 0.25 °C, 11 bits 0.125 °C,
+ * 12 bits 0.0625 °C. El tiempo de conversión se duplica con cada bit.
+ */
+static uint8_t resolution_for_precision(float precision) {
+    float step = 0.5f;
+    for (uint8_t bits = 9; bits < 12; bits++, step /= 2.0f) {
+        if (step <= precision) return bits;
+    }
+    return 12;
+}
+
+/**
+ * @brief Solicita el rail de alimentación del DS18B20
+ * @return Instante (millis) en que el sensor está estabilizado
+ */
+static uint32_t sensor_ds18b20_power_up(void) {
+    return power_rail_acquire(DS18B20_POWER_PIN, DS18B20_POWER_ON_DELAY_MS);
+}
+
+/**
+ * @brief Libera el rail de alimentación del DS18B20
+ */
+static void sensor_ds18b20_power_down(void) {
+    power_rail_release(DS18B20_POWER_PIN);
 }
 
 /**
  * @brief Inicializa el sensor DS18B20
+ *
+ * Si hay una ROM guardada no se toca el bus: el sensor se valida en la
+ * primera lectura y, si no responde, se descarta la ROM.
  */
 bool sensor_ds18b20_init(void) {
-    Serial.println("DS18B20: Iniciando sensor de temperatura a 1m...");
-    
+    LOG_INFO_FAST("DS18B20: Iniciando sensor de temperatura a 1m...\n");
+
+    if (rom_cache_load()) {
+        LOG_INFO("DS18B20: ROM en caché %02X%02X%02X%02X%02X%02X%02X%02X (sin búsqueda en el bus)\n",
+                 rom_cache.rom[0], rom_cache.rom[1], rom_cache.rom[2], rom_cache.rom[3],
+                 rom_cache.rom[4], rom_cache.rom[5], rom_cache.rom[6], rom_cache.rom[7]);
+        sensor_available = true;
+        return true;
+    }
+
     // Encender alimentación de sensores
-    sensor_ds18b20_power_on();
+    power_rail_wait_until(sensor_ds18b20_power_up());
     
-    // Inicializar librería DallasTemperature
+    // Inicializar librería DallasTemperature (búsqueda completa del bus)
     sensors.begin();
     
     // Verificar si hay dispositivos conectados
     int deviceCount = sensors.getDeviceCount();
-    Serial.printf("DS18B20: %d dispositivo(s) encontrado(s) en el bus OneWire\n", deviceCount);
+    LOG_INFO_FAST("DS18B20: %d dispositivo(s) encontrado(s) en el bus OneWire\n", deviceCount);
     
-    if (deviceCount == 0) {
-        Serial.println("DS18B20: ERROR - No se encontró ningún sensor");
-        Serial.println("Verifica conexiones: VCC->MOSFET, GND->GND, DATA->GPIO" + String(DS18B20_DATA_PIN));
+    DeviceAddress rom;
+    if (deviceCount == 0 || !sensors.getAddress(rom, 0) || !rom_is_valid(rom)) {
+        LOG_INFO_FAST("DS18B20: ERROR - No se encontró ningún sensor\n");
+        LOG_INFO_FAST("Verifica conexiones: VCC->MOSFET, GND->GND, DATA->GPIO%d\n", DS18B20_DATA_PIN);
         sensor_available = false;
-        sensor_ds18b20_power_off();
+        sensor_ds18b20_power_down();
         return false;
     }
     
-    // Configurar resolución
-    sensors.setResolution(DS18B20_RESOLUTION);
+    rom_cache_store(rom);
     
-    Serial.println("DS18B20: Sensor inicializado correctamente");
+    LOG_INFO_FAST("DS18B20: Sensor inicializado correctamente\n");
     sensor_available = true;
     
     // Apagar sensores hasta que se necesiten
-    sensor_ds18b20_power_off();
+    sensor_ds18b20_power_down();
     
     return true;
 }
@@ -91,61 +185,94 @@ bool sensor_ds18b20_is_available(void) {
  */
 bool sensor_ds18b20_retry_init(void) {
     if (sensor_available) return true;
-    Serial.println("Reintentando inicialización del sensor DS18B20...");
+    LOG_INFO_FAST("Reintentando inicialización del sensor DS18B20...\n");
     return sensor_ds18b20_init();
 }
 
 /**
- * @brief Lee todos los datos del sensor DS18B20
+ * @brief Fija la precisión requerida (°C); se aplica en la siguiente conversión
  */
-bool sensor_ds18b20_read_all(sensor_data_t* data) {
-    if (!sensor_available || !data) return false;
+void sensor_ds18b20_set_precision(float precision) {
+    precision_c = precision;
+}
 
-    // Encender alimentación de sensores antes de leer
-    sensor_ds18b20_power_on();
-    
-    // Solicitar lectura de temperaturas
-    sensors.requestTemperatures();
-    delay(DS18B20_CONVERSION_DELAY_MS);
-    
-    // Leer temperatura del primer sensor (índice 0)
-    float temp = sensors.getTempCByIndex(0);
-    
-    // Verificar si la lectura es válida
-    if (temp == DEVICE_DISCONNECTED_C || temp < DS18B20_TEMPERATURE_MIN || temp > DS18B20_TEMPERATURE_MAX) {
-        Serial.println("DS18B20: ERROR - Lectura inválida");
-        data->temperature_1m = SENSOR_ERROR_TEMPERATURE;
-        sensor_ds18b20_power_off();
-        return false;
+/**
+ * @brief Lanza la conversión de temperatura sin bloquear
+ *
+ * El sensor debe estar alimentado. La resolución se elige en cada ciclo a
+ * partir de la precisión requerida; tras cada corte del rail el sensor
+ * arranca con la de su EEPROM, así que se escribe en el scratchpad sin
+ * copiarla a EEPROM (no se desgasta). El resultado se recoge con
+ * sensor_ds18b20_wait_conversion() y sensor_ds18b20_read_conversion().
+ *
+ * @return Milisegundos máximos hasta que la conversión esté lista
+ */
+uint32_t sensor_ds18b20_start_conversion(void) {
+    if (!sensor_available) return 0;
+
+    uint8_t bits = resolution_for_precision(precision_c);
+    sensors.setWaitForConversion(false);
+    sensors.setAutoSaveScratchPad(false);
+    sensors.setResolution(rom_cache.rom, bits, true);
+    sensors.requestTemperaturesByAddress(rom_cache.rom);
+    return sensors.millisToWaitForConversion(bits);
+}
+
+/**
+ * @brief Espera el fin de la conversión: bit de estado o plazo máximo
+ *
+ * Con alimentación externa el DS18B20 responde 1 a un read slot al terminar
+ * la conversión, que suele acabar antes del máximo del datasheet. Entre
+ * sondeos la CPU duerme (ver power_rail_wait_until()).
+ *
+ * @param deadline_ms Instante (millis) del plazo máximo de conversión
+ */
+void sensor_ds18b20_wait_conversion(uint32_t deadline_ms) {
+    while ((int32_t)(deadline_ms - millis()) > 0) {
+        if (sensors.isConversionComplete()) return;
+
+        uint32_t next = millis() + DS18B20_POLL_INTERVAL_MS;
+        power_rail_wait_until((int32_t)(next - deadline_ms) < 0 ? next : deadline_ms);
     }
-    
-    data->temperature_1m = temp;
-    Serial.printf("DS18B20: Temperatura a 1m = %.2f °C\n", temp);
-    
-    // Apagar alimentación después de leer
-    sensor_ds18b20_power_off();
-    
-    return true;
 }
 
 /**
- * @brief Obtiene el payload del sensor DS18B20
+ * @brief Recoge el resultado de la conversión lanzada previamente
  */
-uint8_t sensor_ds18b20_get_payload(payload_config_t* config) {
-    if (!config || !sensor_available) return 0;
+bool sensor_ds18b20_read_conversion(sensor_data_t* data) {
+    if (!sensor_available || !data) return false;
 
-    sensor_data_t data;
-    if (!sensor_ds18b20_read_all(&data)) {
-        data.temperature_1m = SENSOR_ERROR_TEMPERATURE;
+    // Lectura directa del scratchpad por ROM (con comprobación de CRC), en 1/128 °C
+    int32_t raw = sensors.getTemp(rom_cache.rom);
+
+    if (raw == DEVICE_DISCONNECTED_RAW) {
+        // El sensor de la ROM guardada no responde: buscar de nuevo en el próximo arranque
+        LOG_INFO_FAST("DS18B20: ERROR - El sensor no responde, se descarta la ROM guardada\n");
+        rom_cache_invalidate();
+        sensor_available = false;
+        data->valid_mask &= ~SENSOR_FIELD_TEMPERATURE_1M;
+        return false;
     }
 
-    // Codificar temperatura como int16 (multiplicar por 100)
-    int16_t temp_int = (int16_t)(data.temperature_1m * 100);
-    
-    config->buffer[0] = temp_int >> 8;
-    config->buffer[1] = temp_int & 0xFF;
-    
-    return 2;  // 2 bytes enviados
+    // 1/128 °C -> centésimas de °C (x100/128 = x25/32), redondeando
+    int32_t temp = (raw * 25 + (raw >= 0 ? 16 : -16)) / 32;
+
+    // Verificar si la lectura es válida
+    if (temp < DS18B20_TEMPERATURE_MIN * SENSOR_SCALE_TEMPERATURE ||
+        temp > DS18B20_TEMPERATURE_MAX * SENSOR_SCALE_TEMPERATURE) {
+        LOG_INFO_FAST("DS18B20: ERROR - Lectura inválida\n");
+        data->valid_mask &= ~SENSOR_FIELD_TEMPERATURE_1M;
+        return false;
+    }
+
+    data->temperature_1m = temp;
+    data->valid_mask |= SENSOR_FIELD_TEMPERATURE_1M;
+
+    char temp_str[12];
+    LOG_INFO("DS18B20: Temperatura a 1m = %s °C (%u bits)\n",
+             sensor_format_fixed(temp_str, sizeof(temp_str), temp, SENSOR_SCALE_TEMPERATURE, 2),
+             resolution_for_precision(precision_c));
+    return true;
 }
 
 /**
@@ -4,54 +4,46 @@
 // Implementacion sensor de pH DFRobot
 #include <DFRobot_PH.h>
 #include "sensor_interface.h"
+#include "power_rail.h"
+#include "ph_adc.h"
 #include "LoRaBoards.h"
+#include "logger.h"
 
 // Objeto global del sensor DFRobot_PH
 static DFRobot_PH ph_sensor;
 
 // Estado del sensor
 static bool sensor_available = false;
-static bool sensor_powered = false;
 
 // Variables para lecturas
 static float temperature = PH_DEFAULT_TEMPERATURE;  // Temperatura para compensacion
 
 /**
- * @brief Enciende alimentacion de sensores
+ * @brief Solicita el rail de alimentacion del sensor de pH
+ * @return Instante (millis) en que el sensor esta estabilizado
  */
-static void sensor_ph_power_on(void) {
-    if (sensor_powered) return;
-    
-    pinMode(PH_POWER_PIN, OUTPUT);
-    digitalWrite(PH_POWER_PIN, HIGH);
-    sensor_powered = true;
-    
-    Serial.println("pH: Alimentacion de sensores activada");
-    Serial.printf("pH: Esperando %d ms para estabilizacion...\n", PH_POWER_ON_DELAY_MS);
-    delay(PH_POWER_ON_DELAY_MS);
+static uint32_t sensor_ph_power_up(void) {
+    return power_rail_acquire(PH_POWER_PIN, PH_POWER_ON_DELAY_MS);
 }
 
 /**
- * @brief Apaga alimentacion de sensores
+ * @brief Libera el rail de alimentacion del sensor de pH
  */
-static void sensor_ph_power_off(void) {
-    if (!sensor_powered) return;
-    
-    digitalWrite(PH_POWER_PIN, LOW);
-    sensor_powered = false;
-    
-    Serial.println("pH: Alimentacion de sensores desactivada");
-    delay(1000);  // Delay para garantizar desconexion completa
+static void sensor_ph_power_down(void) {
+    power_rail_release(PH_POWER_PIN);
 }
 
 /**
  * @brief Inicializa el sensor de pH DFRobot
  */
 bool sensor_ph_init(void) {
-    Serial.println("pH: Iniciando sensor de pH DFRobot...");
+    LOG_INFO_FAST("pH: Iniciando sensor de pH DFRobot...\n");
     
-    // Configurar pin ADC
-    pinMode(PH_ANALOG_PIN, INPUT);
+    // Configurar canal ADC y calibración de eFuse (comprueba el pin)
+    if (!ph_adc_init()) {
+        sensor_available = false;
+        return false;
+    }
     
     // Configurar pin de alimentacion
     pinMode(PH_POWER_PIN, OUTPUT);
@@ -59,9 +51,9 @@ bool sensor_ph_init(void) {
     // Inicializar la libreria DFRobot_PH
     ph_sensor.begin();
     
-    Serial.printf("pH: Pin ADC configurado en GPIO%d\n", PH_ANALOG_PIN);
-    Serial.printf("pH: Pin de alimentacion configurado en GPIO%d\n", PH_POWER_PIN);
-    Serial.println("pH: Libreria DFRobot_PH inicializada");
+    LOG_INFO_FAST("pH: Pin ADC configurado en GPIO%d\n", PH_ANALOG_PIN);
+    LOG_INFO_FAST("pH: Pin de alimentacion configurado en GPIO%d\n", PH_POWER_PIN);
+    LOG_INFO_FAST("pH: Libreria DFRobot_PH inicializada\n");
     
     sensor_available = true;
     
@@ -80,33 +72,36 @@ bool sensor_ph_is_available(void) {
  */
 bool sensor_ph_retry_init(void) {
     if (sensor_available) return true;
-    Serial.println("Reintentando inicializacion del sensor de pH...");
+    LOG_INFO_FAST("Reintentando inicializacion del sensor de pH...\n");
     return sensor_ph_init();
 }
 
 /**
  * @brief Lee el valor de pH usando la libreria DFRobot
+ *
+ * Una rafaga del ADC (ver ph_adc.h) sustituye a las lecturas separadas por
+ * delay(); la libreria espera la tension en mV.
+ *
+ * @param ph Salida: valor de pH
+ * @return true si el ADC dio muestras validas
  */
-static float read_ph_value(void) {
-    uint32_t sum = 0;
-    
-    // Tomar multiples muestras y promediar
-    for (int i = 0; i < PH_READ_SAMPLES; i++) {
-        sum += analogRead(PH_ANALOG_PIN);
-        delay(PH_READ_DELAY_MS);
-    }
-    
-    float avg_reading = sum / (float)PH_READ_SAMPLES;
-    
-    // Convertir a voltaje
-    float voltage = (avg_reading / PH_ADC_RESOLUTION) * PH_REFERENCE_VOLTAGE;
-    
-    Serial.printf("pH: Lectura ADC promedio = %.1f, Voltaje = %.3f V\n", avg_reading, voltage);
+static bool read_ph_value(float* ph) {
+    ph_adc_result_t adc;
+    if (!ph_adc_acquire(&adc)) return false;
+
+    // Tensiones en décimas de mV (ruido en centésimas) para no formatear float
+    char volt_str[12], median_str[12], noise_str[12], span_str[12];
+    LOG_INFO("pH: %u muestras en %lu us, %s mV (mediana %s mV, ruido %s mV rms, pico a pico %s mV)\n",
+             adc.samples, (unsigned long)adc.duration_us,
+             sensor_format_fixed(volt_str, sizeof(volt_str), (int32_t)lroundf(adc.voltage_mv * 10), 10, 1),
+             sensor_format_fixed(median_str, sizeof(median_str), (int32_t)lroundf(adc.median_mv * 10), 10, 1),
+             sensor_format_fixed(noise_str, sizeof(noise_str), (int32_t)lroundf(adc.noise_mv * 100), 100, 2),
+             sensor_format_fixed(span_str, sizeof(span_str), (int32_t)lroundf(adc.span_mv * 10), 10, 1));
     
     // Usar la libreria DFRobot_PH para calcular el pH con compensacion de temperatura
-    float ph_value = ph_sensor.readPH(voltage, temperature);
+    *ph = ph_sensor.readPH(adc.voltage_mv, temperature);
     
-    return ph_value;
+    return true;
 }
 
 /**
@@ -116,55 +111,54 @@ static float read_ph_value(void) {
 void sensor_ph_set_temperature(float temp) {
     if (temp >= -50.0f && temp <= 100.0f) {
         temperature = temp;
-        Serial.printf("pH: Temperatura actualizada a %.2f grados C\n", temp);
+        char temp_str[12];
+        LOG_INFO("pH: Temperatura actualizada a %s grados C\n",
+                 sensor_format_fixed(temp_str, sizeof(temp_str),
+                                     (int32_t)lroundf(temp * SENSOR_SCALE_TEMPERATURE), SENSOR_SCALE_TEMPERATURE, 2));
     }
 }
 
 /**
- * @brief Lee todos los datos del sensor de pH
+ * @brief Muestrea el pH con el sensor ya alimentado y estabilizado
  */
-bool sensor_ph_read_all(sensor_data_t* data) {
+static bool sensor_ph_sample(sensor_data_t* data) {
     if (!sensor_available || !data) return false;
 
-    // Encender alimentacion de sensores antes de leer
-    sensor_ph_power_on();
-    
     // Leer valor de pH
-    float ph = read_ph_value();
+    float ph;
+    if (!read_ph_value(&ph)) {
+        data->valid_mask &= ~SENSOR_FIELD_PH;
+        return false;
+    }
     
+    // La libreria DFRobot_PH trabaja en float: se convierte una sola vez aqui
+    data->ph = (int32_t)lroundf(ph * SENSOR_SCALE_PH);
+    char ph_str[12];
+    sensor_format_fixed(ph_str, sizeof(ph_str), data->ph, SENSOR_SCALE_PH, 2);
+
     // Verificar si la lectura es valida
     if (ph < PH_MIN || ph > PH_MAX) {
-        Serial.printf("pH: ADVERTENCIA - Lectura fuera de rango: %.2f\n", ph);
-        // No marcar como error, solo advertencia
+        LOG_INFO("pH: ADVERTENCIA - Lectura fuera de rango: %s\n", ph_str);
+        // No marcar como error, solo advertencia (el payload la envia como "sin lectura")
     }
     
-    data->ph = ph;
-    Serial.printf("pH: Valor de pH = %.2f\n", ph);
-    
-    // Apagar alimentacion despues de leer
-    sensor_ph_power_off();
-    
+    data->valid_mask |= SENSOR_FIELD_PH;
+    LOG_INFO("pH: Valor de pH = %s\n", ph_str);
     return true;
 }
 
 /**
- * @brief Obtiene el payload del sensor de pH
+ * @brief Lectura para el planificador de sensores
+ *
+ * Compensa con la temperatura del ciclo si ya se ha leído y muestrea el pH.
  */
-uint8_t sensor_ph_get_payload(payload_config_t* config) {
-    if (!config || !sensor_available) return 0;
+bool sensor_ph_read_measurement(sensor_data_t* data) {
+    if (!data) return false;
 
-    sensor_data_t data;
-    if (!sensor_ph_read_all(&data)) {
-        data.ph = SENSOR_ERROR_PH;
+    if (data->valid_mask & SENSOR_FIELD_TEMPERATURE) {
+        sensor_ph_set_temperature((float)data->temperature / SENSOR_SCALE_TEMPERATURE);
     }
-
-    // Codificar pH como uint16 (multiplicar por 100)
-    uint16_t ph_int = (uint16_t)(data.ph * 100);
-    
-    config->buffer[0] = ph_int >> 8;
-    config->buffer[1] = ph_int & 0xFF;
-    
-    return 2;  // 2 bytes enviados
+    return sensor_ph_sample(data);
 }
 
 /**
@@ -179,7 +173,7 @@ const char* sensor_ph_get_name(void) {
  */
 void sensor_ph_set_available_for_testing(bool available) {
     sensor_available = available;
-    Serial.printf("TESTING: Sensor pH forzado a %s\n", available ? "disponible" : "no disponible");
+    LOG_INFO("TESTING: Sensor pH forzado a %s\n", available ? "disponible" : "no disponible");
 }
 
 /**
@@ -196,16 +190,17 @@ void sensor_ph_process_serial(void) {
     if (Serial.available() == 0) return;
 
     // Asegurar alimentación del sensor y hacer una lectura rápida
-    sensor_ph_power_on();
-    uint32_t raw = analogRead(PH_ANALOG_PIN);
-    // Convertir a voltaje usando la misma fórmula que read_ph_value()
-    float voltage = (raw / PH_ADC_RESOLUTION) * PH_REFERENCE_VOLTAGE;
-
-    // Pasar la tensión y la temperatura a la librería; ésta procesará los comandos
-    ph_sensor.calibration(voltage, temperature);
+    power_rail_wait_until(sensor_ph_power_up());
+    ph_adc_result_t adc;
+    if (ph_adc_acquire(&adc)) {
+        // Pasar la tensión (mV) y la temperatura a la librería; ésta procesará los comandos
+        // (e imprime directamente por Serial)
+        logger_flush();
+        ph_sensor.calibration(adc.voltage_mv, temperature);
+    }
 
     // Apagar la alimentación tras la operación rápida
-    sensor_ph_power_off();
+    sensor_ph_power_down();
 }
 
 #endif // ENABLE_SENSOR_PH
@@ -0,0 +1,308 @@
+/**
+ * @file      session.cpp
+ * @brief     Persistencia de la sesión LoRaWAN OTAA entre ciclos de sueño profundo
+ *
+ * El sueño profundo del ESP32 borra la RAM, por lo que sin este módulo cada
+ * despertar repite el join OTAA completo antes de enviar un uplink de pocos
+ * bytes. Aquí se guarda en memoria RTC (RTC_DATA_ATTR) todo lo necesario para
+ * reconstruir la sesión con LMIC_setSession():
+ * - devaddr, netid y claves de sesión (nwkKey / artKey)
+ * - Contadores de trama seqnoUp / seqnoDn
+ * - Plan de canales (frecuencias, mapas de DR y máscara de canales)
+ * - Datarate, potencia ADR, ADR habilitado, RX2 (dn2Dr/dn2Freq) y rxDelay
+ * - Tiempo restante de duty cycle por banda y global
+ *
+ * El snapshot se valida con número mágico, versión y CRC16. Opcionalmente
+ * se copia a NVS (SESSION_PERSIST_NVS) para sobrevivir a un corte de
+ * alimentación.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <lmic.h>
+#include <esp_sleep.h>
+#include <stddef.h>
+#include "session.h"
+#include "logger.h"
+
+#if SESSION_PERSIST_NVS
+#include <Preferences.h>
+#endif
+
+// Identificación del snapshot en memoria RTC
+#define SESSION_MAGIC   0x534E5331UL  // "SNS1"
+#define SESSION_VERSION 1
+
+/**
+ * @brief Snapshot de la sesión LMIC guardado en memoria RTC
+ * @note El CRC debe ser siempre el último campo
+ */
+typedef struct {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  datarate;                    /**< LMIC.datarate */
+    int8_t   adrTxPow;                    /**< LMIC.adrTxPow */
+    uint8_t  adrEnabled;                  /**< LMIC.adrEnabled */
+    uint32_t netid;
+    uint32_t devaddr;
+    uint8_t  nwkKey[16];
+    uint8_t  artKey[16];
+    uint32_t seqnoUp;
+    uint32_t seqnoDn;
+    uint32_t channelFreq[MAX_CHANNELS];
+    uint16_t channelDrMap[MAX_CHANNELS];
+    uint16_t channelMap;
+    uint8_t  dn2Dr;                       /**< DR de la ventana RX2 */
+    uint8_t  rxDelay;                     /**< Retardo RX1 en segundos */
+    uint32_t dn2Freq;                     /**< Frecuencia de la ventana RX2 */
+    uint8_t  globalDutyRate;
+    uint8_t  bandLastChnl[MAX_BANDS];
+    int32_t  globalDutyWait;              /**< Ticks de espera global restantes al guardar */
+    int32_t  bandWait[MAX_BANDS];         /**< Ticks de espera por banda restantes al guardar */
+    uint32_t sleepSeconds;                /**< Duración del sueño que siguió al guardado */
+    uint32_t uplinks;                     /**< Uplinks enviados desde el último join */
+    uint8_t  missedAcks;                  /**< Confirmados consecutivos sin ACK */
+    uint16_t crc;
+} session_snapshot_t;
+
+// Snapshot en memoria RTC (sobrevive al sueño profundo)
+static RTC_DATA_ATTR session_snapshot_t rtc_session;
+
+// Contadores de la sesión activa
+static uint32_t uplinks_since_join = 0;
+static uint8_t missed_acks = 0;
+static bool rejoin_required = false;
+
+/**
+ * @brief Calcula el CRC16 del snapshot (sin incluir el propio campo CRC)
+ */
+static uint16_t snapshot_crc(const session_snapshot_t* s) {
+    return os_crc16((xref2u1_t)s, offsetof(session_snapshot_t, crc));
+}
+
+/**
+ * @brief Comprueba que un snapshot es coherente y utilizable
+ */
+static bool snapshot_is_valid(const session_snapshot_t* s) {
+    if (s->magic != SESSION_MAGIC || s->version != SESSION_VERSION) return false;
+    if (s->crc != snapshot_crc(s)) return false;
+    if (s->devaddr == 0) return false;
+    return true;
+}
+
+/**
+ * @brief Tiempo de espera pendiente tras descontar el sueño, en ticks
+ */
+static ostime_t remaining_wait(int32_t wait_ticks, uint32_t sleep_seconds) {
+    int64_t remaining = (int64_t)wait_ticks - (int64_t)sleep_seconds * OSTICKS_PER_SEC;
+    return remaining > 0 ? (ostime_t)remaining : 0;
+}
+
+#if SESSION_PERSIST_NVS
+/**
+ * @brief Recupera el snapshot de NVS (tras un reinicio o corte de alimentación)
+ */
+static bool load_from_nvs(session_snapshot_t* s) {
+    Preferences prefs;
+    if (!prefs.begin("lorawan", true)) return false;
+    size_t len = prefs.getBytes("session", s, sizeof(*s));
+    prefs.end();
+    return len == sizeof(*s);
+}
+
+/**
+ * @brief Copia el snapshot a NVS
+ */
+static void store_to_nvs(const session_snapshot_t* s) {
+    Preferences prefs;
+    if (!prefs.begin("lorawan", false)) return;
+    prefs.putBytes("session", s, sizeof(*s));
+    prefs.end();
+}
+#endif
+
+/**
+ * @brief Restaura la sesión LoRaWAN guardada antes del sueño profundo
+ */
+bool session_restore(void) {
+    const session_snapshot_t* s = &rtc_session;
+
+    // Tras un encendido o reset la memoria RTC no es fiable: sólo se usa
+    // cuando venimos de un sueño profundo
+    bool from_deep_sleep = esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED;
+
+#if SESSION_PERSIST_NVS
+    static session_snapshot_t nvs_session;
+    if (!from_deep_sleep || !snapshot_is_valid(s)) {
+        if (load_from_nvs(&nvs_session) && snapshot_is_valid(&nvs_session)) {
+            LOG_INFO_FAST("Sesión: usando copia de respaldo de NVS\n");
+            // Sin referencia temporal fiable: respetar el duty cycle completo
+            nvs_session.sleepSeconds = 0;
+            s = &nvs_session;
+            from_deep_sleep = true;
+        }
+    }
+#endif
+
+    if (!from_deep_sleep || !snapshot_is_valid(s)) {
+        LOG_INFO_FAST("Sesión: no hay sesión guardada válida, se requiere join\n");
+        return false;
+    }
+
+    // LMIC_setSession() reinicia canales y contadores: se aplican después los guardados
+    LMIC_setSession(s->netid, s->devaddr, (xref2u1_t)s->nwkKey, (xref2u1_t)s->artKey);
+
+    memcpy(LMIC.channelFreq, s->channelFreq, sizeof(LMIC.channelFreq));
+    memcpy(LMIC.channelDrMap, s->channelDrMap, sizeof(LMIC.channelDrMap));
+    LMIC.channelMap = s->channelMap;
+
+    LMIC.seqnoUp = s->seqnoUp;
+    LMIC.seqnoDn = s->seqnoDn;
+    LMIC.adrEnabled = s->adrEnabled;
+    LMIC_setDrTxpow(s->datarate, s->adrTxPow);
+    LMIC.dn2Dr = s->dn2Dr;
+    LMIC.dn2Freq = s->dn2Freq;
+    LMIC.rxDelay = s->rxDelay;
+
+    // Disponibilidad de bandas: el reloj de LMIC empieza de cero en cada arranque
+    ostime_t now = os_getTime();
+    for (uint8_t i = 0; i < MAX_BANDS; i++) {
+        LMIC.bands[i].avail = now + remaining_wait(s->bandWait[i], s->sleepSeconds);
+        LMIC.bands[i].lastchnl = s->bandLastChnl[i];
+    }
+    LMIC.globalDutyRate = s->globalDutyRate;
+    LMIC.globalDutyAvail = now + remaining_wait(s->globalDutyWait, s->sleepSeconds);
+
+    uplinks_since_join = s->uplinks;
+    missed_acks = s->missedAcks;
+    rejoin_required = false;
+
+    LOG_INFO("Sesión restaurada: devaddr=%08lX, FCntUp=%lu, FCntDn=%lu, DR=%u, uplinks=%lu\n",
+             (unsigned long)s->devaddr, (unsigned long)s->seqnoUp, (unsigned long)s->seqnoDn,
+             s->datarate, (unsigned long)s->uplinks);
+    return true;
+}
+
+/**
+ * @brief Guarda la sesión LoRaWAN actual antes de entrar en sueño profundo
+ */
+void session_save(uint32_t sleep_seconds) {
+    if (rejoin_required || LMIC.devaddr == 0 || (LMIC.opmode & OP_JOINING)) {
+        session_invalidate();
+        return;
+    }
+
+    session_snapshot_t* s = &rtc_session;
+    memset(s, 0, sizeof(*s));
+
+    s->magic = SESSION_MAGIC;
+    s->version = SESSION_VERSION;
+    s->netid = LMIC.netid;
+    s->devaddr = LMIC.devaddr;
+    memcpy(s->nwkKey, LMIC.nwkKey, sizeof(s->nwkKey));
+    memcpy(s->artKey, LMIC.artKey, sizeof(s->artKey));
+    s->seqnoUp = LMIC.seqnoUp;
+    s->seqnoDn = LMIC.seqnoDn;
+    memcpy(s->channelFreq, LMIC.channelFreq, sizeof(s->channelFreq));
+    memcpy(s->channelDrMap, LMIC.channelDrMap, sizeof(s->channelDrMap));
+    s->channelMap = LMIC.channelMap;
+    s->datarate = LMIC.datarate;
+    s->adrTxPow = LMIC.adrTxPow;
+    s->adrEnabled = LMIC.adrEnabled;
+    s->dn2Dr = LMIC.dn2Dr;
+    s->dn2Freq = LMIC.dn2Freq;
+    s->rxDelay = LMIC.rxDelay;
+
+    ostime_t now = os_getTime();
+    for (uint8_t i = 0; i < MAX_BANDS; i++) {
+        ostime_t wait = LMIC.bands[i].avail - now;
+        s->bandWait[i] = wait > 0 ? wait : 0;
+        s->bandLastChnl[i] = LMIC.bands[i].lastchnl;
+    }
+    s->globalDutyRate = LMIC.globalDutyRate;
+    ostime_t global_wait = LMIC.globalDutyAvail - now;
+    s->globalDutyWait = global_wait > 0 ? global_wait : 0;
+
+    s->sleepSeconds = sleep_seconds;
+    s->uplinks = uplinks_since_join;
+    s->missedAcks = missed_acks;
+    s->crc = snapshot_crc(s);
+
+#if SESSION_PERSIST_NVS
+    store_to_nvs(s);
+#endif
+
+    LOG_INFO("Sesión guardada: FCntUp=%lu, uplinks=%lu\n",
+             (unsigned long)s->seqnoUp, (unsigned long)s->uplinks);
+}
+
+/**
+ * @brief Suma un periodo de sueño más a la sesión guardada
+ */
+void session_add_sleep(uint32_t sleep_seconds) {
+    session_snapshot_t* s = &rtc_session;
+    if (!snapshot_is_valid(s)) return;
+
+    s->sleepSeconds += sleep_seconds;
+    s->crc = snapshot_crc(s);
+}
+
+/**
+ * @brief Invalida la sesión guardada para forzar un nuevo join OTAA
+ */
+void session_invalidate(void) {
+    memset(&rtc_session, 0, sizeof(rtc_session));
+#if SESSION_PERSIST_NVS
+    Preferences prefs;
+    if (prefs.begin("lorawan", false)) {
+        prefs.remove("session");
+        prefs.end();
+    }
+#endif
+}
+
+/**
+ * @brief Notifica que se ha completado un join OTAA
+ */
+void session_on_joined(void) {
+    uplinks_since_join = 0;
+    missed_acks = 0;
+    rejoin_required = false;
+}
+
+/**
+ * @brief Notifica el fin de una transacción TX/RX
+ */
+void session_on_tx_complete(bool confirmed, uint8_t txrx_flags) {
+    uplinks_since_join++;
+
+    if (confirmed) {
+        if (txrx_flags & TXRX_ACK) {
+            missed_acks = 0;
+        } else {
+            missed_acks++;
+            LOG_INFO_FAST("Sesión: uplink confirmado sin ACK (%u/%u)\n",
+                          missed_acks, SESSION_MAX_MISSED_ACKS);
+        }
+    }
+
+    if (missed_acks >= SESSION_MAX_MISSED_ACKS) {
+        LOG_INFO_FAST("Sesión: demasiados ACKs perdidos, se forzará un nuevo join\n");
+        rejoin_required = true;
+    } else if (uplinks_since_join >= SESSION_MAX_UPLINKS) {
+        LOG_INFO_FAST("Sesión: límite de uplinks alcanzado, se forzará un nuevo join\n");
+        rejoin_required = true;
+    }
+}
+
+/**
+ * @brief Indica si el próximo uplink debe enviarse como confirmado
+ */
+bool session_should_confirm(void) {
+    // Tras un ACK perdido, volver a comprobar en el siguiente ciclo
+    if (missed_acks > 0) return true;
+    return SESSION_CONFIRM_EVERY > 0 && ((uplinks_since_join + 1) % SESSION_CONFIRM_EVERY) == 0;
+}
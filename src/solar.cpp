@@ -1,5 +1,6 @@
 #include <XPowersLib.h>
 #include <Arduino.h>
+#include "logger.h"       // Logs diferidos por Serial
 
 // Declaración externa para funciones de carga solar
 extern XPowersLibInterface *PMU;
@@ -35,8 +36,8 @@ bool getSolarChargeStatus() {
 void checkSolarStatus() {
     bool isCharging = getSolarChargeStatus();
     if (isCharging) {
-        Serial.println("Placa solar cargando batería");
+        LOG_INFO_FAST("Placa solar cargando batería\n");
     } else {
-        Serial.println("Batería no cargándose (posiblemente sin sol o batería llena)");
+        LOG_INFO_FAST("Batería no cargándose (posiblemente sin sol o batería llena)\n");
     }
 }
\ No newline at end of file
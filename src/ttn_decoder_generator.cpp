@@ -3,7 +3,9 @@
  * @brief     Generador dinámico de decoders TTN según configuración de sensores
  *
  * Este archivo genera automáticamente el código JavaScript del decoder
- * para The Things Network (TTN) basado en los sensores configurados.
+ * para The Things Network (TTN) a partir del mismo esquema de campos que
+ * usa el codificador del payload (config/payload_schema.h), de modo que
+ * codificador y decoder no pueden discrepar en el formato.
  *
  * @author    Boya Marítima V2 - Medialab Uniovi
  * @version   2.0
@@ -12,6 +14,15 @@
 
 #include "../config/config.h"
 #include <Arduino.h>
+#include <stdarg.h>
+#include "payload_codec.h"
+#include "sensor_interface.h"
+#include "batch.h"
+#include "profiler.h"
+#include "hibernate.h"
+#include "remote_config.h"
+#include "LoRaBoards.h"  // isFastBoot()
+#include "logger.h"      // logger_flush()
 
 // =============================================================================
 // CONFIGURACIÓN DEL GENERADOR DE DECODERS TTN
@@ -22,102 +33,295 @@
 #define SHOW_TTN_DECODER 0  // Cambia a 1 para mostrar el decoder por Serial
 #endif
 
+/**
+ * @brief Destino del código generado: Serial (buffer NULL) o un buffer
+ */
+typedef struct {
+    char* buffer;
+    uint16_t max_size;
+    uint16_t offset;
+} decoder_output_t;
+
 // =============================================================================
 // FUNCIONES PARA GENERAR EL DECODER TTN
 // =============================================================================
 
 /**
- * @brief Imprime el header del decoder TTN
+ * @brief Escribe una línea (con formato printf) en el destino
  */
-static void print_decoder_header() {
-    Serial.println(F(""));
-    Serial.println(F("==================== DECODIFICADOR PAYLOAD TTN ===================="));
-    Serial.println(F(""));
-    Serial.println(F("// COPIA Y PEGA ESTE CÓDIGO EN TTN CONSOLE -> APPLICATIONS -> PAYLOAD FORMATTERS"));
-    Serial.println(F("// 1. Ve a tu aplicación en TTN Console"));
-    Serial.println(F("// 2. Ve a Payload formatters -> Uplink"));
-    Serial.println(F("// 3. Selecciona 'Custom Javascript formatter'"));
-    Serial.println(F("// 4. Pega el código siguiente en el campo 'Formatter code'"));
-    Serial.println(F("// 5. Haz clic en 'Save changes'"));
-    Serial.println(F(""));
-    Serial.println(F("function decodeUplink(input) {"));
-    Serial.println(F("  var data = {};"));
-    Serial.println(F("  var bytes = input.bytes;"));
-    Serial.println(F("  var offset = 0;"));
-    Serial.println(F(""));
+static void emit(decoder_output_t* out, const char* format, ...) {
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (!out->buffer) {
+        Serial.println(line);
+        return;
+    }
+
+    if (out->offset >= out->max_size) return;
+    int written = snprintf(out->buffer + out->offset, out->max_size - out->offset, "%s\n", line);
+    if (written > 0) {
+        out->offset += written;
+        if (out->offset >= out->max_size) out->offset = out->max_size - 1;
+    }
 }
 
 /**
- * @brief Imprime el código para decodificar batería (primer byte)
+ * @brief Decimales con los que se representa un campo según su escala
  */
-static void print_battery_percent_decoder() {
-    Serial.println(F("  // Byte 0: Batería en porcentaje (0-100%)"));
-    Serial.println(F("  data.battery_percent = bytes[offset++];"));
-    Serial.println(F(""));
+static uint8_t field_decimals(const payload_field_t* field) {
+    uint8_t decimals = 0;
+    for (float scale = field->scale; scale >= 10.0f; scale /= 10.0f) {
+        decimals++;
+    }
+    return decimals;
 }
 
 /**
- * @brief Imprime el código para decodificar pH
+ * @brief Genera la tabla de campos del esquema en JavaScript
  */
-static void print_ph_decoder() {
-    Serial.println(F("  // Byte 1-2: pH (x100) - Little-endian"));
-    Serial.println(F("  var ph_raw = bytes[offset++] | (bytes[offset++] << 8);"));
-    Serial.println(F("  data.ph = ph_raw / 100.0;"));
-    Serial.println(F(""));
+static void emit_schema(decoder_output_t* out) {
+    emit(out, "// Esquema del payload (generado desde config/payload_schema.h)");
+    emit(out, "// Código 0 = sin lectura; valor = min + (código - 1) / scale");
+    emit(out, "var FIELDS = [");
+    for (uint8_t i = 0; i < payload_codec_field_count(); i++) {
+        const payload_field_t* field = payload_codec_field(i);
+        emit(out, "  { name: '%s', bits: %u, delta: %u, scale: %g, min: %g, decimals: %u },",
+             field->name, payload_codec_field_bits(field), field->delta_bits,
+             field->scale, field->min, field_decimals(field));
+    }
+    emit(out, "];");
+    emit(out, "var RECORD_SIZE = %u;", payload_codec_record_size());
+    emit(out, "var BATCH_FPORT = %d;", BATCH_FPORT);
+    emit(out, "var PROFILER_FPORT = %d;", PROFILER_FPORT);
+    emit(out, "var HIBERNATE_FPORT = %d;", HIBERNATE_FPORT);
+    emit(out, "var REMOTE_CONFIG_FPORT = %d;", REMOTE_CONFIG_FPORT);
+    emit(out, "var PROFILER_PHASES = [");
+    for (uint8_t i = 0; i < PROFILER_PHASE_COUNT; i++) {
+        emit(out, "  '%s',", profiler_phase_name(i));
+    }
+    emit(out, "];");
+    emit(out, "");
 }
 
 /**
- * @brief Imprime el código para decodificar temperatura exterior
+ * @brief Genera las funciones de lectura de bits y de decodificación de registros
  */
-static void print_temperature_ext_decoder() {
-    Serial.println(F("  // Byte 3-4: Temperatura exterior BME280 (°C * 100) - Little-endian"));
-    Serial.println(F("  var temp_ext_raw = bytes[offset++] | (bytes[offset++] << 8);"));
-    Serial.println(F("  data.temperature_ext = temp_ext_raw / 100.0;"));
-    Serial.println(F(""));
+static void emit_record_decoder(decoder_output_t* out) {
+    emit(out, "// Lee n bits (MSB primero)");
+    emit(out, "function readBits(r, n) {");
+    emit(out, "  var value = 0;");
+    emit(out, "  for (var i = 0; i < n; i++) {");
+    emit(out, "    var bit = (r.bytes[r.pos >> 3] >> (7 - (r.pos & 7))) & 1;");
+    emit(out, "    value = value * 2 + bit;");
+    emit(out, "    r.pos++;");
+    emit(out, "  }");
+    emit(out, "  return value;");
+    emit(out, "}");
+    emit(out, "");
+    emit(out, "// Decodifica un registro; con 'prev' cada campo lleva un bit: 0 = delta, 1 = completo");
+    emit(out, "function decodeRecord(r, prev) {");
+    emit(out, "  var codes = [];");
+    emit(out, "  var data = {};");
+    emit(out, "  for (var i = 0; i < FIELDS.length; i++) {");
+    emit(out, "    var f = FIELDS[i];");
+    emit(out, "    var code;");
+    emit(out, "    if (prev && readBits(r, 1) === 0) {");
+    emit(out, "      var delta = readBits(r, f.delta);");
+    emit(out, "      if (delta >= (1 << (f.delta - 1))) delta -= (1 << f.delta);");
+    emit(out, "      code = prev[i] + delta;");
+    emit(out, "    } else {");
+    emit(out, "      code = readBits(r, f.bits);");
+    emit(out, "    }");
+    emit(out, "    codes.push(code);");
+    emit(out, "    data[f.name] = code === 0 ? null : parseFloat((f.min + (code - 1) / f.scale).toFixed(f.decimals));");
+    emit(out, "  }");
+    emit(out, "  return { codes: codes, data: data };");
+    emit(out, "}");
+    emit(out, "");
 }
 
 /**
- * @brief Imprime el código para decodificar temperatura del agua
+ * @brief Genera la tabla y el decodificador de los TLV de configuración
  */
-static void print_temperature_water_decoder() {
-    Serial.println(F("  // Byte 5-6: Temperatura agua 1m DS18B20 (°C * 100) - Little-endian"));
-    Serial.println(F("  var temp_water_raw = bytes[offset++] | (bytes[offset++] << 8);"));
-    Serial.println(F("  data.temperature_water_1m = temp_water_raw / 100.0;"));
-    Serial.println(F(""));
+static void emit_config_codec(decoder_output_t* out) {
+    emit(out, "// Parámetros TLV de la configuración remota (etiqueta, bytes)");
+    emit(out, "var CONFIG_TLV = {");
+    emit(out, "  send_interval_seconds: [%d, 2],", REMOTE_CONFIG_TAG_INTERVAL);
+    emit(out, "  batch_samples: [%d, 1],", REMOTE_CONFIG_TAG_BATCH);
+    emit(out, "  sensor_mask: [%d, 1],", REMOTE_CONFIG_TAG_SENSORS);
+    emit(out, "  ds18b20_bits: [%d, 1],", REMOTE_CONFIG_TAG_DS18B20_BITS);
+    emit(out, "  ph_samples: [%d, 2]", REMOTE_CONFIG_TAG_PH_SAMPLES);
+    emit(out, "};");
+    emit(out, "var CONFIG_TAG_DR_POLICY = %d;", REMOTE_CONFIG_TAG_DR_POLICY);
+    emit(out, "var CONFIG_TAG_DEFAULTS = %d;", REMOTE_CONFIG_TAG_DEFAULTS);
+    emit(out, "var DR_POLICIES = ['model', 'adr', 'fixed'];");
+    emit(out, "var CONFIG_STATUS = ['ok', 'bad_version', 'malformed', 'unknown_tag', 'bad_value'];");
+    emit(out, "");
+    emit(out, "// Decodifica los TLV de configuración desde 'pos'");
+    emit(out, "function decodeConfig(bytes, pos) {");
+    emit(out, "  var config = {};");
+    emit(out, "  while (pos + 2 <= bytes.length) {");
+    emit(out, "    var tag = bytes[pos];");
+    emit(out, "    var len = bytes[pos + 1];");
+    emit(out, "    var v = bytes.slice(pos + 2, pos + 2 + len);");
+    emit(out, "    pos += 2 + len;");
+    emit(out, "    if (tag === CONFIG_TAG_DR_POLICY) {");
+    emit(out, "      config.dr_policy = DR_POLICIES[v[0]];");
+    emit(out, "      if (len > 1) config.fixed_dr = v[1];");
+    emit(out, "      continue;");
+    emit(out, "    }");
+    emit(out, "    for (var name in CONFIG_TLV) {");
+    emit(out, "      if (CONFIG_TLV[name][0] === tag) config[name] = len === 2 ? v[0] | (v[1] << 8) : v[0];");
+    emit(out, "    }");
+    emit(out, "  }");
+    emit(out, "  return config;");
+    emit(out, "}");
+    emit(out, "");
 }
 
 /**
- * @brief Imprime el código para decodificar humedad
+ * @brief Genera encodeDownlink(): comando de configuración remota
  */
-static void print_humidity_decoder() {
-    Serial.println(F("  // Byte 7-8: Humedad BME280 (% * 100) - Little-endian"));
-    Serial.println(F("  var humidity_raw = bytes[offset++] | (bytes[offset++] << 8);"));
-    Serial.println(F("  data.humidity = humidity_raw / 100.0;"));
-    Serial.println(F(""));
+static void emit_downlink_encoder(decoder_output_t* out) {
+    emit(out, "");
+    emit(out, "// Comando de configuración: { sequence, defaults, <parámetros>, dr_policy, fixed_dr }");
+    emit(out, "function encodeDownlink(input) {");
+    emit(out, "  var d = input.data;");
+    emit(out, "  var bytes = [%d, (d.sequence || 0) & 0xFF];", REMOTE_CONFIG_VERSION);
+    emit(out, "  if (d.defaults) bytes.push(CONFIG_TAG_DEFAULTS, 0);");
+    emit(out, "  for (var name in CONFIG_TLV) {");
+    emit(out, "    if (d[name] === undefined) continue;");
+    emit(out, "    bytes.push(CONFIG_TLV[name][0], CONFIG_TLV[name][1], d[name] & 0xFF);");
+    emit(out, "    if (CONFIG_TLV[name][1] === 2) bytes.push((d[name] >> 8) & 0xFF);");
+    emit(out, "  }");
+    emit(out, "  if (d.dr_policy !== undefined) {");
+    emit(out, "    var policy = DR_POLICIES.indexOf(d.dr_policy);");
+    emit(out, "    if (policy < 0) return { errors: ['Unknown dr_policy: ' + d.dr_policy] };");
+    emit(out, "    if (d.fixed_dr !== undefined) {");
+    emit(out, "      bytes.push(CONFIG_TAG_DR_POLICY, 2, policy, d.fixed_dr);");
+    emit(out, "    } else {");
+    emit(out, "      bytes.push(CONFIG_TAG_DR_POLICY, 1, policy);");
+    emit(out, "    }");
+    emit(out, "  }");
+    emit(out, "  return { bytes: bytes, fPort: REMOTE_CONFIG_FPORT };");
+    emit(out, "}");
 }
 
 /**
- * @brief Imprime el código para decodificar presión
+ * @brief Genera decodeUplink(): trama simple o por lotes según el FPort
  */
-static void print_pressure_decoder() {
-    Serial.println(F("  // Byte 9-10: Presión atmosférica BME280 (hPa * 10) - Little-endian"));
-    Serial.println(F("  var pressure_raw = bytes[offset++] | (bytes[offset++] << 8);"));
-    Serial.println(F("  data.pressure = pressure_raw / 10.0;"));
-    Serial.println(F(""));
+static void emit_uplink_decoder(decoder_output_t* out) {
+    emit(out, "function decodeUplink(input) {");
+    emit(out, "  var bytes = input.bytes;");
+    emit(out, "");
+    emit(out, "  // Trama por lotes: N, registros pendientes, intervalo (s), N registros");
+    emit(out, "  if (input.fPort === BATCH_FPORT) {");
+    emit(out, "    if (bytes.length < %d) {", BATCH_HEADER_SIZE);
+    emit(out, "      return { errors: ['Batch frame too short: ' + bytes.length + ' bytes'] };");
+    emit(out, "    }");
+    emit(out, "    var count = bytes[0];");
+    emit(out, "    var pending = bytes[1];");
+    emit(out, "    var interval = bytes[2] | (bytes[3] << 8);");
+    emit(out, "    var r = { bytes: bytes, pos: %d };", BATCH_HEADER_SIZE * 8);
+    emit(out, "    var records = [];");
+    emit(out, "    var prev = null;");
+    emit(out, "    for (var i = 0; i < count; i++) {");
+    emit(out, "      var record = decodeRecord(r, prev);");
+    emit(out, "      record.data.age_seconds = (count - 1 - i + pending) * interval;");
+    emit(out, "      records.push(record.data);");
+    emit(out, "      prev = record.codes;");
+    emit(out, "    }");
+    emit(out, "    if (r.pos > bytes.length * 8) {");
+    emit(out, "      return { errors: ['Batch frame truncated: ' + bytes.length + ' bytes for ' + count + ' records'] };");
+    emit(out, "    }");
+    emit(out, "    return { data: { records: records, interval_seconds: interval } };");
+    emit(out, "  }");
+    emit(out, "");
+    emit(out, "  // Resumen del perfil de fases: versión, N, ciclos, N x (fase, media ms, máx ms, µAh)");
+    emit(out, "  if (input.fPort === PROFILER_FPORT) {");
+    emit(out, "    if (bytes.length < 4 || bytes[0] !== %d) {", PROFILER_REPORT_VERSION);
+    emit(out, "      return { errors: ['Unsupported profiler report'] };");
+    emit(out, "    }");
+    emit(out, "    var phases = {};");
+    emit(out, "    for (var p = 0, o = 4; p < bytes[1] && o + 7 <= bytes.length; p++, o += 7) {");
+    emit(out, "      phases[PROFILER_PHASES[bytes[o]] || ('phase' + bytes[o])] = {");
+    emit(out, "        avg_ms: bytes[o + 1] | (bytes[o + 2] << 8),");
+    emit(out, "        max_ms: bytes[o + 3] | (bytes[o + 4] << 8),");
+    emit(out, "        avg_uah: bytes[o + 5] | (bytes[o + 6] << 8)");
+    emit(out, "      };");
+    emit(out, "    }");
+    emit(out, "    return { data: { cycles: bytes[2] | (bytes[3] << 8), phases: phases } };");
+    emit(out, "  }");
+    emit(out, "");
+    emit(out, "  // Aviso de hibernación: versión, SoC %%, mV, horas de respaldo, µA de la última hibernación");
+    emit(out, "  if (input.fPort === HIBERNATE_FPORT) {");
+    emit(out, "    if (bytes.length < %d || bytes[0] !== %d) {", HIBERNATE_NOTICE_SIZE, HIBERNATE_NOTICE_VERSION);
+    emit(out, "      return { errors: ['Unsupported hibernation notice'] };");
+    emit(out, "    }");
+    emit(out, "    var ua = bytes[5] | (bytes[6] << 8);");
+    emit(out, "    return { data: {");
+    emit(out, "      hibernating: true,");
+    emit(out, "      battery_percent: bytes[1],");
+    emit(out, "      battery_mv: bytes[2] | (bytes[3] << 8),");
+    emit(out, "      wake_hours: bytes[4],");
+    emit(out, "      last_hibernation_ua: ua === %u ? null : ua", HIBERNATE_CURRENT_UNKNOWN);
+    emit(out, "    } };");
+    emit(out, "  }");
+    emit(out, "");
+    emit(out, "  // Confirmación de configuración: versión, secuencia, resultado, etiqueta rechazada, TLV vigentes");
+    emit(out, "  if (input.fPort === REMOTE_CONFIG_FPORT) {");
+    emit(out, "    if (bytes.length < 4 || bytes[0] !== %d) {", REMOTE_CONFIG_VERSION);
+    emit(out, "      return { errors: ['Unsupported config acknowledgement'] };");
+    emit(out, "    }");
+    emit(out, "    return { data: {");
+    emit(out, "      sequence: bytes[1],");
+    emit(out, "      status: CONFIG_STATUS[bytes[2]] || bytes[2],");
+    emit(out, "      rejected_tag: bytes[3],");
+    emit(out, "      config: decodeConfig(bytes, 4)");
+    emit(out, "    } };");
+    emit(out, "  }");
+    emit(out, "");
+    emit(out, "  // Trama de una sola muestra (registro completo)");
+    emit(out, "  if (bytes.length !== RECORD_SIZE) {");
+    emit(out, "    return {");
+    emit(out, "      data: {},");
+    emit(out, "      warnings: ['Payload size should be ' + RECORD_SIZE + ' bytes, got ' + bytes.length],");
+    emit(out, "      errors: []");
+    emit(out, "    };");
+    emit(out, "  }");
+    emit(out, "  return { data: decodeRecord({ bytes: bytes, pos: 0 }, null).data };");
+    emit(out, "}");
 }
 
 /**
- * @brief Imprime validación del tamaño del payload
+ * @brief Genera el decoder completo en el destino indicado
  */
-static void print_payload_validation() {
-    Serial.println(F("  // Validar tamaño del payload (12 bytes esperados)"));
-    Serial.println(F("  if (bytes.length !== 12) {"));
-    Serial.println(F("    return {"));
-    Serial.println(F("      data: data,"));
-    Serial.println(F("      warnings: ['Payload size should be 12 bytes, got ' + bytes.length],"));
-    Serial.println(F("      errors: []"));
-    Serial.println(F("    };"));
-    Serial.println(F("  }"));
+static void emit_decoder(decoder_output_t* out) {
+    emit_schema(out);
+    emit_record_decoder(out);
+    emit_config_codec(out);
+    emit_uplink_decoder(out);
+    emit_downlink_encoder(out);
+}
+
+/**
+ * @brief Imprime el header del decoder TTN
+ */
+static void print_decoder_header() {
+    Serial.println(F(""));
+    Serial.println(F("==================== DECODIFICADOR PAYLOAD TTN ===================="));
+    Serial.println(F(""));
+    Serial.println(F("// COPIA Y PEGA ESTE CÓDIGO EN TTN CONSOLE -> APPLICATIONS -> PAYLOAD FORMATTERS"));
+    Serial.println(F("// 1. Ve a tu aplicación en TTN Console"));
+    Serial.println(F("// 2. Ve a Payload formatters -> Uplink"));
+    Serial.println(F("// 3. Selecciona 'Custom Javascript formatter'"));
+    Serial.println(F("// 4. Pega el código siguiente en el campo 'Formatter code'"));
+    Serial.println(F("// 5. Haz clic en 'Save changes'"));
+    Serial.println(F("// El mismo código sirve en Payload formatters -> Downlink (encodeDownlink)"));
     Serial.println(F(""));
 }
 
@@ -125,8 +329,6 @@ static void print_payload_validation() {
  * @brief Imprime el footer del decoder TTN
  */
 static void print_decoder_footer() {
-    Serial.println(F("  return { data: data };"));
-    Serial.println(F("}"));
     Serial.println(F(""));
     Serial.println(F("==================== FIN DEL DECODIFICADOR ===================="));
     Serial.println(F(""));
@@ -140,30 +342,27 @@ static void print_configuration_info() {
     Serial.println(F("=== CONFIGURACIÓN BOYA MARÍTIMA V2 ==="));
 
     Serial.println(F("Sensores activos:"));
-#ifdef ENABLE_SENSOR_BME280
-    Serial.println(F("  ✓ BME280 (Temperatura exterior, Humedad, Presión)"));
-#endif
-#ifdef ENABLE_SENSOR_DS18B20
-    Serial.println(F("  ✓ DS18B20 (Temperatura agua 1m)"));
-#endif
-#ifdef ENABLE_SENSOR_PH
-    Serial.println(F("  ✓ DFRobot pH (pH del agua)"));
-#endif
+    for (uint8_t i = 0; i < sensors_driver_count(); i++) {
+        const sensor_driver_t* driver = sensors_driver(i);
+        Serial.printf("  ✓ %s (%s)\r\n", driver->name, driver->description);
+    }
 
     Serial.println(F(""));
 
-    // Calcular tamaño del payload
-    uint8_t payload_size = PAYLOAD_SIZE_BYTES;
-    Serial.printf("Tamaño del payload: %d bytes\r\n", payload_size);
-
     // Información sobre estructura del payload
-    Serial.println(F("Estructura del payload (12 bytes):"));
-    Serial.println(F("  Byte 0:      Batería (%)"));
-    Serial.println(F("  Byte 1-2:    pH (x100) - Little-endian"));
-    Serial.println(F("  Byte 3-4:    Temperatura exterior (x100) - Little-endian"));
-    Serial.println(F("  Byte 5-6:    Temperatura agua 1m (x100) - Little-endian"));
-    Serial.println(F("  Byte 7-8:    Humedad (x100) - Little-endian"));
-    Serial.println(F("  Byte 9-10:   Presión (x10) - Little-endian"));
+    Serial.printf("Tamaño del payload: %u bytes\r\n", payload_codec_record_size());
+    Serial.println(F("Estructura del payload (bits, MSB primero):"));
+    for (uint8_t i = 0; i < payload_codec_field_count(); i++) {
+        const payload_field_t* field = payload_codec_field(i);
+        Serial.printf("  %-22s %2u bits  [%g, %g] x%g\r\n", field->name,
+                      payload_codec_field_bits(field), field->min, field->max, field->scale);
+    }
+
+    if (batch_samples_per_uplink() > 1) {
+        Serial.printf("Muestreo por lotes: %u muestras por envío (FPort %d)\r\n",
+                      batch_samples_per_uplink(), BATCH_FPORT);
+    }
+    Serial.printf("Configuración remota por FPort %d (encodeDownlink)\r\n", REMOTE_CONFIG_FPORT);
 
     Serial.println(F(""));
 }
@@ -180,31 +379,18 @@ void generate_and_print_ttn_decoder() {
         return; // No mostrar si no está habilitado
     }
 
+    // Solo al encender: en los despertares por temporizador no cambia
+    if (isFastBoot()) {
+        return;
+    }
+
+    // Volcado directo por Serial: sacar antes los logs pendientes
+    logger_flush();
     print_configuration_info();
     print_decoder_header();
-    print_payload_validation();
-
-    // Generar el código de decodificación para Boya Marítima V2
-    // Payload: Battery(1) + pH(2) + TempExt(2) + Temp1m(2) + Humidity(2) + Pressure(2) = 12 bytes
-    
-    print_battery_percent_decoder();
-    
-#ifdef ENABLE_SENSOR_PH
-    print_ph_decoder();
-#endif
 
-#ifdef ENABLE_SENSOR_BME280
-    print_temperature_ext_decoder();
-#endif
-
-#ifdef ENABLE_SENSOR_DS18B20
-    print_temperature_water_decoder();
-#endif
-
-#ifdef ENABLE_SENSOR_BME280
-    print_humidity_decoder();
-    print_pressure_decoder();
-#endif
+    decoder_output_t out = { NULL, 0, 0 };
+    emit_decoder(&out);
 
     print_decoder_footer();
 }
@@ -219,56 +405,9 @@ void generate_and_print_ttn_decoder() {
 uint16_t generate_ttn_decoder_string(char* buffer, uint16_t max_size) {
     if (!buffer || max_size < 100) return 0;
 
-    uint16_t offset = 0;
-
-    // Header
-    offset += snprintf(buffer + offset, max_size - offset,
-        "function decodeUplink(input) {\n"
-        "  var data = {};\n"
-        "  var bytes = input.bytes;\n"
-        "  var offset = 0;\n\n"
-        "  if (bytes.length !== 12) {\n"
-        "    return { data: data, warnings: ['Payload size should be 12 bytes'], errors: [] };\n"
-        "  }\n\n");
-
-    // Batería
-    offset += snprintf(buffer + offset, max_size - offset,
-        "  data.battery_percent = bytes[offset++];\n");
-
-    // pH
-#ifdef ENABLE_SENSOR_PH
-    offset += snprintf(buffer + offset, max_size - offset,
-        "  var ph_raw = bytes[offset++] | (bytes[offset++] << 8);\n"
-        "  data.ph = ph_raw / 100.0;\n");
-#endif
-
-    // Temperatura exterior BME280
-#ifdef ENABLE_SENSOR_BME280
-    offset += snprintf(buffer + offset, max_size - offset,
-        "  var temp_ext_raw = bytes[offset++] | (bytes[offset++] << 8);\n"
-        "  data.temperature_ext = temp_ext_raw / 100.0;\n");
-#endif
-
-    // Temperatura agua DS18B20
-#ifdef ENABLE_SENSOR_DS18B20
-    offset += snprintf(buffer + offset, max_size - offset,
-        "  var temp_water_raw = bytes[offset++] | (bytes[offset++] << 8);\n"
-        "  data.temperature_water_1m = temp_water_raw / 100.0;\n");
-#endif
+    decoder_output_t out = { buffer, max_size, 0 };
+    buffer[0] = '\0';
+    emit_decoder(&out);
 
-    // Humedad y presión BME280
-#ifdef ENABLE_SENSOR_BME280
-    offset += snprintf(buffer + offset, max_size - offset,
-        "  var humidity_raw = bytes[offset++] | (bytes[offset++] << 8);\n"
-        "  data.humidity = humidity_raw / 100.0;\n"
-        "  var pressure_raw = bytes[offset++] | (bytes[offset++] << 8);\n"
-        "  data.pressure = pressure_raw / 10.0;\n");
-#endif
-
-    // Footer
-    offset += snprintf(buffer + offset, max_size - offset,
-        "\n  return { data: data, warnings: [], errors: [] };\n"
-        "}\n");
-
-    return offset;
-}
\ No newline at end of file
+    return out.offset;
+}
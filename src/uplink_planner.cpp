@@ -0,0 +1,236 @@
+/**
+ * @file      uplink_planner.cpp
+ * @brief     Planificador de uplinks: tiempo en el aire y duty cycle (EU868)
+ *
+ * La ventana móvil se guarda en memoria RTC como PLANNER_BUCKETS cubos de
+ * UPLINK_PLANNER_WINDOW_SECONDS / (PLANNER_BUCKETS - 1) segundos: la suma
+ * de todos cubre siempre al menos una ventana completa, así que el
+ * presupuesto nunca cuenta de menos. Ver uplink_planner.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include "../config/config.h"  // Configuración unificada del proyecto
+#include <lmic.h>
+#include "uplink_planner.h"
+#include "LoRaBoards.h"         // Arduino y memoria RTC
+#include "scheduler.h"          // Reloj que sobrevive al sueño profundo
+#include "logger.h"             // Logs diferidos por Serial
+
+// Identificación del estado en memoria RTC
+#define PLANNER_MAGIC 0x55504C31UL  // "UPL1"
+
+#define PLANNER_BUCKETS 13
+#define PLANNER_BUCKET_SECONDS (UPLINK_PLANNER_WINDOW_SECONDS / (PLANNER_BUCKETS - 1))
+
+// Tiempo en el aire permitido en la ventana
+#define PLANNER_BUDGET_US ((uint32_t)((uint64_t)UPLINK_PLANNER_WINDOW_SECONDS * 1000000ULL * \
+                                      SCHEDULER_DUTY_CYCLE_PERCENT / 100))
+
+static_assert(PLANNER_BUCKET_SECONDS > 0, "UPLINK_PLANNER_WINDOW_SECONDS demasiado corta");
+
+/**
+ * @brief Ventana móvil de tiempo en el aire guardada en memoria RTC
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t bucket_start_s;              /**< Reloj al inicio del cubo actual */
+    uint32_t bucket_us[PLANNER_BUCKETS];  /**< Tiempo en el aire por cubo */
+    uint8_t  head;                        /**< Cubo actual */
+    uint32_t uplinks;                     /**< Uplinks desde el encendido */
+    uint32_t total_ms;                    /**< Tiempo en el aire desde el encendido */
+} planner_rtc_t;
+
+static RTC_DATA_ATTR planner_rtc_t rtc_planner;
+
+/**
+ * @brief Inicializa la ventana al encender y descarta los cubos caducados
+ */
+static void planner_advance(void) {
+    uint32_t now = scheduler_clock_s();
+
+    if (rtc_planner.magic != PLANNER_MAGIC) {
+        memset(&rtc_planner, 0, sizeof(rtc_planner));
+        rtc_planner.magic = PLANNER_MAGIC;
+        rtc_planner.bucket_start_s = now;
+        return;
+    }
+
+    // Un sueño más largo que la ventana la vacía entera
+    if (now - rtc_planner.bucket_start_s >= (uint32_t)PLANNER_BUCKETS * PLANNER_BUCKET_SECONDS) {
+        memset(rtc_planner.bucket_us, 0, sizeof(rtc_planner.bucket_us));
+        rtc_planner.bucket_start_s = now;
+        return;
+    }
+    while (now - rtc_planner.bucket_start_s >= PLANNER_BUCKET_SECONDS) {
+        rtc_planner.head = (rtc_planner.head + 1) % PLANNER_BUCKETS;
+        rtc_planner.bucket_us[rtc_planner.head] = 0;
+        rtc_planner.bucket_start_s += PLANNER_BUCKET_SECONDS;
+    }
+}
+
+/**
+ * @brief Tiempo en el aire de la ventana
+ */
+static uint32_t planner_used_us(void) {
+    planner_advance();
+    uint32_t used = 0;
+    for (uint8_t i = 0; i < PLANNER_BUCKETS; i++) {
+        used += rtc_planner.bucket_us[i];
+    }
+    return used;
+}
+
+/**
+ * @brief Bytes de FOpts que LMIC añadirá al próximo uplink
+ */
+uint8_t uplink_planner_fopts_size(void) {
+    uint8_t size = 0;
+#if !defined(DISABLE_PING)
+    if ((LMIC.opmode & (OP_TRACK | OP_PINGABLE)) == (OP_TRACK | OP_PINGABLE)) size += 2;  // PingSlotInfoReq
+#endif
+#if !defined(DISABLE_MCMD_DCAP_REQ)
+    if (LMIC.dutyCapAns) size += 1;   // DutyCycleAns
+#endif
+#if !defined(DISABLE_MCMD_DN2P_SET)
+    if (LMIC.dn2Ans) size += 2;       // RXParamSetupAns
+#endif
+    if (LMIC.devsAns) size += 3;      // DevStatusAns
+    if (LMIC.ladrAns) size += 2;      // LinkADRAns
+    if (LMIC.lchkReq) size += 1;      // LinkCheckReq
+#if !defined(DISABLE_BEACONS)
+    if (LMIC.bcninfoTries > 0) size += 1;  // BeaconInfoReq
+#endif
+#if !defined(DISABLE_MCMD_PING_SET) && !defined(DISABLE_PING)
+    if (LMIC.pingSetAns != 0) size += 2;   // PingSlotChannelAns
+#endif
+#if !defined(DISABLE_MCMD_SNCH_REQ)
+    if (LMIC.snchAns) size += 2;      // NewChannelAns
+#endif
+    return size;
+}
+
+/**
+ * @brief Tiempo en el aire de un uplink
+ */
+uint32_t uplink_planner_airtime_us(uint8_t datarate, uint8_t payload_size) {
+    uint16_t frame = payload_size + UPLINK_PLANNER_OVERHEAD + uplink_planner_fopts_size();
+    if (frame > 255) frame = 255;
+    return osticks2us(calcAirTime(updr2rps(datarate), (u1_t)frame));
+}
+
+/**
+ * @brief Espera hasta que una banda admite otra transmisión
+ */
+uint32_t uplink_planner_band_wait_ms(uint8_t band) {
+    if (band >= MAX_BANDS) return UPLINK_PLANNER_NEVER;
+
+    ostime_t avail = LMIC.bands[band].avail;
+    if (LMIC.globalDutyRate != 0 && LMIC.globalDutyAvail - avail > 0) {
+        avail = LMIC.globalDutyAvail;
+    }
+    ostime_t wait = avail - os_getTime();
+    return wait > 0 ? (uint32_t)osticks2ms(wait) : 0;
+}
+
+/**
+ * @brief Espera hasta que un canal admite otra transmisión
+ */
+uint32_t uplink_planner_channel_wait_ms(uint8_t channel) {
+    if (channel >= MAX_CHANNELS || (LMIC.channelMap & (1 << channel)) == 0) {
+        return UPLINK_PLANNER_NEVER;
+    }
+    // Los dos bits bajos de la frecuencia guardan la banda (ver LMIC_setupChannel())
+    return uplink_planner_band_wait_ms(LMIC.channelFreq[channel] & 0x3);
+}
+
+/**
+ * @brief Primer instante legal para transmitir a un DR
+ */
+uint32_t uplink_planner_next_tx_ms(uint8_t datarate) {
+    uint32_t best = UPLINK_PLANNER_NEVER;
+    for (uint8_t ch = 0; ch < MAX_CHANNELS; ch++) {
+        if ((LMIC.channelDrMap[ch] & (1 << (datarate & 0xF))) == 0) continue;
+        uint32_t wait = uplink_planner_channel_wait_ms(ch);
+        if (wait < best) best = wait;
+    }
+    return best;
+}
+
+/**
+ * @brief Tiempo en el aire disponible en la ventana móvil
+ */
+uint32_t uplink_planner_budget_left_us(void) {
+    uint32_t used = planner_used_us();
+    return used < PLANNER_BUDGET_US ? PLANNER_BUDGET_US - used : 0;
+}
+
+/**
+ * @brief Payload más grande que cabe en el presupuesto a un DR
+ */
+uint8_t uplink_planner_fit_payload(uint8_t datarate, uint8_t max_size) {
+    uint32_t left = uplink_planner_budget_left_us();
+    if (uplink_planner_airtime_us(datarate, max_size) <= left) return max_size;
+    if (uplink_planner_airtime_us(datarate, 0) > left) return 0;
+
+    // El tiempo en el aire crece con el tamaño: búsqueda binaria
+    uint8_t lo = 0, hi = max_size;  // lo cabe, hi no
+    while (hi - lo > 1) {
+        uint8_t mid = lo + (hi - lo) / 2;
+        if (uplink_planner_airtime_us(datarate, mid) <= left) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief DR con el que el uplink cabe en el presupuesto
+ */
+uint8_t uplink_planner_fit_datarate(uint8_t datarate, uint8_t payload_size) {
+    uint32_t left = uplink_planner_budget_left_us();
+    if (uplink_planner_airtime_us(datarate, payload_size) <= left) return datarate;
+
+#if UPLINK_PLANNER_ADAPT_DR
+    for (uint8_t dr = datarate + 1; dr <= DR_SF7; dr++) {
+        if (uplink_planner_airtime_us(dr, payload_size) <= left) return dr;
+    }
+#endif
+    return DR_NONE;
+}
+
+/**
+ * @brief Anota un uplink en el presupuesto
+ */
+void uplink_planner_record(uint32_t airtime_us) {
+    planner_advance();
+    rtc_planner.bucket_us[rtc_planner.head] += airtime_us;
+    rtc_planner.uplinks++;
+    rtc_planner.total_ms += (airtime_us + 500) / 1000;
+}
+
+/**
+ * @brief Imprime el tiempo en el aire por DR, la espera por banda y el presupuesto
+ */
+void uplink_planner_log(uint8_t payload_size) {
+    uint32_t left = uplink_planner_budget_left_us();
+    LOG_INFO("Uplink: %u bytes a DR%u = %lu ms en el aire, presupuesto %lu/%lu ms, canal libre en %lu ms\n",
+             payload_size, LMIC.datarate,
+             (unsigned long)(uplink_planner_airtime_us(LMIC.datarate, payload_size) / 1000),
+             (unsigned long)(left / 1000), (unsigned long)(PLANNER_BUDGET_US / 1000),
+             (unsigned long)uplink_planner_next_tx_ms(LMIC.datarate));
+
+    for (uint8_t dr = DR_SF12; dr <= DR_SF7; dr++) {
+        LOG_DEBUG("  DR%u (SF%u): %lu ms\n", dr, 12 - dr,
+                  (unsigned long)(uplink_planner_airtime_us(dr, payload_size) / 1000));
+    }
+    for (uint8_t band = 0; band < MAX_BANDS; band++) {
+        LOG_DEBUG("  Banda %u: libre en %lu ms\n", band, (unsigned long)uplink_planner_band_wait_ms(band));
+    }
+    LOG_DEBUG("  Desde el encendido: %lu uplinks, %lu ms en el aire\n",
+              (unsigned long)rtc_planner.uplinks, (unsigned long)rtc_planner.total_ms);
+}
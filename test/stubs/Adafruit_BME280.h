@@ -0,0 +1,123 @@
+/**
+ * @file      Adafruit_BME280.h
+ * @brief     Adafruit_BME280 sobre un banco de registros simulado
+ *
+ * Solo lo que usa src/sensor/sensor_bme280.cpp: begin() copia la calibración
+ * de stub_bme280_calib, write8()/read8() y la ráfaga de I2C leen y escriben
+ * stub_bme280_regs. La prueba carga ahí los registros de datos 0xF7-0xFE
+ * grabados y lee el resultado por la ruta real del driver.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef STUB_ADAFRUIT_BME280_H
+#define STUB_ADAFRUIT_BME280_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+enum {
+    BME280_REGISTER_STATUS = 0xF3,
+    BME280_REGISTER_CONTROL = 0xF4,
+    BME280_REGISTER_PRESSUREDATA = 0xF7,
+};
+
+typedef struct {
+    uint16_t dig_T1;
+    int16_t dig_T2;
+    int16_t dig_T3;
+
+    uint16_t dig_P1;
+    int16_t dig_P2;
+    int16_t dig_P3;
+    int16_t dig_P4;
+    int16_t dig_P5;
+    int16_t dig_P6;
+    int16_t dig_P7;
+    int16_t dig_P8;
+    int16_t dig_P9;
+
+    uint8_t dig_H1;
+    int16_t dig_H2;
+    uint8_t dig_H3;
+    int16_t dig_H4;
+    int16_t dig_H5;
+    int8_t dig_H6;
+} bme280_calib_data;
+
+/// Registros del sensor simulado
+inline uint8_t stub_bme280_regs[256];
+
+/// Calibración que devuelve begin()
+inline bme280_calib_data stub_bme280_calib;
+
+/// Dirección en la que responde el sensor (0: ninguna)
+inline uint8_t stub_bme280_address = 0x76;
+
+/**
+ * @brief Transacción de lectura de Adafruit_BusIO sobre stub_bme280_regs
+ */
+class Adafruit_I2CDevice {
+public:
+    bool write_then_read(const uint8_t* write, size_t write_len, uint8_t* read, size_t read_len) {
+        if (write_len != 1) return false;
+        for (size_t i = 0; i < read_len; i++) read[i] = stub_bme280_regs[(uint8_t)(write[0] + i)];
+        return true;
+    }
+};
+
+class Adafruit_BME280 {
+public:
+    enum sensor_sampling {
+        SAMPLING_NONE = 0b000,
+        SAMPLING_X1 = 0b001,
+        SAMPLING_X2 = 0b010,
+        SAMPLING_X4 = 0b011,
+        SAMPLING_X8 = 0b100,
+        SAMPLING_X16 = 0b101
+    };
+    enum sensor_mode { MODE_SLEEP = 0b00, MODE_FORCED = 0b01, MODE_NORMAL = 0b11 };
+    enum sensor_filter { FILTER_OFF = 0b000 };
+    enum standby_duration { STANDBY_MS_1000 = 0b101 };
+
+    bool begin(uint8_t addr, TwoWire* wire) {
+        (void)wire;
+        if (addr != stub_bme280_address) return false;
+        i2c_dev = &stub_i2c;
+        _bme280_calib = stub_bme280_calib;
+        return true;
+    }
+
+    void setSampling(sensor_mode mode, sensor_sampling temp, sensor_sampling press, sensor_sampling hum,
+                     sensor_filter filter, standby_duration duration) {
+        (void)filter;
+        (void)duration;
+        _measReg.osrs_t = temp;
+        _measReg.osrs_p = press;
+        _measReg.mode = mode;
+        write8(0xF2, hum);
+        write8(BME280_REGISTER_CONTROL, _measReg.get());
+    }
+
+protected:
+    void write8(byte reg, byte value) { stub_bme280_regs[reg] = value; }
+    uint8_t read8(byte reg) { return stub_bme280_regs[reg]; }
+
+    struct ctrl_meas {
+        unsigned int osrs_t : 3;
+        unsigned int osrs_p : 3;
+        unsigned int mode : 2;
+        unsigned int get() { return (osrs_t << 5) | (osrs_p << 2) | mode; }
+    };
+
+    Adafruit_I2CDevice* i2c_dev = NULL;
+    bme280_calib_data _bme280_calib;
+    ctrl_meas _measReg;
+
+private:
+    Adafruit_I2CDevice stub_i2c;
+};
+
+#endif // STUB_ADAFRUIT_BME280_H
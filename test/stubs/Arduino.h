@@ -0,0 +1,55 @@
+/**
+ * @file      Arduino.h
+ * @brief     Arduino mínimo para compilar los módulos en el host (env:native)
+ *
+ * Solo lo que usan los módulos que se prueban fuera de la placa. El reloj es
+ * una variable que cada prueba avanza a mano.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef STUB_ARDUINO_H
+#define STUB_ARDUINO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Sin secciones de memoria RTC ni flash en el host
+#define RTC_DATA_ATTR
+#define PROGMEM
+#define memcpy_P memcpy
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0x01
+#define OUTPUT 0x03
+
+typedef uint8_t byte;
+
+/// Milisegundos desde el arranque simulado
+inline uint32_t stub_millis = 0;
+
+inline unsigned long millis(void) { return stub_millis; }
+inline unsigned long micros(void) { return stub_millis * 1000UL; }
+inline void delay(uint32_t ms) { stub_millis += ms; }
+inline void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+
+// Consola: las pruebas no leen la salida por Serial
+#define F(s) (s)
+
+struct StubSerial {
+    void println(const char* line = "") { (void)line; }
+    int printf(const char* format, ...) { (void)format; return 0; }
+};
+
+inline StubSerial Serial;
+
+#endif // STUB_ARDUINO_H
@@ -0,0 +1,25 @@
+/**
+ * @file      LoRaBoards.h
+ * @brief     Sustituto de include/LoRaBoards.h para las pruebas en el host
+ *
+ * Los módulos lo incluyen por Arduino, los pines y la memoria RTC; el PMU,
+ * la pantalla y los buses no existen fuera de la placa. test/stubs va antes
+ * que include/ en las rutas de búsqueda para que se use este.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef STUB_LORABOARDS_H
+#define STUB_LORABOARDS_H
+
+#include <Arduino.h>
+#include "hardware_config.h"
+
+// Funciones de LoRaBoards.cpp: las define la prueba que las necesita
+uint8_t batteryPercentFromMillivolts(uint16_t millivolts);
+bool isFastBoot();
+bool i2cDeviceCached(uint8_t addr);
+
+#endif // STUB_LORABOARDS_H
@@ -0,0 +1,49 @@
+/**
+ * @file      Preferences.h
+ * @brief     NVS en memoria para las pruebas en el host
+ *
+ * Un único blob por clave, compartido por todos los espacios de nombres.
+ * stub_nvs_writes cuenta las escrituras para comprobar que no se reescribe
+ * NVS sin cambios.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef STUB_PREFERENCES_H
+#define STUB_PREFERENCES_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <string.h>
+
+/// Contenido de la NVS simulada
+inline std::map<std::string, std::vector<uint8_t>> stub_nvs;
+
+/// Escrituras desde el arranque de la prueba
+inline unsigned stub_nvs_writes = 0;
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) { (void)name; (void)readOnly; return true; }
+    void end() {}
+
+    size_t getBytes(const char* key, void* buffer, size_t len) {
+        auto it = stub_nvs.find(key);
+        if (it == stub_nvs.end() || it->second.size() > len) return 0;
+        memcpy(buffer, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putBytes(const char* key, const void* buffer, size_t len) {
+        const uint8_t* bytes = (const uint8_t*)buffer;
+        stub_nvs[key].assign(bytes, bytes + len);
+        stub_nvs_writes++;
+        return len;
+    }
+};
+
+#endif // STUB_PREFERENCES_H
@@ -0,0 +1,26 @@
+/**
+ * @file      Wire.h
+ * @brief     Bus I2C vacío para las pruebas en el host
+ *
+ * Ningún dispositivo responde al escaneo del bus; los sensores que se
+ * prueban simulan sus registros en su propio sustituto.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef STUB_WIRE_H
+#define STUB_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    void beginTransmission(uint8_t address) { (void)address; }
+    uint8_t endTransmission(void) { return 2; }  // NACK en la dirección
+};
+
+inline TwoWire Wire;
+
+#endif // STUB_WIRE_H
@@ -0,0 +1,75 @@
+/**
+ * @file      lmic_host.h
+ * @brief     Lo que los módulos usan de lmic.c, para las pruebas en el host
+ *
+ * Las pruebas usan las cabeceras reales de LMIC pero no enlazan la
+ * librería: aquí se definen el estado global LMIC, la tabla de DR de EU868,
+ * el reloj de LMIC (stub_os_ticks, que avanza cada prueba) y calcAirTime()
+ * con la fórmula de la hoja de datos del SX1276.
+ *
+ * Contiene definiciones: incluir en una sola unidad de compilación de cada
+ * prueba.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef STUB_LMIC_HOST_H
+#define STUB_LMIC_HOST_H
+
+#include <lmic.h>
+#include <math.h>
+
+/// Reloj de LMIC en ticks
+inline ostime_t stub_os_ticks = 0;
+
+extern "C" {
+
+struct lmic_t LMIC;
+
+// EU868, igual que lmic.c
+CONST_TABLE(u1_t, _DR2RPS_CRC)[] = {
+    ILLEGAL_RPS,
+    (u1_t)MAKERPS(SF12, BW125, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(SF11, BW125, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(SF10, BW125, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(SF9,  BW125, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(SF8,  BW125, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(SF7,  BW125, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(SF7,  BW250, CR_4_5, 0, 0),
+    (u1_t)MAKERPS(FSK,  BW125, CR_4_5, 0, 0),
+    ILLEGAL_RPS
+};
+
+ostime_t os_getTime(void) {
+    return stub_os_ticks;
+}
+
+/**
+ * @brief Tiempo en el aire LoRa (SX1276, apartado 4.1.1.7)
+ *
+ * Preámbulo de 8 símbolos, cabecera explícita, CRC y optimización de baja
+ * tasa con SF11/SF12 a 125 kHz. FSK a 50 kbps.
+ */
+ostime_t calcAirTime(rps_t rps, u1_t plen) {
+    double us;
+    if (getSf(rps) == FSK) {
+        // Preámbulo (5), sincronía (3), longitud (1), payload y CRC (2)
+        us = (plen + 5 + 3 + 1 + 2) * 8 * 1e6 / 50000;
+    } else {
+        int sf = 6 + getSf(rps);
+        double bw = 125e3 * (1 << getBw(rps));
+        double tsym = (1 << sf) / bw * 1e6;
+        int de = (sf >= 11 && getBw(rps) == BW125) ? 1 : 0;
+        int cr = getCr(rps) + 1;
+        double n = ceil((8.0 * plen - 4 * sf + 28 + 16) / (4.0 * (sf - 2 * de)));
+        double symbols = 8 + (n > 0 ? n * (cr + 4) : 0);
+        us = (8 + 4.25 + symbols) * tsym;
+    }
+    return (ostime_t)lround(us / US_PER_OSTICK);
+}
+
+}  // extern "C"
+
+#endif // STUB_LMIC_HOST_H
@@ -0,0 +1,20 @@
+/**
+ * @file      aes_backend.c
+ * @brief     AES software de LMIC compilado para el host
+ *
+ * En la placa el backend sale de la librería LMIC-Arduino; en el host se
+ * compilan aquí aes/other.c (CMAC y CTR) y os_rmsbf4(), que vive en
+ * lmic.c junto con todo el MAC.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef ARDUINO
+#include "../../lib/LMIC-Arduino/src/aes/other.c"
+
+u4_t os_rmsbf4 (xref2cu1_t buf) {
+    return (u4_t)((u4_t)buf[3] | ((u4_t)buf[2]<<8) | ((u4_t)buf[1]<<16) | ((u4_t)buf[0]<<24));
+}
+#endif
@@ -0,0 +1,12 @@
+/**
+ * @file      aes_ideetron.cpp
+ * @brief     Cifrado de bloque de Ideetron compilado para el host
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#ifndef ARDUINO
+#include "../../lib/LMIC-Arduino/src/aes/ideetron/AES-128_V10.cpp"
+#endif
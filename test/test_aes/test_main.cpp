@@ -0,0 +1,353 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Vectores de prueba del AES de LMIC: bloque AES-128, CMAC
+ *            (RFC 4493) y las operaciones de LoRaWAN 1.0
+ *
+ * Las operaciones LoRaWAN se hacen con os_aes() y los mismos bloques
+ * AESkey/AESaux que prepara lmic.c (aes_appendMic0(), aes_verifyMic(),
+ * aes_cipher(), aes_sessKeys()). Los valores esperados de LoRaWAN se
+ * calcularon aparte con OpenSSL (AES-128-ECB y CMAC) para estas claves.
+ *
+ * - Host (pio test -e native): backend software por defecto (Ideetron)
+ * - Placa (pio test -e T3_V1_6_SX1276 -f test_aes): el backend configurado;
+ *   con -e T3_V1_6_SX1276_hw_aes, el AES por hardware (aes/esp32/esp32-aes.cpp).
+ *   Además mide los ciclos de CPU de una trama de datos de 51 bytes y de un
+ *   join-accept, para comparar los dos entornos
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <lmic.h>
+#include <hal/hal.h>
+#else
+#include "../../lib/LMIC-Arduino/src/lmic/oslmic.h"
+#endif
+
+// =============================================================================
+// VECTORES
+// =============================================================================
+
+// FIPS-197, apéndice C.1
+static const u1_t FIPS_KEY[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+};
+static const u1_t FIPS_PLAIN[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+static const u1_t FIPS_CIPHER[16] = {
+    0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+};
+
+// RFC 4493, sección 4: mensajes de 0, 16, 40 y 64 bytes
+static const u1_t CMAC_KEY[16] = {
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+static const u1_t CMAC_MSG[64] = {
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+    0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+    0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11, 0xE5, 0xFB, 0xC1, 0x19, 0x1A, 0x0A, 0x52, 0xEF,
+    0xF6, 0x9F, 0x24, 0x45, 0xDF, 0x4F, 0x9B, 0x17, 0xAD, 0x2B, 0x41, 0x7B, 0xE6, 0x6C, 0x37, 0x10
+};
+static const struct {
+    u1_t len;
+    u1_t mac[16];
+} CMAC_VECTORS[] = {
+    { 0,  { 0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46 } },
+    { 16, { 0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C } },
+    { 40, { 0xDF, 0xA6, 0x67, 0x47, 0xDE, 0x9A, 0xE6, 0x30, 0x30, 0xCA, 0x32, 0x61, 0x14, 0x97, 0xC8, 0x27 } },
+    { 64, { 0x51, 0xF0, 0xBE, 0xBF, 0x7E, 0x3B, 0x9D, 0x92, 0xFC, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3C, 0xFE } },
+};
+
+// LoRaWAN 1.0: claves y tramas de prueba
+static const u1_t APP_KEY[16] = {
+    0x8E, 0x8A, 0x0A, 0x61, 0xF6, 0xD1, 0xD4, 0x3C, 0x19, 0xF1, 0xB1, 0xC5, 0xF6, 0xB2, 0x0E, 0xE9
+};
+static const u1_t NWK_SKEY[16] = {
+    0x44, 0x02, 0x42, 0x41, 0xED, 0x4C, 0xE9, 0xA6, 0x8C, 0x6A, 0x8B, 0xC0, 0x55, 0x23, 0x3F, 0xD3
+};
+static const u1_t APP_SKEY[16] = {
+    0xEC, 0x92, 0x58, 0x02, 0xAE, 0x43, 0x0C, 0xA7, 0x7F, 0xD3, 0xDD, 0x73, 0xCB, 0x2C, 0xC5, 0x88
+};
+static const u4_t DEV_ADDR = 0x26011BDA;
+static const u4_t FCNT = 0x2A;
+
+// Join-request: MHDR, AppEUI y DevEUI (LSB primero), DevNonce
+static const u1_t JOIN_REQUEST[19] = {
+    0x00, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22,
+    0x11, 0x2A, 0x5C
+};
+static const u1_t JOIN_REQUEST_MIC[4] = { 0x61, 0x95, 0xA1, 0x9E };
+
+// Join-accept tal como llega (MHDR 0x20 y 16 bytes cifrados) y descifrado
+static const u1_t JOIN_ACCEPT_RX[17] = {
+    0x20, 0x27, 0xA9, 0xF8, 0x54, 0x4B, 0xC5, 0x10, 0x44, 0xDD, 0x77, 0xA9, 0x5A, 0x3E, 0x80, 0xAE,
+    0x8A
+};
+static const u1_t JOIN_ACCEPT_PLAIN[17] = {
+    0x20, 0xA1, 0xB2, 0xC3, 0x13, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x00, 0x01, 0x2C, 0x9A, 0x6F,
+    0x22
+};
+// Claves de sesión derivadas de AppNonce, NetID y DevNonce con la AppKey
+static const u1_t JOIN_NWK_SKEY[16] = {
+    0x60, 0xC6, 0xEE, 0xCF, 0x60, 0x73, 0x51, 0xC7, 0xF4, 0x79, 0x24, 0x65, 0xD3, 0x2B, 0xCC, 0x2D
+};
+static const u1_t JOIN_APP_SKEY[16] = {
+    0xE3, 0x2A, 0x0F, 0xF8, 0xC8, 0x7B, 0x52, 0x37, 0xF1, 0x17, 0x1C, 0xE7, 0x3B, 0xA1, 0x55, 0x19
+};
+
+// Uplink sin confirmar por el FPort 1: FRMPayload en claro, trama cifrada y MIC
+static const u1_t UPLINK_PAYLOAD[35] = {
+    0x48, 0x6F, 0x6C, 0x61, 0x20, 0x62, 0x6F, 0x79, 0x61, 0x20, 0x4C, 0x6F, 0x52, 0x61, 0x57, 0x41,
+    0x4E, 0x20, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x30, 0x61, 0x62, 0x63, 0x64,
+    0x65, 0x66, 0x21
+};
+static const u1_t UPLINK_FRAME[44] = {
+    0x40, 0xDA, 0x1B, 0x01, 0x26, 0x00, 0x2A, 0x00, 0x01, 0x02, 0x5F, 0xE1, 0x6F, 0x96, 0xD7, 0xA5,
+    0x2D, 0x66, 0xA1, 0x09, 0xBE, 0x92, 0x3B, 0xAC, 0xB0, 0x7E, 0x95, 0x0F, 0xD2, 0xC5, 0x26, 0x64,
+    0xCB, 0x45, 0x8C, 0x21, 0x86, 0x7B, 0x30, 0x48, 0x7E, 0x55, 0xC2, 0x6E
+};
+static const u1_t UPLINK_MIC[4] = { 0x34, 0xFA, 0xEC, 0xD8 };
+
+// Longitud de la cabecera MAC del uplink (MHDR, FHDR sin FOpts, FPort)
+#define UPLINK_HDR_LEN 9
+
+// =============================================================================
+// OPERACIONES LORAWAN (mismos bloques que lmic.c)
+// =============================================================================
+
+static void write_lsbf4(u1_t* buf, u4_t v) {
+    buf[0] = v; buf[1] = v >> 8; buf[2] = v >> 16; buf[3] = v >> 24;
+}
+
+/**
+ * @brief Bloque B0 del MIC de una trama de datos (aes_micsub() de lmic.c)
+ */
+static void set_mic_block(u4_t devaddr, u4_t seqno, int dndir, u1_t len) {
+    memset(AESaux, 0, 16);
+    AESaux[0] = 0x49;
+    AESaux[5] = dndir ? 1 : 0;
+    AESaux[15] = len;
+    write_lsbf4(AESaux + 6, devaddr);
+    write_lsbf4(AESaux + 10, seqno);
+}
+
+/**
+ * @brief Cifra el FRMPayload en AES-CTR (aes_cipher() de lmic.c)
+ */
+static void frame_cipher(const u1_t* key, u4_t devaddr, u4_t seqno, int dndir, u1_t* payload, u1_t len) {
+    memset(AESaux, 0, 16);
+    AESaux[0] = AESaux[15] = 1;
+    AESaux[5] = dndir ? 1 : 0;
+    write_lsbf4(AESaux + 6, devaddr);
+    write_lsbf4(AESaux + 10, seqno);
+    memcpy(AESkey, key, 16);
+    os_aes(AES_CTR, payload, len);
+}
+
+/**
+ * @brief MIC de una trama de datos (aes_appendMic() de lmic.c)
+ */
+static u4_t frame_mic(const u1_t* key, u4_t devaddr, u4_t seqno, int dndir, u1_t* pdu, u1_t len) {
+    set_mic_block(devaddr, seqno, dndir, len);
+    memcpy(AESkey, key, 16);
+    return os_aes(AES_MIC, pdu, len);
+}
+
+/**
+ * @brief Procesa un join-accept de 17 bytes como processJoinAccept()
+ *
+ * @return true si el MIC es correcto
+ */
+static bool join_accept(u1_t* frame, u1_t* nwkskey, u1_t* appskey) {
+    memcpy(AESkey, APP_KEY, 16);
+    os_aes(AES_ENC, frame + 1, 16);
+    memcpy(AESkey, APP_KEY, 16);
+    u4_t mic = os_aes(AES_MIC | AES_MICNOAUX, frame, 13);
+    u4_t rx_mic = ((u4_t)frame[13] << 24) | ((u4_t)frame[14] << 16) | ((u4_t)frame[15] << 8) | frame[16];
+
+    // aes_sessKeys(): 0x01/0x02 | AppNonce | NetID | DevNonce | relleno
+    memset(nwkskey, 0, 16);
+    nwkskey[0] = 0x01;
+    memcpy(nwkskey + 1, frame + 1, 6);
+    memcpy(nwkskey + 7, JOIN_REQUEST + 17, 2);
+    memcpy(appskey, nwkskey, 16);
+    appskey[0] = 0x02;
+    memcpy(AESkey, APP_KEY, 16);
+    os_aes(AES_ENC, nwkskey, 16);
+    memcpy(AESkey, APP_KEY, 16);
+    os_aes(AES_ENC, appskey, 16);
+    return mic == rx_mic;
+}
+
+// =============================================================================
+// PRUEBAS
+// =============================================================================
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fips197_block(void) {
+    u1_t block[16];
+    memcpy(block, FIPS_PLAIN, 16);
+    memcpy(AESkey, FIPS_KEY, 16);
+    os_aes(AES_ENC, block, 16);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(FIPS_CIPHER, block, 16);
+
+    // Mismo bloque dos veces seguidas (el backend por hardware reutiliza la clave)
+    memcpy(block, FIPS_PLAIN, 16);
+    os_aes(AES_ENC, block, 16);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(FIPS_CIPHER, block, 16);
+}
+
+void test_rfc4493_cmac(void) {
+    for (unsigned i = 0; i < sizeof(CMAC_VECTORS) / sizeof(CMAC_VECTORS[0]); i++) {
+        u1_t msg[64];
+        memcpy(msg, CMAC_MSG, sizeof(msg));
+        memcpy(AESkey, CMAC_KEY, 16);
+        u4_t mic = os_aes(AES_MIC | AES_MICNOAUX, msg, CMAC_VECTORS[i].len);
+        char label[24];
+        snprintf(label, sizeof(label), "mensaje de %u bytes", CMAC_VECTORS[i].len);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(CMAC_VECTORS[i].mac, AESaux, 16, label);
+        u4_t expected = ((u4_t)CMAC_VECTORS[i].mac[0] << 24) | ((u4_t)CMAC_VECTORS[i].mac[1] << 16) |
+                        ((u4_t)CMAC_VECTORS[i].mac[2] << 8) | CMAC_VECTORS[i].mac[3];
+        TEST_ASSERT_EQUAL_HEX32(expected, mic);
+    }
+}
+
+void test_join_request_mic(void) {
+    u1_t frame[sizeof(JOIN_REQUEST)];
+    memcpy(frame, JOIN_REQUEST, sizeof(frame));
+    memcpy(AESkey, APP_KEY, 16);
+    os_aes(AES_MIC | AES_MICNOAUX, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(JOIN_REQUEST_MIC, AESaux, 4);
+}
+
+void test_join_accept(void) {
+    u1_t frame[sizeof(JOIN_ACCEPT_RX)];
+    u1_t nwkskey[16], appskey[16];
+    memcpy(frame, JOIN_ACCEPT_RX, sizeof(frame));
+    TEST_ASSERT_TRUE(join_accept(frame, nwkskey, appskey));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(JOIN_ACCEPT_PLAIN, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(JOIN_NWK_SKEY, nwkskey, 16);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(JOIN_APP_SKEY, appskey, 16);
+
+    // Un bit cambiado invalida el MIC
+    memcpy(frame, JOIN_ACCEPT_RX, sizeof(frame));
+    frame[5] ^= 0x01;
+    TEST_ASSERT_FALSE(join_accept(frame, nwkskey, appskey));
+}
+
+void test_uplink_cipher_and_mic(void) {
+    u1_t frame[sizeof(UPLINK_FRAME)];
+    memcpy(frame, UPLINK_FRAME, UPLINK_HDR_LEN);
+    memcpy(frame + UPLINK_HDR_LEN, UPLINK_PAYLOAD, sizeof(UPLINK_PAYLOAD));
+
+    frame_cipher(APP_SKEY, DEV_ADDR, FCNT, 0, frame + UPLINK_HDR_LEN, sizeof(UPLINK_PAYLOAD));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(UPLINK_FRAME, frame, sizeof(frame));
+
+    u4_t mic = frame_mic(NWK_SKEY, DEV_ADDR, FCNT, 0, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_HEX32(((u4_t)UPLINK_MIC[0] << 24) | ((u4_t)UPLINK_MIC[1] << 16) |
+                            ((u4_t)UPLINK_MIC[2] << 8) | UPLINK_MIC[3], mic);
+
+    // CTR es su propio inverso: descifrar devuelve el payload en claro
+    frame_cipher(APP_SKEY, DEV_ADDR, FCNT, 0, frame + UPLINK_HDR_LEN, sizeof(UPLINK_PAYLOAD));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(UPLINK_PAYLOAD, frame + UPLINK_HDR_LEN, sizeof(UPLINK_PAYLOAD));
+}
+
+#ifdef ARDUINO
+// =============================================================================
+// MEDIDA EN LA PLACA
+// =============================================================================
+
+// Símbolos que LMIC espera de la aplicación (el MAC no se ejecuta aquí)
+const lmic_pinmap lmic_pins = {
+    .nss = LMIC_UNUSED_PIN,
+    .rxtx = LMIC_UNUSED_PIN,
+    .rst = LMIC_UNUSED_PIN,
+    .dio = { LMIC_UNUSED_PIN, LMIC_UNUSED_PIN, LMIC_UNUSED_PIN },
+};
+void onEvent(ev_t ev) { (void)ev; }
+void os_getArtEui(u1_t* buf) { memcpy(buf, JOIN_REQUEST + 1, 8); }
+void os_getDevEui(u1_t* buf) { memcpy(buf, JOIN_REQUEST + 9, 8); }
+void os_getDevKey(u1_t* buf) { memcpy(buf, APP_KEY, 16); }
+
+#define BENCH_ROUNDS 200
+
+/**
+ * @brief Ciclos de una trama de 51 bytes: CTR con AppSKey y MIC con NwkSKey
+ *
+ * Alterna las dos claves como LMIC en cada uplink.
+ */
+void test_benchmark_frame(void) {
+    u1_t frame[UPLINK_HDR_LEN + 51];
+    memset(frame, 0xA5, sizeof(frame));
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        frame_cipher(APP_SKEY, DEV_ADDR, FCNT + i, 0, frame + UPLINK_HDR_LEN, 51);
+        frame_mic(NWK_SKEY, DEV_ADDR, FCNT + i, 0, frame, sizeof(frame));
+    }
+    uint32_t cycles = (ESP.getCycleCount() - start) / BENCH_ROUNDS;
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Trama de 51 bytes: %lu ciclos (%lu us a %lu MHz)",
+             (unsigned long)cycles, (unsigned long)(cycles / getCpuFrequencyMhz()),
+             (unsigned long)getCpuFrequencyMhz());
+    TEST_MESSAGE(msg);
+}
+
+/**
+ * @brief Ciclos de un join-accept: descifrado, MIC y claves de sesión
+ */
+void test_benchmark_join_accept(void) {
+    u1_t frame[sizeof(JOIN_ACCEPT_RX)];
+    u1_t nwkskey[16], appskey[16];
+    uint32_t total = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        memcpy(frame, JOIN_ACCEPT_RX, sizeof(frame));
+        uint32_t start = ESP.getCycleCount();
+        bool ok = join_accept(frame, nwkskey, appskey);
+        total += ESP.getCycleCount() - start;
+        TEST_ASSERT_TRUE(ok);
+    }
+    uint32_t cycles = total / BENCH_ROUNDS;
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Join-accept: %lu ciclos (%lu us a %lu MHz)",
+             (unsigned long)cycles, (unsigned long)(cycles / getCpuFrequencyMhz()),
+             (unsigned long)getCpuFrequencyMhz());
+    TEST_MESSAGE(msg);
+}
+#endif
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fips197_block);
+    RUN_TEST(test_rfc4493_cmac);
+    RUN_TEST(test_join_request_mic);
+    RUN_TEST(test_join_accept);
+    RUN_TEST(test_uplink_cipher_and_mic);
+#ifdef ARDUINO
+    RUN_TEST(test_benchmark_frame);
+    RUN_TEST(test_benchmark_join_accept);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);  // Tiempo para que el monitor de PlatformIO abra el puerto
+    run_tests();
+}
+
+void loop() {}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
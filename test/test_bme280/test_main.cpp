@@ -0,0 +1,217 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del BME280: compensación entera contra float
+ *
+ * El driver lee un banco de registros simulado (test/stubs/Adafruit_BME280.h)
+ * por su ruta real: ráfaga 0xF7-0xFE, compensación entera de Bosch y paso a
+ * las unidades de sensor_data_t. El resultado se compara con la
+ * compensación en coma flotante de la hoja de datos (BME280, 8.1) sobre el
+ * ejemplo resuelto de Bosch y un barrido de lecturas crudas que cubre los
+ * rangos válidos de temperatura, presión y humedad.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include <math.h>
+#include "../../src/sensor/sensor_bme280.cpp"
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+bool isFastBoot() { return false; }
+bool i2cDeviceCached(uint8_t addr) { return false; }
+uint32_t power_rail_acquire(uint8_t pin, uint32_t warmup_ms) { return millis() + warmup_ms; }
+void power_rail_release(uint8_t pin) {}
+void power_rail_wait_until(uint32_t deadline_ms) {}
+char* sensor_format_fixed(char* buffer, size_t size, int32_t value, int32_t scale, uint8_t decimals) {
+    snprintf(buffer, size, "%ld", (long)value);
+    return buffer;
+}
+void logger_printf(const char* fmt, ...) {}
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {}
+
+// =============================================================================
+// CALIBRACIÓN Y REFERENCIA
+// =============================================================================
+
+/**
+ * @brief Calibración del ejemplo resuelto de Bosch (temperatura y presión)
+ *
+ * Los coeficientes de humedad no vienen en el ejemplo: son los de un
+ * BME280 típico.
+ */
+static const bme280_calib_data CALIB = {
+    27504, 26435, -1000,
+    36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+    75, 362, 0, 324, 50, 30
+};
+
+/**
+ * @brief Compensación en coma flotante de la hoja de datos
+ */
+typedef struct {
+    double temperature_c;
+    double pressure_pa;
+    double humidity_pct;
+} reference_t;
+
+static reference_t reference(int32_t adc_T, int32_t adc_P, int32_t adc_H, const bme280_calib_data* c) {
+    reference_t r;
+
+    double var1 = (adc_T / 16384.0 - c->dig_T1 / 1024.0) * c->dig_T2;
+    double var2 = (adc_T / 131072.0 - c->dig_T1 / 8192.0) * (adc_T / 131072.0 - c->dig_T1 / 8192.0) * c->dig_T3;
+    double t_fine = (int32_t)(var1 + var2);
+    r.temperature_c = (var1 + var2) / 5120.0;
+
+    var1 = t_fine / 2.0 - 64000.0;
+    var2 = var1 * var1 * c->dig_P6 / 32768.0;
+    var2 = var2 + var1 * c->dig_P5 * 2.0;
+    var2 = var2 / 4.0 + c->dig_P4 * 65536.0;
+    var1 = (c->dig_P3 * var1 * var1 / 524288.0 + c->dig_P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * c->dig_P1;
+    double p = 1048576.0 - adc_P;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = c->dig_P9 * p * p / 2147483648.0;
+    var2 = p * c->dig_P8 / 32768.0;
+    r.pressure_pa = p + (var1 + var2 + c->dig_P7) / 16.0;
+
+    double h = t_fine - 76800.0;
+    h = (adc_H - (c->dig_H4 * 64.0 + c->dig_H5 / 16384.0 * h)) *
+        (c->dig_H2 / 65536.0 * (1.0 + c->dig_H6 / 67108864.0 * h * (1.0 + c->dig_H3 / 67108864.0 * h)));
+    h = h * (1.0 - c->dig_H1 * h / 524288.0);
+    r.humidity_pct = h < 0 ? 0 : h > 100 ? 100 : h;
+    return r;
+}
+
+/**
+ * @brief Carga una lectura cruda en los registros de datos 0xF7-0xFE
+ */
+static void load_raw(int32_t adc_T, int32_t adc_P, int32_t adc_H) {
+    uint8_t* r = &stub_bme280_regs[BME280_REGISTER_PRESSUREDATA];
+    r[0] = adc_P >> 12;
+    r[1] = adc_P >> 4;
+    r[2] = (adc_P & 0x0F) << 4;
+    r[3] = adc_T >> 12;
+    r[4] = adc_T >> 4;
+    r[5] = (adc_T & 0x0F) << 4;
+    r[6] = adc_H >> 8;
+    r[7] = adc_H;
+}
+
+/**
+ * @brief Lectura por la ruta del driver
+ */
+static bool read_driver(int32_t adc_T, int32_t adc_P, int32_t adc_H, sensor_data_t* data) {
+    memset(data, 0, sizeof(*data));
+    load_raw(adc_T, adc_P, adc_H);
+    return sensor_bme280_read_measurement(data);
+}
+
+void setUp(void) {
+    memset(stub_bme280_regs, 0, sizeof(stub_bme280_regs));
+    stub_bme280_calib = CALIB;
+    stub_bme280_address = 0x76;
+    stub_millis = 0;
+    sensor_available = false;
+    TEST_ASSERT_TRUE(sensor_bme280_init());
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// PRUEBAS
+// =============================================================================
+
+/**
+ * @brief Ejemplo resuelto de Bosch: 25,08 °C y 100653 Pa
+ */
+void test_datasheet_example(void) {
+    sensor_data_t data;
+    TEST_ASSERT_TRUE(read_driver(519888, 415148, 30000, &data));
+    TEST_ASSERT_EQUAL_INT32(2508, data.temperature);
+    TEST_ASSERT_EQUAL_INT32(100653, data.pressure);
+
+    reference_t ref = reference(519888, 415148, 30000, &CALIB);
+    TEST_ASSERT_INT_WITHIN(1, lround(ref.humidity_pct * SENSOR_SCALE_HUMIDITY), data.humidity);
+    TEST_ASSERT_EQUAL_HEX8(SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY | SENSOR_FIELD_PRESSURE,
+                           data.valid_mask);
+}
+
+/**
+ * @brief Barrido de lecturas crudas: la ruta entera coincide con la float
+ *
+ * Se comparan solo los resultados dentro de los rangos válidos del payload.
+ * Diferencia máxima: 0,01 °C, 1 Pa y 0,01 % (el redondeo a las unidades de
+ * sensor_data_t).
+ */
+void test_matches_float_compensation(void) {
+    uint32_t compared = 0;
+    for (int32_t adc_T = 330000; adc_T <= 620000; adc_T += 7919) {
+        for (int32_t adc_P = 150000; adc_P <= 700000; adc_P += 13007) {
+            for (int32_t adc_H = 0; adc_H <= 65000; adc_H += 1499) {
+                reference_t ref = reference(adc_T, adc_P, adc_H, &CALIB);
+                if (ref.temperature_c < TEMPERATURE_MIN || ref.temperature_c > TEMPERATURE_MAX) continue;
+                if (ref.pressure_pa < PRESSURE_MIN * SENSOR_SCALE_PRESSURE ||
+                    ref.pressure_pa > PRESSURE_MAX * SENSOR_SCALE_PRESSURE) continue;
+
+                sensor_data_t data;
+                char message[64];
+                snprintf(message, sizeof(message), "T %ld P %ld H %ld", (long)adc_T, (long)adc_P, (long)adc_H);
+                TEST_ASSERT_TRUE_MESSAGE(read_driver(adc_T, adc_P, adc_H, &data), message);
+                TEST_ASSERT_INT_WITHIN_MESSAGE(1, lround(ref.temperature_c * SENSOR_SCALE_TEMPERATURE),
+                                               data.temperature, message);
+                TEST_ASSERT_INT_WITHIN_MESSAGE(1, lround(ref.pressure_pa), data.pressure, message);
+                TEST_ASSERT_INT_WITHIN_MESSAGE(1, lround(ref.humidity_pct * SENSOR_SCALE_HUMIDITY),
+                                               data.humidity, message);
+                compared++;
+            }
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(10000, compared);
+}
+
+/**
+ * @brief Magnitud no medida (0x80000 / 0x8000): la lectura no es válida
+ */
+void test_unmeasured_is_invalid(void) {
+    sensor_data_t data;
+    TEST_ASSERT_FALSE(read_driver(0x80000, 415148, 30000, &data));
+    TEST_ASSERT_FALSE(read_driver(519888, 0x80000, 30000, &data));
+    TEST_ASSERT_FALSE(read_driver(519888, 415148, 0x8000, &data));
+    TEST_ASSERT_EQUAL_HEX8(0, data.valid_mask & (SENSOR_FIELD_TEMPERATURE | SENSOR_FIELD_HUMIDITY | SENSOR_FIELD_PRESSURE));
+}
+
+/**
+ * @brief init() deja el sensor en sleep sin esperas; la medida lo pasa a forzado
+ */
+void test_init_and_forced_measurement(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, stub_millis);
+    TEST_ASSERT_EQUAL_HEX8((1 << 5) | (1 << 2) | Adafruit_BME280::MODE_SLEEP,
+                           stub_bme280_regs[BME280_REGISTER_CONTROL]);
+
+    TEST_ASSERT_EQUAL_UINT32(BME280_MEASUREMENT_MS, sensor_bme280_start_measurement());
+    TEST_ASSERT_EQUAL_HEX8(Adafruit_BME280::MODE_FORCED, stub_bme280_regs[BME280_REGISTER_CONTROL] & 0x03);
+
+    // Sensor en 0x77: se encuentra en el segundo intento
+    sensor_available = false;
+    stub_bme280_address = 0x77;
+    TEST_ASSERT_TRUE(sensor_bme280_init());
+    TEST_ASSERT_EQUAL_HEX8(0x77, sensor_address);
+
+    stub_bme280_address = 0;
+    sensor_available = false;
+    TEST_ASSERT_FALSE(sensor_bme280_init());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_datasheet_example);
+    RUN_TEST(test_matches_float_compensation);
+    RUN_TEST(test_unmeasured_is_invalid);
+    RUN_TEST(test_init_and_forced_measurement);
+    return UNITY_END();
+}
@@ -0,0 +1,276 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del control de enlace con pérdidas simuladas
+ *
+ * Un canal simulado da la SNR de cada uplink en el gateway: la de la
+ * potencia máxima (S0, fija por la pérdida de trayecto), menos lo que se
+ * baje la potencia, más un desvanecimiento normal de SIGMA_DB. La trama
+ * llega si supera el suelo de demodulación del SF; las comprobaciones y
+ * los confirmados (uno de cada CONFIRMED_EVERY) devuelven LinkCheckAns o
+ * la SNR de RX1 como lo haría la red. Se compara la carga por trama
+ * entregada de choose() con la de SF7 a potencia máxima en todo el rango
+ * de pérdidas, y la reacción de ladder() a un corte de 20 dB.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include "lmic_host.h"
+#include "../../src/uplink_planner.cpp"
+#include "../../src/link_controller.cpp"
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+static remote_config_t config;
+
+const remote_config_t* remote_config_get(void) { return &config; }
+uint32_t scheduler_clock_s(void) { return 0; }
+void logger_printf(const char* fmt, ...) {}
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {}
+
+void LMIC_requestLinkCheck(void) {
+    LMIC.lchkReq = 1;
+    LMIC.gwCnt = 0;
+}
+void LMIC_setAdrMode(bit_t enabled) { LMIC.adrEnabled = enabled; }
+void LMIC_setLinkCheckMode(bit_t enabled) {}
+void LMIC_setDrTxpow(dr_t dr, s1_t txpow) {
+    LMIC.datarate = dr;
+    if (txpow != KEEP_TXPOW) LMIC.adrTxPow = txpow;
+}
+
+// =============================================================================
+// CANAL SIMULADO
+// =============================================================================
+
+#define PAYLOAD_SIZE     11
+#define SIGMA_DB         3.0
+#define CONFIRMED_EVERY  12
+#define UPLINKS          3000
+
+// Suelo de demodulación del SX1276 (dB), DR_SF12 ... DR_SF7
+static const double FLOOR_DB[DR_SF7 + 1] = { -20, -17.5, -15, -12.5, -10, -7.5 };
+
+/**
+ * @brief Resultado de una simulación
+ */
+typedef struct {
+    uint32_t delivered;
+    double charge_uc;              /**< Carga total de los ciclos con envío */
+    uint32_t per_dr[DR_SF7 + 1];   /**< Uplinks en cada DR */
+} sim_result_t;
+
+static uint32_t seed;
+
+/**
+ * @brief Normal(0, 1) determinista: Box-Muller sobre un LCG
+ */
+static double gaussian(void) {
+    seed = seed * 1103515245UL + 12345UL;
+    double u1 = ((seed >> 8) + 1.0) / 16777217.0;
+    seed = seed * 1103515245UL + 12345UL;
+    double u2 = (seed >> 8) / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/**
+ * @brief Corriente de TX interpolada entre los puntos del controlador
+ */
+static double tx_ma(int8_t txpow) {
+    for (uint8_t i = 0; i + 1 < (int)TXPOW_COUNT; i++) {
+        if (txpow >= TXPOW_DBM[i + 1]) {
+            return TXPOW_MA[i + 1] + (double)(TXPOW_MA[i] - TXPOW_MA[i + 1]) *
+                   (txpow - TXPOW_DBM[i + 1]) / (TXPOW_DBM[i] - TXPOW_DBM[i + 1]);
+        }
+    }
+    return TXPOW_MA[TXPOW_COUNT - 1];
+}
+
+/**
+ * @brief Arranque en frío del nodo: SF7, sin histórico
+ */
+static void power_on(void) {
+    memset(&LMIC, 0, sizeof(LMIC));
+    LMIC.bands[BAND_CENTI].txpow = 14;
+    LMIC.datarate = DR_SF7;
+    LMIC.adrTxPow = 14;
+    rtc_link.magic = 0;
+    checkInFlight = false;
+    link_controller_begin();
+}
+
+/**
+ * @brief Uplinks con la SNR a potencia máxima que da s0_db(i)
+ *
+ * @param controlled false: SF7 a potencia máxima, sin control de enlace
+ */
+static sim_result_t simulate(double (*s0_db)(uint32_t), bool controlled, uint32_t first, uint32_t last) {
+    sim_result_t r = {};
+    seed = 1;
+    power_on();
+
+    for (uint32_t i = 0; i < UPLINKS; i++) {
+        bool confirmed = i % CONFIRMED_EVERY == CONFIRMED_EVERY - 1;
+        if (controlled) link_controller_apply(PAYLOAD_SIZE);
+        LMIC.txpow = LMIC.adrTxPow < 14 ? LMIC.adrTxPow : 14;
+
+        uint8_t dr = LMIC.datarate;
+        double s0 = s0_db(i);
+        double snr_up = s0 - (radio_dbm(max_txpow()) - radio_dbm(LMIC.txpow)) + SIGMA_DB * gaussian();
+        bool up_ok = snr_up >= FLOOR_DB[dr];
+
+        uint8_t flags = 0;
+        if (up_ok && (LMIC.lchkReq || confirmed)) {
+            // RX1 a LINK_CONTROLLER_GW_TX_DBM frente a los 16 dBm del nodo
+            double snr_down = s0 - (radio_dbm(max_txpow()) - LINK_CONTROLLER_GW_TX_DBM) + SIGMA_DB * gaussian();
+            if (snr_down >= FLOOR_DB[dr]) {
+                flags |= TXRX_DNW1;
+                LMIC.snr = (s1_t)lround(snr_down * SNR_SCALEUP);
+                if (LMIC.lchkReq) {
+                    double margin = snr_up - FLOOR_DB[dr];
+                    LMIC.gwMargin = (u1_t)margin;
+                    LMIC.gwCnt = 1;
+                }
+            }
+        }
+        LMIC.lchkReq = 0;
+        if (controlled) link_controller_on_tx_complete(confirmed, flags);
+
+        if (i < first || i >= last) continue;
+        r.per_dr[dr]++;
+        if (up_ok) r.delivered++;
+        r.charge_uc += LINK_CONTROLLER_CYCLE_UC + uplink_planner_airtime_us(dr, PAYLOAD_SIZE) / 1000.0 * tx_ma(LMIC.txpow);
+    }
+    return r;
+}
+
+static double uc_per_delivered(const sim_result_t* r) {
+    return r->delivered ? r->charge_uc / r->delivered : INFINITY;
+}
+
+static double path_s0;
+static double fixed_s0(uint32_t i) { return path_s0; }
+
+// Corte de 20 dB entre los uplinks 1000 y 2000
+static double step_s0(uint32_t i) { return i >= 1000 && i < 2000 ? path_s0 - 20 : path_s0; }
+
+void setUp(void) {
+    memset(&config, 0, sizeof(config));
+    config.dr_policy = REMOTE_CONFIG_DR_MODEL;
+    config.fixed_dr = DR_SF7;
+    power_on();
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// PRUEBAS
+// =============================================================================
+
+/**
+ * @brief Sin histórico: DR de arranque a la potencia máxima
+ */
+void test_choose_without_history(void) {
+    uint8_t dr;
+    int8_t txpow;
+    choose(PAYLOAD_SIZE, &dr, &txpow);
+    TEST_ASSERT_EQUAL_UINT8(DR_SF7, dr);
+    TEST_ASSERT_EQUAL_INT8(14, txpow);
+}
+
+/**
+ * @brief Escalera: potencia máxima con la primera pérdida, luego un DR cada
+ *        LINK_CONTROLLER_MISSED_STEP, hasta SF12
+ */
+void test_ladder_steps(void) {
+    static const struct { uint8_t missed; uint8_t dr; int8_t txpow; } CASES[] = {
+        { 0, DR_SF7, 5 },
+        { 1, DR_SF7, 14 },
+        { 2, DR_SF7, 14 },
+        { 3, DR_SF8, 14 },
+        { 5, DR_SF9, 14 },
+        { 11, DR_SF12, 14 },
+        { 40, DR_SF12, 14 },
+    };
+    for (uint8_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+        uint8_t dr = DR_SF7;
+        int8_t txpow = 5;
+        rtc_link.missed = CASES[i].missed;
+        ladder(&dr, &txpow);
+        TEST_ASSERT_EQUAL_UINT8(CASES[i].dr, dr);
+        TEST_ASSERT_EQUAL_INT8(CASES[i].txpow, txpow);
+    }
+}
+
+/**
+ * @brief Barrido de pérdidas: el control nunca cuesta más por trama
+ *        entregada que SF7 a potencia máxima, y entrega donde SF7 no llega
+ */
+void test_path_loss_sweep(void) {
+    for (path_s0 = 20; path_s0 >= -14; path_s0 -= 4) {
+        sim_result_t fixed = simulate(fixed_s0, false, 0, UPLINKS);
+        sim_result_t ctrl = simulate(fixed_s0, true, 0, UPLINKS);
+
+        char message[160];
+        snprintf(message, sizeof(message),
+                 "S0 %+.0f dB: SF7 %.1f %% %.0f uC/trama, control %.1f %% %.0f uC/trama, DR0-5 %u %u %u %u %u %u",
+                 path_s0, 100.0 * fixed.delivered / UPLINKS, uc_per_delivered(&fixed),
+                 100.0 * ctrl.delivered / UPLINKS, uc_per_delivered(&ctrl),
+                 (unsigned)ctrl.per_dr[0], (unsigned)ctrl.per_dr[1], (unsigned)ctrl.per_dr[2],
+                 (unsigned)ctrl.per_dr[3], (unsigned)ctrl.per_dr[4], (unsigned)ctrl.per_dr[5]);
+        TEST_MESSAGE(message);
+
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(uc_per_delivered(&fixed) * 1.02, uc_per_delivered(&ctrl), message);
+        // Con SF12 a 10 dB del límite el enlace es fiable
+        if (path_s0 >= FLOOR_DB[DR_SF12] + 10) {
+            TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(0.9 * UPLINKS, ctrl.delivered, message);
+        }
+    }
+}
+
+/**
+ * @brief Enlace holgado: SF7 y potencia reducida casi siempre
+ */
+void test_strong_link_lowers_power(void) {
+    path_s0 = 12;
+    sim_result_t ctrl = simulate(fixed_s0, true, 100, UPLINKS);
+    TEST_ASSERT_GREATER_OR_EQUAL(0.95 * (UPLINKS - 100), ctrl.per_dr[DR_SF7]);
+    TEST_ASSERT_GREATER_OR_EQUAL(0.99 * (UPLINKS - 100), ctrl.delivered);
+    TEST_ASSERT_LESS_THAN(14, LMIC.txpow);
+}
+
+/**
+ * @brief Corte de 20 dB: la escalera recupera el enlace y el modelo vuelve
+ *        a SF7 cuando pasa
+ */
+void test_step_loss_recovers(void) {
+    path_s0 = 8;
+    sim_result_t fixed = simulate(step_s0, false, 1000, 2000);
+    sim_result_t during = simulate(step_s0, true, 1000, 2000);
+    sim_result_t after = simulate(step_s0, true, 2100, UPLINKS);
+
+    char message[120];
+    snprintf(message, sizeof(message), "corte: SF7 %u, control %u entregadas de 1000; después SF7 %u de %u",
+             (unsigned)fixed.delivered, (unsigned)during.delivered,
+             (unsigned)after.per_dr[DR_SF7], UPLINKS - 2100);
+    TEST_MESSAGE(message);
+
+    // Durante el corte S0 es -12 dB: SF10 o más lento, como en el barrido
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(800, during.delivered, message);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(5 * fixed.delivered, during.delivered, message);
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(0.9 * (UPLINKS - 2100), after.per_dr[DR_SF7], message);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_choose_without_history);
+    RUN_TEST(test_ladder_steps);
+    RUN_TEST(test_path_loss_sweep);
+    RUN_TEST(test_strong_link_lowers_power);
+    RUN_TEST(test_step_loss_recovers);
+    return UNITY_END();
+}
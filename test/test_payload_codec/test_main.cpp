@@ -0,0 +1,252 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del codec del payload: tramas bit a bit
+ *
+ * Lecturas de sensor_data_t típicas y en los límites de cada campo, con sus
+ * tramas esperadas byte a byte para el esquema por defecto de config.h
+ * (batería en %, pH, BME280 y DS18B20: 9 bytes por registro). Las tramas se
+ * calcularon aparte con aritmética racional exacta a partir de la fórmula
+ * del esquema, round((valor - mínimo) * escala) + 1. Se comprueba también
+ * la cuantización entera contra esa fórmula en coma flotante en todo el
+ * rango de cada campo, y una trama por lotes con deltas.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include <math.h>
+#include "../../src/payload_codec.cpp"
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+static battery_status_t battery;
+
+const battery_status_t* battery_status(void) { return &battery; }
+uint8_t batteryPercentFromMillivolts(uint16_t millivolts) { return millivolts >= 4000 ? 90 : 30; }
+
+// =============================================================================
+// LECTURAS Y TRAMAS ESPERADAS
+// =============================================================================
+
+#define ALL_FIELDS (SENSOR_FIELDS_SENSORS | SENSOR_FIELD_BATTERY)
+
+/**
+ * @brief Lectura con el estado de carga que da el medidor en ese momento
+ */
+typedef struct {
+    uint8_t soc_percent;
+    sensor_data_t data;   /**< temperature, humidity, pressure, temperature_1m, ph, battery, valid_mask */
+} reading_t;
+
+static const reading_t READINGS[] = {
+    // Mediodía: todo válido
+    { 87, { 2354, 5523, 101325, 1812, 712, 4105, ALL_FIELDS } },
+    // Madrugada bajo cero
+    { 64, { -312, 9120, 98760, 905, 698, 3890, ALL_FIELDS } },
+    // Sin DS18B20 ni pH
+    { 41, { 1500, 4000, 100000, 0, 0, 3720, ALL_FIELDS & ~(SENSOR_FIELD_TEMPERATURE_1M | SENSOR_FIELD_PH) } },
+    // Máximos de cada campo
+    { 100, { 8500, 10000, 110000, 5000, 1400, 4200, ALL_FIELDS } },
+    // Mínimos de cada campo
+    { 0, { -4000, 0, 30000, -1000, 0, 3300, ALL_FIELDS } },
+    // Justo por encima del máximo (presión a menos de medio paso)
+    { 50, { -4001, 10001, 110004, 5001, 1401, 3800, ALL_FIELDS } },
+    // Presión a menos de medio paso por debajo del mínimo
+    { 50, { 2000, 5000, 29996, 1000, 700, 3800, ALL_FIELDS } },
+};
+
+static const uint8_t FRAMES[][9] = {
+    { 0xB0, 0xB2, 0x58, 0xD3, 0x57, 0xEA, 0xB2, 0x9B, 0xDE },
+    { 0x82, 0xAE, 0xCE, 0x69, 0x3B, 0x94, 0x74, 0x3A, 0xDD },
+    { 0x54, 0x00, 0x15, 0x7D, 0x00, 0x01, 0xF4, 0x3B, 0x59 },
+    { 0xCB, 0x5E, 0x70, 0xD5, 0xBB, 0x8C, 0xE2, 0x3F, 0x41 },
+    { 0x02, 0x00, 0x40, 0x01, 0x00, 0x08, 0x00, 0x20, 0x01 },
+    { 0x66, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x66, 0xAF, 0x57, 0x71, 0x3E, 0x8A, 0x71, 0x20, 0x00 },
+};
+
+/**
+ * @brief Codifica una lectura como registro completo
+ */
+static uint8_t encode(const reading_t* reading, uint8_t* buffer, uint8_t size) {
+    battery.soc_source = BATTERY_SOC_GAUGE;
+    battery.soc_percent = reading->soc_percent;
+
+    payload_record_t record;
+    payload_codec_quantize(&reading->data, &record);
+
+    payload_bitwriter_t writer;
+    payload_codec_writer_init(&writer, buffer, size);
+    if (!payload_codec_write_record(&writer, &record, NULL)) return 0;
+    return payload_codec_writer_bytes(&writer);
+}
+
+/**
+ * @brief Código de referencia: la fórmula del esquema en coma flotante
+ */
+static uint16_t reference_code(const payload_field_t* field, int32_t raw, int32_t unit) {
+    double value = (double)raw / unit;
+    if (value < field->min || value > field->max) return 0;
+    return (uint16_t)lround((value - field->min) * field->scale) + 1;
+}
+
+void setUp(void) {
+    memset(&battery, 0, sizeof(battery));
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// PRUEBAS
+// =============================================================================
+
+/**
+ * @brief El esquema por defecto es el de las tramas esperadas
+ */
+void test_default_schema(void) {
+    static const char* const NAMES[] = {
+        "battery_percent", "ph", "temperature_ext", "temperature_water_1m", "humidity", "pressure"
+    };
+    static const uint8_t BITS[] = { 7, 11, 14, 13, 14, 13 };
+
+    TEST_ASSERT_EQUAL_UINT8(6, payload_codec_field_count());
+    for (uint8_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_STRING(NAMES[i], payload_codec_field(i)->name);
+        TEST_ASSERT_EQUAL_UINT8(BITS[i], payload_codec_field_bits(payload_codec_field(i)));
+    }
+    TEST_ASSERT_EQUAL_UINT8(9, payload_codec_record_size());
+}
+
+/**
+ * @brief Cada lectura da exactamente su trama
+ */
+void test_frames_bit_exact(void) {
+    for (uint8_t i = 0; i < sizeof(READINGS) / sizeof(READINGS[0]); i++) {
+        uint8_t buffer[16];
+        char message[32];
+        snprintf(message, sizeof(message), "lectura %u", i);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(9, encode(&READINGS[i], buffer, sizeof(buffer)), message);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(FRAMES[i], buffer, 9, message);
+    }
+}
+
+/**
+ * @brief Sin medidor de carga, el porcentaje sale de la curva sobre los mV
+ */
+void test_battery_without_gauge(void) {
+    reading_t reading = READINGS[0];
+    payload_record_t record;
+
+    battery.soc_source = BATTERY_SOC_NONE;
+    payload_codec_quantize(&reading.data, &record);
+    TEST_ASSERT_EQUAL_UINT16(91, record.code[0]);
+
+    reading.data.valid_mask &= ~SENSOR_FIELD_BATTERY;
+    payload_codec_quantize(&reading.data, &record);
+    TEST_ASSERT_EQUAL_UINT16(0, record.code[0]);
+}
+
+/**
+ * @brief La cuantización entera coincide con la fórmula en todo el rango
+ *
+ * Se recorre cada campo desde medio paso por debajo del mínimo hasta medio
+ * paso por encima del máximo. Los empates exactos (x,5 en la unidad del
+ * payload) no se comparan: en coma flotante dependen de la representación.
+ */
+void test_quantize_matches_formula(void) {
+    static const int32_t UNITS[] = {
+        1, SENSOR_SCALE_PH, SENSOR_SCALE_TEMPERATURE, SENSOR_SCALE_TEMPERATURE,
+        SENSOR_SCALE_HUMIDITY, SENSOR_SCALE_PRESSURE
+    };
+    battery.soc_source = BATTERY_SOC_GAUGE;
+
+    for (uint8_t i = 0; i < payload_codec_field_count(); i++) {
+        const payload_field_t* field = payload_codec_field(i);
+        int32_t raw_max = field->raw_min + (int32_t)(field->max_code - 1) * field->raw_step;
+        uint32_t compared = 0;
+
+        for (int32_t raw = field->raw_min - field->raw_step; raw <= raw_max + field->raw_step; raw++) {
+            if (field->raw_step > 1 && (raw - field->raw_min) % field->raw_step == field->raw_step / 2) continue;
+            if (i == 0 && (raw < 0 || raw > 255)) continue;  // soc_percent es uint8_t
+
+            sensor_data_t data = {};
+            data.valid_mask = ALL_FIELDS;
+            *(int32_t*)((uint8_t*)&data + field->offset) = raw;
+            battery.soc_percent = (uint8_t)raw;
+
+            payload_record_t record;
+            payload_codec_quantize(&data, &record);
+            if (record.code[i] != reference_code(field, raw, UNITS[i])) {
+                char message[64];
+                snprintf(message, sizeof(message), "%s: %ld", field->name, (long)raw);
+                TEST_FAIL_MESSAGE(message);
+                return;
+            }
+            compared++;
+        }
+        TEST_ASSERT_GREATER_THAN(field->max_code, compared);
+    }
+}
+
+/**
+ * @brief Trama por lotes: deltas, valores completos y campos sin lectura
+ */
+void test_batch_frame_bit_exact(void) {
+    static const reading_t SERIES[] = {
+        { 87, { 2354, 5523, 101325, 1812, 712, 4105, ALL_FIELDS } },
+        { 87, { 2371, 5490, 101318, 1814, 715, 4104, ALL_FIELDS } },
+        { 86, { 2620, 4210, 101290, 1815, 760, 4101, ALL_FIELDS } },
+        { 86, { 2618, 4205, 101990, 0, 761, 4100, ALL_FIELDS & ~SENSOR_FIELD_TEMPERATURE_1M } },
+        { 86, { 2610, 4200, 101985, 1816, 761, 4100, ALL_FIELDS } },
+    };
+    static const uint8_t EXPECTED[] = {
+        0xB0, 0xB2, 0x58, 0xD3, 0x57, 0xEA, 0xB2, 0x9B, 0xDE, 0x00, 0x60, 0x88,
+        0x13, 0xBE, 0xFD, 0xEB, 0xE4, 0xF9, 0x01, 0xA0, 0xE6, 0xF4, 0x00, 0xBF,
+        0xD0, 0x00, 0x3F, 0x7E, 0x10, 0x00, 0x07, 0xE2, 0xB0, 0x17, 0xEC, 0x00
+    };
+
+    uint8_t buffer[64];
+    payload_bitwriter_t writer;
+    payload_codec_writer_init(&writer, buffer, sizeof(buffer));
+    battery.soc_source = BATTERY_SOC_GAUGE;
+
+    payload_record_t records[5];
+    for (uint8_t i = 0; i < 5; i++) {
+        battery.soc_percent = SERIES[i].soc_percent;
+        payload_codec_quantize(&SERIES[i].data, &records[i]);
+        TEST_ASSERT_TRUE(payload_codec_write_record(&writer, &records[i], i ? &records[i - 1] : NULL));
+    }
+    TEST_ASSERT_EQUAL_UINT8(sizeof(EXPECTED), payload_codec_writer_bytes(&writer));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(EXPECTED, buffer, sizeof(EXPECTED));
+}
+
+/**
+ * @brief Un registro que no cabe no deja bits a medias
+ */
+void test_record_does_not_fit(void) {
+    uint8_t buffer[9];
+    TEST_ASSERT_EQUAL_UINT8(0, encode(&READINGS[0], buffer, 8));
+
+    payload_record_t record;
+    payload_bitwriter_t writer;
+    payload_codec_quantize(&READINGS[0].data, &record);
+    payload_codec_writer_init(&writer, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(payload_codec_write_record(&writer, &record, NULL));
+    TEST_ASSERT_FALSE(payload_codec_write_record(&writer, &record, &record));
+    TEST_ASSERT_EQUAL_UINT16(72, writer.bits);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_schema);
+    RUN_TEST(test_frames_bit_exact);
+    RUN_TEST(test_battery_without_gauge);
+    RUN_TEST(test_quantize_matches_formula);
+    RUN_TEST(test_batch_frame_bit_exact);
+    RUN_TEST(test_record_does_not_fit);
+    return UNITY_END();
+}
@@ -0,0 +1,318 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del driver SX127x: transacciones SPI y sombra
+ *
+ * radio.c de LMIC se compila contra un SX1276 simulado: un banco de 128
+ * registros detrás de hal_spi_burst() que cuenta las transacciones (ciclos
+ * de NSS) y los bytes. Se recorren dos ciclos TX/RX1 al mismo canal y SF y
+ * un tercero con otra frecuencia y SF que acaba con un downlink de 12 bytes.
+ *
+ * Los registros esperados tras cada paso son los que dejaba el driver
+ * anterior a la sombra de registros (una escritura por registro y
+ * lectura-modificación-escritura): la escritura diferida debe dejar la radio
+ * exactamente igual con menos transacciones.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include "lmic_host.h"
+#include "../../lib/LMIC-Arduino/src/lmic/radio.c"
+
+// =============================================================================
+// SX1276 SIMULADO
+// =============================================================================
+
+static u1_t regs[SHADOW_REGS];
+static uint32_t transactions;
+static uint32_t spi_bytes;
+static uint16_t noise;
+
+/**
+ * @brief Bit de ruido de RegRssiWideband (LFSR de 16 bits)
+ */
+static u1_t noise_bit(void) {
+    noise = (noise >> 1) ^ (-(noise & 1) & 0xB400);
+    return noise & 1;
+}
+
+/**
+ * @brief Una transacción: dirección y len bytes con NSS bajo
+ *
+ * La dirección avanza tras cada byte salvo en la FIFO. Escribir en
+ * LORARegIrqFlags borra los bits a 1, como en el chip.
+ */
+void hal_spi_burst(u1_t addr, u1_t* buf, u1_t len, u1_t dir) {
+    transactions++;
+    spi_bytes += 1 + len;
+
+    u1_t reg = addr & 0x7F;
+    for (u1_t i = 0; i < len; i++) {
+        if (dir == HAL_SPI_WRITE) {
+            if (reg == LORARegIrqFlags) regs[reg] &= ~buf[i];
+            else regs[reg] = buf[i];
+        } else {
+            buf[i] = reg == LORARegRssiWideband ? noise_bit() : regs[reg];
+        }
+        if (reg != RegFifo) reg++;
+    }
+}
+
+void hal_pin_rxtx(u1_t val) {}
+void hal_pin_rst(u1_t val) {}
+void hal_disableIRQs(void) {}
+void hal_enableIRQs(void) {}
+void hal_waitUntil(u4_t time) {}
+void hal_failed(const char* file, u2_t line) { TEST_FAIL_MESSAGE("ASSERT de LMIC"); }
+u4_t os_aes(u1_t mode, xref2u1_t buf, u2_t len) { return 0; }
+void os_setCallback(xref2osjob_t job, osjobcb_t cb) {}
+
+/**
+ * @brief Registros tras el encendido (LoRa no seleccionado) y versión
+ */
+static void radio_power_on(void) {
+    memset(regs, 0, sizeof(regs));
+    regs[RegOpMode] = 0x09;
+    regs[RegVersion] = 0x12;
+    noise = 0xACE1;
+}
+
+/**
+ * @brief Fin de TX o RX: el chip vuelve a standby y activa DIO
+ */
+static void radio_done(u1_t irq_flags) {
+    regs[LORARegIrqFlags] = irq_flags;
+    regs[RegOpMode] = (regs[RegOpMode] & ~OPMODE_MASK) | OPMODE_STANDBY;
+    radio_irq_handler(0);
+}
+
+// =============================================================================
+// SECUENCIA
+// =============================================================================
+
+typedef enum {
+    STEP_TX,
+    STEP_TX_DONE,
+    STEP_RX1,
+    STEP_RX_TIMEOUT,
+    STEP_RX_DONE,
+} step_action_t;
+
+/**
+ * @brief Paso de la secuencia con su resultado esperado
+ */
+typedef struct {
+    const char* name;
+    step_action_t action;
+    u4_t freq;              /**< Frecuencia de TX (STEP_TX) */
+    u1_t sf;                /**< SF de TX (STEP_TX) */
+    uint8_t transactions;   /**< Transacciones SPI con la sombra de registros */
+    uint8_t old_transactions; /**< Transacciones del driver anterior (referencia) */
+    const char* registers;  /**< Banco de registros 0x00-0x7F tras el paso (hex) */
+} step_t;
+
+static const step_t STEPS[] = {
+    { "TX", STEP_TX, 868100000, SF9, 16, 26,
+      "008B00000000D906668E08002100000000F700000000000000000000007294000000144000000400000000000000000000000040000000000034000000000000"
+      "F0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "TxDone", STEP_TX_DONE, 0, 0, 3, 6,
+      "008800000000D906668E08002100000000FF00000000000000000000007294000000144000000400000000000000000000000040000000000034000000000000"
+      "F0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "RX1", STEP_RX1, 0, 0, 9, 22,
+      "008E00000000D906668E080021000000003F00000000000000000000007294080000144000000400000000000000000000000040000000000034000000000000"
+      "C0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "RxTimeout", STEP_RX_TIMEOUT, 0, 0, 3, 6,
+      "008800000000D906668E08002100000000FF00000000000000000000007294080000144000000400000000000000000000000040000000000034000000000000"
+      "C0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "TX", STEP_TX, 868100000, SF9, 10, 26,
+      "008B00000000D906668E08002100000000F700000000000000000000007294080000004000000400000000000000000000000040000000000034000000000000"
+      "F0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "TxDone", STEP_TX_DONE, 0, 0, 3, 6,
+      "008800000000D906668E08002100000000FF00000000000000000000007294080000004000000400000000000000000000000040000000000034000000000000"
+      "F0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "RX1", STEP_RX1, 0, 0, 8, 22,
+      "008E00000000D906668E080021000000003F00000000000000000000007294080000004000000400000000000000000000000040000000000034000000000000"
+      "C0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "RxTimeout", STEP_RX_TIMEOUT, 0, 0, 3, 6,
+      "008800000000D906668E08002100000000FF00000000000000000000007294080000004000000400000000000000000000000040000000000034000000000000"
+      "C0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "TX nueva frecuencia y SF", STEP_TX, 868300000, SF7, 12, 26,
+      "008B00000000D913338E08002100000000F700000000000000000000007274080000004000000400000000000000000000000040000000000034000000000000"
+      "F0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "TxDone", STEP_TX_DONE, 0, 0, 3, 6,
+      "008800000000D913338E08002100000000FF00000000000000000000007274080000004000000400000000000000000000000040000000000034000000000000"
+      "F0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "RX1", STEP_RX1, 0, 0, 8, 22,
+      "008E00000000D913338E080021000000003F00000000000000000000007274080000004000000400000000000000000000000040000000000034000000000000"
+      "C0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+    { "RxDone (12 bytes)", STEP_RX_DONE, 0, 0, 6, 13,
+      "008800000000D913338E08002120000020FF000C0000000000285000007274080000004000000400000000000000000000000040000000000034000000000000"
+      "C0001200000000000000000000000000000000000000000000000400000000000000000000000000000000000000000000000000000000000000000000000000" },
+};
+
+#define STEP_COUNT (sizeof(STEPS) / sizeof(STEPS[0]))
+
+/**
+ * @brief Ejecuta un paso y devuelve las transacciones que ha costado
+ */
+static uint32_t run_step(const step_t* step) {
+    transactions = 0;
+    spi_bytes = 0;
+    switch (step->action) {
+        case STEP_TX:
+            LMIC.freq = step->freq;
+            LMIC.rps = MAKERPS(step->sf, BW125, CR_4_5, 0, 0);
+            os_radio(RADIO_TX);
+            break;
+        case STEP_TX_DONE:
+            radio_done(IRQ_LORA_TXDONE_MASK);
+            break;
+        case STEP_RX1:
+            LMIC.rxsyms = 8;
+            os_radio(RADIO_RX);
+            break;
+        case STEP_RX_TIMEOUT:
+            radio_done(IRQ_LORA_RXTOUT_MASK);
+            break;
+        case STEP_RX_DONE:
+            regs[LORARegRxNbBytes] = 12;
+            regs[LORARegFifoRxCurrentAddr] = 0x20;
+            regs[LORARegPktSnrValue] = 40;
+            regs[LORARegPktRssiValue] = 80;
+            radio_done(IRQ_LORA_RXDONE_MASK);
+            break;
+    }
+    return transactions;
+}
+
+/**
+ * @brief Compara el banco de registros con el esperado del paso
+ */
+static void assert_registers(const step_t* step) {
+    for (u1_t addr = 0; addr < SHADOW_REGS; addr++) {
+        unsigned expected;
+        sscanf(step->registers + 2 * addr, "%2x", &expected);
+        if (regs[addr] != expected) {
+            char message[80];
+            snprintf(message, sizeof(message), "%s: registro 0x%02X = 0x%02X, esperado 0x%02X",
+                     step->name, addr, regs[addr], expected);
+            TEST_FAIL_MESSAGE(message);
+            return;
+        }
+    }
+}
+
+void setUp(void) {
+    memset(&LMIC, 0, sizeof(LMIC));
+    stub_os_ticks = 0;
+    LMIC.txpow = 14;
+    LMIC.dataLen = 20;
+    radio_power_on();
+    radio_init();
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// PRUEBAS
+// =============================================================================
+
+/**
+ * @brief Tras cada paso la radio queda igual que con el driver anterior
+ */
+void test_registers_match_reference(void) {
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        run_step(&STEPS[i]);
+        assert_registers(&STEPS[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(12, LMIC.dataLen);
+    TEST_ASSERT_EQUAL_INT(40, LMIC.snr);
+}
+
+/**
+ * @brief Transacciones SPI por paso, y la mitad o menos que antes en régimen
+ */
+void test_transaction_counts(void) {
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        char message[48];
+        snprintf(message, sizeof(message), "paso %u (%s)", i, STEPS[i].name);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(STEPS[i].transactions, run_step(&STEPS[i]), message);
+        if (i >= 4) TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(STEPS[i].old_transactions / 2, STEPS[i].transactions, message);
+    }
+}
+
+/**
+ * @brief La sombra coincide con la radio en todo registro ya escrito
+ *
+ * Salvo la FIFO y las banderas de IRQ, que el chip cambia por su cuenta.
+ */
+void test_shadow_matches_radio(void) {
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        run_step(&STEPS[i]);
+        for (u1_t addr = 0; addr < SHADOW_REGS; addr++) {
+            if (addr == RegFifo || addr == LORARegIrqFlags) continue;
+            if (!SHADOW_TEST(shadowValid, addr)) continue;
+            char message[64];
+            snprintf(message, sizeof(message), "%s: registro 0x%02X", STEPS[i].name, addr);
+            TEST_ASSERT_FALSE_MESSAGE(SHADOW_TEST(shadowDirty, addr), message);
+            TEST_ASSERT_EQUAL_HEX8_MESSAGE(regs[addr], shadow[addr], message);
+        }
+    }
+}
+
+/**
+ * @brief Un reinicio de la radio descarta la sombra y se reescribe todo
+ *
+ * Tras la secuencia, la sombra guarda la configuración del último canal; la
+ * radio vuelve a sus valores de encendido y el primer TX debe escribirlo
+ * todo como en el primer arranque.
+ */
+void test_reset_rewrites_configuration(void) {
+    for (uint8_t i = 0; i < STEP_COUNT; i++) {
+        run_step(&STEPS[i]);
+    }
+
+    setUp();
+    TEST_ASSERT_EQUAL_UINT32(STEPS[0].transactions, run_step(&STEPS[0]));
+    assert_registers(&STEPS[0]);
+}
+
+/**
+ * @brief TXDONE y RXDONE toman la hora del flanco de DIO que da la HAL, no
+ *        la de cuando se atiende (tras la latencia de la tarea o del light
+ *        sleep)
+ */
+void test_irq_uses_edge_time(void) {
+    const ostime_t edge = 100000;
+    stub_os_ticks = edge + ms2osticks(3);
+
+    run_step(&STEPS[0]);
+    regs[LORARegIrqFlags] = IRQ_LORA_TXDONE_MASK;
+    regs[RegOpMode] = (regs[RegOpMode] & ~OPMODE_MASK) | OPMODE_STANDBY;
+    radio_irq_handler_v2(0, edge);
+    TEST_ASSERT_EQUAL_INT32(edge - us2osticks(43), LMIC.txend);
+
+    run_step(&STEPS[2]);
+    regs[LORARegRxNbBytes] = 12;
+    regs[LORARegIrqFlags] = IRQ_LORA_RXDONE_MASK;
+    regs[RegOpMode] = (regs[RegOpMode] & ~OPMODE_MASK) | OPMODE_STANDBY;
+    radio_irq_handler_v2(0, edge + ms2osticks(1000));
+    TEST_ASSERT_EQUAL_INT32(edge + ms2osticks(1000) - us2osticks(3265), LMIC.rxtime);
+
+    // Sin hora de la HAL, la de os_getTime()
+    run_step(&STEPS[0]);
+    radio_done(IRQ_LORA_TXDONE_MASK);
+    TEST_ASSERT_EQUAL_INT32(stub_os_ticks - us2osticks(43), LMIC.txend);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_registers_match_reference);
+    RUN_TEST(test_transaction_counts);
+    RUN_TEST(test_shadow_matches_radio);
+    RUN_TEST(test_reset_rewrites_configuration);
+    RUN_TEST(test_irq_uses_edge_time);
+    return UNITY_END();
+}
@@ -0,0 +1,321 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del parser de configuración por downlink
+ *
+ * remote_config_parse() no toca nada fuera de la configuración que recibe:
+ * se prueba con tramas preparadas. Se compila remote_config.cpp en esta
+ * misma unidad para simular un nuevo despertar (received_this_boot) y la
+ * NVS con test/stubs/Preferences.h.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include "../../src/remote_config.cpp"
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+// BME280, DS18B20 y pH, como en config.h
+#define TEST_DRIVER_COUNT 3
+
+static float ds18b20_precision = -1;
+static uint16_t ph_samples = 0;
+
+uint8_t sensors_driver_count(void) { return TEST_DRIVER_COUNT; }
+void sensor_ds18b20_set_precision(float precision) { ds18b20_precision = precision; }
+void ph_adc_set_samples(uint16_t samples) { ph_samples = samples; }
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {}
+
+extern "C" u2_t os_crc16(xref2u1_t data, uint len) {
+    u2_t crc = 0;
+    for (uint i = 0; i < len; i++) {
+        crc ^= data[i] << 8;
+        for (u1_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// =============================================================================
+// AUXILIARES
+// =============================================================================
+
+static remote_config_t defaults;
+
+/**
+ * @brief Aplica una trama sobre los ajustes de config.h
+ */
+static remote_config_status_t parse(const uint8_t* frame, uint8_t len, remote_config_t* config, uint8_t* tag) {
+    *config = defaults;
+    return remote_config_parse(frame, len, config, tag);
+}
+
+/**
+ * @brief Simula un arranque en frío: sin memoria RTC, NVS intacta
+ */
+static void cold_boot(void) {
+    memset(&rtc_remote, 0, sizeof(rtc_remote));
+    received_this_boot = false;
+}
+
+void setUp(void) {
+    remote_config_defaults(&defaults);
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// PARSER
+// =============================================================================
+
+void test_defaults(void) {
+    TEST_ASSERT_EQUAL_UINT16(SEND_INTERVAL_SECONDS, defaults.send_interval_s);
+    TEST_ASSERT_EQUAL_UINT8(BATCH_SAMPLES_PER_UPLINK, defaults.batch_samples);
+    TEST_ASSERT_EQUAL_HEX8(0x07, defaults.sensor_mask);
+    TEST_ASSERT_EQUAL_UINT8(0, defaults.ds18b20_bits);
+    TEST_ASSERT_EQUAL_UINT16(0, defaults.ph_samples);
+    TEST_ASSERT_EQUAL_UINT8(DR_SF7, defaults.fixed_dr);
+}
+
+void test_parse_ok(void) {
+    // Intervalo 600 s, 4 muestras, DS18B20 a 10 bits, pH 64 muestras, DR fijo DR3
+    const uint8_t frame[] = { 0x01, 0x07,
+                              0x01, 2, 0x58, 0x02,
+                              0x02, 1, 4,
+                              0x04, 1, 10,
+                              0x05, 2, 64, 0,
+                              0x06, 2, REMOTE_CONFIG_DR_FIXED, 3 };
+    remote_config_t config;
+    uint8_t tag = 0xFF;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_OK, parse(frame, sizeof(frame), &config, &tag));
+    TEST_ASSERT_EQUAL_UINT8(0, tag);
+    TEST_ASSERT_EQUAL_UINT16(600, config.send_interval_s);
+    TEST_ASSERT_EQUAL_UINT8(4, config.batch_samples);
+    TEST_ASSERT_EQUAL_HEX8(defaults.sensor_mask, config.sensor_mask);
+    TEST_ASSERT_EQUAL_UINT8(10, config.ds18b20_bits);
+    TEST_ASSERT_EQUAL_UINT16(64, config.ph_samples);
+    TEST_ASSERT_EQUAL_UINT8(REMOTE_CONFIG_DR_FIXED, config.dr_policy);
+    TEST_ASSERT_EQUAL_UINT8(3, config.fixed_dr);
+}
+
+void test_parse_query_only(void) {
+    // Sin TLV: solo pide la confirmación, la configuración no cambia
+    const uint8_t frame[] = { 0x01, 0x09 };
+    remote_config_t config;
+    uint8_t tag;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_OK, parse(frame, sizeof(frame), &config, &tag));
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+}
+
+void test_parse_bad_version(void) {
+    const uint8_t frame[] = { REMOTE_CONFIG_VERSION + 1, 0x01, 0x02, 1, 4 };
+    remote_config_t config;
+    uint8_t tag;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_BAD_VERSION, parse(frame, sizeof(frame), &config, &tag));
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+}
+
+void test_parse_malformed(void) {
+    remote_config_t config;
+    uint8_t tag;
+
+    // Sin secuencia
+    const uint8_t short_frame[] = { 0x01 };
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_MALFORMED, parse(short_frame, sizeof(short_frame), &config, &tag));
+
+    // Etiqueta sin longitud
+    const uint8_t dangling[] = { 0x01, 0x03, 0x02 };
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_MALFORMED, parse(dangling, sizeof(dangling), &config, &tag));
+
+    // Valor truncado tras un TLV válido
+    const uint8_t truncated[] = { 0x01, 0x03, 0x02, 1, 4, 0x01, 2, 0x58 };
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_MALFORMED, parse(truncated, sizeof(truncated), &config, &tag));
+    TEST_ASSERT_EQUAL_HEX8(REMOTE_CONFIG_TAG_INTERVAL, tag);
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+
+    // Longitud que no corresponde a la etiqueta
+    const uint8_t wrong_len[] = { 0x01, 0x03, 0x02, 2, 4, 0 };
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_MALFORMED, parse(wrong_len, sizeof(wrong_len), &config, &tag));
+    TEST_ASSERT_EQUAL_HEX8(REMOTE_CONFIG_TAG_BATCH, tag);
+
+    const uint8_t defaults_len[] = { 0x01, 0x03, 0x7F, 1, 0 };
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_MALFORMED, parse(defaults_len, sizeof(defaults_len), &config, &tag));
+    TEST_ASSERT_EQUAL_HEX8(REMOTE_CONFIG_TAG_DEFAULTS, tag);
+}
+
+void test_parse_unknown_tag(void) {
+    const uint8_t frame[] = { 0x01, 0x04, 0x02, 1, 8, 0x20, 0 };
+    remote_config_t config;
+    uint8_t tag;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_UNKNOWN_TAG, parse(frame, sizeof(frame), &config, &tag));
+    TEST_ASSERT_EQUAL_HEX8(0x20, tag);
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+}
+
+void test_parse_out_of_range(void) {
+    struct {
+        uint8_t frame[6];
+        uint8_t len;
+        uint8_t tag;
+    } const cases[] = {
+        { { 0x01, 0x05, 0x01, 2, 10, 0 }, 6, REMOTE_CONFIG_TAG_INTERVAL },              // 10 s
+        { { 0x01, 0x05, 0x01, 2, 0x11, 0x0E }, 6, REMOTE_CONFIG_TAG_INTERVAL },         // 3601 s
+        { { 0x01, 0x05, 0x02, 1, 0 }, 5, REMOTE_CONFIG_TAG_BATCH },                     // 0 muestras
+        { { 0x01, 0x05, 0x02, 1, BATCH_BUFFER_RECORDS + 1 }, 5, REMOTE_CONFIG_TAG_BATCH },
+        { { 0x01, 0x05, 0x03, 1, 1 << TEST_DRIVER_COUNT }, 5, REMOTE_CONFIG_TAG_SENSORS },
+        { { 0x01, 0x05, 0x04, 1, 8 }, 5, REMOTE_CONFIG_TAG_DS18B20_BITS },
+        { { 0x01, 0x05, 0x04, 1, 13 }, 5, REMOTE_CONFIG_TAG_DS18B20_BITS },
+        { { 0x01, 0x05, 0x05, 2, PH_SAMPLES_MIN - 1, 0 }, 6, REMOTE_CONFIG_TAG_PH_SAMPLES },
+        { { 0x01, 0x05, 0x05, 2, 0x01, 0x01 }, 6, REMOTE_CONFIG_TAG_PH_SAMPLES },       // 257
+        { { 0x01, 0x05, 0x06, 1, 3 }, 5, REMOTE_CONFIG_TAG_DR_POLICY },
+        { { 0x01, 0x05, 0x06, 2, REMOTE_CONFIG_DR_FIXED, DR_SF7 + 1 }, 6, REMOTE_CONFIG_TAG_DR_POLICY },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        remote_config_t config;
+        uint8_t tag;
+        char msg[32];
+        snprintf(msg, sizeof(msg), "caso %u", (unsigned)i);
+        TEST_ASSERT_EQUAL_MESSAGE(REMOTE_CONFIG_BAD_VALUE, parse(cases[i].frame, cases[i].len, &config, &tag), msg);
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(cases[i].tag, tag, msg);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&defaults, &config, sizeof(config), msg);
+    }
+}
+
+void test_parse_rollback(void) {
+    // Tres TLV válidos y el cuarto fuera de rango: no se aplica ninguno
+    remote_config_t config = defaults;
+    config.batch_samples = 6;
+    config.ds18b20_bits = 11;
+    remote_config_t before = config;
+    const uint8_t frame[] = { 0x01, 0x0A,
+                              0x01, 2, 0x58, 0x02,
+                              0x02, 1, 2,
+                              0x04, 1, 12,
+                              0x06, 1, 7 };
+    uint8_t tag;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_BAD_VALUE, remote_config_parse(frame, sizeof(frame), &config, &tag));
+    TEST_ASSERT_EQUAL_HEX8(REMOTE_CONFIG_TAG_DR_POLICY, tag);
+    TEST_ASSERT_EQUAL_MEMORY(&before, &config, sizeof(config));
+}
+
+void test_parse_defaults_tag(void) {
+    // DEFAULTS vuelve a config.h y los TLV siguientes se aplican encima
+    remote_config_t config = defaults;
+    config.send_interval_s = 900;
+    config.batch_samples = 9;
+    config.ds18b20_bits = 11;
+    const uint8_t frame[] = { 0x01, 0x0B, 0x7F, 0, 0x02, 1, 3 };
+    uint8_t tag;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_OK, remote_config_parse(frame, sizeof(frame), &config, &tag));
+    TEST_ASSERT_EQUAL_UINT16(SEND_INTERVAL_SECONDS, config.send_interval_s);
+    TEST_ASSERT_EQUAL_UINT8(3, config.batch_samples);
+    TEST_ASSERT_EQUAL_UINT8(0, config.ds18b20_bits);
+}
+
+// =============================================================================
+// DOWNLINK, NVS Y CONFIRMACIÓN
+// =============================================================================
+
+void test_downlink_persists_and_acks(void) {
+    stub_nvs.clear();
+    stub_nvs_writes = 0;
+    cold_boot();
+    TEST_ASSERT_EQUAL_UINT16(SEND_INTERVAL_SECONDS, remote_config_get()->send_interval_s);
+
+    // Otro FPort no es de configuración
+    const uint8_t frame[] = { 0x01, 42, 0x01, 2, 0x58, 0x02, 0x04, 1, 12 };
+    TEST_ASSERT_FALSE(remote_config_on_downlink(REMOTE_CONFIG_FPORT + 1, frame, sizeof(frame)));
+    TEST_ASSERT_FALSE(remote_config_ack_pending());
+
+    TEST_ASSERT_TRUE(remote_config_on_downlink(REMOTE_CONFIG_FPORT, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT16(600, remote_config_get()->send_interval_s);
+    TEST_ASSERT_EQUAL_UINT(1, stub_nvs_writes);
+    // Se confirma en el ciclo siguiente, no en el del downlink
+    TEST_ASSERT_FALSE(remote_config_ack_pending());
+
+    // El mismo comando otra vez no reescribe NVS
+    TEST_ASSERT_TRUE(remote_config_on_downlink(REMOTE_CONFIG_FPORT, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT(1, stub_nvs_writes);
+
+    remote_config_apply();
+    TEST_ASSERT_EQUAL_FLOAT(0.0625f, ds18b20_precision);
+    TEST_ASSERT_EQUAL_UINT16(PH_ADC_SAMPLES, ph_samples);
+
+    // Siguiente despertar: confirmación con la secuencia y la configuración vigente
+    received_this_boot = false;
+    TEST_ASSERT_TRUE(remote_config_ack_pending());
+    uint8_t ack[REMOTE_CONFIG_ACK_SIZE];
+    TEST_ASSERT_EQUAL_UINT8(REMOTE_CONFIG_ACK_SIZE, remote_config_build_ack(ack));
+    const uint8_t expected_head[] = { REMOTE_CONFIG_VERSION, 42, REMOTE_CONFIG_OK, 0, 0x01, 2, 0x58, 0x02 };
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected_head, ack, sizeof(expected_head));
+
+    // Los TLV de la confirmación, como downlink, reproducen la configuración
+    uint8_t echo[REMOTE_CONFIG_ACK_SIZE - 2];
+    echo[0] = REMOTE_CONFIG_VERSION;
+    echo[1] = 0;
+    memcpy(&echo[2], &ack[4], REMOTE_CONFIG_ACK_SIZE - 4);
+    remote_config_t config = defaults;
+    TEST_ASSERT_EQUAL(REMOTE_CONFIG_OK, remote_config_parse(echo, sizeof(echo), &config, NULL));
+    TEST_ASSERT_EQUAL_MEMORY(remote_config_get(), &config, sizeof(config));
+
+    remote_config_ack_sent();
+    TEST_ASSERT_FALSE(remote_config_ack_pending());
+
+    // Arranque en frío: los ajustes vuelven de NVS
+    cold_boot();
+    TEST_ASSERT_EQUAL_UINT16(600, remote_config_get()->send_interval_s);
+    TEST_ASSERT_EQUAL_UINT8(12, remote_config_get()->ds18b20_bits);
+}
+
+void test_rejected_downlink_acks_error(void) {
+    stub_nvs.clear();
+    stub_nvs_writes = 0;
+    cold_boot();
+
+    const uint8_t frame[] = { 0x01, 43, 0x02, 1, 0 };
+    TEST_ASSERT_TRUE(remote_config_on_downlink(REMOTE_CONFIG_FPORT, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT(0, stub_nvs_writes);
+    TEST_ASSERT_EQUAL_UINT8(BATCH_SAMPLES_PER_UPLINK, remote_config_get()->batch_samples);
+
+    received_this_boot = false;
+    uint8_t ack[REMOTE_CONFIG_ACK_SIZE];
+    remote_config_build_ack(ack);
+    TEST_ASSERT_EQUAL_UINT8(43, ack[1]);
+    TEST_ASSERT_EQUAL_UINT8(REMOTE_CONFIG_BAD_VALUE, ack[2]);
+    TEST_ASSERT_EQUAL_HEX8(REMOTE_CONFIG_TAG_BATCH, ack[3]);
+}
+
+void test_corrupt_nvs_falls_back_to_defaults(void) {
+    stub_nvs.clear();
+    cold_boot();
+    const uint8_t frame[] = { 0x01, 44, 0x02, 1, 5 };
+    remote_config_on_downlink(REMOTE_CONFIG_FPORT, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_UINT8(5, remote_config_get()->batch_samples);
+
+    // Un bit cambiado en NVS: el CRC no cuadra
+    stub_nvs["config"][offsetof(remote_config_stored_t, config)] ^= 0x01;
+    cold_boot();
+    TEST_ASSERT_EQUAL_MEMORY(&defaults, remote_config_get(), sizeof(defaults));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_defaults);
+    RUN_TEST(test_parse_ok);
+    RUN_TEST(test_parse_query_only);
+    RUN_TEST(test_parse_bad_version);
+    RUN_TEST(test_parse_malformed);
+    RUN_TEST(test_parse_unknown_tag);
+    RUN_TEST(test_parse_out_of_range);
+    RUN_TEST(test_parse_rollback);
+    RUN_TEST(test_parse_defaults_tag);
+    RUN_TEST(test_downlink_persists_and_acks);
+    RUN_TEST(test_rejected_downlink_acks_error);
+    RUN_TEST(test_corrupt_nvs_falls_back_to_defaults);
+    return UNITY_END();
+}
@@ -0,0 +1,336 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del planificador: reloj y políticas sobre trazas
+ *
+ * Se simulan semanas de ciclos de medida con una batería y un panel solar
+ * modelados: cada despertar pasa por scheduler_plan() con la política
+ * elegida (SCHEDULER_POLICY es aquí una variable de la prueba) y el reloj
+ * avanza con scheduler_on_sleep(), como en el firmware. Las trazas son la
+ * corriente del panel hora a hora de días tipo soleado y nublado. Se
+ * comparan las políticas por muestras tomadas, horas sin batería y energía
+ * por muestra.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include "../../config/config.h"
+
+// La política se elige en cada simulación
+#undef SCHEDULER_POLICY
+#define SCHEDULER_POLICY sim_policy
+static uint8_t sim_policy = 0;
+
+#include "../../src/scheduler.cpp"
+
+// =============================================================================
+// MODELO DE BATERÍA Y PANEL
+// =============================================================================
+
+// Perfil de consumo de docs/9_troubleshooting.md: 120 mA durante 2 s y
+// 25 mA durante 8 s por ciclo, 20 µA en sueño profundo
+#define SIM_CAPACITY_UAH  1000000   // 1000 mAh
+#define SIM_CYCLE_UAH     122       // Carga de un ciclo despierto
+#define SIM_AWAKE_MS      10300     // Ciclo despierto (no múltiplo de 1 s)
+#define SIM_SLEEP_UA      20        // Sueño profundo
+#define SIM_RESTART_PCT   5         // El nodo vuelve a arrancar con esta carga
+
+// Corriente del panel (mA) en cada hora del día
+static const uint8_t DAY_SUNNY[24] = {
+    0, 0, 0, 0, 0, 0, 0, 5, 20, 40, 60, 75, 80, 80, 75, 60, 40, 20, 5, 0, 0, 0, 0, 0
+};
+static const uint8_t DAY_CLOUDY[24] = {
+    0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0
+};
+
+/**
+ * @brief Resultado de una simulación
+ */
+typedef struct {
+    uint32_t samples;          /**< Ciclos de medida completos */
+    uint32_t off_s;            /**< Tiempo con el nodo apagado por batería */
+    uint64_t consumed_uah;     /**< Carga consumida por el nodo */
+    uint32_t min_interval_s;
+    uint32_t max_interval_s;
+    uint8_t  min_soc;
+    uint8_t  end_soc;
+} sim_result_t;
+
+static const uint8_t* const* sim_trace;
+static uint8_t sim_days;
+static int64_t sim_charge_uah;
+static uint64_t sim_now_ms;  // Hora real desde la medianoche del primer día
+static battery_status_t sim_battery;
+static remote_config_t sim_config;
+
+static uint8_t sim_soc(void) {
+    return (uint8_t)(sim_charge_uah * 100 / SIM_CAPACITY_UAH);
+}
+
+static uint8_t sim_panel_ma(uint64_t t_ms) {
+    uint32_t t_s = (uint32_t)(t_ms / 1000);
+    uint32_t day = t_s / 86400;
+    if (day >= sim_days) day = sim_days - 1;  // El último sueño puede pasarse de la traza
+    return sim_trace[day][(t_s / 3600) % 24];
+}
+
+/**
+ * @brief Avanza la hora real: carga del panel menos el consumo del nodo
+ */
+static void sim_advance(uint64_t ms, uint32_t load_ua) {
+    uint64_t end_ms = sim_now_ms + ms;
+    while (sim_now_ms < end_ms) {
+        uint64_t step = 3600000 - sim_now_ms % 3600000;
+        if (step > end_ms - sim_now_ms) step = end_ms - sim_now_ms;
+        int64_t net_ua = (int64_t)sim_panel_ma(sim_now_ms) * 1000 - load_ua;
+        sim_charge_uah += net_ua * (int64_t)step / 3600000;
+        if (sim_charge_uah > SIM_CAPACITY_UAH) sim_charge_uah = SIM_CAPACITY_UAH;
+        if (sim_charge_uah < 0) sim_charge_uah = 0;
+        sim_now_ms += step;
+    }
+}
+
+/**
+ * @brief Recorre la traza (un puntero a 24 horas por día) con una política
+ */
+static sim_result_t simulate(uint8_t policy, const uint8_t* const* trace, uint8_t days, uint8_t soc) {
+    sim_result_t result = {};
+    result.min_interval_s = UINT32_MAX;
+    result.min_soc = 100;
+
+    sim_policy = policy;
+    sim_trace = trace;
+    sim_days = days;
+    sim_charge_uah = (int64_t)SIM_CAPACITY_UAH * soc / 100;
+    sim_now_ms = 0;
+    rtc_scheduler.magic = 0;  // Encendido
+
+    uint64_t end_ms = days * 86400000ULL;
+    while (sim_now_ms < end_ms) {
+        if (sim_charge_uah < SIM_CYCLE_UAH) {
+            // Sin batería: apagado hasta que el panel la recupere, y el
+            // arranque pierde la memoria RTC
+            while (sim_now_ms < end_ms && sim_soc() < SIM_RESTART_PCT) {
+                sim_advance(60000, 0);
+                result.off_s += 60;
+            }
+            rtc_scheduler.magic = 0;
+            continue;
+        }
+
+        sim_charge_uah -= SIM_CYCLE_UAH;
+        result.consumed_uah += SIM_CYCLE_UAH;
+        uint8_t panel_ma = sim_panel_ma(sim_now_ms);
+        sim_battery.soc_percent = sim_soc();
+        sim_battery.battery_mv = 3400 + (uint16_t)(sim_charge_uah * 800 / SIM_CAPACITY_UAH);
+        sim_battery.vbus = panel_ma > 0;
+        sim_battery.charging = sim_battery.vbus && sim_battery.soc_percent < 100;
+
+        stub_millis = SIM_AWAKE_MS;
+        uint32_t interval = scheduler_plan(0);
+        scheduler_on_sleep(interval);
+        stub_millis = 0;
+
+        sim_advance(SIM_AWAKE_MS, 0);
+        sim_advance(interval * 1000ULL, SIM_SLEEP_UA);
+        result.consumed_uah += (uint64_t)SIM_SLEEP_UA * interval / 3600;
+        result.samples++;
+        if (interval < result.min_interval_s) result.min_interval_s = interval;
+        if (interval > result.max_interval_s) result.max_interval_s = interval;
+        if (sim_soc() < result.min_soc) result.min_soc = sim_soc();
+    }
+    result.end_soc = sim_soc();
+    return result;
+}
+
+/**
+ * @brief Energía media por muestra (µAh)
+ */
+static uint32_t uah_per_sample(const sim_result_t* r) {
+    return r->samples ? (uint32_t)(r->consumed_uah / r->samples) : 0;
+}
+
+static void report(const char* name, const sim_result_t* r) {
+    char line[160];
+    snprintf(line, sizeof(line), "%s: %u muestras, %u µAh/muestra, %u h apagado, SoC mín %u %%, final %u %%",
+             name, (unsigned)r->samples, (unsigned)uah_per_sample(r), (unsigned)(r->off_s / 3600),
+             r->min_soc, r->end_soc);
+    TEST_MESSAGE(line);
+}
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+bool battery_soc_update(void) { return true; }
+const battery_status_t* battery_status(void) { return &sim_battery; }
+const remote_config_t* remote_config_get(void) { return &sim_config; }
+void logger_printf(const char* fmt, ...) {}
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {}
+
+static uint8_t stub_batch_count = 0;
+uint8_t batch_count(void) { return stub_batch_count; }
+
+void setUp(void) {
+    memset(&rtc_scheduler, 0, sizeof(rtc_scheduler));
+    memset(&sim_battery, 0, sizeof(sim_battery));
+    memset(&sim_config, 0, sizeof(sim_config));
+    sim_config.send_interval_s = SEND_INTERVAL_SECONDS;
+    stub_millis = 0;
+    stub_batch_count = 0;
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// RELOJ
+// =============================================================================
+
+/**
+ * @brief 2,7 s despierto por ciclo: el reloj no pierde los 0,7 s de cada uno
+ */
+void test_clock_keeps_ms_remainder(void) {
+    for (int i = 0; i < 1000; i++) {
+        stub_millis = 2700;
+        scheduler_on_sleep(300);
+    }
+    stub_millis = 0;
+    TEST_ASSERT_EQUAL_UINT32(1000 * 300 + 2700, scheduler_clock_s());
+
+    // A mitad de ciclo el resto guardado se suma a millis()
+    stub_millis = 2700;
+    scheduler_on_sleep(300);
+    stub_millis = 400;
+    TEST_ASSERT_EQUAL_UINT32(1001 * 300 + 2702 + 1, scheduler_clock_s());
+}
+
+/**
+ * @brief El reloj del planificador sigue a la hora real en una semana simulada
+ */
+void test_clock_follows_simulated_time(void) {
+    const uint8_t* week[7];
+    for (int d = 0; d < 7; d++) week[d] = DAY_SUNNY;
+    simulate(1, week, 7, 60);
+    TEST_ASSERT_EQUAL_UINT32(sim_now_ms / 1000, scheduler_clock_s());
+}
+
+// =============================================================================
+// POLÍTICAS
+// =============================================================================
+
+/**
+ * @brief Las políticas son funciones puras del estado
+ */
+void test_policies_are_pure(void) {
+    scheduler_state_t state = {};
+    state.battery_mv = 3700;
+    state.soc_percent = 40;
+    state.trend_mv_per_hour = -5;
+    state.hour = 22;
+    state.base_interval_s = 300;
+
+    for (uint8_t i = 0; i < scheduler_policy_count(); i++) {
+        const scheduler_policy_t* policy = scheduler_policy(i);
+        TEST_ASSERT_NOT_NULL(policy);
+        scheduler_state_t copy = state;
+        uint32_t first = policy->next_interval(&copy);
+        TEST_ASSERT_EQUAL_UINT32(first, policy->next_interval(&copy));
+        TEST_ASSERT_EQUAL_MEMORY(&state, &copy, sizeof(state));
+    }
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler_policy(0)->next_interval(&state));
+    TEST_ASSERT_EQUAL_UINT32(1200, scheduler_policy(1)->next_interval(&state));
+    TEST_ASSERT_NULL(scheduler_policy(scheduler_policy_count()));
+}
+
+/**
+ * @brief Semana soleada: la adaptativa mide más a menudo con el excedente
+ */
+void test_sunny_week_adaptive_uses_surplus(void) {
+    const uint8_t* week[7];
+    for (int d = 0; d < 7; d++) week[d] = DAY_SUNNY;
+
+    sim_result_t fixed = simulate(0, week, 7, 60);
+    sim_result_t adaptive = simulate(1, week, 7, 60);
+    report("fija", &fixed);
+    report("adaptativa", &adaptive);
+
+    TEST_ASSERT_EQUAL_UINT32(0, fixed.off_s);
+    TEST_ASSERT_EQUAL_UINT32(0, adaptive.off_s);
+    TEST_ASSERT_GREATER_THAN(fixed.samples, adaptive.samples);
+    TEST_ASSERT_LESS_OR_EQUAL(uah_per_sample(&fixed), uah_per_sample(&adaptive));
+    TEST_ASSERT_GREATER_OR_EQUAL(SCHEDULER_MIN_INTERVAL_SECONDS, adaptive.min_interval_s);
+    TEST_ASSERT_GREATER_OR_EQUAL(90, adaptive.end_soc);
+}
+
+/**
+ * @brief Tres semanas nubladas: la fija agota la batería, la adaptativa no
+ */
+void test_cloudy_weeks_adaptive_stays_on(void) {
+    const uint8_t* days[21];
+    for (int d = 0; d < 21; d++) days[d] = DAY_CLOUDY;
+
+    sim_result_t fixed = simulate(0, days, 21, 25);
+    sim_result_t adaptive = simulate(1, days, 21, 25);
+    report("fija", &fixed);
+    report("adaptativa", &adaptive);
+
+    TEST_ASSERT_GREATER_THAN(0, fixed.off_s);
+    TEST_ASSERT_EQUAL_UINT32(0, adaptive.off_s);
+    TEST_ASSERT_GREATER_THAN(fixed.min_soc, adaptive.min_soc);
+    TEST_ASSERT_LESS_OR_EQUAL(SCHEDULER_MAX_INTERVAL_SECONDS, adaptive.max_interval_s);
+}
+
+/**
+ * @brief Mezcla de días: ninguna política sale de los límites del intervalo
+ */
+void test_mixed_trace_within_limits(void) {
+    const uint8_t* days[10] = {
+        DAY_SUNNY, DAY_CLOUDY, DAY_CLOUDY, DAY_SUNNY, DAY_CLOUDY,
+        DAY_CLOUDY, DAY_CLOUDY, DAY_SUNNY, DAY_SUNNY, DAY_CLOUDY
+    };
+
+    for (uint8_t i = 0; i < scheduler_policy_count(); i++) {
+        sim_result_t r = simulate(i, days, 10, 30);
+        report(scheduler_policy(i)->name, &r);
+        TEST_ASSERT_GREATER_OR_EQUAL(SCHEDULER_MIN_INTERVAL_SECONDS, r.min_interval_s);
+        TEST_ASSERT_LESS_OR_EQUAL(SCHEDULER_MAX_INTERVAL_SECONDS, r.max_interval_s);
+        TEST_ASSERT_GREATER_OR_EQUAL(SIM_CYCLE_UAH, uah_per_sample(&r));
+    }
+}
+
+/**
+ * @brief Con registros en el lote el intervalo no cambia, ni por la política
+ *        ni por un intervalo nuevo por downlink ni por el duty cycle
+ */
+void test_interval_frozen_while_batch_pending(void) {
+    sim_policy = 0;
+    sim_config.send_interval_s = 300;
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler_plan(0));
+
+    // Envío parcial o aplazado: el downlink y el tiempo en el aire no cuentan
+    stub_batch_count = 2;
+    sim_config.send_interval_s = 900;
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler_plan(0));
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler_plan(5000000));
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler_interval());
+
+    // Lote vacío: se replanifica con el intervalo nuevo
+    stub_batch_count = 0;
+    TEST_ASSERT_EQUAL_UINT32(900, scheduler_plan(0));
+    TEST_ASSERT_EQUAL_UINT32(900, scheduler_interval());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_clock_keeps_ms_remainder);
+    RUN_TEST(test_clock_follows_simulated_time);
+    RUN_TEST(test_policies_are_pure);
+    RUN_TEST(test_sunny_week_adaptive_uses_surplus);
+    RUN_TEST(test_cloudy_weeks_adaptive_stays_on);
+    RUN_TEST(test_mixed_trace_within_limits);
+    RUN_TEST(test_interval_frozen_while_batch_pending);
+    return UNITY_END();
+}
@@ -0,0 +1,386 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del decoder TTN generado: ida y vuelta con node
+ *
+ * Se codifican lecturas de sensor_data_t con payload_codec.cpp, se genera
+ * el decoder con generate_ttn_decoder_string() y se ejecuta decodeUplink()
+ * en node sobre las mismas tramas. Cada campo decodificado debe quedar a
+ * medio paso de la lectura original, o ser null si no había lectura o
+ * estaba fuera de rango. Cubre tramas simples (lecturas típicas, límites y
+ * un barrido aleatorio), por lotes con deltas y valores completos, y tramas
+ * truncadas o de tamaño incorrecto.
+ *
+ * Sin node en el PATH las pruebas se ignoran.
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include <string>
+#include <unistd.h>
+#include "../../src/payload_codec.cpp"
+#include "../../src/ttn_decoder_generator.cpp"
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+static battery_status_t battery;
+
+const battery_status_t* battery_status(void) { return &battery; }
+uint8_t batteryPercentFromMillivolts(uint16_t millivolts) { return millivolts >= 4000 ? 90 : 30; }
+bool isFastBoot(void) { return false; }
+void logger_flush(void) {}
+const char* profiler_phase_name(uint8_t phase) { return "phase"; }
+uint8_t sensors_driver_count(void) { return 0; }
+const sensor_driver_t* sensors_driver(uint8_t index) { return NULL; }
+uint8_t batch_samples_per_uplink(void) { return 1; }
+
+// =============================================================================
+// LECTURAS
+// =============================================================================
+
+#define ALL_FIELDS (SENSOR_FIELDS_SENSORS | SENSOR_FIELD_BATTERY)
+
+// FPort de las tramas de una sola muestra (pgm_board.cpp)
+#define SINGLE_FPORT 1
+
+/**
+ * @brief Lectura con el estado de carga que da el medidor en ese momento
+ */
+typedef struct {
+    uint8_t soc_percent;
+    sensor_data_t data;   /**< temperature, humidity, pressure, temperature_1m, ph, battery, valid_mask */
+} reading_t;
+
+static const reading_t READINGS[] = {
+    // Mediodía: todo válido
+    { 87, { 2354, 5523, 101325, 1812, 712, 4105, ALL_FIELDS } },
+    // Madrugada bajo cero
+    { 64, { -312, 9120, 98760, 905, 698, 3890, ALL_FIELDS } },
+    // Sin DS18B20 ni pH
+    { 41, { 1500, 4000, 100000, 0, 0, 3720, ALL_FIELDS & ~(SENSOR_FIELD_TEMPERATURE_1M | SENSOR_FIELD_PH) } },
+    // Máximos de cada campo
+    { 100, { 8500, 10000, 110000, 5000, 1400, 4200, ALL_FIELDS } },
+    // Mínimos de cada campo
+    { 0, { -4000, 0, 30000, -1000, 0, 3300, ALL_FIELDS } },
+    // Fuera de rango por una unidad
+    { 50, { -4001, 10001, 110001, 5001, 1401, 3800, ALL_FIELDS } },
+    // Sin ninguna lectura
+    { 50, { 0, 0, 0, 0, 0, 0, 0 } },
+};
+
+/// Script de node en construcción: decoder generado y comprobaciones
+static std::string script;
+static uint16_t checks;
+
+/**
+ * @brief Valor físico que debe devolver el decoder para un campo, o NaN
+ *        si no hay lectura
+ */
+static double expected_value(const payload_field_t* field, const reading_t* reading) {
+    if (!(reading->data.valid_mask & field->valid_bit)) return NAN;
+    int32_t raw = *(const int32_t*)((const uint8_t*)&reading->data + field->offset);
+#ifdef BATTERY_AS_PERCENTAGE
+    if (field->valid_bit == SENSOR_FIELD_BATTERY) raw = reading->soc_percent;
+#endif
+    double value = (double)raw / (field->raw_step * field->scale);
+    return value < field->min || value > field->max ? NAN : value;
+}
+
+/**
+ * @brief Objeto JavaScript con los valores esperados de una lectura
+ */
+static std::string expected_object(const reading_t* reading, int32_t age_seconds) {
+    std::string object = "{";
+    char item[64];
+    for (uint8_t i = 0; i < payload_codec_field_count(); i++) {
+        const payload_field_t* field = payload_codec_field(i);
+        double value = expected_value(field, reading);
+        if (isnan(value)) {
+            snprintf(item, sizeof(item), "%s: null, ", field->name);
+        } else {
+            snprintf(item, sizeof(item), "%s: %.6f, ", field->name, value);
+        }
+        object += item;
+    }
+    if (age_seconds >= 0) {
+        snprintf(item, sizeof(item), "age_seconds: %ld, ", (long)age_seconds);
+        object += item;
+    }
+    return object + "}";
+}
+
+/**
+ * @brief Array JavaScript con los bytes de una trama
+ */
+static std::string bytes_array(const uint8_t* bytes, uint8_t size) {
+    std::string array = "[";
+    char item[8];
+    for (uint8_t i = 0; i < size; i++) {
+        snprintf(item, sizeof(item), "%u,", bytes[i]);
+        array += item;
+    }
+    return array + "]";
+}
+
+/**
+ * @brief Añade una comprobación al script
+ */
+static void add_check(const char* call, const char* label, uint8_t fport, const uint8_t* bytes, uint8_t size,
+                      const std::string& expected) {
+    script += std::string(call) + "('" + label + "', " + std::to_string(fport) + ", " +
+              bytes_array(bytes, size) + ", " + expected + ");\n";
+    checks++;
+}
+
+/**
+ * @brief Cuantiza una lectura con el estado de carga indicado
+ */
+static void quantize(const reading_t* reading, payload_record_t* record) {
+    battery.soc_source = BATTERY_SOC_GAUGE;
+    battery.soc_percent = reading->soc_percent;
+    payload_codec_quantize(&reading->data, record);
+}
+
+/**
+ * @brief Codifica una lectura como trama simple y la añade al script
+ */
+static void check_single(const reading_t* reading, const char* label) {
+    payload_record_t record;
+    quantize(reading, &record);
+
+    uint8_t frame[16];
+    payload_bitwriter_t writer;
+    payload_codec_writer_init(&writer, frame, sizeof(frame));
+    TEST_ASSERT_TRUE(payload_codec_write_record(&writer, &record, NULL));
+    add_check("checkRecord", label, SINGLE_FPORT, frame, payload_codec_writer_bytes(&writer),
+              expected_object(reading, -1));
+}
+
+/**
+ * @brief Codifica lecturas como trama por lotes (batch.h) y la añade al script
+ *
+ * @return Bytes de la trama
+ */
+static uint8_t check_batch(const reading_t* readings, uint8_t count, uint8_t pending, uint16_t interval_s,
+                           const char* label, uint8_t* frame, uint8_t max_size) {
+    frame[0] = count;
+    frame[1] = pending;
+    frame[2] = interval_s & 0xFF;
+    frame[3] = interval_s >> 8;
+
+    payload_bitwriter_t writer;
+    payload_codec_writer_init(&writer, frame + BATCH_HEADER_SIZE, max_size - BATCH_HEADER_SIZE);
+    payload_record_t records[2];
+    std::string expected = "[";
+    for (uint8_t i = 0; i < count; i++) {
+        quantize(&readings[i], &records[i & 1]);
+        TEST_ASSERT_TRUE(payload_codec_write_record(&writer, &records[i & 1], i ? &records[(i - 1) & 1] : NULL));
+        expected += expected_object(&readings[i], (int32_t)(count - 1 - i + pending) * interval_s) + ",";
+    }
+    uint8_t size = BATCH_HEADER_SIZE + payload_codec_writer_bytes(&writer);
+    add_check("checkBatch", label, BATCH_FPORT, frame, size, expected + "]");
+    return size;
+}
+
+/**
+ * @brief Ejecuta el script en node
+ *
+ * @return Salida de node (una línea por comprobación)
+ */
+static std::string run_node(void) {
+    char path[] = "/tmp/test_ttn_decoder_XXXXXX.js";
+    int fd = mkstemps(path, 3);
+    TEST_ASSERT_TRUE_MESSAGE(fd >= 0, "no se pudo crear el script temporal");
+    FILE* file = fdopen(fd, "w");
+    fputs(script.c_str(), file);
+    fclose(file);
+
+    std::string command = std::string("node ") + path + " 2>&1";
+    std::string output;
+    FILE* pipe = popen(command.c_str(), "r");
+    char line[512];
+    while (pipe && fgets(line, sizeof(line), pipe)) output += line;
+    if (pipe) pclose(pipe);
+    unlink(path);
+    return output;
+}
+
+/**
+ * @brief Comprueba que node ejecutó todas las comprobaciones sin fallos
+ */
+static void assert_node_ok(void) {
+    std::string output = run_node();
+    size_t fail = output.find("FAIL");
+    if (fail != std::string::npos) {
+        TEST_FAIL_MESSAGE(output.substr(fail, output.find('\n', fail) - fail).c_str());
+    }
+    uint16_t passed = 0;
+    for (size_t pos = output.find("ok "); pos != std::string::npos; pos = output.find("ok ", pos + 1)) passed++;
+    TEST_ASSERT_EQUAL_UINT16_MESSAGE(checks, passed, output.c_str());
+}
+
+// Comprobaciones en JavaScript: cada campo a medio paso del esperado
+static const char HARNESS[] =
+    "function near(name, got, want) {\n"
+    "  if (want === null) return got === null;\n"
+    "  if (typeof got !== 'number') return false;\n"
+    "  var field = FIELDS.filter(function (f) { return f.name === name; })[0];\n"
+    "  var tolerance = field ? 0.5 / field.scale + 1e-9 : 0;\n"
+    "  return Math.abs(got - want) <= tolerance;\n"
+    "}\n"
+    "function compare(label, got, want) {\n"
+    "  for (var name in want) {\n"
+    "    if (!near(name, got[name], want[name])) {\n"
+    "      console.log('FAIL ' + label + ': ' + name + ' = ' + got[name] + ', esperado ' + want[name]);\n"
+    "      return false;\n"
+    "    }\n"
+    "  }\n"
+    "  if (Object.keys(got).length !== Object.keys(want).length) {\n"
+    "    console.log('FAIL ' + label + ': campos ' + Object.keys(got).join(','));\n"
+    "    return false;\n"
+    "  }\n"
+    "  return true;\n"
+    "}\n"
+    "function checkRecord(label, fPort, bytes, want) {\n"
+    "  var out = decodeUplink({ bytes: bytes, fPort: fPort });\n"
+    "  if (out.errors && out.errors.length) return console.log('FAIL ' + label + ': ' + out.errors);\n"
+    "  if (compare(label, out.data, want)) console.log('ok ' + label);\n"
+    "}\n"
+    "function checkBatch(label, fPort, bytes, want) {\n"
+    "  var out = decodeUplink({ bytes: bytes, fPort: fPort });\n"
+    "  if (out.errors && out.errors.length) return console.log('FAIL ' + label + ': ' + out.errors);\n"
+    "  if (out.data.records.length !== want.length) return console.log('FAIL ' + label + ': ' + out.data.records.length + ' registros');\n"
+    "  for (var i = 0; i < want.length; i++) {\n"
+    "    if (!compare(label + ' registro ' + i, out.data.records[i], want[i])) return;\n"
+    "  }\n"
+    "  console.log('ok ' + label);\n"
+    "}\n"
+    "function checkError(label, fPort, bytes, kind) {\n"
+    "  var out = decodeUplink({ bytes: bytes, fPort: fPort });\n"
+    "  if (out[kind] && out[kind].length) console.log('ok ' + label);\n"
+    "  else console.log('FAIL ' + label + ': sin ' + kind);\n"
+    "}\n";
+
+void setUp(void) {
+    memset(&battery, 0, sizeof(battery));
+    checks = 0;
+
+    static char decoder[16384];
+    uint16_t size = generate_ttn_decoder_string(decoder, sizeof(decoder));
+    TEST_ASSERT_GREATER_THAN(0, size);
+    TEST_ASSERT_LESS_THAN_MESSAGE(sizeof(decoder) - 1, size, "decoder truncado");
+    script = std::string(decoder) + "\n" + HARNESS;
+
+    if (system("node --version > /dev/null 2>&1") != 0) {
+        TEST_IGNORE_MESSAGE("node no está en el PATH");
+    }
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// PRUEBAS
+// =============================================================================
+
+/**
+ * @brief Lecturas típicas, límites, fuera de rango y sin lectura
+ */
+void test_single_frames(void) {
+    for (uint8_t i = 0; i < sizeof(READINGS) / sizeof(READINGS[0]); i++) {
+        char label[24];
+        snprintf(label, sizeof(label), "lectura %u", i);
+        check_single(&READINGS[i], label);
+    }
+    assert_node_ok();
+}
+
+/**
+ * @brief Barrido aleatorio de cada campo, algo más allá de sus límites
+ */
+void test_single_frames_sweep(void) {
+    uint32_t seed = 1;
+    for (uint16_t n = 0; n < 500; n++) {
+        reading_t reading = {};
+        reading.data.valid_mask = ALL_FIELDS;
+        for (uint8_t i = 0; i < payload_codec_field_count(); i++) {
+            const payload_field_t* field = payload_codec_field(i);
+            int32_t span = (int32_t)field->max_code * field->raw_step;
+            seed = seed * 1103515245UL + 12345UL;
+            int32_t raw = field->raw_min - span / 20 + (int32_t)((seed >> 8) % (uint32_t)(span + span / 10));
+#ifdef BATTERY_AS_PERCENTAGE
+            if (field->valid_bit == SENSOR_FIELD_BATTERY) {
+                reading.soc_percent = (uint8_t)((seed >> 8) % 101);
+                continue;
+            }
+#endif
+            *(int32_t*)((uint8_t*)&reading.data + field->offset) = raw;
+            if ((seed >> 20) % 16 == 0) reading.data.valid_mask &= ~field->valid_bit;
+        }
+        char label[24];
+        snprintf(label, sizeof(label), "barrido %u", n);
+        check_single(&reading, label);
+    }
+    assert_node_ok();
+}
+
+/**
+ * @brief Trama por lotes: deltas pequeñas, saltos que no caben en la delta,
+ *        campos que aparecen y desaparecen, y edades de cada registro
+ */
+void test_batch_frame(void) {
+    static const reading_t SERIES[] = {
+        { 80, { 2100, 6000, 101300, 1500, 710, 4000, ALL_FIELDS } },
+        { 80, { 2104, 5990, 101290, 1502, 711, 4000, ALL_FIELDS } },
+        { 79, { 2110, 5985, 101310, 1501, 709, 4000, ALL_FIELDS } },
+        // Salto de temperatura y humedad: valor completo
+        { 79, { 3500, 3000, 101310, 1501, 709, 4000, ALL_FIELDS } },
+        // Sin pH
+        { 79, { 3502, 3010, 101300, 1499, 0, 4000, ALL_FIELDS & ~SENSOR_FIELD_PH } },
+        // El pH vuelve
+        { 78, { 3498, 3005, 101305, 1500, 712, 4000, ALL_FIELDS } },
+    };
+    // Deltas en el límite de los bits de delta: temperatura (9 bits, 0,01 °C
+    // por código) y presión (6 bits, 0,1 hPa por código)
+    static const reading_t EDGES[] = {
+        { 80, { 2000, 6000, 101300, 1500, 710, 4000, ALL_FIELDS } },
+        { 80, { 2255, 6000, 101610, 1500, 710, 4000, ALL_FIELDS } },   // +255, +31: delta
+        { 80, { 1999, 6000, 101290, 1500, 710, 4000, ALL_FIELDS } },   // -256, -32: delta
+        { 80, { 2255, 6000, 101610, 1500, 710, 4000, ALL_FIELDS } },   // +256, +32: completo
+        { 80, { 1998, 6000, 101280, 1500, 710, 4000, ALL_FIELDS } },   // -257, -33: completo
+    };
+    uint8_t frame[128];
+    check_batch(EDGES, 5, 0, 60, "lote en los límites de la delta", frame, sizeof(frame));
+    check_batch(SERIES, 6, 0, 600, "lote", frame, sizeof(frame));
+    check_batch(SERIES, 3, 2, 300, "lote con pendientes", frame, sizeof(frame));
+    check_batch(READINGS, sizeof(READINGS) / sizeof(READINGS[0]), 0, 900, "lote de límites", frame, sizeof(frame));
+    assert_node_ok();
+}
+
+/**
+ * @brief Tramas truncadas o de tamaño incorrecto dan error o aviso
+ */
+void test_malformed_frames(void) {
+    static const reading_t SERIES[] = {
+        { 80, { 2100, 6000, 101300, 1500, 710, 4000, ALL_FIELDS } },
+        { 80, { 3100, 3000, 99300, 2500, 610, 4000, ALL_FIELDS } },
+    };
+    uint8_t frame[64];
+    uint8_t size = check_batch(SERIES, 2, 0, 600, "lote completo", frame, sizeof(frame));
+    add_check("checkError", "lote truncado", BATCH_FPORT, frame, size - 1, "'errors'");
+    add_check("checkError", "cabecera corta", BATCH_FPORT, frame, BATCH_HEADER_SIZE - 1, "'errors'");
+    add_check("checkError", "trama simple corta", SINGLE_FPORT, frame, payload_codec_record_size() - 1, "'warnings'");
+    assert_node_ok();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_frames);
+    RUN_TEST(test_single_frames_sweep);
+    RUN_TEST(test_batch_frame);
+    RUN_TEST(test_malformed_frames);
+    return UNITY_END();
+}
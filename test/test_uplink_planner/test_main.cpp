@@ -0,0 +1,337 @@
+/**
+ * @file      test_main.cpp
+ * @brief     Pruebas en el host del planificador de uplinks: un día simulado
+ *
+ * El reloj del planificador (scheduler_clock_s()) y el de LMIC son variables
+ * de la prueba, y calcAirTime() sale de test/stubs/lmic_host.h. Se comprueba
+ * que ninguna hora real (ventana deslizante de UPLINK_PLANNER_WINDOW_SECONDS,
+ * no los cubos) supera el duty cycle, los totales de tiempo en el aire, la
+ * caducidad de los 13 cubos de planner_advance() y la búsqueda binaria de
+ * uplink_planner_fit_payload().
+ *
+ * @author    Proyecto IoT de Bajo Consumo
+ * @version   1.0
+ * @date      2025
+ */
+
+#include <unity.h>
+#include <vector>
+#include "lmic_host.h"
+#include "../../src/uplink_planner.cpp"
+
+// =============================================================================
+// DEPENDENCIAS DEL MÓDULO
+// =============================================================================
+
+static uint32_t clock_s = 0;
+
+uint32_t scheduler_clock_s(void) { return clock_s; }
+void logger_printf(const char* fmt, ...) {}
+void logger_push_deferred(const char* fmt, const uint32_t* args, uint8_t count) {}
+
+// =============================================================================
+// AUXILIARES
+// =============================================================================
+
+// Tiempo en el aire permitido en una hora real
+#define WINDOW_BUDGET_US ((uint64_t)UPLINK_PLANNER_WINDOW_SECONDS * 1000000ULL * SCHEDULER_DUTY_CYCLE_PERCENT / 100)
+
+/**
+ * @brief Uplink simulado
+ */
+typedef struct {
+    uint32_t t_s;
+    uint32_t airtime_us;
+} sim_uplink_t;
+
+/**
+ * @brief Resultado de un día simulado
+ */
+typedef struct {
+    std::vector<sim_uplink_t> uplinks;
+    uint32_t deferred;
+    uint64_t total_us;
+} sim_day_t;
+
+/**
+ * @brief Generador determinista para el desfase de los despertares
+ */
+static uint32_t lcg(uint32_t* state) {
+    *state = *state * 1103515245UL + 12345UL;
+    return *state >> 16;
+}
+
+/**
+ * @brief Un día de uplinks cada interval_s (con 0-4 s de desfase) a un DR fijo
+ */
+static sim_day_t simulate_day(uint32_t interval_s, uint8_t datarate, uint8_t payload_size) {
+    sim_day_t day = {};
+    uint32_t seed = 1;
+    for (clock_s = 7; clock_s < 86400; clock_s += interval_s + lcg(&seed) % 5) {
+        uint8_t dr = uplink_planner_fit_datarate(datarate, payload_size);
+        if (dr == DR_NONE) {
+            day.deferred++;
+            continue;
+        }
+        uint32_t airtime = uplink_planner_airtime_us(dr, payload_size);
+        uplink_planner_record(airtime);
+        day.uplinks.push_back({ clock_s, airtime });
+        day.total_us += airtime;
+    }
+    return day;
+}
+
+/**
+ * @brief Mayor tiempo en el aire en cualquier ventana deslizante de una hora
+ */
+static uint64_t worst_window_us(const sim_day_t* day) {
+    uint64_t worst = 0;
+    size_t first = 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < day->uplinks.size(); i++) {
+        sum += day->uplinks[i].airtime_us;
+        while (day->uplinks[i].t_s - day->uplinks[first].t_s >= UPLINK_PLANNER_WINDOW_SECONDS) {
+            sum -= day->uplinks[first++].airtime_us;
+        }
+        if (sum > worst) worst = sum;
+    }
+    return worst;
+}
+
+void setUp(void) {
+    memset(&rtc_planner, 0, sizeof(rtc_planner));
+    memset(&LMIC, 0, sizeof(LMIC));
+    clock_s = 0;
+    stub_os_ticks = 0;
+}
+
+void tearDown(void) {}
+
+// =============================================================================
+// TIEMPO EN EL AIRE
+// =============================================================================
+
+void test_airtime(void) {
+    // 51 + 13 bytes: 103 símbolos a SF7 y 73 a SF12 (con optimización de baja tasa)
+    TEST_ASSERT_EQUAL_UINT32(118016, uplink_planner_airtime_us(DR_SF7, 51));
+    TEST_ASSERT_EQUAL_UINT32(2793472, uplink_planner_airtime_us(DR_SF12, 51));
+
+    // Crece con el tamaño y baja con el DR
+    for (uint8_t dr = DR_SF12; dr < DR_SF7; dr++) {
+        TEST_ASSERT_GREATER_THAN(uplink_planner_airtime_us(dr + 1, 20), uplink_planner_airtime_us(dr, 20));
+    }
+    for (uint8_t size = 0; size < 222; size++) {
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(uplink_planner_airtime_us(DR_SF9, size + 1),
+                                         uplink_planner_airtime_us(DR_SF9, size));
+    }
+}
+
+void test_airtime_counts_fopts(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, uplink_planner_fopts_size());
+    uint32_t plain = uplink_planner_airtime_us(DR_SF10, 40);
+    uint32_t plus_six = uplink_planner_airtime_us(DR_SF10, 46);
+
+    // LinkCheckReq (1) + LinkADRAns (2) + DevStatusAns (3)
+    LMIC.lchkReq = 1;
+    LMIC.ladrAns = 1;
+    LMIC.devsAns = 1;
+    TEST_ASSERT_EQUAL_UINT8(6, uplink_planner_fopts_size());
+    TEST_ASSERT_EQUAL_UINT32(plus_six, uplink_planner_airtime_us(DR_SF10, 40));
+    TEST_ASSERT_GREATER_THAN(plain, plus_six);
+}
+
+// =============================================================================
+// VENTANA DE 13 CUBOS
+// =============================================================================
+
+void test_window_expiry(void) {
+    const uint32_t bucket_s = UPLINK_PLANNER_WINDOW_SECONDS / 12;
+    const uint32_t span_s = 13 * bucket_s;
+
+    // Un uplink al principio y otro al final del primer cubo
+    uplink_planner_budget_left_us();  // Inicializa la ventana en t = 0
+    uplink_planner_record(1000000);
+    clock_s = bucket_s - 1;
+    uplink_planner_record(2000000);
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US - 3000000, uplink_planner_budget_left_us());
+
+    // Los dos siguen contando una ventana completa tras el último
+    clock_s = (bucket_s - 1) + UPLINK_PLANNER_WINDOW_SECONDS;
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US - 3000000, uplink_planner_budget_left_us());
+
+    // Y caducan juntos con el cubo, como mucho 13 cubos después
+    clock_s = span_s;
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US, uplink_planner_budget_left_us());
+}
+
+void test_window_rolls_bucket_by_bucket(void) {
+    const uint32_t bucket_s = UPLINK_PLANNER_WINDOW_SECONDS / 12;
+
+    // Un uplink de 1 s en cada cubo: al avanzar solo cae el más antiguo
+    uplink_planner_budget_left_us();
+    for (uint32_t i = 0; i < 13; i++) {
+        clock_s = i * bucket_s;
+        uplink_planner_record(1000000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US - 13000000, uplink_planner_budget_left_us());
+    for (uint32_t i = 1; i <= 13; i++) {
+        clock_s = (12 + i) * bucket_s;
+        TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US - (13 - i) * 1000000ULL, uplink_planner_budget_left_us());
+    }
+}
+
+void test_window_long_sleep_clears(void) {
+    uplink_planner_budget_left_us();
+    uplink_planner_record(5000000);
+    clock_s = 100000;
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US, uplink_planner_budget_left_us());
+    uplink_planner_record(1000000);
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_BUDGET_US - 1000000, uplink_planner_budget_left_us());
+}
+
+// =============================================================================
+// AJUSTE DEL PAYLOAD Y DEL DR
+// =============================================================================
+
+void test_fit_payload_matches_linear_search(void) {
+    uplink_planner_budget_left_us();
+    for (uint8_t dr = DR_SF12; dr <= DR_SF7; dr++) {
+        // Presupuesto libre de 0 a ~3 s, repartido para cortar en todos los tamaños
+        for (uint32_t left_ms = 0; left_ms <= 3000; left_ms += 37) {
+            memset(rtc_planner.bucket_us, 0, sizeof(rtc_planner.bucket_us));
+            rtc_planner.bucket_us[rtc_planner.head] = WINDOW_BUDGET_US - left_ms * 1000;
+            uint32_t left = uplink_planner_budget_left_us();
+
+            uint8_t expected = 0;
+            bool any = false;
+            for (uint16_t size = 0; size <= 222; size++) {
+                if (uplink_planner_airtime_us(dr, size) > left) break;
+                expected = size;
+                any = true;
+            }
+            uint8_t fit = uplink_planner_fit_payload(dr, 222);
+            char msg[40];
+            snprintf(msg, sizeof(msg), "DR%u, %lu ms libres", dr, (unsigned long)left_ms);
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(any ? expected : 0, fit, msg);
+            if (any) {
+                TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(left, uplink_planner_airtime_us(dr, fit), msg);
+            }
+        }
+    }
+}
+
+void test_fit_payload_respects_max(void) {
+    uplink_planner_budget_left_us();
+    TEST_ASSERT_EQUAL_UINT8(51, uplink_planner_fit_payload(DR_SF12, 51));
+    TEST_ASSERT_EQUAL_UINT8(0, uplink_planner_fit_payload(DR_SF12, 0));
+}
+
+void test_fit_datarate(void) {
+    uplink_planner_budget_left_us();
+    TEST_ASSERT_EQUAL_UINT8(DR_SF12, uplink_planner_fit_datarate(DR_SF12, 51));
+
+    // Queda menos de lo que cuesta la trama a SF12 pero más que a SF7
+    rtc_planner.bucket_us[rtc_planner.head] = WINDOW_BUDGET_US - 500000;
+#if UPLINK_PLANNER_ADAPT_DR
+    uint8_t dr = uplink_planner_fit_datarate(DR_SF12, 51);
+    TEST_ASSERT_NOT_EQUAL(DR_NONE, dr);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(500000, uplink_planner_airtime_us(dr, 51));
+#else
+    TEST_ASSERT_EQUAL_UINT8(DR_NONE, uplink_planner_fit_datarate(DR_SF12, 51));
+#endif
+    TEST_ASSERT_EQUAL_UINT8(DR_SF7, uplink_planner_fit_datarate(DR_SF7, 51));
+}
+
+// =============================================================================
+// ESPERA POR BANDA
+// =============================================================================
+
+void test_next_tx_waits_for_band(void) {
+    // Canales como setupLMIC(): 0-7 en la banda del 1 %, 8 (FSK) en la del 0,1 %
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        LMIC.channelFreq[ch] = (867100000 + ch * 200000) | BAND_CENTI;
+        LMIC.channelDrMap[ch] = DR_RANGE_MAP(DR_SF12, DR_SF7);
+    }
+    LMIC.channelFreq[8] = 868800000 | BAND_MILLI;
+    LMIC.channelDrMap[8] = DR_RANGE_MAP(DR_FSK, DR_FSK);
+    LMIC.channelMap = 0x1FF;
+
+    // Tras un uplink de 118 ms a SF7 la banda del 1 % queda ocupada 100 veces eso
+    stub_os_ticks = sec2osticks(1000);
+    LMIC.bands[BAND_CENTI].avail = stub_os_ticks + 100 * us2osticks(uplink_planner_airtime_us(DR_SF7, 51));
+    TEST_ASSERT_UINT32_WITHIN(1, 11802, uplink_planner_next_tx_ms(DR_SF7));
+    TEST_ASSERT_EQUAL_UINT32(0, uplink_planner_next_tx_ms(DR_FSK));
+    TEST_ASSERT_GREATER_THAN_UINT32(UPLINK_PLANNER_CHAIN_WAIT_MS, uplink_planner_next_tx_ms(DR_SF7));
+
+    // Canal deshabilitado y DR que no admite ningún canal
+    TEST_ASSERT_EQUAL_UINT32(UPLINK_PLANNER_NEVER, uplink_planner_channel_wait_ms(9));
+    TEST_ASSERT_EQUAL_UINT32(UPLINK_PLANNER_NEVER, uplink_planner_next_tx_ms(DR_SF7B));
+
+    stub_os_ticks = LMIC.bands[BAND_CENTI].avail;
+    TEST_ASSERT_EQUAL_UINT32(0, uplink_planner_next_tx_ms(DR_SF7));
+}
+
+// =============================================================================
+// UN DÍA
+// =============================================================================
+
+void test_day_relaxed(void) {
+    // 51 bytes a SF7 cada 5 min: muy por debajo del 1 %, ningún aplazamiento
+    sim_day_t day = simulate_day(300, DR_SF7, 51);
+    TEST_ASSERT_EQUAL_UINT32(0, day.deferred);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)day.uplinks.size() * 118016, day.total_us);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(WINDOW_BUDGET_US, worst_window_us(&day));
+    TEST_ASSERT_EQUAL_UINT32(day.uplinks.size(), rtc_planner.uplinks);
+    TEST_ASSERT_UINT32_WITHIN(day.uplinks.size(), day.total_us / 1000, rtc_planner.total_ms);
+}
+
+void test_day_saturated(void) {
+    // 51 bytes a SF12 cada minuto (2,8 s): pediría el 4,6 % del tiempo
+    sim_day_t day = simulate_day(60, DR_SF12, 51);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, day.deferred);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(WINDOW_BUDGET_US, worst_window_us(&day));
+
+    // Los cubos cuentan de más como mucho un cubo: se usa al menos el
+    // presupuesto de una ventana cada 13 cubos, menos una trama
+    const uint32_t span_s = 13 * (UPLINK_PLANNER_WINDOW_SECONDS / 12);
+    uint64_t floor_us = (86400 / span_s) * (WINDOW_BUDGET_US - uplink_planner_airtime_us(DR_SF12, 51));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(floor_us, day.total_us);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(25 * WINDOW_BUDGET_US, day.total_us);
+
+    TEST_ASSERT_EQUAL_UINT32(day.uplinks.size(), rtc_planner.uplinks);
+    TEST_ASSERT_UINT32_WITHIN(day.uplinks.size(), day.total_us / 1000, rtc_planner.total_ms);
+}
+
+void test_day_batch_frames(void) {
+    // Lotes: se envía lo que quepa a SF10 cada 2 min; nunca se pasa del presupuesto
+    uint64_t total = 0;
+    std::vector<sim_uplink_t> log;
+    for (clock_s = 0; clock_s < 86400; clock_s += 120) {
+        uint8_t size = uplink_planner_fit_payload(DR_SF10, 51);
+        if (size == 0) continue;
+        uint32_t airtime = uplink_planner_airtime_us(DR_SF10, size);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(uplink_planner_budget_left_us(), airtime);
+        uplink_planner_record(airtime);
+        log.push_back({ clock_s, airtime });
+        total += airtime;
+    }
+    sim_day_t day = { log, 0, total };
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(WINDOW_BUDGET_US, worst_window_us(&day));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_airtime);
+    RUN_TEST(test_airtime_counts_fopts);
+    RUN_TEST(test_window_expiry);
+    RUN_TEST(test_window_rolls_bucket_by_bucket);
+    RUN_TEST(test_window_long_sleep_clears);
+    RUN_TEST(test_fit_payload_matches_linear_search);
+    RUN_TEST(test_fit_payload_respects_max);
+    RUN_TEST(test_fit_datarate);
+    RUN_TEST(test_next_tx_waits_for_band);
+    RUN_TEST(test_day_relaxed);
+    RUN_TEST(test_day_saturated);
+    RUN_TEST(test_day_batch_frames);
+    return UNITY_END();
+}